@@ -18,6 +18,7 @@
 #include <cstdio>
 #include <cstring>
 #include <iterator> // std::size
+#include <limits>
 #include <mutex>
 #include <string_view>
 
@@ -26,6 +27,7 @@
 #endif
 
 #if defined(CONF_FAMILY_UNIX)
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/utsname.h>
@@ -111,6 +113,28 @@ void net_buffer_init(NETSOCKET_BUFFER *buffer);
 void net_buffer_reinit(NETSOCKET_BUFFER *buffer);
 void net_buffer_simple(NETSOCKET_BUFFER *buffer, char **buf, int *size);
 
+#if defined(CONF_PLATFORM_LINUX)
+// UDP_SEGMENT is missing from older libc headers
+#define NET_UDP_SEGMENT 103
+#define NET_GSO_MAX_SEGMENTS 64
+#define NET_GSO_MAX_SIZE 65000
+typedef struct
+{
+	int gso; // cleared when the kernel or the device rejects UDP_SEGMENT
+	int num;
+	int socks[VLEN];
+	int sizes[VLEN];
+	int64_t times[VLEN];
+	socklen_t addrlens[VLEN];
+	sockaddr_storage addrs[VLEN];
+	char bufs[VLEN][PACKETSIZE];
+
+	struct mmsghdr msgs[VLEN];
+	struct iovec iovecs[VLEN];
+	char controls[VLEN][CMSG_SPACE(sizeof(uint16_t))];
+} NETSOCKET_SEND_QUEUE;
+#endif
+
 struct NETSOCKET_INTERNAL
 {
 	int type;
@@ -120,6 +144,9 @@ struct NETSOCKET_INTERNAL
 	int web_ipv6sock;
 
 	NETSOCKET_BUFFER buffer;
+#if defined(CONF_PLATFORM_LINUX)
+	NETSOCKET_SEND_QUEUE *send_queue;
+#endif
 };
 static NETSOCKET_INTERNAL invalid_socket = {NETTYPE_INVALID, -1, -1, -1, -1};
 
@@ -355,6 +382,79 @@ int io_error(IOHANDLE io)
 	return ferror((FILE *)io);
 }
 
+int io_file_info(IOHANDLE io, IO_FILE_INFO *info)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	BY_HANDLE_FILE_INFORMATION file_info;
+	if(!GetFileInformationByHandle((HANDLE)_get_osfhandle(_fileno((FILE *)io)), &file_info))
+	{
+		return 1;
+	}
+	info->device = file_info.dwVolumeSerialNumber;
+	info->inode = ((uint64_t)file_info.nFileIndexHigh << 32) | file_info.nFileIndexLow;
+	info->size = ((int64_t)file_info.nFileSizeHigh << 32) | file_info.nFileSizeLow;
+	// FILETIME counts 100 ns intervals since 1601
+	const uint64_t modified = ((uint64_t)file_info.ftLastWriteTime.dwHighDateTime << 32) | file_info.ftLastWriteTime.dwLowDateTime;
+	info->modified = ((int64_t)modified - 116444736000000000LL) * 100;
+#elif defined(CONF_FAMILY_UNIX)
+	struct stat sb;
+	if(fstat(fileno((FILE *)io), &sb))
+	{
+		return 1;
+	}
+	info->device = sb.st_dev;
+	info->inode = sb.st_ino;
+	info->size = sb.st_size;
+#if defined(CONF_PLATFORM_MACOS)
+	info->modified = (int64_t)sb.st_mtimespec.tv_sec * 1000000000 + sb.st_mtimespec.tv_nsec;
+#else
+	info->modified = (int64_t)sb.st_mtim.tv_sec * 1000000000 + sb.st_mtim.tv_nsec;
+#endif
+#else
+#error not implemented
+#endif
+	return 0;
+}
+
+void *io_map(IOHANDLE io, int64_t size)
+{
+	if(size <= 0 || (uint64_t)size > std::numeric_limits<size_t>::max())
+	{
+		return nullptr;
+	}
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE mapping = CreateFileMappingW((HANDLE)_get_osfhandle(_fileno((FILE *)io)), nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if(mapping == nullptr)
+	{
+		return nullptr;
+	}
+	void *ptr = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+	// the view keeps the mapping alive
+	CloseHandle(mapping);
+	return ptr;
+#else
+	void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno((FILE *)io), 0);
+	if(ptr == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	return ptr;
+#endif
+}
+
+void io_unmap(void *ptr, int64_t size)
+{
+	if(ptr == nullptr)
+	{
+		return;
+	}
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(ptr);
+#else
+	munmap(ptr, size);
+#endif
+}
+
 IOHANDLE io_stdin()
 {
 	return stdin;
@@ -1645,6 +1745,147 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
+#if defined(CONF_PLATFORM_LINUX)
+static void priv_net_udp_flush_sock(NETSOCKET_SEND_QUEUE *queue, int fd, int64_t now)
+{
+	// collect the datagrams for this socket, consecutive ones to the same
+	// address are merged into one GSO message if all but the last one
+	// have the same size
+	int num_msgs = 0;
+	int num_iovecs = 0;
+	for(int i = 0; i < queue->num; i++)
+	{
+		if(queue->socks[i] != fd)
+			continue;
+
+		network_stats.sent_queue_delay += now - queue->times[i];
+
+		struct msghdr *prev = num_msgs > 0 ? &queue->msgs[num_msgs - 1].msg_hdr : nullptr;
+		if(queue->gso && prev &&
+			prev->msg_namelen == queue->addrlens[i] &&
+			mem_comp(prev->msg_name, &queue->addrs[i], queue->addrlens[i]) == 0 &&
+			prev->msg_iovlen < NET_GSO_MAX_SEGMENTS &&
+			(prev->msg_iovlen + 1) * prev->msg_iov[0].iov_len <= NET_GSO_MAX_SIZE &&
+			prev->msg_iov[prev->msg_iovlen - 1].iov_len == prev->msg_iov[0].iov_len &&
+			(size_t)queue->sizes[i] <= prev->msg_iov[0].iov_len)
+		{
+			queue->iovecs[num_iovecs].iov_base = queue->bufs[i];
+			queue->iovecs[num_iovecs].iov_len = queue->sizes[i];
+			num_iovecs++;
+			prev->msg_iovlen++;
+			continue;
+		}
+
+		queue->iovecs[num_iovecs].iov_base = queue->bufs[i];
+		queue->iovecs[num_iovecs].iov_len = queue->sizes[i];
+		struct msghdr *msg = &queue->msgs[num_msgs].msg_hdr;
+		mem_zero(msg, sizeof(*msg));
+		msg->msg_name = &queue->addrs[i];
+		msg->msg_namelen = queue->addrlens[i];
+		msg->msg_iov = &queue->iovecs[num_iovecs];
+		msg->msg_iovlen = 1;
+		num_iovecs++;
+		num_msgs++;
+	}
+
+	for(int i = 0; i < num_msgs; i++)
+	{
+		struct msghdr *msg = &queue->msgs[i].msg_hdr;
+		if(msg->msg_iovlen < 2)
+			continue;
+		msg->msg_control = queue->controls[i];
+		msg->msg_controllen = sizeof(queue->controls[i]);
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg);
+		cmsg->cmsg_level = IPPROTO_UDP;
+		cmsg->cmsg_type = NET_UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		const uint16_t segment_size = msg->msg_iov[0].iov_len;
+		mem_copy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+	}
+
+	int sent = 0;
+	while(sent < num_msgs)
+	{
+		const int result = sendmmsg(fd, &queue->msgs[sent], num_msgs - sent, 0);
+		network_stats.sent_syscalls++;
+		if(result > 0)
+		{
+			sent += result;
+			continue;
+		}
+
+		// the first remaining message failed, skip it like a failed sendto
+		struct msghdr *msg = &queue->msgs[sent].msg_hdr;
+		if(msg->msg_iovlen > 1 && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP))
+		{
+			log_warn("net", "UDP segmentation offload unavailable, sending packets separately (%s)", net_error_message().c_str());
+			queue->gso = 0;
+			for(size_t segment = 0; segment < msg->msg_iovlen; segment++)
+			{
+				sendto(fd, msg->msg_iov[segment].iov_base, msg->msg_iov[segment].iov_len, 0, (sockaddr *)msg->msg_name, msg->msg_namelen);
+				network_stats.sent_syscalls++;
+			}
+		}
+		sent++;
+	}
+}
+
+static void priv_net_udp_flush(NETSOCKET sock)
+{
+	NETSOCKET_SEND_QUEUE *queue = sock->send_queue;
+	if(!queue || queue->num == 0)
+		return;
+
+	const int64_t now = time_get_nanoseconds().count();
+	if(sock->ipv4sock >= 0)
+		priv_net_udp_flush_sock(queue, sock->ipv4sock, now);
+	if(sock->ipv6sock >= 0)
+		priv_net_udp_flush_sock(queue, sock->ipv6sock, now);
+	queue->num = 0;
+}
+
+static int priv_net_udp_enqueue(NETSOCKET sock, int fd, const sockaddr *sa, socklen_t sa_len, const void *data, int size)
+{
+	NETSOCKET_SEND_QUEUE *queue = sock->send_queue;
+	if(queue->num == VLEN)
+		priv_net_udp_flush(sock);
+
+	const int i = queue->num++;
+	queue->socks[i] = fd;
+	queue->sizes[i] = size;
+	queue->times[i] = time_get_nanoseconds().count();
+	queue->addrlens[i] = sa_len;
+	mem_copy(&queue->addrs[i], sa, sa_len);
+	mem_copy(queue->bufs[i], data, size);
+	return size;
+}
+#endif
+
+void net_udp_set_send_batching(NETSOCKET sock, bool enabled)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	if(enabled && !sock->send_queue)
+	{
+		sock->send_queue = (NETSOCKET_SEND_QUEUE *)malloc(sizeof(*sock->send_queue));
+		sock->send_queue->gso = 1;
+		sock->send_queue->num = 0;
+	}
+	else if(!enabled && sock->send_queue)
+	{
+		priv_net_udp_flush(sock);
+		free(sock->send_queue);
+		sock->send_queue = nullptr;
+	}
+#endif
+}
+
+void net_udp_flush(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	priv_net_udp_flush(sock);
+#endif
+}
+
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
 	int d = -1;
@@ -1666,7 +1907,15 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in(addr, &sa);
 			}
 
-			d = sendto(sock->ipv4sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+#if defined(CONF_PLATFORM_LINUX)
+			if(sock->send_queue && !(addr->type & NETTYPE_LINK_BROADCAST) && size <= PACKETSIZE)
+				d = priv_net_udp_enqueue(sock, sock->ipv4sock, (const sockaddr *)&sa, sizeof(sa), data, size);
+			else
+#endif
+			{
+				d = sendto(sock->ipv4sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+				network_stats.sent_syscalls++;
+			}
 		}
 		else
 		{
@@ -1714,7 +1963,15 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in6(addr, &sa);
 			}
 
-			d = sendto(sock->ipv6sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+#if defined(CONF_PLATFORM_LINUX)
+			if(sock->send_queue && !(addr->type & NETTYPE_LINK_BROADCAST) && size <= PACKETSIZE)
+				d = priv_net_udp_enqueue(sock, sock->ipv6sock, (const sockaddr *)&sa, sizeof(sa), data, size);
+			else
+#endif
+			{
+				d = sendto(sock->ipv6sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+				network_stats.sent_syscalls++;
+			}
 		}
 		else
 		{
@@ -1892,6 +2149,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 
 void net_udp_close(NETSOCKET sock)
 {
+	net_udp_set_send_batching(sock, false);
 	priv_net_close_all_sockets(sock);
 }
 
@@ -282,6 +282,44 @@ int io_sync(IOHANDLE io);
  */
 int io_error(IOHANDLE io);
 
+/**
+ * Gets the identity, size and last modification time of an open file.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ * @param info Pointer where the information will be stored.
+ *
+ * @return `0` on success, non-zero on failure.
+ */
+int io_file_info(IOHANDLE io, IO_FILE_INFO *info);
+
+/**
+ * Maps the contents of a file into memory.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ * @param size Number of bytes to map, starting at the beginning of the file.
+ *
+ * @return Pointer to the mapped memory, or `nullptr` on error.
+ *
+ * @remark The mapping is private, writing to it does not change the file.
+ * @remark The mapping stays valid after the file is closed and must be freed with @link io_unmap @endlink.
+ * @remark Accessing the mapping can crash the process if the file is truncated by someone else.
+ */
+void *io_map(IOHANDLE io, int64_t size);
+
+/**
+ * Frees memory that was mapped with @link io_map @endlink.
+ *
+ * @ingroup File-IO
+ *
+ * @param ptr Pointer to the mapped memory.
+ * @param size Number of bytes that were mapped.
+ */
+void io_unmap(void *ptr, int64_t size);
+
 /**
  * Returns a handle for the standard input.
  *
@@ -796,6 +834,29 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
  */
 int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data);
 
+/**
+ * Enables or disables the send queue of an UDP socket. While enabled,
+ * @link net_udp_send @endlink only queues the packets and they are sent
+ * in batches by @link net_udp_flush @endlink or once the queue is full.
+ * Only has an effect on Linux, where the queue is sent with `sendmmsg`
+ * and UDP segmentation offload.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ * @param enabled Whether packets should be queued.
+ */
+void net_udp_set_send_batching(NETSOCKET sock, bool enabled);
+
+/**
+ * Sends all packets queued on an UDP socket.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to flush.
+ */
+void net_udp_flush(NETSOCKET sock);
+
 /**
  * Closes an UDP socket.
  *
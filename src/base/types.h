@@ -25,6 +25,24 @@ enum class TRISTATE
  */
 typedef void *IOHANDLE;
 
+/**
+ * Information that changes when a file is replaced or modified.
+ *
+ * @ingroup File-IO
+ *
+ * @see io_file_info
+ */
+typedef struct
+{
+	uint64_t device;
+	uint64_t inode;
+	int64_t size;
+	/**
+	 * Last modification time in nanoseconds since UNIX Epoch.
+	 */
+	int64_t modified;
+} IO_FILE_INFO;
+
 typedef int (*FS_LISTDIR_CALLBACK)(const char *name, int is_dir, int dir_type, void *user);
 
 typedef struct
@@ -94,6 +112,8 @@ typedef struct NETSTATS
 	uint64_t sent_bytes;
 	uint64_t recv_packets;
 	uint64_t recv_bytes;
+	uint64_t sent_syscalls;
+	uint64_t sent_queue_delay; // nanoseconds packets waited in send queues
 } NETSTATS;
 
 #if defined(CONF_FAMILY_WINDOWS)
@@ -2031,7 +2031,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 				return;
 			}
 
-			int64_t Now = time_get();
+			int64_t Now = m_aNetClient[Conn].LastRecvTime();
 
 			// adjust our prediction time
 			int64_t Target = 0;
@@ -2215,7 +2215,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 					}
 
 					// add new
-					m_aSnapshotStorage[Conn].Add(GameTick, time_get(), SnapSize, pTmpBuffer3, AltSnapSize, pAltSnapBuffer);
+					m_aSnapshotStorage[Conn].Add(GameTick, m_aNetClient[Conn].LastRecvTime(), SnapSize, pTmpBuffer3, AltSnapSize, pAltSnapBuffer);
 
 					if(!Dummy)
 					{
@@ -2294,7 +2294,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket, int Conn, bool Dummy)
 					// adjust game time
 					if(m_aReceivedSnapshots[Conn] > 2)
 					{
-						int64_t Now = m_aGameTime[Conn].Get(time_get());
+						int64_t Now = m_aGameTime[Conn].Get(m_aNetClient[Conn].LastRecvTime());
 						int64_t TickStart = GameTick * time_freq() / GameTickSpeed();
 						int64_t TimeLeft = (TickStart - Now) * 1000 / time_freq();
 						m_aGameTime[Conn].Update(&m_aGametimeMarginGraphs[Conn], (GameTick - 1) * time_freq() / GameTickSpeed(), TimeLeft, CSmoothTime::ADJUSTDIRECTION_DOWN);
@@ -3572,7 +3572,8 @@ bool CClient::InitNetworkClientImpl(NETADDR BindAddr, int Conn, char *pError, si
 	BindAddr.port = *pPort;
 
 	unsigned RemainingAttempts = 25;
-	while(!m_aNetClient[Conn].Open(BindAddr))
+	const bool RecvThread = g_Config.m_ClNetThread && Conn != CONN_CONTACT;
+	while(!m_aNetClient[Conn].Open(BindAddr, RecvThread))
 	{
 		--RemainingAttempts;
 		if(RemainingAttempts == 0)
@@ -5015,7 +5016,7 @@ int main(int argc, const char **argv)
 	pKernel->RegisterInterface(pEngineTextRender); // IEngineTextRender
 	pKernel->RegisterInterface(static_cast<ITextRender *>(pEngineTextRender), false);
 
-	IEngineMap *pEngineMap = CreateEngineMap();
+	IEngineMap *pEngineMap = CreateEngineMap(pEngine);
 	pKernel->RegisterInterface(pEngineMap); // IEngineMap
 	pKernel->RegisterInterface(static_cast<IMap *>(pEngineMap), false);
 
@@ -5046,12 +5047,18 @@ int main(int argc, const char **argv)
 	pClient->InitInterfaces();
 
 	// execute config file
+	// the chains of config variables only run once the config files and autoexec are executed,
+	// the config domains include the warlist, chat bind and skin profile files
+	pConsole->BeginBatch();
 	pConsole->SetUnknownCommandCallback(SaveUnknownCommandCallback, pClient);
 	for(ConfigDomain ConfigDomain = ConfigDomain::START; ConfigDomain < ConfigDomain::NUM; ++ConfigDomain)
 	{
 		if(!pStorage->FileExists(s_aConfigDomains[ConfigDomain].m_aConfigPath, IStorage::TYPE_ALL))
 			continue;
-		if(!pConsole->ExecuteFile(s_aConfigDomains[ConfigDomain].m_aConfigPath, IConsole::CLIENT_ID_UNSPECIFIED))
+		const std::chrono::nanoseconds ConfigStart = time_get_nanoseconds();
+		const bool ConfigLoaded = pConsole->ExecuteFile(s_aConfigDomains[ConfigDomain].m_aConfigPath, IConsole::CLIENT_ID_UNSPECIFIED);
+		log_info("client", "executed config '%s' in %.3f ms", s_aConfigDomains[ConfigDomain].m_aConfigPath, (time_get_nanoseconds() - ConfigStart).count() / 1e6);
+		if(!ConfigLoaded)
 		{
 			char aError[2048];
 			str_format(aError, sizeof(aError), "Failed to load config from '%s'.", s_aConfigDomains[ConfigDomain].m_aConfigPath);
@@ -5072,6 +5079,10 @@ int main(int argc, const char **argv)
 		pConsole->ExecuteFile(AUTOEXEC_FILE, IConsole::CLIENT_ID_UNSPECIFIED);
 	}
 
+	const std::chrono::nanoseconds BatchStart = time_get_nanoseconds();
+	pConsole->EndBatch();
+	log_info("client", "ran the chains of config variables in %.3f ms", (time_get_nanoseconds() - BatchStart).count() / 1e6);
+
 	if(g_Config.m_ClConfigVersion < 1)
 	{
 		if(g_Config.m_ClAntiPing == 0)
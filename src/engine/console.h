@@ -127,6 +127,23 @@ public:
 	virtual void ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bool InterpretSemicolons = true) = 0;
 	virtual bool ExecuteFile(const char *pFilename, int ClientId, bool LogFailure = false, int StorageType = IStorage::TYPE_ALL) = 0;
 
+	/**
+	 * Starts a batch of commands, e.g. while loading config files at startup.
+	 * Until the batch ends, config variables with chained callbacks are
+	 * assigned without running their chains. When the batch ends, the chain
+	 * of each of them runs once, with the change from the value before the
+	 * batch to the current value. Batches can be nested.
+	 */
+	virtual void BeginBatch() = 0;
+
+	/**
+	 * Ends a batch of commands and runs the chains of the assigned config
+	 * variables in the order of their last assignment.
+	 *
+	 * @see BeginBatch
+	 */
+	virtual void EndBatch() = 0;
+
 	/**
 	 * @deprecated Prefer using the `log_*` functions from base/log.h instead of this function for the following reasons:
 	 * - They support `printf`-formatting without a separate buffer.
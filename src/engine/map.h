@@ -46,6 +46,7 @@ public:
 	virtual int MapSize() const = 0;
 };
 
-extern IEngineMap *CreateEngineMap();
+// the job pool of the engine is used to decompress the map data in parallel if given
+extern IEngineMap *CreateEngineMap(class IEngine *pEngine = nullptr);
 
 #endif
@@ -236,6 +236,8 @@ public:
 	virtual int SnapNewId() = 0;
 	virtual void SnapFreeId(int Id) = 0;
 	virtual void *SnapNewItem(int Type, int Id, int Size) = 0;
+	// number of items in the snapshot that is currently being built
+	virtual int SnapNumItems() const = 0;
 
 	template<typename T>
 	T *SnapNewItem(int Id)
@@ -318,6 +320,11 @@ public:
 	//
 	// GlobalSnap is true when sending snapshots to all clients,
 	// otherwise only forced high bandwidth clients would receive snap.
+	//
+	// Called on the main thread, but the snapshots of the clients snapped
+	// before may still be encoded on worker threads. Items must only be added
+	// through SnapNewItem and the game state must not depend on the order in
+	// which the clients are snapped.
 	virtual void OnSnap(int ClientId, bool GlobalSnap) = 0;
 
 	// Called after sending snapshots to all clients.
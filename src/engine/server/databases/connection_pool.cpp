@@ -2,13 +2,17 @@
 
 #include "connection.h"
 
+#include <base/lock.h>
 #include <base/system.h>
+#include <base/tl/threading.h>
 
 #include <engine/console.h>
 #include <engine/shared/config.h>
 
 #include <chrono>
+#include <cinttypes>
 #include <cstring>
+#include <deque>
 #include <iterator>
 #include <memory>
 #include <thread>
@@ -67,6 +71,67 @@ struct CSqlExecData
 
 	std::unique_ptr<const ISqlData> m_pThreadData;
 	const char *m_pName;
+	// when the query was added, for the latency statistics
+	int64_t m_QueueTime;
+};
+
+class CAtomicLaneStats
+{
+public:
+	std::atomic<int> m_NumQueued{0};
+	std::atomic<int> m_MaxQueued{0};
+	std::atomic<int64_t> m_NumDone{0};
+	std::atomic<int64_t> m_NumFailed{0};
+	std::atomic<int64_t> m_aLatencyBuckets[CDbConnectionPool::CLaneStats::NUM_LATENCY_BUCKETS] = {};
+
+	void OnQueued()
+	{
+		const int NumQueued = m_NumQueued.fetch_add(1) + 1;
+		int MaxQueued = m_MaxQueued.load();
+		while(NumQueued > MaxQueued && !m_MaxQueued.compare_exchange_weak(MaxQueued, NumQueued))
+		{
+		}
+	}
+
+	void OnDone(const CSqlExecData *pData, bool Success)
+	{
+		const int64_t LatencyMs = (time_get_nanoseconds().count() - pData->m_QueueTime) / 1000000;
+		int Bucket = 0;
+		while(Bucket < CDbConnectionPool::CLaneStats::NUM_LATENCY_BUCKETS - 1 && LatencyMs >= (int64_t{1} << Bucket))
+			Bucket++;
+		m_aLatencyBuckets[Bucket].fetch_add(1);
+		(Success ? m_NumDone : m_NumFailed).fetch_add(1);
+		m_NumQueued.fetch_sub(1);
+	}
+};
+
+struct CDbConnectionPool::CSharedData
+{
+	// Used as signal that shutdown is in progress from main thread to
+	// speed up the queries by discarding read queries and writing to
+	// the sqlite file instead of the remote mysql server.
+	// The worker thread signals the main thread that all queries are
+	// processed by setting this variable to false again.
+	std::atomic_bool m_Shutdown{false};
+	// Queries go first to the backup thread. This semaphore signals about
+	// new queries.
+	CSemaphore m_NumBackup;
+	// When the backup thread processed the query, it signals the main
+	// thread with this semaphore about the new query
+	CSemaphore m_NumWorker;
+
+	// spsc queue with additional backup worker to look at queries first.
+	std::unique_ptr<CSqlExecData> m_aQueries[512];
+
+	// read queries are taken by whichever read worker is free
+	CLock m_ReadLock;
+	CSemaphore m_NumRead;
+	std::deque<std::unique_ptr<CSqlExecData>> m_ReadQueries GUARDED_BY(m_ReadLock);
+	// registered read databases, every read worker connects to them on its own
+	std::vector<std::unique_ptr<CSqlExecData>> m_vpReadServers GUARDED_BY(m_ReadLock);
+	std::atomic<int> m_NumReadServers{0};
+
+	CAtomicLaneStats m_aStats[NUM_LANES];
 };
 
 CSqlExecData::CSqlExecData(
@@ -75,7 +140,8 @@ CSqlExecData::CSqlExecData(
 	const char *pName) :
 	m_Mode(READ_ACCESS),
 	m_pThreadData(std::move(pThreadData)),
-	m_pName(pName)
+	m_pName(pName),
+	m_QueueTime(time_get_nanoseconds().count())
 {
 	m_Ptr.m_pReadFunc = pFunc;
 }
@@ -86,7 +152,8 @@ CSqlExecData::CSqlExecData(
 	const char *pName) :
 	m_Mode(WRITE_ACCESS),
 	m_pThreadData(std::move(pThreadData)),
-	m_pName(pName)
+	m_pName(pName),
+	m_QueueTime(time_get_nanoseconds().count())
 {
 	m_Ptr.m_pWriteFunc = pFunc;
 }
@@ -96,7 +163,8 @@ CSqlExecData::CSqlExecData(
 	const char aFilename[64]) :
 	m_Mode(ADD_SQLITE),
 	m_pThreadData(nullptr),
-	m_pName("add sqlite server")
+	m_pName("add sqlite server"),
+	m_QueueTime(0)
 {
 	m_Ptr.m_Sqlite.m_Mode = m;
 	str_copy(m_Ptr.m_Sqlite.m_Filename, aFilename);
@@ -105,7 +173,8 @@ CSqlExecData::CSqlExecData(CDbConnectionPool::Mode m,
 	const CMysqlConfig *pMysqlConfig) :
 	m_Mode(ADD_MYSQL),
 	m_pThreadData(nullptr),
-	m_pName("add mysql server")
+	m_pName("add mysql server"),
+	m_QueueTime(0)
 {
 	m_Ptr.m_Mysql.m_Mode = m;
 	mem_copy(&m_Ptr.m_Mysql.m_Config, pMysqlConfig, sizeof(m_Ptr.m_Mysql.m_Config));
@@ -114,31 +183,62 @@ CSqlExecData::CSqlExecData(CDbConnectionPool::Mode m,
 CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 	m_Mode(PRINT),
 	m_pThreadData(nullptr),
-	m_pName("print database server")
+	m_pName("print database server"),
+	m_QueueTime(0)
 {
 	m_Ptr.m_Print.m_pConsole = pConsole;
 	m_Ptr.m_Print.m_Mode = m;
 }
 
-void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+void CDbConnectionPool::AddQuery(std::unique_ptr<CSqlExecData> pData)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pConsole, DatabaseMode);
+	m_pShared->m_aQueries[m_InsertIdx++] = std::move(pData);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
 	m_pShared->m_NumBackup.Signal();
 }
 
+void CDbConnectionPool::AddReadQuery(std::unique_ptr<CSqlExecData> pData)
+{
+	StartReadWorkers();
+	{
+		const CLockScope LockScope(m_pShared->m_ReadLock);
+		m_pShared->m_ReadQueries.push_back(std::move(pData));
+	}
+	m_pShared->m_NumRead.Signal();
+}
+
+void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+{
+	if(DatabaseMode == Mode::READ)
+		AddReadQuery(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+	else
+		AddQuery(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+}
+
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64])
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFilename);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		StartReadWorkers();
+		const CLockScope LockScope(m_pShared->m_ReadLock);
+		m_pShared->m_vpReadServers.push_back(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
+		m_pShared->m_NumReadServers.store(m_pShared->m_vpReadServers.size());
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
 }
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		StartReadWorkers();
+		const CLockScope LockScope(m_pShared->m_ReadLock);
+		m_pShared->m_vpReadServers.push_back(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
+		m_pShared->m_NumReadServers.store(m_pShared->m_vpReadServers.size());
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
 }
 
 void CDbConnectionPool::Execute(
@@ -146,9 +246,17 @@ void CDbConnectionPool::Execute(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	m_pShared->m_aStats[LANE_READ].OnQueued();
+	AddReadQuery(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
+}
+
+void CDbConnectionPool::ExecuteAfterWrites(
+	FRead pFunc,
+	std::unique_ptr<const ISqlData> pSqlRequestData,
+	const char *pName)
+{
+	m_pShared->m_aStats[LANE_WRITE].OnQueued();
+	AddQuery(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
 }
 
 void CDbConnectionPool::ExecuteWrite(
@@ -156,9 +264,8 @@ void CDbConnectionPool::ExecuteWrite(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	m_pShared->m_aStats[LANE_WRITE].OnQueued();
+	AddQuery(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
 }
 
 void CDbConnectionPool::OnShutdown()
@@ -168,6 +275,10 @@ void CDbConnectionPool::OnShutdown()
 	m_Shutdown = true;
 	m_pShared->m_Shutdown.store(true);
 	m_pShared->m_NumBackup.Signal();
+	// one empty query for every read worker to exit, remaining reads
+	// before it are dismissed
+	for(size_t i = 0; i < m_vpReadWorkerThreads.size(); i++)
+		AddReadQuery(nullptr);
 	int i = 0;
 	while(m_pShared->m_Shutdown.load())
 	{
@@ -181,6 +292,58 @@ void CDbConnectionPool::OnShutdown()
 	}
 }
 
+CDbConnectionPool::CLaneStats CDbConnectionPool::Stats(ELane Lane) const
+{
+	const CAtomicLaneStats &AtomicStats = m_pShared->m_aStats[Lane];
+	CLaneStats Stats;
+	Stats.m_NumQueued = AtomicStats.m_NumQueued.load();
+	Stats.m_MaxQueued = AtomicStats.m_MaxQueued.load();
+	Stats.m_NumDone = AtomicStats.m_NumDone.load();
+	Stats.m_NumFailed = AtomicStats.m_NumFailed.load();
+	for(int i = 0; i < CLaneStats::NUM_LATENCY_BUCKETS; i++)
+		Stats.m_aLatencyBuckets[i] = AtomicStats.m_aLatencyBuckets[i].load();
+	return Stats;
+}
+
+void CDbConnectionPool::PrintStats(IConsole *pConsole) const
+{
+	for(int Lane = 0; Lane < NUM_LANES; Lane++)
+	{
+		const CLaneStats Stats = this->Stats((ELane)Lane);
+		char aLane[32];
+		if(Lane == LANE_READ)
+			str_format(aLane, sizeof(aLane), "read (%d workers)", (int)m_vpReadWorkerThreads.size());
+		else
+			str_copy(aLane, "write");
+
+		char aBuf[512];
+		str_format(aBuf, sizeof(aBuf), "%s: %d queued (max %d), %" PRId64 " done, %" PRId64 " failed",
+			aLane, Stats.m_NumQueued, Stats.m_MaxQueued, Stats.m_NumDone, Stats.m_NumFailed);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "sql", aBuf);
+
+		str_format(aBuf, sizeof(aBuf), "%s latency:", aLane);
+		for(int i = 0; i < CLaneStats::NUM_LATENCY_BUCKETS; i++)
+		{
+			if(Stats.m_aLatencyBuckets[i] == 0)
+				continue;
+			char aBucket[64];
+			if(i < CLaneStats::NUM_LATENCY_BUCKETS - 1)
+				str_format(aBucket, sizeof(aBucket), " <%dms %" PRId64, 1 << i, Stats.m_aLatencyBuckets[i]);
+			else
+				str_format(aBucket, sizeof(aBucket), " >=%dms %" PRId64, 1 << (i - 1), Stats.m_aLatencyBuckets[i]);
+			str_append(aBuf, aBucket);
+		}
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "sql", aBuf);
+	}
+}
+
+static std::unique_ptr<IDbConnection> CreateConnection(const CSqlExecData *pData)
+{
+	if(pData->m_Mode == CSqlExecData::ADD_MYSQL)
+		return CreateMysqlConnection(pData->m_Ptr.m_Mysql.m_Config);
+	return CreateSqliteConnection(pData->m_Ptr.m_Sqlite.m_Filename, true);
+}
+
 // The backup worker thread looks at write queries and stores them
 // in the sqlite database (WRITE_BACKUP). It skips over read queries.
 // After processing the query, it gets passed on to the Worker thread.
@@ -240,9 +403,10 @@ void CBackup::ProcessQueries()
 	}
 }
 
-// the worker threads executes queries on mysql or sqlite. If we write on
-// a mysql server and have a backup server configured, we'll remove the
-// entry from the backup server after completing it on the write server.
+// the worker thread executes write queries, and the reads that have to see
+// them, on mysql or sqlite in the order they were added. If we write on a mysql server and have a backup server
+// configured, we'll remove the entry from the backup server after completing
+// it on the write server.
 // static void Worker(void *pUser);
 class CWorker
 {
@@ -264,8 +428,8 @@ private:
 	//                most one WRITE server. The WRITE server for all DDNet
 	//                Servers must be the same (to counteract double loads).
 	//                There may be one WRITE_BACKUP sqlite server.
+	// The READ servers are used by the read workers.
 	// This variable should only change, before the worker threads
-	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
 	std::unique_ptr<IDbConnection> m_pWriteConnection;
 	std::unique_ptr<IDbConnection> m_pWriteBackup;
 
@@ -282,10 +446,8 @@ void CWorker::Start(void *pUser)
 
 void CWorker::ProcessQueries()
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	// enter fail mode when a sql request fails, skip read request during it and
-	// write to the backup database until all requests are handled
+	// enter fail mode when a sql request fails, write to the backup database
+	// until all requests are handled
 	bool FailMode = false;
 	for(int JobNum = 0;; JobNum++)
 	{
@@ -306,32 +468,22 @@ void CWorker::ProcessQueries()
 		{
 		case CSqlExecData::READ_ACCESS:
 		{
-			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+			// the writes before it are only on the backup database in these cases
+			if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
+			{
+				dbg_msg("sql", "[%i] %s dismissed during shutdown", JobNum, pThreadData->m_pName);
+			}
+			else if(FailMode && m_pWriteBackup != nullptr)
 			{
-				if(m_pShared->m_Shutdown)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
-					break;
-				}
-				if(FailMode)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
-					break;
-				}
-				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
-				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
-				{
-					ReadServer = CurServer;
-					if(m_DebugSql)
-						dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
-				}
+				dbg_msg("sql", "[%i] %s dismissed during FailMode", JobNum, pThreadData->m_pName);
 			}
-			if(!Success)
+			else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pThreadData.get(), Write::NORMAL))
 			{
-				FailMode = true;
+				if(m_DebugSql)
+					dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
+				Success = true;
 			}
+			m_pShared->m_aStats[CDbConnectionPool::LANE_WRITE].OnDone(pThreadData.get(), Success);
 		}
 		break;
 		case CSqlExecData::WRITE_ACCESS:
@@ -359,45 +511,17 @@ void CWorker::ProcessQueries()
 					dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
 				Success = true;
 			}
+			m_pShared->m_aStats[CDbConnectionPool::LANE_WRITE].OnDone(pThreadData.get(), Success);
 		}
 		break;
 		case CSqlExecData::ADD_MYSQL:
-		{
-			auto pMysql = CreateMysqlConnection(pThreadData->m_Ptr.m_Mysql.m_Config);
-			switch(pThreadData->m_Ptr.m_Mysql.m_Mode)
-			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pMysql));
-				break;
-			case CDbConnectionPool::Mode::WRITE:
-				m_pWriteConnection = std::move(pMysql);
-				break;
-			case CDbConnectionPool::Mode::WRITE_BACKUP:
-				m_pWriteBackup = std::move(pMysql);
-				break;
-			case CDbConnectionPool::Mode::NUM_MODES:
-				break;
-			}
-			Success = true;
-			break;
-		}
 		case CSqlExecData::ADD_SQLITE:
 		{
-			auto pSqlite = CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_Filename, true);
-			switch(pThreadData->m_Ptr.m_Sqlite.m_Mode)
-			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pSqlite));
-				break;
-			case CDbConnectionPool::Mode::WRITE:
-				m_pWriteConnection = std::move(pSqlite);
-				break;
-			case CDbConnectionPool::Mode::WRITE_BACKUP:
-				m_pWriteBackup = std::move(pSqlite);
-				break;
-			case CDbConnectionPool::Mode::NUM_MODES:
-				break;
-			}
+			const CDbConnectionPool::Mode Mode = pThreadData->m_Mode == CSqlExecData::ADD_MYSQL ? pThreadData->m_Ptr.m_Mysql.m_Mode : pThreadData->m_Ptr.m_Sqlite.m_Mode;
+			if(Mode == CDbConnectionPool::Mode::WRITE)
+				m_pWriteConnection = CreateConnection(pThreadData.get());
+			else if(Mode == CDbConnectionPool::Mode::WRITE_BACKUP)
+				m_pWriteBackup = CreateConnection(pThreadData.get());
 			Success = true;
 			break;
 		}
@@ -418,14 +542,7 @@ void CWorker::ProcessQueries()
 
 void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 {
-	if(DatabaseMode == CDbConnectionPool::Mode::READ)
-	{
-		for(auto &pReadConnection : m_vpReadConnections)
-			pReadConnection->Print(pConsole, "Read");
-		if(m_vpReadConnections.empty())
-			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
-	}
-	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
+	if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
 	{
 		if(m_pWriteConnection)
 			m_pWriteConnection->Print(pConsole, "Write");
@@ -441,6 +558,132 @@ void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 	}
 }
 
+// The read workers execute read queries, each on its own connections to all
+// READ servers, so slow reads don't hold up the writes or each other.
+class CReadWorker
+{
+public:
+	CReadWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared, int Id, int DebugSql) :
+		m_Id(Id), m_DebugSql(DebugSql), m_pShared(std::move(pShared)) {}
+	static void Start(void *pUser);
+	void ProcessQueries();
+
+private:
+	void UpdateConnections();
+	void Print(IConsole *pConsole);
+
+	int m_Id;
+	bool m_DebugSql;
+
+	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+
+	std::shared_ptr<CDbConnectionPool::CSharedData> m_pShared;
+};
+
+/* static */
+void CReadWorker::Start(void *pUser)
+{
+	CReadWorker *pThis = (CReadWorker *)pUser;
+	pThis->ProcessQueries();
+	delete pThis;
+}
+
+void CReadWorker::UpdateConnections()
+{
+	if((int)m_vpReadConnections.size() == m_pShared->m_NumReadServers.load())
+		return;
+	const CLockScope LockScope(m_pShared->m_ReadLock);
+	for(size_t i = m_vpReadConnections.size(); i < m_pShared->m_vpReadServers.size(); i++)
+		m_vpReadConnections.push_back(CreateConnection(m_pShared->m_vpReadServers[i].get()));
+}
+
+void CReadWorker::ProcessQueries()
+{
+	// remember last working server and try to connect to it first
+	int ReadServer = 0;
+	// enter fail mode when a sql request fails, skip read requests during it
+	// until all queued requests are handled
+	bool FailMode = false;
+	for(int JobNum = 0;; JobNum++)
+	{
+		if(FailMode && m_pShared->m_NumRead.GetApproximateValue() == 0)
+		{
+			FailMode = false;
+		}
+		m_pShared->m_NumRead.Wait();
+		std::unique_ptr<CSqlExecData> pThreadData;
+		{
+			const CLockScope LockScope(m_pShared->m_ReadLock);
+			pThreadData = std::move(m_pShared->m_ReadQueries.front());
+			m_pShared->m_ReadQueries.pop_front();
+		}
+		// the pool adds an empty query for every read worker when shutting down
+		if(pThreadData == nullptr)
+		{
+			return;
+		}
+		UpdateConnections();
+		if(pThreadData->m_Mode == CSqlExecData::PRINT)
+		{
+			Print(pThreadData->m_Ptr.m_Print.m_pConsole);
+			continue;
+		}
+
+		bool Success = false;
+		for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+		{
+			if(m_pShared->m_Shutdown)
+			{
+				dbg_msg("sql", "[%d.%i] %s dismissed read request during shutdown", m_Id, JobNum, pThreadData->m_pName);
+				break;
+			}
+			if(FailMode)
+			{
+				dbg_msg("sql", "[%d.%i] %s dismissed read request during FailMode", m_Id, JobNum, pThreadData->m_pName);
+				break;
+			}
+			int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
+			if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+			{
+				ReadServer = CurServer;
+				if(m_DebugSql)
+					dbg_msg("sql", "[%d.%i] %s done on read database %d", m_Id, JobNum, pThreadData->m_pName, CurServer);
+				Success = true;
+				break;
+			}
+		}
+		if(!Success)
+		{
+			FailMode = true;
+			dbg_msg("sql", "[%d.%i] %s failed on all databases", m_Id, JobNum, pThreadData->m_pName);
+		}
+		m_pShared->m_aStats[CDbConnectionPool::LANE_READ].OnDone(pThreadData.get(), Success);
+		if(pThreadData->m_pThreadData->m_pResult != nullptr)
+		{
+			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
+			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
+		}
+	}
+}
+
+void CReadWorker::Print(IConsole *pConsole)
+{
+	for(auto &pReadConnection : m_vpReadConnections)
+		pReadConnection->Print(pConsole, "Read");
+	if(m_vpReadConnections.empty())
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+}
+
+void CDbConnectionPool::StartReadWorkers()
+{
+	if(m_Shutdown || !m_vpReadWorkerThreads.empty())
+		return;
+	for(int i = 0; i < g_Config.m_SvSqlReadWorkers; i++)
+	{
+		m_vpReadWorkerThreads.push_back(thread_init(CReadWorker::Start, new CReadWorker(m_pShared, i, g_Config.m_DbgSql), "database read worker thread"));
+	}
+}
+
 /* static */
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, Write w)
 {
@@ -489,4 +732,6 @@ CDbConnectionPool::~CDbConnectionPool()
 		thread_wait(m_pWorkerThread);
 	if(m_pBackupThread)
 		thread_wait(m_pBackupThread);
+	for(void *pReadWorkerThread : m_vpReadWorkerThreads)
+		thread_wait(pReadWorkerThread);
 }
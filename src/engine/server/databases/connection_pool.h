@@ -1,9 +1,10 @@
 #ifndef ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
 #define ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
 
-#include <base/tl/threading.h>
+#include <base/system.h>
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -82,10 +83,18 @@ public:
 	void RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64]);
 	void RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig);
 
+	// executed by the read workers next to the write lane, so it doesn't
+	// necessarily see the writes that were added before it
 	void Execute(
 		FRead pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
+	// executed in the write lane on the WRITE server, after all writes that
+	// were added before it
+	void ExecuteAfterWrites(
+		FRead pFunc,
+		std::unique_ptr<const ISqlData> pSqlRequestData,
+		const char *pName);
 	// writes to WRITE_BACKUP first and removes it from there when successfully
 	// executed on WRITE server
 	void ExecuteWrite(
@@ -95,40 +104,61 @@ public:
 
 	void OnShutdown();
 
+	enum ELane
+	{
+		// read queries, executed in parallel by the read workers
+		LANE_READ,
+		// write queries and reads that have to see them, executed one after
+		// another in the order they were added
+		LANE_WRITE,
+		NUM_LANES,
+	};
+
+	class CLaneStats
+	{
+	public:
+		enum
+		{
+			NUM_LATENCY_BUCKETS = 12,
+		};
+		// queries that are waiting or being executed
+		int m_NumQueued;
+		int m_MaxQueued;
+		// queries that succeeded
+		int64_t m_NumDone;
+		int64_t m_NumFailed;
+		// time from adding a query until it's done, bucket `i` counts the
+		// queries that took less than 2^i ms and weren't counted by the
+		// previous bucket, the last bucket also counts all slower ones
+		int64_t m_aLatencyBuckets[NUM_LATENCY_BUCKETS];
+	};
+
+	CLaneStats Stats(ELane Lane) const;
+	void PrintStats(IConsole *pConsole) const;
+
 	friend class CWorker;
+	friend class CReadWorker;
 	friend class CBackup;
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
 
+	void AddQuery(std::unique_ptr<struct CSqlExecData> pData);
+	void AddReadQuery(std::unique_ptr<struct CSqlExecData> pData);
+	void StartReadWorkers();
+
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
 	int m_InsertIdx = 0;
 
 	bool m_Shutdown = false;
 
-	struct CSharedData
-	{
-		// Used as signal that shutdown is in progress from main thread to
-		// speed up the queries by discarding read queries and writing to
-		// the sqlite file instead of the remote mysql server.
-		// The worker thread signals the main thread that all queries are
-		// processed by setting this variable to false again.
-		std::atomic_bool m_Shutdown{false};
-		// Queries go first to the backup thread. This semaphore signals about
-		// new queries.
-		CSemaphore m_NumBackup;
-		// When the backup thread processed the query, it signals the main
-		// thread with this semaphore about the new query
-		CSemaphore m_NumWorker;
-
-		// spsc queue with additional backup worker to look at queries first.
-		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
-	};
-
+	struct CSharedData;
 	std::shared_ptr<CSharedData> m_pShared;
 	void *m_pWorkerThread = nullptr;
 	void *m_pBackupThread = nullptr;
+	// started with the first read query or read database
+	std::vector<void *> m_vpReadWorkerThreads;
 };
 
 #endif // ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
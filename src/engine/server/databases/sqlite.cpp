@@ -7,6 +7,7 @@
 #include <sqlite3.h>
 
 #include <atomic>
+#include <limits>
 
 class CSqliteConnection : public IDbConnection
 {
@@ -143,8 +144,9 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 		return false;
 	}
 
-	// wait for database to unlock so we don't have to handle SQLITE_BUSY errors
-	sqlite3_busy_timeout(m_pDb, -1);
+	// wait for database to unlock so we don't have to handle SQLITE_BUSY errors,
+	// the write worker and the read workers use their own connections
+	sqlite3_busy_timeout(m_pDb, std::numeric_limits<int>::max());
 
 	if(m_Setup)
 	{
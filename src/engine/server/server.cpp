@@ -26,6 +26,7 @@
 #include <engine/shared/filecollection.h>
 #include <engine/shared/host_lookup.h>
 #include <engine/shared/http.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/json.h>
 #include <engine/shared/jsonwriter.h>
 #include <engine/shared/linereader.h>
@@ -236,6 +237,7 @@ CServer::CServer()
 	m_aDemoRecorder[RECORDER_AUTO] = CDemoRecorder(&m_SnapshotDelta, false);
 
 	m_pGameServer = nullptr;
+	m_pSnapshotBuilder = &m_SnapshotBuilder;
 
 	m_CurrentGameTick = MIN_TICK;
 	m_RunServer = UNINITIALIZED;
@@ -1000,6 +1002,128 @@ void CServer::SendMsgRaw(int ClientId, const void *pData, int Size, int Flags)
 	m_NetServer.Send(&Packet);
 }
 
+class CSnapshotJob : public IJob
+{
+	CServer *m_pServer;
+	CServer::CSnapshotWorker *m_pWorker;
+
+	void Run() override
+	{
+		m_pServer->FinishSnapshot(m_pWorker);
+		m_pWorker->m_Done.Signal();
+	}
+
+public:
+	CSnapshotJob(CServer *pServer, CServer::CSnapshotWorker *pWorker) :
+		m_pServer(pServer), m_pWorker(pWorker)
+	{
+		// the tick waits for all snapshots
+		SetPriority(PRIORITY_HIGH);
+	}
+};
+
+// runs on a worker thread if sv_snap_workers > 1, must only touch the state of the client of the worker
+void CServer::FinishSnapshot(CSnapshotWorker *pWorker)
+{
+	const int ClientId = pWorker->m_ClientId;
+	CClient &Client = m_aClients[ClientId];
+
+	const CSnapshot *pData = (CSnapshot *)pWorker->m_aData; // Fix compiler warning for strict-aliasing
+
+	// remove old snapshots
+	// keep 3 seconds worth of snapshots
+	Client.m_Snapshots.PurgeUntil(m_CurrentGameTick - TickSpeed() * 3);
+
+	// save the snapshot
+	Client.m_Snapshots.Add(m_CurrentGameTick, time_get(), pWorker->m_SnapshotSize, pData, 0, nullptr);
+
+	// find snapshot that we can perform delta against
+	pWorker->m_DeltaTick = -1;
+	const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
+	{
+		int DeltashotSize = Client.m_Snapshots.Get(Client.m_LastAckedSnapshot, nullptr, &pDeltashot, nullptr);
+		if(DeltashotSize >= 0)
+			pWorker->m_DeltaTick = Client.m_LastAckedSnapshot;
+		else
+		{
+			// no acked package found, force client to recover rate
+			if(Client.m_SnapRate == CClient::SNAPRATE_FULL)
+				Client.m_SnapRate = CClient::SNAPRATE_RECOVER;
+		}
+
+		// nothing changed since the acked snapshot, e.g. for idle spectators,
+		// the delta would be empty and empty snapshots are sent without crc
+		pWorker->m_Unchanged = DeltashotSize == pWorker->m_SnapshotSize && mem_comp(pDeltashot, pData, DeltashotSize) == 0;
+		if(pWorker->m_Unchanged)
+		{
+			pWorker->m_DeltaSize = 0;
+			return;
+		}
+	}
+
+	pWorker->m_Crc = pData->Crc();
+
+	// create delta
+	pWorker->m_DeltaSize = m_aClientSnapshotDeltas[Client.m_Sixup].CreateDelta(pDeltashot, pData, pWorker->m_aDeltaData);
+
+	// compress it
+	if(pWorker->m_DeltaSize)
+		pWorker->m_CompSize = CVariableInt::Compress(pWorker->m_aDeltaData, pWorker->m_DeltaSize, pWorker->m_aCompData, sizeof(pWorker->m_aCompData));
+}
+
+void CServer::SendSnapshot(CSnapshotWorker *pWorker)
+{
+	const int ClientId = pWorker->m_ClientId;
+	pWorker->m_ClientId = -1;
+
+	m_NumSnapshotsSent++;
+	if(pWorker->m_Unchanged)
+		m_NumSnapshotsUnchanged++;
+
+	if(pWorker->m_DeltaSize)
+	{
+		const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+		const int SnapshotSize = pWorker->m_CompSize;
+		int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+
+		for(int n = 0, Left = SnapshotSize; Left > 0; n++)
+		{
+			int Chunk = Left < MaxSize ? Left : MaxSize;
+			Left -= Chunk;
+
+			if(NumPackets == 1)
+			{
+				CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick - pWorker->m_DeltaTick);
+				Msg.AddInt(pWorker->m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pWorker->m_aCompData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+			}
+			else
+			{
+				CMsgPacker Msg(NETMSG_SNAP, true);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick - pWorker->m_DeltaTick);
+				Msg.AddInt(NumPackets);
+				Msg.AddInt(n);
+				Msg.AddInt(pWorker->m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pWorker->m_aCompData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+			}
+		}
+	}
+	else
+	{
+		CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+		Msg.AddInt(m_CurrentGameTick);
+		Msg.AddInt(m_CurrentGameTick - pWorker->m_DeltaTick);
+		SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+	}
+}
+
 void CServer::DoSnapshot()
 {
 	bool IsGlobalSnap = Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0;
@@ -1021,6 +1145,20 @@ void CServer::DoSnapshot()
 			m_aDemoRecorder[RECORDER_AUTO].RecordSnapshot(Tick(), aData, SnapshotSize);
 	}
 
+	// the deltas only differ in the sizes of these events, the demo recorders change them on m_SnapshotDelta
+	for(int Sixup = 0; Sixup < 2; Sixup++)
+	{
+		m_aClientSnapshotDeltas[Sixup].SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, Sixup);
+		m_aClientSnapshotDeltas[Sixup].SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, Sixup);
+	}
+
+	const size_t NumWorkers = Config()->m_SvSnapWorkers;
+	m_vpSnapshotWorkers.resize(NumWorkers);
+	for(auto &pWorker : m_vpSnapshotWorkers)
+		if(!pWorker)
+			pWorker = std::make_unique<CSnapshotWorker>();
+	size_t NextWorker = 0;
+
 	// create snapshots for all clients
 	for(int i = 0; i < MaxClients(); i++)
 	{
@@ -1040,101 +1178,56 @@ void CServer::DoSnapshot()
 		if(!IsGlobalSnap && !(m_aClients[i].m_ForceHighBandwidthOnSpectate && GameServer()->IsClientHighBandwidth(i)))
 			continue;
 
+		// the workers are used in turn, so the oldest pending snapshot is always sent first
+		CSnapshotWorker *pWorker = m_vpSnapshotWorkers[NextWorker].get();
+		NextWorker = (NextWorker + 1) % NumWorkers;
+		if(pWorker->m_ClientId != -1)
 		{
-			m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
-
-			// only snap events on global ticks
-			GameServer()->OnSnap(i, IsGlobalSnap);
-
-			// finish snapshot
-			char aData[CSnapshot::MAX_SIZE];
-			CSnapshot *pData = (CSnapshot *)aData; // Fix compiler warning for strict-aliasing
-			int SnapshotSize = m_SnapshotBuilder.Finish(pData);
-
-			if(m_aDemoRecorder[i].IsRecording())
-			{
-				// write snapshot
-				m_aDemoRecorder[i].RecordSnapshot(Tick(), aData, SnapshotSize);
-			}
-
-			int Crc = pData->Crc();
-
-			// remove old snapshots
-			// keep 3 seconds worth of snapshots
-			m_aClients[i].m_Snapshots.PurgeUntil(m_CurrentGameTick - TickSpeed() * 3);
-
-			// save the snapshot
-			m_aClients[i].m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, pData, 0, nullptr);
-
-			// find snapshot that we can perform delta against
-			int DeltaTick = -1;
-			const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
-			{
-				int DeltashotSize = m_aClients[i].m_Snapshots.Get(m_aClients[i].m_LastAckedSnapshot, nullptr, &pDeltashot, nullptr);
-				if(DeltashotSize >= 0)
-					DeltaTick = m_aClients[i].m_LastAckedSnapshot;
-				else
-				{
-					// no acked package found, force client to recover rate
-					if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
-						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
-				}
-			}
-
-			// create delta
-			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
-			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
-			char aDeltaData[CSnapshot::MAX_SIZE];
-			int DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
-
-			if(DeltaSize)
-			{
-				// compress it
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
-
-				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
-				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+			pWorker->m_Done.Wait();
+			SendSnapshot(pWorker);
+		}
 
-				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
-				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
+		// the game state is only read on the main thread
+		// extended item types are registered in the same order as with a single builder
+		pWorker->m_ClientId = i;
+		pWorker->m_Builder.CopyExtendedItemTypes(m_SnapshotBuilder);
+		pWorker->m_Builder.Init(m_aClients[i].m_Sixup);
+		m_pSnapshotBuilder = &pWorker->m_Builder;
+		// only snap events on global ticks
+		GameServer()->OnSnap(i, IsGlobalSnap);
+		m_pSnapshotBuilder = &m_SnapshotBuilder;
+		m_SnapshotBuilder.CopyExtendedItemTypes(pWorker->m_Builder);
+
+		// finish snapshot
+		pWorker->m_SnapshotSize = pWorker->m_Builder.Finish(pWorker->m_aData);
+
+		if(m_aDemoRecorder[i].IsRecording())
+		{
+			// write snapshot
+			m_aDemoRecorder[i].RecordSnapshot(Tick(), pWorker->m_aData, pWorker->m_SnapshotSize);
+		}
 
-					if(NumPackets == 1)
-					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-				}
-			}
-			else
-			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
-				Msg.AddInt(m_CurrentGameTick);
-				Msg.AddInt(m_CurrentGameTick - DeltaTick);
-				SendMsg(&Msg, MSGFLAG_FLUSH, i);
-			}
+		if(NumWorkers == 1)
+		{
+			FinishSnapshot(pWorker);
+			SendSnapshot(pWorker);
+		}
+		else
+		{
+			Engine()->AddJob(std::make_shared<CSnapshotJob>(this, pWorker));
 		}
 	}
 
+	// send the remaining snapshots in client order
+	for(size_t i = 0; i < NumWorkers; i++)
+	{
+		CSnapshotWorker *pWorker = m_vpSnapshotWorkers[(NextWorker + i) % NumWorkers].get();
+		if(pWorker->m_ClientId == -1)
+			continue;
+		pWorker->m_Done.Wait();
+		SendSnapshot(pWorker);
+	}
+
 	if(IsGlobalSnap)
 	{
 		GameServer()->OnPostGlobalSnap();
@@ -3094,6 +3187,7 @@ int CServer::Run()
 
 	if(Port == 0)
 		log_info("server", "using port %d", BindAddr.port);
+	net_udp_set_send_batching(m_NetServer.Socket(), Config()->m_SvSendBatching);
 
 #if defined(CONF_UPNP)
 	m_UPnP.Open(BindAddr);
@@ -3105,7 +3199,6 @@ int CServer::Run()
 		return -1;
 	}
 
-	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pRegister = CreateRegister(&g_Config, m_pConsole, m_pEngine, &m_Http, g_Config.m_SvRegisterPort > 0 ? g_Config.m_SvRegisterPort : this->Port(), m_NetServer.GetGlobalToken());
 
 	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
@@ -3403,6 +3496,9 @@ int CServer::Run()
 				m_ReloadedWhenEmpty = false;
 			}
 
+			// send everything queued during this iteration before sleeping
+			m_NetServer.Flush();
+
 			// wait for incoming data
 			if(NonActive && Config()->m_SvShutdownWhenEmpty)
 			{
@@ -3443,6 +3539,7 @@ int CServer::Run()
 		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
 			m_NetServer.Drop(i, pDisconnectReason);
 	}
+	m_NetServer.Flush();
 
 	m_pRegister->OnShutdown();
 	m_Econ.Shutdown();
@@ -3534,6 +3631,13 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 		}
 		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 	}
+
+	if(pThis->m_NumSnapshotsSent > 0)
+	{
+		str_format(aBuf, sizeof(aBuf), "snapshots sent=%" PRId64 " unchanged=%" PRId64 " (%.1f%%, sent without creating a delta)",
+			pThis->m_NumSnapshotsSent, pThis->m_NumSnapshotsUnchanged, 100.0 * pThis->m_NumSnapshotsUnchanged / pThis->m_NumSnapshotsSent);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
 }
 
 static int GetAuthLevel(const char *pLevel)
@@ -4071,6 +4175,12 @@ void CServer::ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+void CServer::ConDumpSqlStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pSelf = (CServer *)pUserData;
+	pSelf->DbPool()->PrintStats(pSelf->Console());
+}
+
 void CServer::ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData)
 {
 	CServer *pThis = static_cast<CServer *>(pUserData);
@@ -4345,6 +4455,7 @@ void CServer::ConchainConnLoggingServerChange(IConsole::IResult *pResult, void *
 void CServer::RegisterCommands()
 {
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pGameServer = Kernel()->RequestInterface<IGameServer>();
 	m_pMap = Kernel()->RequestInterface<IEngineMap>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
@@ -4368,6 +4479,7 @@ void CServer::RegisterCommands()
 
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
+	Console()->Register("dump_sqlstats", "", CFGFLAG_SERVER, ConDumpSqlStats, this, "dumps queue depth and latency of the read and write database queries");
 
 	Console()->Register("auth_add", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAdd, this, "Add a rcon key");
 	Console()->Register("auth_add_p", "s[ident] s[level] s[hash] s[salt]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAddHashed, this, "Add a prehashed rcon key");
@@ -4427,12 +4539,19 @@ void CServer::SnapFreeId(int Id)
 void *CServer::SnapNewItem(int Type, int Id, int Size)
 {
 	dbg_assert(Id >= -1 && Id <= 0xffff, "Invalid snap item Id: %d", Id);
-	return Id < 0 ? nullptr : m_SnapshotBuilder.NewItem(Type, Id, Size);
+	return Id < 0 ? nullptr : m_pSnapshotBuilder->NewItem(Type, Id, Size);
+}
+
+int CServer::SnapNumItems() const
+{
+	return m_pSnapshotBuilder->NumItems();
 }
 
 void CServer::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
+	for(auto &SnapshotDelta : m_aClientSnapshotDeltas)
+		SnapshotDelta.SetStaticsize(ItemType, Size);
 }
 
 CServer *CreateServer() { return new CServer(); }
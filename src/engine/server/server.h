@@ -9,6 +9,7 @@
 #include "snap_id_pool.h"
 
 #include <base/hash.h>
+#include <base/tl/threading.h>
 
 #include <engine/console.h>
 #include <engine/server.h>
@@ -213,7 +214,32 @@ public:
 	int m_aIdMap[MAX_CLIENTS * VANILLA_MAX_CLIENTS];
 
 	CSnapshotDelta m_SnapshotDelta;
+	CSnapshotDelta m_aClientSnapshotDeltas[2]; // only read while snapping clients, indexed by sixup
 	CSnapshotBuilder m_SnapshotBuilder;
+	CSnapshotBuilder *m_pSnapshotBuilder; // where SnapNewItem adds the items to
+
+	// state for finishing the snapshot of one client, see DoSnapshot
+	class CSnapshotWorker
+	{
+	public:
+		CSnapshotBuilder m_Builder;
+		CSemaphore m_Done;
+		int m_ClientId = -1;
+
+		int m_SnapshotSize;
+		bool m_Unchanged; // same as the snapshot the delta is based on, no delta had to be created
+		int m_Crc;
+		int m_DeltaTick;
+		int m_DeltaSize;
+		int m_CompSize;
+		char m_aData[CSnapshot::MAX_SIZE];
+		char m_aDeltaData[CSnapshot::MAX_SIZE];
+		char m_aCompData[CSnapshot::MAX_SIZE];
+	};
+	std::vector<std::unique_ptr<CSnapshotWorker>> m_vpSnapshotWorkers;
+	// since the server started, shown by the status command
+	int64_t m_NumSnapshotsSent = 0;
+	int64_t m_NumSnapshotsUnchanged = 0;
 	CSnapIdPool m_IdPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
@@ -334,6 +360,8 @@ public:
 	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientId) override;
 
 	void DoSnapshot();
+	void FinishSnapshot(CSnapshotWorker *pWorker);
+	void SendSnapshot(CSnapshotWorker *pWorker);
 
 	static int NewClientCallback(int ClientId, void *pUser, bool Sixup);
 	static int NewClientNoAuthCallback(int ClientId, void *pUser);
@@ -448,6 +476,7 @@ public:
 	// console commands for sqlmasters
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData);
+	static void ConDumpSqlStats(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConReloadAnnouncement(IConsole::IResult *pResult, void *pUserData);
 	static void ConReloadMaplist(IConsole::IResult *pResult, void *pUserData);
@@ -480,6 +509,7 @@ public:
 	int SnapNewId() override;
 	void SnapFreeId(int Id) override;
 	void *SnapNewItem(int Type, int Id, int Size) override;
+	int SnapNumItems() const override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
 
 	// DDRace
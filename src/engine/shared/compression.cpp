@@ -4,8 +4,17 @@
 
 #include <base/system.h>
 
+#include <bit>
 #include <iterator> // std::size
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CONF_COMPRESSION_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CONF_COMPRESSION_NEON 1
+#endif
+
 // Format: ESDDDDDD EDDDDDDD EDD... Extended, Data, Sign
 unsigned char *CVariableInt::Pack(unsigned char *pDst, int i, int DstSize)
 {
@@ -65,6 +74,91 @@ const unsigned char *CVariableInt::Unpack(const unsigned char *pSrc, int *pInOut
 	return pSrc;
 }
 
+// Most values in snapshot deltas fit into a single byte. The vectorized
+// loops below handle 16 of those at a time and leave every other value
+// to Pack and Unpack, so the output is always identical to theirs.
+
+#if defined(CONF_COMPRESSION_SSE2) || defined(CONF_COMPRESSION_NEON)
+// returns the number of leading bytes that are complete packed ints,
+// after storing them unpacked to pDst
+static int UnpackSingleBytes16(const unsigned char *pSrc, int *pDst)
+{
+#if defined(CONF_COMPRESSION_SSE2)
+	const __m128i Bytes = _mm_loadu_si128((const __m128i *)pSrc);
+	const unsigned Extended = _mm_movemask_epi8(Bytes);
+	const __m128i Sign = _mm_cmpeq_epi8(_mm_and_si128(Bytes, _mm_set1_epi8(0x40)), _mm_set1_epi8(0x40));
+	const __m128i Values = _mm_xor_si128(_mm_and_si128(Bytes, _mm_set1_epi8(0x3F)), Sign);
+	const __m128i Low = _mm_unpacklo_epi8(Values, Sign);
+	const __m128i High = _mm_unpackhi_epi8(Values, Sign);
+	const __m128i LowSign = _mm_srai_epi16(Low, 15);
+	const __m128i HighSign = _mm_srai_epi16(High, 15);
+	_mm_storeu_si128((__m128i *)pDst, _mm_unpacklo_epi16(Low, LowSign));
+	_mm_storeu_si128((__m128i *)(pDst + 4), _mm_unpackhi_epi16(Low, LowSign));
+	_mm_storeu_si128((__m128i *)(pDst + 8), _mm_unpacklo_epi16(High, HighSign));
+	_mm_storeu_si128((__m128i *)(pDst + 12), _mm_unpackhi_epi16(High, HighSign));
+	return Extended ? std::countr_zero(Extended) : 16;
+#else
+	const uint8x16_t Bytes = vld1q_u8(pSrc);
+	const uint8x16_t Extended = vcltzq_s8(vreinterpretq_s8_u8(Bytes));
+	const uint64_t ExtendedNibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Extended), 4)), 0);
+	const int8x16_t Sign = vreinterpretq_s8_u8(vtstq_u8(Bytes, vdupq_n_u8(0x40)));
+	const int8x16_t Values = veorq_s8(vreinterpretq_s8_u8(vandq_u8(Bytes, vdupq_n_u8(0x3F))), Sign);
+	const int16x8_t Low = vmovl_s8(vget_low_s8(Values));
+	const int16x8_t High = vmovl_s8(vget_high_s8(Values));
+	vst1q_s32(pDst, vmovl_s16(vget_low_s16(Low)));
+	vst1q_s32(pDst + 4, vmovl_s16(vget_high_s16(Low)));
+	vst1q_s32(pDst + 8, vmovl_s16(vget_low_s16(High)));
+	vst1q_s32(pDst + 12, vmovl_s16(vget_high_s16(High)));
+	return ExtendedNibbles ? std::countr_zero(ExtendedNibbles) / 4 : 16;
+#endif
+}
+
+// returns the number of leading ints that pack into a single byte,
+// after storing them packed to pDst
+static int PackSingleBytes16(const int *pSrc, unsigned char *pDst)
+{
+#if defined(CONF_COMPRESSION_SSE2)
+	__m128i aBytes[4];
+	__m128i aMultiple[4];
+	for(int i = 0; i < 4; i++)
+	{
+		const __m128i Value = _mm_loadu_si128((const __m128i *)(pSrc + i * 4));
+		const __m128i Sign = _mm_srai_epi32(Value, 31);
+		const __m128i Magnitude = _mm_xor_si128(Value, Sign);
+		aBytes[i] = _mm_or_si128(Magnitude, _mm_and_si128(Sign, _mm_set1_epi32(0x40)));
+		aMultiple[i] = _mm_cmpgt_epi32(Magnitude, _mm_set1_epi32(0x3F));
+	}
+	const __m128i Bytes = _mm_packs_epi16(_mm_packs_epi32(aBytes[0], aBytes[1]), _mm_packs_epi32(aBytes[2], aBytes[3]));
+	const unsigned Multiple = _mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(aMultiple[0], aMultiple[1]), _mm_packs_epi32(aMultiple[2], aMultiple[3])));
+	_mm_storeu_si128((__m128i *)pDst, Bytes);
+	return Multiple ? std::countr_zero(Multiple) : 16;
+#else
+	int16x8_t aBytes[2];
+	int16x8_t aMultiple[2];
+	for(int i = 0; i < 2; i++)
+	{
+		int32x4_t aHalfBytes[2];
+		uint32x4_t aHalfMultiple[2];
+		for(int j = 0; j < 2; j++)
+		{
+			const int32x4_t Value = vld1q_s32(pSrc + i * 8 + j * 4);
+			const int32x4_t Sign = vshrq_n_s32(Value, 31);
+			const int32x4_t Magnitude = veorq_s32(Value, Sign);
+			aHalfBytes[j] = vorrq_s32(Magnitude, vandq_s32(Sign, vdupq_n_s32(0x40)));
+			aHalfMultiple[j] = vcgtq_s32(Magnitude, vdupq_n_s32(0x3F));
+		}
+		aBytes[i] = vcombine_s16(vmovn_s32(aHalfBytes[0]), vmovn_s32(aHalfBytes[1]));
+		aMultiple[i] = vreinterpretq_s16_u16(vcombine_u16(vmovn_u32(aHalfMultiple[0]), vmovn_u32(aHalfMultiple[1])));
+	}
+	const int8x16_t Bytes = vcombine_s8(vmovn_s16(aBytes[0]), vmovn_s16(aBytes[1]));
+	const int8x16_t Multiple = vcombine_s8(vmovn_s16(aMultiple[0]), vmovn_s16(aMultiple[1]));
+	const uint64_t MultipleNibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_s8(Multiple), 4)), 0);
+	vst1q_s8((int8_t *)pDst, Bytes);
+	return MultipleNibbles ? std::countr_zero(MultipleNibbles) / 4 : 16;
+#endif
+}
+#endif
+
 long CVariableInt::Decompress(const void *pSrc, int SrcSize, void *pDst, int DstSize)
 {
 	dbg_assert(DstSize % sizeof(int) == 0, "invalid bounds");
@@ -73,6 +167,23 @@ long CVariableInt::Decompress(const void *pSrc, int SrcSize, void *pDst, int Dst
 	const unsigned char *pCharSrcEnd = pCharSrc + SrcSize;
 	int *pIntDst = (int *)pDst;
 	const int *pIntDstEnd = pIntDst + DstSize / sizeof(int); // NOLINT(bugprone-sizeof-expression)
+#if defined(CONF_COMPRESSION_SSE2) || defined(CONF_COMPRESSION_NEON)
+	while(pCharSrcEnd - pCharSrc >= 16 && pIntDstEnd - pIntDst >= 16)
+	{
+		const unsigned char *pBlockEnd = pCharSrc + 16;
+		const int Num = UnpackSingleBytes16(pCharSrc, pIntDst);
+		pCharSrc += Num;
+		pIntDst += Num;
+		// unpack the rest of the block one by one
+		while(pCharSrc < pBlockEnd)
+		{
+			pCharSrc = CVariableInt::Unpack(pCharSrc, pIntDst, pCharSrcEnd - pCharSrc);
+			if(!pCharSrc)
+				return -1;
+			pIntDst++;
+		}
+	}
+#endif
 	while(pCharSrc < pCharSrcEnd)
 	{
 		if(pIntDst >= pIntDstEnd)
@@ -93,6 +204,22 @@ long CVariableInt::Compress(const void *pSrc, int SrcSize, void *pDst, int DstSi
 	unsigned char *pCharDst = (unsigned char *)pDst;
 	const unsigned char *pCharDstEnd = pCharDst + DstSize;
 	SrcSize /= sizeof(int);
+#if defined(CONF_COMPRESSION_SSE2) || defined(CONF_COMPRESSION_NEON)
+	while(SrcSize >= 16 && pCharDstEnd - pCharDst >= 16)
+	{
+		const int Num = PackSingleBytes16(pIntSrc, pCharDst);
+		pCharDst += Num;
+		// pack the rest of the block one by one
+		for(int i = Num; i < 16; i++)
+		{
+			pCharDst = CVariableInt::Pack(pCharDst, pIntSrc[i], pCharDstEnd - pCharDst);
+			if(!pCharDst)
+				return -1;
+		}
+		pIntSrc += 16;
+		SrcSize -= 16;
+	}
+#endif
 	while(SrcSize)
 	{
 		pCharDst = CVariableInt::Pack(pCharDst, *pIntSrc, pCharDstEnd - pCharDst);
@@ -570,11 +570,25 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bo
 				if(Stroke || IsStrokeCommand)
 				{
 					bool IsColor = false;
+					FCommandCallback pfnVariableCallback = nullptr;
+					void *pVariableUserData = nullptr;
+					const SConfigVariable *pVariable = nullptr;
 					{
 						FCommandCallback pfnCallback = pCommand->m_pfnCallback;
 						void *pUserData = pCommand->m_pUserData;
 						TraverseChain(&pfnCallback, &pUserData);
 						IsColor = pfnCallback == &SColorConfigVariable::CommandCallback;
+						if(pfnCallback == &SIntConfigVariable::CommandCallback)
+							pVariable = static_cast<SIntConfigVariable *>(pUserData);
+						else if(IsColor)
+							pVariable = static_cast<SColorConfigVariable *>(pUserData);
+						else if(pfnCallback == &SStringConfigVariable::CommandCallback)
+							pVariable = static_cast<SStringConfigVariable *>(pUserData);
+						if(pVariable)
+						{
+							pfnVariableCallback = pfnCallback;
+							pVariableUserData = pUserData;
+						}
 					}
 
 					if(int Error = ParseArgs(&Result, pCommand->m_pParams, IsColor))
@@ -618,6 +632,12 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bo
 								pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
 							}
 						}
+						else if(m_BatchDepth > 0 && pVariable && pCommand->m_pfnCallback == Con_Chain && Result.NumArguments() > 0)
+						{
+							// assign the value right away, the chain only runs once when the batch ends
+							BatchVariable(pCommand, pVariable, ClientId);
+							pfnVariableCallback(&Result, pVariableUserData);
+						}
 						else
 						{
 							pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
@@ -679,11 +699,15 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 	return Index;
 }
 
-CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
+CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask, std::optional<bool> Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	const auto Bucket = m_CommandIndex.find(CommandNameHash(pName));
+	if(Bucket == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : Bucket->second)
 	{
-		if(pCommand->m_Flags & FlagMask)
+		if(pCommand->m_Flags & FlagMask && (!Temp.has_value() || pCommand->m_Temp == Temp.value()))
 		{
 			if(str_comp_nocase(pCommand->m_pName, pName) == 0)
 				return pCommand;
@@ -754,6 +778,62 @@ bool CConsole::ExecuteFile(const char *pFilename, int ClientId, bool LogFailure,
 	return Success;
 }
 
+void CConsole::BeginBatch()
+{
+	m_BatchDepth++;
+}
+
+void CConsole::EndBatch()
+{
+	dbg_assert(m_BatchDepth > 0, "No batch of commands started");
+	m_BatchDepth--;
+	if(m_BatchDepth > 0)
+		return;
+
+	std::vector<CBatchedVariable> vBatchedVariables = std::move(m_vBatchedVariables);
+	m_vBatchedVariables.clear();
+	for(const CBatchedVariable &Batched : vBatchedVariables)
+	{
+		// the chain sees the change from the value before the batch to the current one
+		char aAssignment[2048];
+		Batched.m_pVariable->Serialize(aAssignment, sizeof(aAssignment));
+		ExecuteAssignment(Batched.m_pCommand, Batched.m_OldAssignment.c_str(), Batched.m_ClientId, false);
+		ExecuteAssignment(Batched.m_pCommand, aAssignment, Batched.m_ClientId, true);
+	}
+}
+
+void CConsole::BatchVariable(CCommand *pCommand, const SConfigVariable *pVariable, int ClientId)
+{
+	auto It = std::find_if(m_vBatchedVariables.begin(), m_vBatchedVariables.end(), [pCommand](const CBatchedVariable &Batched) {
+		return Batched.m_pCommand == pCommand;
+	});
+	if(It != m_vBatchedVariables.end())
+	{
+		std::rotate(It, It + 1, m_vBatchedVariables.end());
+		m_vBatchedVariables.back().m_ClientId = ClientId;
+		return;
+	}
+
+	char aOldAssignment[2048];
+	pVariable->Serialize(aOldAssignment, sizeof(aOldAssignment));
+	m_vBatchedVariables.push_back({pCommand, pVariable, ClientId, aOldAssignment});
+}
+
+void CConsole::ExecuteAssignment(CCommand *pCommand, const char *pAssignment, int ClientId, bool Chained)
+{
+	FCommandCallback pfnCallback = pCommand->m_pfnCallback;
+	void *pUserData = pCommand->m_pUserData;
+	TraverseChain(&pfnCallback, &pUserData);
+	CResult Result(ClientId);
+	if(ParseStart(&Result, pAssignment, str_length(pAssignment) + 1) != 0 ||
+		ParseArgs(&Result, pCommand->m_pParams, pfnCallback == &SColorConfigVariable::CommandCallback) != 0)
+		return;
+	if(Chained)
+		pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
+	else
+		pfnCallback(&Result, pUserData);
+}
+
 void CConsole::Con_Echo(IResult *pResult, void *pUserData)
 {
 	((CConsole *)pUserData)->Print(IConsole::OUTPUT_LEVEL_STANDARD, "console", pResult->GetString(0));
@@ -942,14 +1022,32 @@ void CConsole::ParseArguments(int NumArgs, const char **ppArguments)
 	}
 }
 
+unsigned CConsole::CommandNameHash(const char *pName)
+{
+	// same as str_quickhash, but case-insensitive like str_comp_nocase
+	unsigned Hash = 5381;
+	for(; *pName; pName++)
+	{
+		char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		Hash = ((Hash << 5) + Hash) + c;
+	}
+	return Hash;
+}
+
 void CConsole::AddCommandSorted(CCommand *pCommand)
 {
+	// keep the same order in the index as in the list, so lookups find the same command
+	std::vector<CCommand *> &vpBucket = m_CommandIndex[CommandNameHash(pCommand->m_pName)];
+	vpBucket.insert(std::find_if(vpBucket.begin(), vpBucket.end(), [pCommand](const CCommand *pOther) {
+		return str_comp(pCommand->m_pName, pOther->m_pName) <= 0;
+	}),
+		pCommand);
+
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
-		if(m_pFirstCommand && m_pFirstCommand->Next())
-			pCommand->SetNext(m_pFirstCommand);
-		else
-			pCommand->SetNext(nullptr);
+		pCommand->SetNext(m_pFirstCommand);
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -1027,6 +1125,16 @@ void CConsole::RegisterTemp(const char *pName, const char *pParams, int Flags, c
 	AddCommandSorted(pCommand);
 }
 
+void CConsole::RemoveCommandIndex(CCommand *pCommand)
+{
+	const auto Bucket = m_CommandIndex.find(CommandNameHash(pCommand->m_pName));
+	dbg_assert(Bucket != m_CommandIndex.end(), "Command '%s' is not indexed", pCommand->m_pName);
+	std::vector<CCommand *> &vpBucket = Bucket->second;
+	vpBucket.erase(std::find(vpBucket.begin(), vpBucket.end(), pCommand));
+	if(vpBucket.empty())
+		m_CommandIndex.erase(Bucket);
+}
+
 void CConsole::DeregisterTemp(const char *pName)
 {
 	if(!m_pFirstCommand)
@@ -1054,6 +1162,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandIndex(pRemoved);
 		pRemoved->SetNext(m_pRecycleList);
 		m_pRecycleList = pRemoved;
 	}
@@ -1061,6 +1170,16 @@ void CConsole::DeregisterTemp(const char *pName)
 
 void CConsole::DeregisterTempAll()
 {
+	for(auto Bucket = m_CommandIndex.begin(); Bucket != m_CommandIndex.end();)
+	{
+		std::vector<CCommand *> &vpBucket = Bucket->second;
+		vpBucket.erase(std::remove_if(vpBucket.begin(), vpBucket.end(), [](const CCommand *pCommand) { return pCommand->m_Temp; }), vpBucket.end());
+		if(vpBucket.empty())
+			Bucket = m_CommandIndex.erase(Bucket);
+		else
+			++Bucket;
+	}
+
 	// set non temp as first one
 	for(; m_pFirstCommand && m_pFirstCommand->m_Temp; m_pFirstCommand = m_pFirstCommand->Next())
 		;
@@ -1127,16 +1246,7 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::ICommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
-	{
-		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
-		{
-			if(str_comp_nocase(pCommand->Name(), pName) == 0)
-				return pCommand;
-		}
-	}
-
-	return nullptr;
+	return FindCommand(pName, FlagMask, Temp);
 }
 
 std::unique_ptr<IConsole> CreateConsole(int FlagMask) { return std::make_unique<CConsole>(FlagMask); }
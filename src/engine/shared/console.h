@@ -9,8 +9,12 @@
 #include <engine/storage.h>
 
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+struct SConfigVariable;
+
 class CConsole : public IConsole
 {
 	class CCommand : public ICommandInfo
@@ -52,6 +56,8 @@ class CConsole : public IConsole
 	bool m_StoreCommands;
 	const char *m_apStrokeStr[2];
 	CCommand *m_pFirstCommand;
+	// commands by case-insensitive hash of their name, in the same order as in the list
+	std::unordered_map<unsigned, std::vector<CCommand *>> m_CommandIndex;
 
 	class CExecFile
 	{
@@ -162,8 +168,25 @@ class CConsole : public IConsole
 	};
 	std::vector<CExecutionQueueEntry> m_vExecutionQueue;
 
+	class CBatchedVariable
+	{
+	public:
+		CCommand *m_pCommand;
+		const SConfigVariable *m_pVariable;
+		int m_ClientId;
+		// assignment of the value from before the batch
+		std::string m_OldAssignment;
+	};
+	int m_BatchDepth = 0;
+	// chained config variables assigned during the batch, in the order of their last assignment
+	std::vector<CBatchedVariable> m_vBatchedVariables;
+	void BatchVariable(CCommand *pCommand, const SConfigVariable *pVariable, int ClientId);
+	void ExecuteAssignment(CCommand *pCommand, const char *pAssignment, int ClientId, bool Chained);
+
+	static unsigned CommandNameHash(const char *pName);
 	void AddCommandSorted(CCommand *pCommand);
-	CCommand *FindCommand(const char *pName, int FlagMask);
+	void RemoveCommandIndex(CCommand *pCommand);
+	CCommand *FindCommand(const char *pName, int FlagMask, std::optional<bool> Temp = std::nullopt);
 
 	bool m_Cheated;
 
@@ -189,6 +212,8 @@ public:
 	void ExecuteLine(const char *pStr, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED, bool InterpretSemicolons = true) override;
 	void ExecuteLineFlag(const char *pStr, int FlagMask, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED, bool InterpretSemicolons = true) override;
 	bool ExecuteFile(const char *pFilename, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED, bool LogFailure = false, int StorageType = IStorage::TYPE_ALL) override;
+	void BeginBatch() override;
+	void EndBatch() override;
 
 	void Print(int Level, const char *pFrom, const char *pStr, ColorRGBA PrintColor = gs_ConsoleDefaultColor) const override;
 	void SetTeeHistorianCommandCallback(FTeeHistorianCommandCallback pfnCallback, void *pUser) override;
@@ -9,13 +9,20 @@
 #include <base/log.h>
 #include <base/math.h>
 #include <base/system.h>
+#include <base/tl/threading.h>
 
+#include <engine/engine.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <functional>
 #include <limits>
+#include <thread>
 #include <unordered_set>
 
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
@@ -130,6 +137,13 @@ class CDatafile
 public:
 	IOHANDLE m_File;
 	unsigned m_FileSize;
+	char *m_pMapping; // the whole file if it was opened with MapFile, otherwise nullptr
+	IStorage *m_pStorage;
+	char m_aPath[IO_MAX_PATH_LENGTH];
+	IO_FILE_INFO m_FileInfo;
+	bool m_HasFileInfo;
+	bool m_HashesCalculated;
+	bool m_HashesValid;
 	SHA256_DIGEST m_Sha256;
 	unsigned m_Crc;
 	CDatafileInfo m_Info;
@@ -139,6 +153,80 @@ public:
 	int *m_pDataSizes;
 	char *m_pData;
 
+	bool IsMapped(const void *pData) const
+	{
+		return m_pMapping != nullptr && pData >= m_pMapping && pData < m_pMapping + m_FileSize;
+	}
+
+	void FreeData(int Index)
+	{
+		if(!IsMapped(m_ppDataPtrs[Index]))
+		{
+			free(m_ppDataPtrs[Index]);
+		}
+		m_ppDataPtrs[Index] = nullptr;
+	}
+
+	// reading the whole file is only needed if the hashes are actually used and not cached
+	bool CalculateHashes()
+	{
+		if(m_HashesCalculated)
+		{
+			return m_HashesValid;
+		}
+		m_HashesCalculated = true;
+		m_HashesValid = false;
+		if(m_HasFileInfo && m_pStorage->FindDigest(m_aPath, m_FileInfo, &m_Sha256, &m_Crc))
+		{
+			m_HashesValid = true;
+			return true;
+		}
+
+		SHA256_CTX Sha256Ctxt;
+		sha256_init(&Sha256Ctxt);
+		m_Crc = 0;
+		unsigned char aBuffer[64 * 1024];
+		int64_t Hashed = 0;
+		if(m_pMapping == nullptr && io_seek(m_File, 0, IOSEEK_START) != 0)
+		{
+			log_error("datafile", "could not seek to start to calculate hashes");
+			return false;
+		}
+		while(Hashed < m_FileSize)
+		{
+			const unsigned char *pBytes = aBuffer;
+			unsigned Bytes;
+			if(m_pMapping != nullptr)
+			{
+				// feed both hashes the same chunk while it is still in cache
+				pBytes = reinterpret_cast<unsigned char *>(m_pMapping) + Hashed;
+				Bytes = minimum<int64_t>(sizeof(aBuffer), m_FileSize - Hashed);
+			}
+			else
+			{
+				Bytes = io_read(m_File, aBuffer, sizeof(aBuffer));
+			}
+			if(Bytes == 0)
+				break;
+			Hashed += Bytes;
+			m_Crc = crc32(m_Crc, pBytes, Bytes);
+			sha256_update(&Sha256Ctxt, pBytes, Bytes);
+		}
+		m_Sha256 = sha256_finish(&Sha256Ctxt);
+		if(Hashed != m_FileSize)
+		{
+			// the hashes of a part of the file must neither be used nor cached
+			log_error("datafile", "truncation error. could not read file to calculate hashes. wanted=%u got=%" PRId64, m_FileSize, Hashed);
+			return false;
+		}
+		m_HashesValid = true;
+		if(m_HasFileInfo)
+		{
+			m_pStorage->AddDigest(m_aPath, m_FileInfo, m_Sha256, m_Crc);
+		}
+		return true;
+	}
+
 	int GetFileDataSize(int Index) const
 	{
 		dbg_assert(Index >= 0 && Index < m_Header.m_NumRawData, "Invalid Index: %d", Index);
@@ -213,41 +301,51 @@ public:
 				return nullptr;
 			}
 
-			// read the compressed data
-			void *pCompressedData = malloc(DataSize);
-			if(pCompressedData == nullptr)
+			// read the compressed data, mapped files are uncompressed in place
+			void *pCompressedData = nullptr;
+			void *pReadData = nullptr;
+			if(m_pMapping != nullptr)
 			{
-				log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
+				pCompressedData = m_pMapping + m_DataStartOffset + m_Info.m_pDataOffsets[Index];
 			}
-			unsigned ActualDataSize = 0;
-			if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
-			{
-				ActualDataSize = io_read(m_File, pCompressedData, DataSize);
-			}
-			if(DataSize != ActualDataSize)
+			else
 			{
-				log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
-				free(pCompressedData);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
+				pReadData = malloc(DataSize);
+				if(pReadData == nullptr)
+				{
+					log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
+				unsigned ActualDataSize = 0;
+				if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
+				{
+					ActualDataSize = io_read(m_File, pReadData, DataSize);
+				}
+				if(DataSize != ActualDataSize)
+				{
+					log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
+					free(pReadData);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
+				pCompressedData = pReadData;
 			}
 
 			// decompress the data
 			m_ppDataPtrs[Index] = static_cast<char *>(malloc(OriginalUncompressedSize));
 			if(m_ppDataPtrs[Index] == nullptr)
 			{
-				free(pCompressedData);
+				free(pReadData);
 				log_error("datafile", "out of memory. could not allocate memory for uncompressed data. index=%d size=%d", Index, OriginalUncompressedSize);
 				m_pDataSizes[Index] = -1;
 				return nullptr;
 			}
 			unsigned long UncompressedSize = OriginalUncompressedSize;
 			const int Result = uncompress(static_cast<Bytef *>(m_ppDataPtrs[Index]), &UncompressedSize, static_cast<Bytef *>(pCompressedData), DataSize);
-			free(pCompressedData);
+			free(pReadData);
 			if(Result != Z_OK || UncompressedSize != OriginalUncompressedSize)
 			{
 				log_error("datafile", "failed to uncompress data. index=%d result=%d wanted=%d got=%ld", Index, Result, OriginalUncompressedSize, UncompressedSize);
@@ -258,6 +356,13 @@ public:
 			}
 			m_pDataSizes[Index] = OriginalUncompressedSize;
 		}
+		else if(m_pMapping != nullptr)
+		{
+			// v3 data is used directly from mapped files
+			log_trace("datafile", "mapping data. index=%d size=%d", Index, DataSize);
+			m_ppDataPtrs[Index] = m_pMapping + m_DataStartOffset + m_Info.m_pDataOffsets[Index];
+			m_pDataSizes[Index] = DataSize;
+		}
 		else
 		{
 			log_trace("datafile", "loading data. index=%d size=%d", Index, DataSize);
@@ -430,6 +535,90 @@ public:
 	}
 };
 
+// shared by the jobs of one RunParallel call, jobs that only start
+// after all work was claimed return without running any of it
+class CParallelWork
+{
+public:
+	std::function<void(size_t)> m_Work;
+	size_t m_Num;
+	std::atomic<size_t> m_Next = 0;
+	std::atomic<size_t> m_NumDone = 0;
+	CSemaphore m_Done;
+
+	void Run()
+	{
+		while(true)
+		{
+			const size_t Next = m_Next.fetch_add(1);
+			if(Next >= m_Num)
+			{
+				return;
+			}
+			m_Work(Next);
+			if(m_NumDone.fetch_add(1) + 1 == m_Num)
+			{
+				m_Done.Signal();
+			}
+		}
+	}
+};
+
+class CParallelWorkJob : public IJob
+{
+	std::shared_ptr<CParallelWork> m_pWork;
+
+	void Run() override
+	{
+		m_pWork->Run();
+	}
+
+public:
+	CParallelWorkJob(std::shared_ptr<CParallelWork> pWork) :
+		m_pWork(std::move(pWork))
+	{
+		// the calling thread waits for the work
+		SetPriority(PRIORITY_HIGH);
+	}
+};
+
+// Calls Work for every index from 0 to Num - 1 on the job pool of the engine,
+// or on a temporary job pool without an engine. The calling thread helps out
+// instead of blocking, in case all workers are busy or this runs in a job itself.
+static void RunParallel(IEngine *pEngine, size_t Num, std::function<void(size_t)> &&Work)
+{
+	if(Num == 0)
+	{
+		return;
+	}
+
+	std::shared_ptr<CParallelWork> pWork = std::make_shared<CParallelWork>();
+	pWork->m_Work = std::move(Work);
+	pWork->m_Num = Num;
+
+	const size_t NumJobs = std::min<size_t>(Num - 1, maximum(std::thread::hardware_concurrency(), 2u) - 1);
+	std::unique_ptr<CJobPool> pJobPool;
+	if(pEngine == nullptr && NumJobs > 0)
+	{
+		pJobPool = std::make_unique<CJobPool>();
+		pJobPool->Init(NumJobs);
+	}
+	for(size_t i = 0; i < NumJobs; i++)
+	{
+		if(pJobPool)
+			pJobPool->Add(std::make_shared<CParallelWorkJob>(pWork));
+		else
+			pEngine->AddJob(std::make_shared<CParallelWorkJob>(pWork));
+	}
+
+	pWork->Run();
+	pWork->m_Done.Wait();
+	if(pJobPool)
+	{
+		pJobPool->Shutdown();
+	}
+}
+
 CDataFileReader::~CDataFileReader()
 {
 	Close();
@@ -442,50 +631,56 @@ CDataFileReader &CDataFileReader::operator=(CDataFileReader &&Other)
 	return *this;
 }
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool MapFile)
 {
 	dbg_assert(m_pDataFile == nullptr, "File already open");
 
 	log_trace("datafile", "loading '%s'", pFilename);
 
-	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	char aPath[IO_MAX_PATH_LENGTH];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aPath, sizeof(aPath));
 	if(!File)
 	{
 		log_error("datafile", "failed to open file '%s' for reading", pFilename);
 		return false;
 	}
 
-	// determine size and hashes of the file and store them
-	int64_t FileSize = 0;
-	unsigned Crc = 0;
-	SHA256_DIGEST Sha256;
+	// map the whole file if requested, hashes, items and data are then read from the mapping
+	char *pMapping = nullptr;
+	int64_t MappingSize = 0;
+	if(MapFile)
 	{
-		SHA256_CTX Sha256Ctxt;
-		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[64 * 1024];
-		while(true)
+		MappingSize = io_length(File);
+		pMapping = static_cast<char *>(io_map(File, MappingSize));
+		if(pMapping == nullptr)
 		{
-			const unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
-			if(Bytes == 0)
-				break;
-			FileSize += Bytes;
-			Crc = crc32(Crc, aBuffer, Bytes);
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
-		}
-		Sha256 = sha256_finish(&Sha256Ctxt);
-		if(io_seek(File, 0, IOSEEK_START) != 0)
-		{
-			io_close(File);
-			log_error("datafile", "could not seek to start after calculating hashes");
-			return false;
+			log_warn("datafile", "could not map file, reading it instead. size=%" PRId64, MappingSize);
+			MappingSize = 0;
 		}
 	}
+	const auto &&CloseFile = [&]() {
+		io_unmap(pMapping, MappingSize);
+		io_close(File);
+	};
+
+	// determine size of the file, the hashes are calculated when they are first used
+	const int64_t FileSize = pMapping != nullptr ? MappingSize : io_length(File);
+	if(FileSize < 0)
+	{
+		CloseFile();
+		log_error("datafile", "could not determine size of file");
+		return false;
+	}
 
 	// read header
 	CDatafileHeader Header;
-	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header))
+	if(pMapping != nullptr && FileSize >= (int64_t)sizeof(Header))
 	{
-		io_close(File);
+		mem_copy(&Header, pMapping, sizeof(Header));
+	}
+	else if(pMapping != nullptr || io_read(File, &Header, sizeof(Header)) != sizeof(Header))
+	{
+		CloseFile();
 		log_error("datafile", "could not read file header. file truncated or not a datafile.");
 		return false;
 	}
@@ -494,7 +689,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if((Header.m_aId[0] != 'A' || Header.m_aId[1] != 'T' || Header.m_aId[2] != 'A' || Header.m_aId[3] != 'D') &&
 		(Header.m_aId[0] != 'D' || Header.m_aId[1] != 'A' || Header.m_aId[2] != 'T' || Header.m_aId[3] != 'A'))
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "wrong header magic. magic=%x%x%x%x", Header.m_aId[0], Header.m_aId[1], Header.m_aId[2], Header.m_aId[3]);
 		return false;
 	}
@@ -504,7 +699,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	// check header version
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "unsupported header version. version=%d", Header.m_Version);
 		return false;
 	}
@@ -518,7 +713,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Header.m_ItemSize % sizeof(int) != 0 ||
 		Header.m_DataSize < 0)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header information. num_types=%d num_items=%d num_data=%d item_size=%d data_size=%d",
 			Header.m_NumItemTypes, Header.m_NumItems, Header.m_NumRawData, Header.m_ItemSize, Header.m_DataSize);
 		return false;
@@ -544,7 +739,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if((int64_t)sizeof(Header) + Size + (int64_t)Header.m_DataSize != FileSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header data size or truncated file. data_size=%d file_size=%" PRId64, Header.m_DataSize, FileSize);
 		return false;
 	}
@@ -559,7 +754,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header size or truncated file. size=%" PRId64 " actual=%" PRId64, HeaderFileSize, FileSize);
 			return false;
 		}
@@ -576,20 +771,20 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header swaplen or truncated file. swaplen=%" PRId64 " actual=%" PRId64, HeaderSwaplen, FileSizeSwaplen);
 			return false;
 		}
 	}
 
 	constexpr int64_t MaxAllocSize = (int64_t)2 * 1024 * 1024 * 1024;
-	int64_t AllocSize = Size;
+	int64_t AllocSize = pMapping != nullptr ? 0 : Size; // mapped files don't need a copy of the item data
 	AllocSize += sizeof(CDatafile); // add space for info structure
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(void *); // add space for data pointers
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(int); // add space for data sizes
 	if(AllocSize > MaxAllocSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "file too large. alloc_size=%" PRId64 " max=%" PRId64, AllocSize, MaxAllocSize);
 		return false;
 	}
@@ -597,7 +792,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	CDatafile *pTmpDataFile = static_cast<CDatafile *>(malloc(AllocSize));
 	if(pTmpDataFile == nullptr)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "out of memory. could not allocate memory for datafile. alloc_size=%" PRId64, AllocSize);
 		return false;
 	}
@@ -605,21 +800,25 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	pTmpDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
 	pTmpDataFile->m_ppDataPtrs = (void **)(pTmpDataFile + 1);
 	pTmpDataFile->m_pDataSizes = (int *)(pTmpDataFile->m_ppDataPtrs + Header.m_NumRawData);
-	pTmpDataFile->m_pData = (char *)(pTmpDataFile->m_pDataSizes + Header.m_NumRawData);
+	pTmpDataFile->m_pData = pMapping != nullptr ? pMapping + sizeof(CDatafileHeader) : (char *)(pTmpDataFile->m_pDataSizes + Header.m_NumRawData);
 	pTmpDataFile->m_File = File;
 	pTmpDataFile->m_FileSize = FileSize;
-	pTmpDataFile->m_Sha256 = Sha256;
-	pTmpDataFile->m_Crc = Crc;
+	pTmpDataFile->m_pMapping = pMapping;
+	pTmpDataFile->m_pStorage = pStorage;
+	str_copy(pTmpDataFile->m_aPath, aPath);
+	pTmpDataFile->m_HasFileInfo = io_file_info(File, &pTmpDataFile->m_FileInfo) == 0;
+	pTmpDataFile->m_HashesCalculated = false;
+	pTmpDataFile->m_HashesValid = false;
 
 	// clear the data pointers and sizes
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData * sizeof(void *));
 	mem_zero(pTmpDataFile->m_pDataSizes, Header.m_NumRawData * sizeof(int));
 
 	// read types, offsets, sizes and item data
-	const unsigned ReadSize = io_read(pTmpDataFile->m_File, pTmpDataFile->m_pData, Size);
+	const unsigned ReadSize = pMapping != nullptr ? Size : io_read(pTmpDataFile->m_File, pTmpDataFile->m_pData, Size);
 	if((int64_t)ReadSize != Size)
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile();
 		free(pTmpDataFile);
 		log_error("datafile", "truncation error. could not read all item data. wanted=%" PRId64 " got=%d", Size, ReadSize);
 		return false;
@@ -647,7 +846,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if(!pTmpDataFile->Validate())
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile();
 		free(pTmpDataFile);
 		return false;
 	}
@@ -667,9 +866,10 @@ void CDataFileReader::Close()
 
 	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
 	{
-		free(m_pDataFile->m_ppDataPtrs[i]);
+		m_pDataFile->FreeData(i);
 	}
 
+	io_unmap(m_pDataFile->m_pMapping, m_pDataFile->m_FileSize);
 	io_close(m_pDataFile->m_File);
 	free(m_pDataFile);
 	m_pDataFile = nullptr;
@@ -731,12 +931,47 @@ const char *CDataFileReader::GetDataString(int Index)
 	return pData;
 }
 
+void CDataFileReader::LoadData(const std::vector<int> &vIndices, IEngine *pEngine)
+{
+	dbg_assert(m_pDataFile != nullptr, "File not open");
+
+	std::vector<int> vLoadIndices;
+	for(const int Index : vIndices)
+	{
+		if(Index >= 0 && Index < m_pDataFile->m_Header.m_NumRawData && m_pDataFile->m_ppDataPtrs[Index] == nullptr && m_pDataFile->m_pDataSizes[Index] >= 0)
+		{
+			vLoadIndices.push_back(Index);
+		}
+	}
+	// the same data must not be loaded by two threads
+	std::sort(vLoadIndices.begin(), vLoadIndices.end());
+	vLoadIndices.erase(std::unique(vLoadIndices.begin(), vLoadIndices.end()), vLoadIndices.end());
+
+	// unmapped files are read through the shared file handle
+	if(m_pDataFile->m_pMapping == nullptr || pEngine == nullptr)
+	{
+		for(const int Index : vLoadIndices)
+		{
+			m_pDataFile->GetData(Index, false);
+		}
+		return;
+	}
+
+	// start with the largest data so the threads finish at about the same time
+	std::stable_sort(vLoadIndices.begin(), vLoadIndices.end(), [&](int Left, int Right) {
+		return m_pDataFile->GetDataSize(Left) > m_pDataFile->GetDataSize(Right);
+	});
+	RunParallel(pEngine, vLoadIndices.size(), [&](size_t i) {
+		m_pDataFile->GetData(vLoadIndices[i], false);
+	});
+}
+
 void CDataFileReader::ReplaceData(int Index, char *pData, size_t Size)
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 	dbg_assert(Index >= 0 && Index < m_pDataFile->m_Header.m_NumRawData, "Index invalid: %d", Index);
 
-	free(m_pDataFile->m_ppDataPtrs[Index]);
+	m_pDataFile->FreeData(Index);
 	m_pDataFile->m_ppDataPtrs[Index] = pData;
 	m_pDataFile->m_pDataSizes[Index] = Size;
 }
@@ -748,8 +983,7 @@ void CDataFileReader::UnloadData(int Index)
 	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
 		return;
 
-	free(m_pDataFile->m_ppDataPtrs[Index]);
-	m_pDataFile->m_ppDataPtrs[Index] = nullptr;
+	m_pDataFile->FreeData(Index);
 	m_pDataFile->m_pDataSizes[Index] = 0;
 }
 
@@ -894,10 +1128,18 @@ int CDataFileReader::NumItems() const
 	return m_pDataFile->m_Header.m_NumItems;
 }
 
+bool CDataFileReader::CalculateHashes() const
+{
+	dbg_assert(m_pDataFile != nullptr, "File not open");
+
+	return m_pDataFile->CalculateHashes();
+}
+
 SHA256_DIGEST CDataFileReader::Sha256() const
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 
+	m_pDataFile->CalculateHashes();
 	return m_pDataFile->m_Sha256;
 }
 
@@ -905,6 +1147,7 @@ unsigned CDataFileReader::Crc() const
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 
+	m_pDataFile->CalculateHashes();
 	return m_pDataFile->m_Crc;
 }
 
@@ -1095,6 +1338,8 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 {
 	switch(CompressionLevel)
 	{
+	case CDataFileWriter::COMPRESSION_FAST:
+		return Z_BEST_SPEED;
 	case CDataFileWriter::COMPRESSION_DEFAULT:
 		return Z_DEFAULT_COMPRESSION;
 	case CDataFileWriter::COMPRESSION_BEST:
@@ -1104,22 +1349,34 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 	}
 }
 
-void CDataFileWriter::Finish()
+void CDataFileWriter::Finish(IEngine *pEngine)
 {
 	dbg_assert((bool)m_File, "File not open");
 
 	// Compress data. This takes the majority of the time when saving a datafile,
-	// so it's delayed until the end so it can be off-loaded to another thread.
-	for(CDataInfo &DataInfo : m_vDatas)
-	{
+	// so it's delayed until the end so it can be off-loaded to other threads.
+	// Every data is compressed on its own, so the file is the same as when
+	// compressing them one after another.
+	std::vector<int> vOrder(m_vDatas.size());
+	for(size_t i = 0; i < vOrder.size(); i++)
+	{
+		vOrder[i] = i;
+	}
+	// start with the largest data so the threads finish at about the same time
+	std::stable_sort(vOrder.begin(), vOrder.end(), [&](int Left, int Right) {
+		return m_vDatas[Left].m_UncompressedSize > m_vDatas[Right].m_UncompressedSize;
+	});
+	RunParallel(pEngine, vOrder.size(), [&](size_t i) {
+		CDataInfo &DataInfo = m_vDatas[vOrder[i]];
+		const ECompressionLevel CompressionLevel = m_FastCompression ? COMPRESSION_FAST : DataInfo.m_CompressionLevel;
 		unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
 		DataInfo.m_pCompressedData = malloc(CompressedSize);
-		const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
+		const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(CompressionLevel));
 		DataInfo.m_CompressedSize = CompressedSize;
 		free(DataInfo.m_pUncompressedData);
 		DataInfo.m_pUncompressedData = nullptr;
 		dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
-	}
+	});
 
 	// Calculate total size of items
 	int64_t ItemSize = 0;
@@ -31,7 +31,9 @@ public:
 	~CDataFileReader();
 	CDataFileReader &operator=(CDataFileReader &&Other);
 
-	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
+	// MapFile maps the file into memory instead of reading it, item and uncompressed
+	// data is then used directly from the mapping
+	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool MapFile = false);
 	void Close();
 	bool IsOpen() const;
 	IOHANDLE File() const;
@@ -40,6 +42,7 @@ public:
 	void *GetData(int Index);
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
 	const char *GetDataString(int Index);
+	void LoadData(const std::vector<int> &vIndices, class IEngine *pEngine); // loads the data in parallel on the job pool if the file is mapped
 	void ReplaceData(int Index, char *pData, size_t Size); // memory for data must have been allocated with malloc
 	void UnloadData(int Index);
 	int NumData() const;
@@ -51,6 +54,8 @@ public:
 	void *FindItem(int Type, int Id);
 	int NumItems() const;
 
+	// the hashes are calculated when they are first used, unless they are in the digest cache
+	[[nodiscard]] bool CalculateHashes() const; // false if the file could not be read completely, the hashes are invalid then
 	SHA256_DIGEST Sha256() const;
 	unsigned Crc() const;
 	int MapSize() const;
@@ -62,6 +67,7 @@ class CDataFileWriter
 public:
 	enum ECompressionLevel
 	{
+		COMPRESSION_FAST,
 		COMPRESSION_DEFAULT,
 		COMPRESSION_BEST,
 	};
@@ -104,6 +110,7 @@ private:
 	};
 
 	IOHANDLE m_File;
+	bool m_FastCompression = false;
 	std::map<uint16_t, CItemTypeInfo, std::less<>> m_ItemTypes; // item types must be sorted in ascending order
 	std::vector<CItemInfo> m_vItems;
 	std::vector<CDataInfo> m_vDatas;
@@ -118,6 +125,7 @@ public:
 	{
 		m_File = Other.m_File;
 		Other.m_File = nullptr;
+		m_FastCompression = Other.m_FastCompression;
 		m_ItemTypes = std::move(Other.m_ItemTypes);
 		m_vItems = std::move(Other.m_vItems);
 		m_vDatas = std::move(Other.m_vDatas);
@@ -130,7 +138,8 @@ public:
 	int AddData(size_t Size, const void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
 	int AddDataSwapped(size_t Size, const void *pData);
 	int AddDataString(const char *pStr);
-	void Finish();
+	void SetFastCompression(bool FastCompression) { m_FastCompression = FastCompression; } // compress all data with COMPRESSION_FAST, e.g. for autosaves
+	void Finish(class IEngine *pEngine = nullptr); // compresses the data in parallel on the job pool of the engine or on temporary threads
 };
 
 #endif
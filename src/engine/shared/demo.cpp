@@ -17,6 +17,11 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
 const CUuid SHA256_EXTENSION =
 	{{0x6b, 0xe6, 0xda, 0x4a, 0xce, 0xbd, 0x38, 0x0c,
 		0x9b, 0x5b, 0x12, 0x89, 0xc8, 0x42, 0xd7, 0x80}};
@@ -40,6 +45,250 @@ bool CDemoHeader::Valid() const
 	       mem_has_null(m_aTimestamp, sizeof(m_aTimestamp)) && str_utf8_check(m_aTimestamp);
 }
 
+/*
+	Tickmarker
+		7	= Always set
+		6	= Keyframe flag
+		0-5	= Delta tick
+
+	Normal
+		7 = Not set
+		5-6	= Type
+		0-4	= Size
+*/
+
+enum
+{
+	CHUNKTYPEFLAG_TICKMARKER = 0x80,
+	CHUNKTICKFLAG_KEYFRAME = 0x40, // only when tickmarker is set
+	CHUNKTICKFLAG_TICK_COMPRESSED = 0x20, // when we store the tick value in the first chunk
+
+	CHUNKMASK_TICK = 0x1f,
+	CHUNKMASK_TICK_LEGACY = 0x3f,
+	CHUNKMASK_TYPE = 0x60,
+	CHUNKMASK_SIZE = 0x1f,
+
+	CHUNKTYPE_SNAPSHOT = 1,
+	CHUNKTYPE_MESSAGE = 2,
+	CHUNKTYPE_DELTA = 3,
+};
+
+// Compresses the chunks of a demo and writes them to the file on the demo
+// writer thread, so recording doesn't have to wait for the disk.
+class CDemoWriter
+{
+	friend class CDemoWriterThread;
+
+	class CQueuedChunk
+	{
+	public:
+		int m_Type; // CHUNKTYPEFLAG_TICKMARKER for tick markers that are written as they are
+		int m_Size;
+	};
+
+	IOHANDLE m_File;
+	// guarded by the lock of the writer thread
+	std::vector<unsigned char> m_vQueue;
+	bool m_Writing = false;
+
+	void WriteChunks(const std::vector<unsigned char> &vChunks);
+	void WriteChunk(int Type, const unsigned char *pData, int Size);
+
+public:
+	enum
+	{
+		// recording waits for the writer thread if more than this is queued
+		MAX_QUEUED_SIZE = 1024 * 1024,
+	};
+
+	CDemoWriter(IOHANDLE File);
+	// waits until all queued chunks are written, the file is not closed
+	~CDemoWriter();
+
+	void Queue(int Type, const void *pData, int Size);
+};
+
+// One thread writes the chunks of all demos that are being recorded, e.g.
+// the demos of every player on a server. It runs while any demo is recorded.
+class CDemoWriterThread
+{
+	std::mutex m_StartLock;
+	int m_NumWriters = 0;
+	void *m_pThread = nullptr;
+
+	std::mutex m_Lock;
+	// signaled when there is a demo to write or the thread should stop
+	std::condition_variable m_PendingCv;
+	// signaled when the chunks of a demo are written
+	std::condition_variable m_WrittenCv;
+	std::deque<CDemoWriter *> m_vpPending;
+	bool m_Shutdown = false;
+
+	static void ThreadMain(void *pUser);
+	void Run();
+
+public:
+	void Add();
+	void Remove(CDemoWriter *pWriter);
+	void Queue(CDemoWriter *pWriter, int Type, const void *pData, int Size);
+};
+
+static CDemoWriterThread gs_DemoWriterThread;
+
+void CDemoWriterThread::Add()
+{
+	const std::unique_lock StartLock(m_StartLock);
+	if(m_NumWriters++ == 0)
+		m_pThread = thread_init(ThreadMain, this, "demo writer");
+}
+
+void CDemoWriterThread::Remove(CDemoWriter *pWriter)
+{
+	const std::unique_lock StartLock(m_StartLock);
+	{
+		std::unique_lock Lock(m_Lock);
+		m_WrittenCv.wait(Lock, [pWriter]() { return pWriter->m_vQueue.empty() && !pWriter->m_Writing; });
+		if(--m_NumWriters > 0)
+			return;
+		m_Shutdown = true;
+	}
+	m_PendingCv.notify_one();
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+	m_Shutdown = false;
+}
+
+void CDemoWriterThread::Queue(CDemoWriter *pWriter, int Type, const void *pData, int Size)
+{
+	CDemoWriter::CQueuedChunk Chunk;
+	Chunk.m_Type = Type;
+	Chunk.m_Size = Size;
+	bool WasEmpty;
+	{
+		std::unique_lock Lock(m_Lock);
+		m_WrittenCv.wait(Lock, [pWriter]() { return pWriter->m_vQueue.size() < CDemoWriter::MAX_QUEUED_SIZE; });
+		WasEmpty = pWriter->m_vQueue.empty();
+		const size_t Pos = pWriter->m_vQueue.size();
+		pWriter->m_vQueue.resize(Pos + sizeof(Chunk) + Size);
+		mem_copy(pWriter->m_vQueue.data() + Pos, &Chunk, sizeof(Chunk));
+		mem_copy(pWriter->m_vQueue.data() + Pos + sizeof(Chunk), pData, Size);
+		// the thread takes all queued chunks of a demo at once, so it only has to be told about the first one
+		if(WasEmpty)
+			m_vpPending.push_back(pWriter);
+	}
+	if(WasEmpty)
+		m_PendingCv.notify_one();
+}
+
+void CDemoWriterThread::ThreadMain(void *pUser)
+{
+	static_cast<CDemoWriterThread *>(pUser)->Run();
+}
+
+void CDemoWriterThread::Run()
+{
+	std::vector<unsigned char> vChunks;
+	std::unique_lock Lock(m_Lock);
+	while(true)
+	{
+		m_PendingCv.wait(Lock, [this]() { return m_Shutdown || !m_vpPending.empty(); });
+		if(m_vpPending.empty())
+			break;
+
+		CDemoWriter *pWriter = m_vpPending.front();
+		m_vpPending.pop_front();
+		std::swap(vChunks, pWriter->m_vQueue);
+		pWriter->m_Writing = true;
+
+		Lock.unlock();
+		pWriter->WriteChunks(vChunks);
+		vChunks.clear();
+		Lock.lock();
+
+		pWriter->m_Writing = false;
+		m_WrittenCv.notify_all();
+	}
+}
+
+CDemoWriter::CDemoWriter(IOHANDLE File) :
+	m_File(File)
+{
+	gs_DemoWriterThread.Add();
+}
+
+CDemoWriter::~CDemoWriter()
+{
+	gs_DemoWriterThread.Remove(this);
+}
+
+void CDemoWriter::Queue(int Type, const void *pData, int Size)
+{
+	gs_DemoWriterThread.Queue(this, Type, pData, Size);
+}
+
+void CDemoWriter::WriteChunks(const std::vector<unsigned char> &vChunks)
+{
+	size_t Pos = 0;
+	while(Pos < vChunks.size())
+	{
+		CQueuedChunk Chunk;
+		mem_copy(&Chunk, vChunks.data() + Pos, sizeof(Chunk));
+		Pos += sizeof(Chunk);
+		WriteChunk(Chunk.m_Type, vChunks.data() + Pos, Chunk.m_Size);
+		Pos += Chunk.m_Size;
+	}
+}
+
+void CDemoWriter::WriteChunk(int Type, const unsigned char *pData, int Size)
+{
+	if(Type == CHUNKTYPEFLAG_TICKMARKER)
+	{
+		io_write(m_File, pData, Size);
+		return;
+	}
+
+	/* pad the data with 0 so we get an alignment of 4,
+	else the compression won't work and miss some bytes */
+	char aBuffer[64 * 1024];
+	char aBuffer2[64 * 1024];
+	mem_copy(aBuffer2, pData, Size);
+	while(Size & 3)
+		aBuffer2[Size++] = 0;
+	Size = CVariableInt::Compress(aBuffer2, Size, aBuffer, sizeof(aBuffer)); // buffer2 -> buffer
+	if(Size < 0)
+		return;
+
+	Size = CNetBase::Compress(aBuffer, Size, aBuffer2, sizeof(aBuffer2)); // buffer -> buffer2
+	if(Size < 0)
+		return;
+
+	unsigned char aChunk[3];
+	aChunk[0] = ((Type & 0x3) << 5);
+	if(Size < 30)
+	{
+		aChunk[0] |= Size;
+		io_write(m_File, aChunk, 1);
+	}
+	else
+	{
+		if(Size < 256)
+		{
+			aChunk[0] |= 30;
+			aChunk[1] = Size & 0xff;
+			io_write(m_File, aChunk, 2);
+		}
+		else
+		{
+			aChunk[0] |= 31;
+			aChunk[1] = Size & 0xff;
+			aChunk[2] = Size >> 8;
+			io_write(m_File, aChunk, 3);
+		}
+	}
+
+	io_write(m_File, aBuffer2, Size);
+}
+
 CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
 {
 	m_File = nullptr;
@@ -51,11 +300,15 @@ CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapDat
 	m_NoMapData = NoMapData;
 }
 
+CDemoRecorder::CDemoRecorder() = default;
+
 CDemoRecorder::~CDemoRecorder()
 {
 	dbg_assert(m_File == 0, "Demo recorder was not stopped");
 }
 
+CDemoRecorder &CDemoRecorder::operator=(CDemoRecorder &&Other) = default;
+
 // Record
 int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned Crc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser)
 {
@@ -214,39 +467,12 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_pUser = pUser;
 
 	m_File = DemoFile;
+	m_pWriter = std::make_unique<CDemoWriter>(DemoFile);
 	str_copy(m_aCurrentFilename, pFilename);
 
 	return 0;
 }
 
-/*
-	Tickmarker
-		7	= Always set
-		6	= Keyframe flag
-		0-5	= Delta tick
-
-	Normal
-		7 = Not set
-		5-6	= Type
-		0-4	= Size
-*/
-
-enum
-{
-	CHUNKTYPEFLAG_TICKMARKER = 0x80,
-	CHUNKTICKFLAG_KEYFRAME = 0x40, // only when tickmarker is set
-	CHUNKTICKFLAG_TICK_COMPRESSED = 0x20, // when we store the tick value in the first chunk
-
-	CHUNKMASK_TICK = 0x1f,
-	CHUNKMASK_TICK_LEGACY = 0x3f,
-	CHUNKMASK_TYPE = 0x60,
-	CHUNKMASK_SIZE = 0x1f,
-
-	CHUNKTYPE_SNAPSHOT = 1,
-	CHUNKTYPE_MESSAGE = 2,
-	CHUNKTYPE_DELTA = 3,
-};
-
 void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 {
 	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
@@ -258,13 +484,13 @@ void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 		if(Keyframe)
 			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
 
-		io_write(m_File, aChunk, sizeof(aChunk));
+		m_pWriter->Queue(CHUNKTYPEFLAG_TICKMARKER, aChunk, sizeof(aChunk));
 	}
 	else
 	{
 		unsigned char aChunk[1];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
-		io_write(m_File, aChunk, sizeof(aChunk));
+		m_pWriter->Queue(CHUNKTYPEFLAG_TICKMARKER, aChunk, sizeof(aChunk));
 	}
 
 	m_LastTickMarker = Tick;
@@ -280,46 +506,8 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 	if(Size > 64 * 1024)
 		return;
 
-	/* pad the data with 0 so we get an alignment of 4,
-	else the compression won't work and miss some bytes */
-	char aBuffer[64 * 1024];
-	char aBuffer2[64 * 1024];
-	mem_copy(aBuffer2, pData, Size);
-	while(Size & 3)
-		aBuffer2[Size++] = 0;
-	Size = CVariableInt::Compress(aBuffer2, Size, aBuffer, sizeof(aBuffer)); // buffer2 -> buffer
-	if(Size < 0)
-		return;
-
-	Size = CNetBase::Compress(aBuffer, Size, aBuffer2, sizeof(aBuffer2)); // buffer -> buffer2
-	if(Size < 0)
-		return;
-
-	unsigned char aChunk[3];
-	aChunk[0] = ((Type & 0x3) << 5);
-	if(Size < 30)
-	{
-		aChunk[0] |= Size;
-		io_write(m_File, aChunk, 1);
-	}
-	else
-	{
-		if(Size < 256)
-		{
-			aChunk[0] |= 30;
-			aChunk[1] = Size & 0xff;
-			io_write(m_File, aChunk, 2);
-		}
-		else
-		{
-			aChunk[0] |= 31;
-			aChunk[1] = Size & 0xff;
-			aChunk[2] = Size >> 8;
-			io_write(m_File, aChunk, 3);
-		}
-	}
-
-	io_write(m_File, aBuffer2, Size);
+	// compressed and written by the writer thread
+	m_pWriter->Queue(Type, pData, Size);
 }
 
 void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
@@ -371,6 +559,9 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 	if(!m_File)
 		return -1;
 
+	// waits until the queued chunks are written
+	m_pWriter = nullptr;
+
 	if(Mode == IDemoRecorder::EStopMode::KEEP_FILE)
 	{
 		// add the demo length to the header
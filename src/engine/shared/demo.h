@@ -11,6 +11,7 @@
 #include <engine/shared/protocol.h>
 
 #include <functional>
+#include <memory>
 #include <vector>
 
 typedef std::function<void()> TUpdateIntraTimesFunc;
@@ -21,6 +22,7 @@ class CDemoRecorder : public IDemoRecorder
 	class IStorage *m_pStorage;
 
 	IOHANDLE m_File;
+	std::unique_ptr<class CDemoWriter> m_pWriter;
 	char m_aCurrentFilename[IO_MAX_PATH_LENGTH];
 	int m_LastTickMarker;
 	int m_LastKeyFrame;
@@ -42,8 +44,9 @@ class CDemoRecorder : public IDemoRecorder
 
 public:
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
-	CDemoRecorder() = default;
+	CDemoRecorder();
 	~CDemoRecorder() override;
+	CDemoRecorder &operator=(CDemoRecorder &&Other);
 
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned MapCrc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser);
 	int Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilename = "") override;
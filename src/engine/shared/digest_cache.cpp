@@ -0,0 +1,140 @@
+#include "digest_cache.h"
+
+#include <base/log.h>
+
+#include <engine/shared/linereader.h>
+#include <engine/storage.h>
+
+#include <cinttypes>
+
+static bool SameFileInfo(const IO_FILE_INFO &Left, const IO_FILE_INFO &Right)
+{
+	return Left.device == Right.device && Left.inode == Right.inode && Left.size == Right.size && Left.modified == Right.modified;
+}
+
+void CDigestCache::Init(const char *pFilename)
+{
+	str_copy(m_aFilename, pFilename);
+}
+
+void CDigestCache::Load()
+{
+	if(m_Loaded)
+		return;
+	m_Loaded = true;
+	Read();
+}
+
+void CDigestCache::Read()
+{
+	m_Entries.clear();
+	IOHANDLE File = io_open(m_aFilename, IOFLAG_READ);
+	if(!File)
+		return;
+	CLineReader LineReader;
+	if(!LineReader.OpenFile(File))
+		return;
+
+	// sha256 crc size modified device inode path
+	int NumLines = 0;
+	while(const char *pLine = LineReader.Get())
+	{
+		NumLines++;
+		char aSha256[SHA256_MAXSTRSIZE];
+		char aCrc[16];
+		char aSize[32];
+		char aModified[32];
+		char aDevice[32];
+		char aInode[32];
+		const char *pRest = pLine;
+		pRest = str_next_token(pRest, " ", aSha256, sizeof(aSha256));
+		pRest = pRest == nullptr ? nullptr : str_next_token(pRest, " ", aCrc, sizeof(aCrc));
+		pRest = pRest == nullptr ? nullptr : str_next_token(pRest, " ", aSize, sizeof(aSize));
+		pRest = pRest == nullptr ? nullptr : str_next_token(pRest, " ", aModified, sizeof(aModified));
+		pRest = pRest == nullptr ? nullptr : str_next_token(pRest, " ", aDevice, sizeof(aDevice));
+		pRest = pRest == nullptr ? nullptr : str_next_token(pRest, " ", aInode, sizeof(aInode));
+		CEntry Entry;
+		if(pRest == nullptr || pRest[0] != ' ' || pRest[1] == '\0' || sha256_from_str(&Entry.m_Sha256, aSha256) != 0)
+		{
+			log_warn("digest_cache", "ignoring invalid line %d in '%s'", NumLines, m_aFilename);
+			continue;
+		}
+		Entry.m_Crc = str_toulong_base(aCrc, 16);
+		Entry.m_Info.size = str_toint64_base(aSize);
+		Entry.m_Info.modified = str_toint64_base(aModified);
+		Entry.m_Info.device = str_toint64_base(aDevice);
+		Entry.m_Info.inode = str_toint64_base(aInode);
+		m_Entries[pRest + 1] = Entry;
+	}
+}
+
+void CDigestCache::WriteEntry(IOHANDLE File, const std::string &Path, const CEntry &Entry)
+{
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Entry.m_Sha256, aSha256, sizeof(aSha256));
+	char aLine[IO_MAX_PATH_LENGTH + 256];
+	str_format(aLine, sizeof(aLine), "%s %08x %" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 " %s", aSha256, Entry.m_Crc,
+		Entry.m_Info.size, Entry.m_Info.modified, (int64_t)Entry.m_Info.device, (int64_t)Entry.m_Info.inode, Path.c_str());
+	io_write(File, aLine, str_length(aLine));
+	io_write_newline(File);
+}
+
+void CDigestCache::Rewrite()
+{
+	char aTmpFilename[IO_MAX_PATH_LENGTH];
+	IStorage::FormatTmpPath(aTmpFilename, sizeof(aTmpFilename), m_aFilename);
+	IOHANDLE File = io_open(aTmpFilename, IOFLAG_WRITE);
+	if(!File)
+	{
+		log_error("digest_cache", "failed to open '%s' for writing", aTmpFilename);
+		return;
+	}
+	for(const auto &[Path, Entry] : m_Entries)
+	{
+		WriteEntry(File, Path, Entry);
+	}
+	if(io_close(File) != 0 || fs_rename(aTmpFilename, m_aFilename) != 0)
+	{
+		log_error("digest_cache", "failed to rewrite '%s'", m_aFilename);
+		fs_remove(aTmpFilename);
+	}
+}
+
+bool CDigestCache::Find(const char *pPath, const IO_FILE_INFO &Info, SHA256_DIGEST *pSha256, unsigned *pCrc)
+{
+	const CLockScope LockScope(m_Lock);
+	Load();
+
+	const auto Entry = m_Entries.find(pPath);
+	if(Entry == m_Entries.end() || !SameFileInfo(Entry->second.m_Info, Info))
+		return false;
+	*pSha256 = Entry->second.m_Sha256;
+	*pCrc = Entry->second.m_Crc;
+	return true;
+}
+
+bool CDigestCache::Add(const char *pPath, const IO_FILE_INFO &Info, const SHA256_DIGEST &Sha256, unsigned Crc)
+{
+	const CLockScope LockScope(m_Lock);
+	Load();
+
+	bool Outdated = false;
+	const auto Existing = m_Entries.find(pPath);
+	if(Existing != m_Entries.end() && SameFileInfo(Existing->second.m_Info, Info))
+	{
+		if(Existing->second.m_Sha256 == Sha256 && Existing->second.m_Crc == Crc)
+			return true;
+		// the file was changed without changing its size and modification time
+		log_warn("digest_cache", "cached hashes of '%s' are outdated", pPath);
+		Outdated = true;
+	}
+
+	// keep the entries that other processes added since the file was loaded
+	Read();
+	CEntry &Entry = m_Entries[pPath];
+	Entry.m_Info = Info;
+	Entry.m_Sha256 = Sha256;
+	Entry.m_Crc = Crc;
+	Rewrite();
+	return !Outdated;
+}
@@ -0,0 +1,80 @@
+#ifndef ENGINE_SHARED_DIGEST_CACHE_H
+#define ENGINE_SHARED_DIGEST_CACHE_H
+
+#include <base/hash.h>
+#include <base/lock.h>
+#include <base/system.h>
+
+#include <string>
+#include <unordered_map>
+
+/**
+ * Remembers the hashes of files by their complete path, size, modification
+ * time and inode, so unchanged files don't have to be read to hash them.
+ *
+ * The hashes of a file whose size, modification time, device and inode are
+ * unchanged are trusted without reading it. A file modified in place that
+ * keeps all of them gets its old hashes, the strict mode of `digest_cache`
+ * hashes every file and reports such entries.
+ *
+ * Adding an entry rewrites the text file to a temporary file that is renamed
+ * over it, after reading the entries other processes added in the meantime.
+ * Concurrent processes therefore never leave a mixed up file behind, at
+ * worst an entry added at the same moment is lost and added again the next
+ * time that file is hashed.
+ */
+class CDigestCache
+{
+	class CEntry
+	{
+	public:
+		IO_FILE_INFO m_Info;
+		SHA256_DIGEST m_Sha256;
+		unsigned m_Crc;
+	};
+
+	CLock m_Lock;
+	char m_aFilename[IO_MAX_PATH_LENGTH] = "";
+	bool m_Loaded GUARDED_BY(m_Lock) = false;
+	std::unordered_map<std::string, CEntry> m_Entries GUARDED_BY(m_Lock);
+
+	static void WriteEntry(IOHANDLE File, const std::string &Path, const CEntry &Entry);
+	void Load() REQUIRES(m_Lock);
+	void Read() REQUIRES(m_Lock);
+	void Rewrite() REQUIRES(m_Lock);
+
+public:
+	/**
+	 * Sets the file the cache is stored in. It is only read when the cache is
+	 * used for the first time.
+	 *
+	 * @param pFilename Complete path of the cache file.
+	 */
+	void Init(const char *pFilename);
+
+	/**
+	 * Looks up the hashes of a file.
+	 *
+	 * @param pPath Complete path of the file.
+	 * @param Info Current information of the file.
+	 * @param pSha256 Pointer where the SHA256 digest will be stored.
+	 * @param pCrc Pointer where the CRC32 will be stored.
+	 *
+	 * @return `true` if the file is cached and did not change.
+	 */
+	bool Find(const char *pPath, const IO_FILE_INFO &Info, SHA256_DIGEST *pSha256, unsigned *pCrc) REQUIRES(!m_Lock);
+
+	/**
+	 * Stores the hashes of a file.
+	 *
+	 * @param pPath Complete path of the file.
+	 * @param Info Information of the file when it was hashed.
+	 * @param Sha256 SHA256 digest of the file.
+	 * @param Crc CRC32 of the file.
+	 *
+	 * @return `false` if the unchanged file was cached with different hashes.
+	 */
+	bool Add(const char *pPath, const IO_FILE_INFO &Info, const SHA256_DIGEST &Sha256, unsigned Crc) REQUIRES(!m_Lock);
+};
+
+#endif
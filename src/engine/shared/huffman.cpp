@@ -96,36 +96,47 @@ void CHuffman::Init(const unsigned *pFrequencies)
 {
 	// make sure to cleanout every thing
 	mem_zero(m_aNodes, sizeof(m_aNodes));
-	mem_zero(m_apDecodeLut, sizeof(m_apDecodeLut));
+	mem_zero(m_aDecodeLut, sizeof(m_aDecodeLut));
 	m_pStartNode = nullptr;
 	m_NumNodes = 0;
 
 	// construct the tree
 	ConstructTree(pFrequencies);
 
-	// build decode LUT
+	// build decode LUT, decoding as many symbols as fit into the bits
 	for(int i = 0; i < HUFFMAN_LUTSIZE; i++)
 	{
+		CDecodeEntry *pEntry = &m_aDecodeLut[i];
 		unsigned Bits = i;
-		int k;
-		CNode *pNode = m_pStartNode;
-		for(k = 0; k < HUFFMAN_LUTBITS; k++)
+		unsigned NumBits = 0;
+		while(pEntry->m_NumSymbols < HUFFMAN_LUTSYMBOLS)
 		{
-			pNode = &m_aNodes[pNode->m_aLeaves[Bits & 1]];
-			Bits >>= 1;
-
-			if(!pNode)
-				break;
+			CNode *pNode = m_pStartNode;
+			unsigned k;
+			for(k = NumBits; k < HUFFMAN_LUTBITS; k++)
+			{
+				pNode = &m_aNodes[pNode->m_aLeaves[Bits & 1]];
+				Bits >>= 1;
+				if(pNode->m_NumBits)
+					break;
+			}
 
-			if(pNode->m_NumBits)
+			if(k == HUFFMAN_LUTBITS || pNode == &m_aNodes[HUFFMAN_EOF_SYMBOL])
 			{
-				m_apDecodeLut[i] = pNode;
+				// the tree has to be walked further, or it's the end of
+				// the stream, both are handled one node at a time
+				if(pEntry->m_NumSymbols == 0)
+				{
+					pEntry->m_Node = pNode - m_aNodes;
+					pEntry->m_NumBits = pNode->m_NumBits ? pNode->m_NumBits : (unsigned)HUFFMAN_LUTBITS;
+				}
 				break;
 			}
-		}
 
-		if(k == HUFFMAN_LUTBITS)
-			m_apDecodeLut[i] = pNode;
+			pEntry->m_aSymbols[pEntry->m_NumSymbols++] = pNode->m_Symbol;
+			NumBits = k + 1;
+			pEntry->m_NumBits = NumBits;
+		}
 	}
 }
 
@@ -218,10 +229,10 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 
 	while(true)
 	{
-		// {A} try to load a node now, this will reduce dependency at location {D}
-		const CNode *pNode = nullptr;
+		// {A} try to load an entry now, this will reduce dependency at location {D}
+		const CDecodeEntry *pEntry = nullptr;
 		if(Bitcount >= HUFFMAN_LUTBITS)
-			pNode = m_apDecodeLut[Bits & HUFFMAN_LUTMASK];
+			pEntry = &m_aDecodeLut[Bits & HUFFMAN_LUTMASK];
 
 		// {B} fill with new bits
 		while(Bitcount < 24 && pSrc != pSrcEnd)
@@ -230,26 +241,43 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 			Bitcount += 8;
 		}
 
-		// {C} load symbol now if we didn't that earlier at location {A}
-		if(!pNode)
-			pNode = m_apDecodeLut[Bits & HUFFMAN_LUTMASK];
+		// {C} load entry now if we didn't that earlier at location {A}
+		if(!pEntry)
+			pEntry = &m_aDecodeLut[Bits & HUFFMAN_LUTMASK];
 
-		if(!pNode)
-			return -1;
+		// {D} remove the bits that the lut checked up for us
+		Bits >>= pEntry->m_NumBits;
+		Bitcount -= pEntry->m_NumBits;
 
-		// {D} check if we hit a symbol already
-		if(pNode->m_NumBits)
+		// output all the characters the lut decoded
+		const int NumSymbols = pEntry->m_NumSymbols;
+		if(NumSymbols)
 		{
-			// remove the bits for that symbol
-			Bits >>= pNode->m_NumBits;
-			Bitcount -= pNode->m_NumBits;
+			// read them first, the output could alias the lut as far as the compiler knows
+			unsigned char aSymbols[HUFFMAN_LUTSYMBOLS];
+			for(int i = 0; i < HUFFMAN_LUTSYMBOLS; i++)
+				aSymbols[i] = pEntry->m_aSymbols[i];
+
+			if(pDstEnd - pDst >= HUFFMAN_LUTSYMBOLS)
+			{
+				// copy all of them, the ones past the decoded symbols get overwritten later
+				for(int i = 0; i < HUFFMAN_LUTSYMBOLS; i++)
+					pDst[i] = aSymbols[i];
+			}
+			else if(pDstEnd - pDst >= NumSymbols)
+			{
+				for(int i = 0; i < NumSymbols; i++)
+					pDst[i] = aSymbols[i];
+			}
+			else
+				return -1;
+			pDst += NumSymbols;
+			continue;
 		}
-		else
-		{
-			// remove the bits that the lut checked up for us
-			Bits >>= HUFFMAN_LUTBITS;
-			Bitcount -= HUFFMAN_LUTBITS;
 
+		const CNode *pNode = &m_aNodes[pEntry->m_Node];
+		if(!pNode->m_NumBits)
+		{
 			// walk the tree bit by bit
 			while(true)
 			{
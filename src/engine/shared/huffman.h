@@ -12,9 +12,10 @@ class CHuffman
 		HUFFMAN_MAX_SYMBOLS = HUFFMAN_EOF_SYMBOL + 1,
 		HUFFMAN_MAX_NODES = HUFFMAN_MAX_SYMBOLS * 2 - 1,
 
-		HUFFMAN_LUTBITS = 10,
+		HUFFMAN_LUTBITS = 12,
 		HUFFMAN_LUTSIZE = (1 << HUFFMAN_LUTBITS),
-		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1)
+		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1),
+		HUFFMAN_LUTSYMBOLS = 4
 	};
 
 	struct CNode
@@ -30,10 +31,20 @@ class CHuffman
 		unsigned char m_Symbol;
 	};
 
+	// all the symbols whose codes fit into the looked up bits, or the node
+	// to continue from if there are none
+	struct CDecodeEntry
+	{
+		unsigned char m_aSymbols[HUFFMAN_LUTSYMBOLS];
+		unsigned char m_NumSymbols;
+		unsigned char m_NumBits;
+		unsigned short m_Node;
+	};
+
 	static const unsigned ms_aFreqTable[HUFFMAN_MAX_SYMBOLS];
 
 	CNode m_aNodes[HUFFMAN_MAX_NODES];
-	CNode *m_apDecodeLut[HUFFMAN_LUTSIZE];
+	CDecodeEntry m_aDecodeLut[HUFFMAN_LUTSIZE];
 	CNode *m_pStartNode;
 	int m_NumNodes;
 
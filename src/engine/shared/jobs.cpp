@@ -5,9 +5,9 @@
 #include <algorithm>
 
 IJob::IJob() :
-	m_pNext(nullptr),
 	m_State(STATE_QUEUED),
-	m_Abortable(false)
+	m_Abortable(false),
+	m_Priority(PRIORITY_NORMAL)
 {
 }
 
@@ -43,9 +43,23 @@ bool IJob::IsAbortable() const
 	return m_Abortable;
 }
 
+void IJob::SetPriority(EJobPriority Priority)
+{
+	dbg_assert(Priority >= PRIORITY_HIGH && Priority < NUM_PRIORITIES, "Invalid job priority: %d", static_cast<int>(Priority));
+	m_Priority = Priority;
+}
+
+IJob::EJobPriority IJob::Priority() const
+{
+	return m_Priority;
+}
+
+thread_local CJobPool::CWorker *CJobPool::ms_pCurrentWorker = nullptr;
+
 CJobPool::CJobPool()
 {
 	m_Shutdown = true;
+	m_NumAdded = 0;
 }
 
 CJobPool::~CJobPool()
@@ -58,65 +72,142 @@ CJobPool::~CJobPool()
 
 void CJobPool::WorkerThread(void *pUser)
 {
-	static_cast<CJobPool *>(pUser)->RunLoop();
+	CWorker *pWorker = static_cast<CWorker *>(pUser);
+	ms_pCurrentWorker = pWorker;
+	pWorker->m_pPool->RunLoop(pWorker);
+	ms_pCurrentWorker = nullptr;
 }
 
-void CJobPool::RunLoop()
+void CJobPool::CQueue::Push(std::shared_ptr<IJob> pJob)
 {
-	while(true)
+	const int Priority = pJob->Priority();
+	const CLockScope LockScope(m_Lock);
+	m_aJobs[Priority].push_back(std::move(pJob));
+	m_aNumJobs[Priority]++;
+}
+
+std::shared_ptr<IJob> CJobPool::CQueue::Pop(int Priority, bool Newest)
+{
+	if(m_aNumJobs[Priority].load() == 0)
+		return nullptr;
+
+	const CLockScope LockScope(m_Lock);
+	std::deque<std::shared_ptr<IJob>> &Jobs = m_aJobs[Priority];
+	if(Jobs.empty())
+		return nullptr;
+	std::shared_ptr<IJob> pJob;
+	if(Newest)
 	{
-		// wait for job to become available
-		sphore_wait(&m_Semaphore);
+		pJob = std::move(Jobs.back());
+		Jobs.pop_back();
+	}
+	else
+	{
+		pJob = std::move(Jobs.front());
+		Jobs.pop_front();
+	}
+	m_aNumJobs[Priority]--;
+	return pJob;
+}
 
-		// fetch job from queue
-		std::shared_ptr<IJob> pJob = nullptr;
+void CJobPool::CQueue::AbortJobs()
+{
+	const CLockScope LockScope(m_Lock);
+	for(int Priority = IJob::PRIORITY_HIGH; Priority < IJob::NUM_PRIORITIES; Priority++)
+	{
+		// only remove abortable jobs from queue
+		std::deque<std::shared_ptr<IJob>> &Jobs = m_aJobs[Priority];
+		Jobs.erase(std::remove_if(Jobs.begin(), Jobs.end(), [](const std::shared_ptr<IJob> &pJob) {
+			return pJob->Abort();
+		}),
+			Jobs.end());
+		m_aNumJobs[Priority] = Jobs.size();
+	}
+}
+
+std::shared_ptr<IJob> CJobPool::PopJob(CWorker *pWorker)
+{
+	for(int Priority = IJob::PRIORITY_HIGH; Priority < IJob::NUM_PRIORITIES; Priority++)
+	{
+		// newest job of this worker, its data is most likely still cached
+		std::shared_ptr<IJob> pJob = pWorker->m_Queue.Pop(Priority, true);
+		if(pJob)
+			return pJob;
+
+		// oldest job added by other threads
+		pJob = m_Queue.Pop(Priority, false);
+		if(pJob)
+			return pJob;
+
+		// oldest job of another worker, starting with the next one so not all idle workers steal from the same one
+		for(size_t i = 1; i < m_vpWorkers.size(); i++)
 		{
-			const CLockScope LockScope(m_Lock);
-			if(m_pFirstJob)
-			{
-				pJob = m_pFirstJob;
-				m_pFirstJob = m_pFirstJob->m_pNext;
-				// allow remaining objects in list to destruct, even when current object stays alive
-				pJob->m_pNext = nullptr;
-				if(!m_pFirstJob)
-					m_pLastJob = nullptr;
-			}
+			pJob = m_vpWorkers[(pWorker->m_Index + i) % m_vpWorkers.size()]->m_Queue.Pop(Priority, false);
+			if(pJob)
+				return pJob;
 		}
+	}
+	return nullptr;
+}
 
-		if(pJob)
+void CJobPool::RunJob(const std::shared_ptr<IJob> &pJob)
+{
+	IJob::EJobState OldStateQueued = IJob::STATE_QUEUED;
+	if(!pJob->m_State.compare_exchange_strong(OldStateQueued, IJob::STATE_RUNNING))
+	{
+		if(OldStateQueued != IJob::STATE_ABORTED)
 		{
-			IJob::EJobState OldStateQueued = IJob::STATE_QUEUED;
-			if(!pJob->m_State.compare_exchange_strong(OldStateQueued, IJob::STATE_RUNNING))
-			{
-				if(OldStateQueued == IJob::STATE_ABORTED)
-				{
-					// job was aborted before it was started
-					pJob->m_State = IJob::STATE_ABORTED;
-					continue;
-				}
-				dbg_assert_failed("Job state invalid. Job was reused or uninitialized.");
-			}
+			dbg_assert_failed("Job state invalid. Job was reused or uninitialized.");
+		}
+		// job was aborted before it was started
+	}
+	else
+	{
+		// remember running jobs so we can abort them
+		{
+			const CLockScope LockScope(m_LockRunning);
+			m_RunningJobs.push_back(pJob);
+		}
+		pJob->Run();
+		{
+			const CLockScope LockScope(m_LockRunning);
+			m_RunningJobs.erase(std::find(m_RunningJobs.begin(), m_RunningJobs.end(), pJob));
+		}
 
-			// remember running jobs so we can abort them
-			{
-				const CLockScope LockScope(m_LockRunning);
-				m_RunningJobs.push_back(pJob);
-			}
-			pJob->Run();
+		// do not change state to done if job was not completed successfully
+		IJob::EJobState OldStateRunning = IJob::STATE_RUNNING;
+		if(!pJob->m_State.compare_exchange_strong(OldStateRunning, IJob::STATE_DONE))
+		{
+			if(OldStateRunning != IJob::STATE_ABORTED)
 			{
-				const CLockScope LockScope(m_LockRunning);
-				m_RunningJobs.erase(std::find(m_RunningJobs.begin(), m_RunningJobs.end(), pJob));
+				dbg_assert_failed("Job state invalid, must be either running or aborted");
 			}
+		}
+	}
+}
 
-			// do not change state to done if job was not completed successfully
-			IJob::EJobState OldStateRunning = IJob::STATE_RUNNING;
-			if(!pJob->m_State.compare_exchange_strong(OldStateRunning, IJob::STATE_DONE))
-			{
-				if(OldStateRunning != IJob::STATE_ABORTED)
-				{
-					dbg_assert_failed("Job state invalid, must be either running or aborted");
-				}
-			}
+void CJobPool::RunLoop(CWorker *pWorker)
+{
+	while(true)
+	{
+		// wait for job to become available
+		sphore_wait(&m_Semaphore);
+
+		// fetch job from queues, every signal belongs to a queued job. Other
+		// workers can take jobs while this one goes through the queues, but
+		// there is always one left for it unless another job was added to a
+		// queue it had already looked at, then it has to look again
+		std::shared_ptr<IJob> pJob;
+		int NumAdded;
+		do
+		{
+			NumAdded = m_NumAdded.load();
+			pJob = PopJob(pWorker);
+		} while(!pJob && m_NumAdded.load() != NumAdded);
+
+		if(pJob)
+		{
+			RunJob(pJob);
 		}
 		else if(m_Shutdown)
 		{
@@ -131,18 +222,25 @@ void CJobPool::Init(int NumThreads)
 	dbg_assert(m_Shutdown, "Job pool already running");
 	m_Shutdown = false;
 
-	const CLockScope LockScope(m_Lock);
 	sphore_init(&m_Semaphore);
-	m_pFirstJob = nullptr;
-	m_pLastJob = nullptr;
+
+	// create all workers before starting them, so they can steal from each other
+	m_vpWorkers.reserve(NumThreads);
+	for(int i = 0; i < NumThreads; i++)
+	{
+		std::unique_ptr<CWorker> pWorker = std::make_unique<CWorker>();
+		pWorker->m_pPool = this;
+		pWorker->m_Index = i;
+		pWorker->m_pThread = nullptr;
+		m_vpWorkers.push_back(std::move(pWorker));
+	}
 
 	// start worker threads
 	char aName[16]; // unix kernel length limit
-	m_vpThreads.reserve(NumThreads);
 	for(int i = 0; i < NumThreads; i++)
 	{
 		str_format(aName, sizeof(aName), "CJobPool W%d", i);
-		m_vpThreads.push_back(thread_init(WorkerThread, this, aName));
+		m_vpWorkers[i]->m_pThread = thread_init(WorkerThread, m_vpWorkers[i].get(), aName);
 	}
 }
 
@@ -152,33 +250,10 @@ void CJobPool::Shutdown()
 	m_Shutdown = true;
 
 	// abort queued jobs
+	m_Queue.AbortJobs();
+	for(std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
 	{
-		const CLockScope LockScope(m_Lock);
-		std::shared_ptr<IJob> pJob = m_pFirstJob;
-		std::shared_ptr<IJob> pPrev = nullptr;
-		while(pJob != nullptr)
-		{
-			std::shared_ptr<IJob> pNext = pJob->m_pNext;
-			if(pJob->Abort())
-			{
-				// only remove abortable jobs from queue
-				pJob->m_pNext = nullptr;
-				if(pPrev)
-				{
-					pPrev->m_pNext = pNext;
-				}
-				else
-				{
-					m_pFirstJob = pNext;
-				}
-			}
-			else
-			{
-				pPrev = pJob;
-			}
-			pJob = pNext;
-		}
-		m_pLastJob = pPrev;
+		pWorker->m_Queue.AbortJobs();
 	}
 
 	// abort running jobs
@@ -191,18 +266,18 @@ void CJobPool::Shutdown()
 	}
 
 	// wake up all worker threads
-	for(size_t i = 0; i < m_vpThreads.size(); i++)
+	for(size_t i = 0; i < m_vpWorkers.size(); i++)
 	{
 		sphore_signal(&m_Semaphore);
 	}
 
 	// wait for all worker threads to finish
-	for(void *pThread : m_vpThreads)
+	for(std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
 	{
-		thread_wait(pThread);
+		thread_wait(pWorker->m_pThread);
 	}
 
-	m_vpThreads.clear();
+	m_vpWorkers.clear();
 	sphore_destroy(&m_Semaphore);
 }
 
@@ -215,15 +290,17 @@ void CJobPool::Add(std::shared_ptr<IJob> pJob)
 		return;
 	}
 
-	// add job to queue
+	// add job to the queue of the current worker or to the shared queue
+	CWorker *pWorker = ms_pCurrentWorker;
+	if(pWorker != nullptr && pWorker->m_pPool == this)
+	{
+		pWorker->m_Queue.Push(std::move(pJob));
+	}
+	else
 	{
-		const CLockScope LockScope(m_Lock);
-		if(m_pLastJob)
-			m_pLastJob->m_pNext = pJob;
-		m_pLastJob = std::move(pJob);
-		if(!m_pFirstJob)
-			m_pFirstJob = m_pLastJob;
+		m_Queue.Push(std::move(pJob));
 	}
+	m_NumAdded++;
 
 	// signal a worker thread that a job is available
 	sphore_signal(&m_Semaphore);
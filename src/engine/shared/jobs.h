@@ -50,10 +50,34 @@ public:
 		STATE_ABORTED,
 	};
 
+	/**
+	 * The priority of a job. Queued jobs with a higher priority are always
+	 * started before queued jobs with a lower priority.
+	 */
+	enum EJobPriority
+	{
+		/**
+		 * Job is needed as soon as possible, e.g. because a thread waits for it.
+		 */
+		PRIORITY_HIGH = 0,
+
+		/**
+		 * Default priority of jobs.
+		 */
+		PRIORITY_NORMAL,
+
+		/**
+		 * Job is not urgent, e.g. loading and downloading many files in bulk.
+		 */
+		PRIORITY_LOW,
+
+		NUM_PRIORITIES,
+	};
+
 private:
-	std::shared_ptr<IJob> m_pNext;
 	std::atomic<EJobState> m_State;
 	std::atomic<bool> m_Abortable;
+	EJobPriority m_Priority;
 
 protected:
 	/**
@@ -70,6 +94,15 @@ protected:
 	 */
 	void Abortable(bool Abortable);
 
+	/**
+	 * Sets the priority of this job.
+	 *
+	 * @remark Must be called before the job is added to a job pool.
+	 *
+	 * @see EJobPriority
+	 */
+	void SetPriority(EJobPriority Priority);
+
 public:
 	IJob();
 	virtual ~IJob();
@@ -117,28 +150,66 @@ public:
 	 * @return `true` if the job can be aborted, `false` otherwise.
 	 */
 	bool IsAbortable() const;
+
+	/**
+	 * Returns the priority of the job.
+	 *
+	 * @return Priority of the job.
+	 */
+	EJobPriority Priority() const;
 };
 
 /**
  * A job pool which runs jobs in one or more worker threads.
  *
+ * Jobs added by other threads are queued in a shared queue per priority.
+ * Jobs added by a worker thread, e.g. jobs split into smaller jobs, are
+ * queued in a queue of that worker, which runs the most recently added of
+ * them first while idle workers steal the oldest of them.
+ *
  * @see IJob
  */
 class CJobPool
 {
-	std::vector<void *> m_vpThreads;
+	class CQueue
+	{
+	public:
+		CLock m_Lock;
+		std::deque<std::shared_ptr<IJob>> m_aJobs[IJob::NUM_PRIORITIES] GUARDED_BY(m_Lock);
+		// allows skipping empty queues without locking them
+		std::atomic<int> m_aNumJobs[IJob::NUM_PRIORITIES];
+
+		void Push(std::shared_ptr<IJob> pJob) REQUIRES(!m_Lock);
+		std::shared_ptr<IJob> Pop(int Priority, bool Newest) REQUIRES(!m_Lock);
+		void AbortJobs() REQUIRES(!m_Lock);
+	};
+
+	class CWorker
+	{
+	public:
+		CJobPool *m_pPool;
+		int m_Index;
+		void *m_pThread;
+		CQueue m_Queue;
+	};
+
+	static thread_local CWorker *ms_pCurrentWorker;
+
+	std::vector<std::unique_ptr<CWorker>> m_vpWorkers;
 	std::atomic<bool> m_Shutdown;
+	// number of jobs added so far, see RunLoop
+	std::atomic<int> m_NumAdded;
 
-	CLock m_Lock;
 	SEMAPHORE m_Semaphore;
-	std::shared_ptr<IJob> m_pFirstJob GUARDED_BY(m_Lock);
-	std::shared_ptr<IJob> m_pLastJob GUARDED_BY(m_Lock);
+	CQueue m_Queue;
 
 	CLock m_LockRunning;
 	std::deque<std::shared_ptr<IJob>> m_RunningJobs GUARDED_BY(m_LockRunning);
 
 	static void WorkerThread(void *pUser) NO_THREAD_SAFETY_ANALYSIS;
-	void RunLoop() NO_THREAD_SAFETY_ANALYSIS;
+	void RunLoop(CWorker *pWorker) NO_THREAD_SAFETY_ANALYSIS;
+	std::shared_ptr<IJob> PopJob(CWorker *pWorker);
+	void RunJob(const std::shared_ptr<IJob> &pJob) REQUIRES(!m_LockRunning);
 
 public:
 	CJobPool();
@@ -151,7 +222,7 @@ public:
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Init(int NumThreads) REQUIRES(!m_Lock);
+	void Init(int NumThreads);
 
 	/**
 	 * Shuts down the job pool. Aborts all abortable jobs. Then waits for all
@@ -159,16 +230,19 @@ public:
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Shutdown() REQUIRES(!m_Lock) REQUIRES(!m_LockRunning);
+	void Shutdown() REQUIRES(!m_LockRunning);
 
 	/**
 	 * Adds a job to the queue of the job pool.
 	 *
 	 * @param pJob The job to enqueue.
 	 *
+	 * @remark Jobs with the same priority added by the same thread are started
+	 * in the order they were added, unless they are added by a worker thread.
+	 *
 	 * @remark If the job pool is already shutting down, no additional jobs
 	 * will be enqueue anymore. Abortable jobs will immediately be aborted.
 	 */
-	void Add(std::shared_ptr<IJob> pJob) REQUIRES(!m_Lock);
+	void Add(std::shared_ptr<IJob> pJob);
 };
 #endif
@@ -4,11 +4,17 @@
 
 #include <base/log.h>
 
+#include <engine/engine.h>
 #include <engine/storage.h>
 
 #include <game/mapitems.h>
 
-CMap::CMap() = default;
+#include <vector>
+
+CMap::CMap(IEngine *pEngine) :
+	m_pEngine(pEngine)
+{
+}
 
 int CMap::GetDataSize(int Index) const
 {
@@ -79,8 +85,16 @@ bool CMap::Load(const char *pMapName)
 	// Ensure current datafile is not left in an inconsistent state if loading fails,
 	// by loading the new datafile separately first.
 	CDataFileReader NewDataFile;
-	if(!NewDataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL))
+	if(!NewDataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL, true))
+		return false;
+
+	// the client and the server always use the hashes of the map, a map that can't be hashed completely is rejected
+	if(!NewDataFile.CalculateHashes())
+	{
+		log_error("map/load", "Error: could not calculate the hashes of the map.");
+		NewDataFile.Close();
 		return false;
+	}
 
 	// Check version
 	const CMapItemVersion *pItem = (CMapItemVersion *)NewDataFile.FindItem(MAPITEMTYPE_VERSION, 0);
@@ -95,6 +109,23 @@ bool CMap::Load(const char *pMapName)
 	int GroupsStart, GroupsNum, LayersStart, LayersNum;
 	NewDataFile.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
 	NewDataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+
+	// Decompress the tile data of all layers at once, this is most of the loading time of big maps
+	std::vector<int> vTileData;
+	for(int g = 0; g < GroupsNum; g++)
+	{
+		const CMapItemGroup *pGroup = static_cast<CMapItemGroup *>(NewDataFile.GetItem(GroupsStart + g));
+		for(int l = 0; l < pGroup->m_NumLayers; l++)
+		{
+			const CMapItemLayer *pLayer = static_cast<CMapItemLayer *>(NewDataFile.GetItem(LayersStart + pGroup->m_StartLayer + l));
+			if(pLayer->m_Type == LAYERTYPE_TILES)
+			{
+				vTileData.push_back(reinterpret_cast<const CMapItemLayerTilemap *>(pLayer)->m_Data);
+			}
+		}
+	}
+	NewDataFile.LoadData(vTileData, m_pEngine);
+
 	for(int g = 0; g < GroupsNum; g++)
 	{
 		const CMapItemGroup *pGroup = static_cast<CMapItemGroup *>(NewDataFile.GetItem(GroupsStart + g));
@@ -176,4 +207,4 @@ void CMap::ExtractTiles(CTile *pDest, size_t DestSize, const CTile *pSrc, size_t
 	}
 }
 
-extern IEngineMap *CreateEngineMap() { return new CMap; }
+extern IEngineMap *CreateEngineMap(IEngine *pEngine) { return new CMap(pEngine); }
@@ -12,9 +12,10 @@
 class CMap : public IEngineMap
 {
 	CDataFileReader m_DataFile;
+	class IEngine *m_pEngine;
 
 public:
-	CMap();
+	CMap(class IEngine *pEngine = nullptr);
 
 	CDataFileReader *GetReader() { return &m_DataFile; }
 
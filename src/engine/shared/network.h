@@ -13,6 +13,7 @@
 
 class CHuffman;
 class CNetBan;
+class CNetRecvThread;
 class CPacker;
 
 /*
@@ -463,6 +464,7 @@ public:
 	int Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken);
 	int Send(CNetChunk *pChunk);
 	void Update();
+	void Flush();
 
 	//
 	void Drop(int ClientId, const char *pReason);
@@ -574,10 +576,15 @@ class CNetClient
 
 	CStun *m_pStun = nullptr;
 
+	// optional thread reading the socket so packets are timestamped when they arrive
+	CNetRecvThread *m_pRecvThread = nullptr;
+	int64_t m_LastRecvTime = 0;
+	int RecvPacket(NETADDR *pAddr, unsigned char **ppData);
+
 public:
 	NETSOCKET m_Socket = nullptr;
 	// openness
-	bool Open(NETADDR BindAddr);
+	bool Open(NETADDR BindAddr, bool RecvThread = false);
 	void Close();
 
 	// connection state
@@ -598,6 +605,8 @@ public:
 	// error and state
 	int NetType() const { return net_socket_type(m_Socket); }
 	int State();
+	// arrival time of the packet the last received chunk came from
+	int64_t LastRecvTime() const { return m_LastRecvTime; }
 	const NETADDR *ServerAddress() const { return m_Connection.PeerAddress(); }
 	void ConnectAddresses(const NETADDR **ppAddrs, int *pNumAddrs) const { m_Connection.ConnectAddresses(ppAddrs, pNumAddrs); }
 	bool GotProblems(int64_t MaxLatency) const;
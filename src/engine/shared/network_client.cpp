@@ -7,7 +7,116 @@
 
 #include <engine/shared/protocol7.h>
 
-bool CNetClient::Open(NETADDR BindAddr)
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+// Receives packets on its own thread and hands them to the network client
+// through a single producer, single consumer ring, so that a slow frame
+// doesn't delay when a packet is considered received.
+class CNetRecvThread
+{
+	enum
+	{
+		QUEUE_SIZE = 256,
+	};
+
+	class CPacket
+	{
+	public:
+		NETADDR m_Addr;
+		int64_t m_RecvTime;
+		int m_DataSize;
+		unsigned char m_aData[NET_MAX_PACKETSIZE];
+	};
+
+	NETSOCKET m_Socket;
+	void *m_pThread;
+	std::atomic_bool m_Stop = false;
+
+	// m_Tail is only written by the receive thread, m_Head only by the consumer
+	std::atomic<unsigned> m_Head = 0;
+	std::atomic<unsigned> m_Tail = 0;
+	bool m_Peeked = false;
+	CPacket m_aQueue[QUEUE_SIZE];
+
+	static void ThreadMain(void *pUser) { static_cast<CNetRecvThread *>(pUser)->Run(); }
+
+	void Run()
+	{
+		while(!m_Stop.load(std::memory_order_relaxed))
+		{
+			bool Full = false;
+			while(true)
+			{
+				const unsigned Tail = m_Tail.load(std::memory_order_relaxed);
+				if(Tail - m_Head.load(std::memory_order_acquire) == QUEUE_SIZE)
+				{
+					Full = true;
+					break;
+				}
+
+				NETADDR Addr;
+				unsigned char *pData;
+				const int Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+				if(Bytes <= 0)
+					break;
+				if(Bytes > (int)sizeof(CPacket::m_aData))
+					continue;
+
+				CPacket &Packet = m_aQueue[Tail % QUEUE_SIZE];
+				Packet.m_Addr = Addr;
+				Packet.m_RecvTime = time_get();
+				Packet.m_DataSize = Bytes;
+				mem_copy(Packet.m_aData, pData, Bytes);
+				m_Tail.store(Tail + 1, std::memory_order_release);
+			}
+
+			// leave the packets in the socket until the consumer caught up
+			if(Full)
+				std::this_thread::sleep_for(1ms);
+			else
+				net_socket_read_wait(m_Socket, 100ms);
+		}
+	}
+
+public:
+	CNetRecvThread(NETSOCKET Socket) :
+		m_Socket(Socket)
+	{
+		m_pThread = thread_init(ThreadMain, this, "network receive");
+	}
+
+	~CNetRecvThread()
+	{
+		m_Stop.store(true, std::memory_order_relaxed);
+		thread_wait(m_pThread);
+	}
+
+	// the returned data stays valid until the next call
+	int Recv(NETADDR *pAddr, unsigned char **ppData, int64_t *pRecvTime)
+	{
+		unsigned Head = m_Head.load(std::memory_order_relaxed);
+		if(m_Peeked)
+		{
+			m_Head.store(++Head, std::memory_order_release);
+			m_Peeked = false;
+		}
+		if(Head == m_Tail.load(std::memory_order_acquire))
+			return 0;
+
+		CPacket &Packet = m_aQueue[Head % QUEUE_SIZE];
+		*pAddr = Packet.m_Addr;
+		*ppData = Packet.m_aData;
+		*pRecvTime = Packet.m_RecvTime;
+		m_Peeked = true;
+		return Packet.m_DataSize;
+	}
+};
+
+bool CNetClient::Open(NETADDR BindAddr, bool RecvThread)
 {
 	// open socket
 	NETSOCKET Socket;
@@ -23,6 +132,8 @@ bool CNetClient::Open(NETADDR BindAddr)
 	m_pStun = new CStun(m_Socket);
 	m_Connection.Init(m_Socket, false);
 	m_TokenCache.Init(m_Socket);
+	if(RecvThread)
+		m_pRecvThread = new CNetRecvThread(m_Socket);
 
 	return true;
 }
@@ -33,6 +144,11 @@ void CNetClient::Close()
 	{
 		return;
 	}
+	if(m_pRecvThread)
+	{
+		delete m_pRecvThread;
+		m_pRecvThread = nullptr;
+	}
 	if(m_pStun)
 	{
 		delete m_pStun;
@@ -82,7 +198,7 @@ int CNetClient::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken, bool Six
 		// TODO: empty the recvinfo
 		NETADDR Addr;
 		unsigned char *pData;
-		int Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		int Bytes = RecvPacket(&Addr, &pData);
 
 		// no more packets for now
 		if(Bytes <= 0)
@@ -142,6 +258,17 @@ int CNetClient::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken, bool Six
 	return 0;
 }
 
+int CNetClient::RecvPacket(NETADDR *pAddr, unsigned char **ppData)
+{
+	if(m_pRecvThread)
+		return m_pRecvThread->Recv(pAddr, ppData, &m_LastRecvTime);
+
+	const int Bytes = net_udp_recv(m_Socket, pAddr, ppData);
+	if(Bytes > 0)
+		m_LastRecvTime = time_get();
+	return Bytes;
+}
+
 int CNetClient::Send(CNetChunk *pChunk)
 {
 	if(pChunk->m_DataSize >= NET_MAX_PAYLOAD)
@@ -118,6 +118,11 @@ void CNetServer::Update()
 	}
 }
 
+void CNetServer::Flush()
+{
+	net_udp_flush(m_Socket);
+}
+
 SECURITY_TOKEN CNetServer::GetGlobalToken()
 {
 	static const NETADDR NULL_ADDR = {0};
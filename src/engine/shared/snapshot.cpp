@@ -11,9 +11,18 @@
 #include <generated/protocol7.h>
 #include <generated/protocolglue.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CONF_SNAPSHOT_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CONF_SNAPSHOT_NEON 1
+#endif
+
 // CSnapshot
 
 const CSnapshotItem *CSnapshot::GetItem(int Index) const
@@ -162,61 +171,113 @@ bool CSnapshot::IsValid(size_t ActualSize) const
 
 // CSnapshotDelta
 
-enum
+// Maps item keys to item indices with open addressing. The table is sized
+// for the number of items, so building it only touches a few cache lines.
+class CItemIndex
 {
-	HASHLIST_SIZE = 256,
-	HASHLIST_BUCKET_SIZE = 64,
-};
+	enum
+	{
+		MAX_SLOTS = 2 * CSnapshot::MAX_ITEMS,
+	};
 
-struct CItemList
-{
-	int m_Num;
-	int m_aKeys[HASHLIST_BUCKET_SIZE];
-	int m_aIndex[HASHLIST_BUCKET_SIZE];
-};
+	unsigned m_Shift;
+	unsigned m_Mask;
+	int m_aKeys[MAX_SLOTS];
+	int m_aIndices[MAX_SLOTS];
 
-static inline size_t CalcHashId(int Key)
-{
-	// djb2 (http://www.cse.yorku.ca/~oz/hash.html)
-	unsigned Hash = 5381;
-	for(unsigned Shift = 0; Shift < sizeof(int); Shift++)
-		Hash = ((Hash << 5) + Hash) + ((Key >> (Shift * 8)) & 0xFF);
-	return Hash % HASHLIST_SIZE;
-}
+	unsigned Slot(int Key) const
+	{
+		// fibonacci hashing
+		return ((unsigned)Key * 2654435769u) >> m_Shift;
+	}
 
-static void GenerateHash(CItemList *pHashlist, const CSnapshot *pSnapshot)
-{
-	for(int i = 0; i < HASHLIST_SIZE; i++)
-		pHashlist[i].m_Num = 0;
+public:
+	void Init(int NumItems)
+	{
+		dbg_assert(NumItems <= CSnapshot::MAX_ITEMS, "too many items for index");
+		unsigned Bits = 4;
+		while((1 << Bits) < 2 * NumItems)
+			Bits++;
+		m_Shift = 32 - Bits;
+		m_Mask = (1u << Bits) - 1;
+		std::fill(m_aIndices, m_aIndices + (1 << Bits), -1);
+	}
 
-	for(int i = 0; i < pSnapshot->NumItems(); i++)
+	void Init(const CSnapshot *pSnapshot)
 	{
-		int Key = pSnapshot->GetItem(i)->Key();
-		size_t HashId = CalcHashId(Key);
-		if(pHashlist[HashId].m_Num < HASHLIST_BUCKET_SIZE)
+		Init(pSnapshot->NumItems());
+		for(int i = 0; i < pSnapshot->NumItems(); i++)
+			Insert(pSnapshot->GetItem(i)->Key(), i);
+	}
+
+	// keeps the first index if the key is added again
+	void Insert(int Key, int Index)
+	{
+		unsigned Slot = this->Slot(Key);
+		while(m_aIndices[Slot] != -1)
 		{
-			pHashlist[HashId].m_aIndex[pHashlist[HashId].m_Num] = i;
-			pHashlist[HashId].m_aKeys[pHashlist[HashId].m_Num] = Key;
-			pHashlist[HashId].m_Num++;
+			if(m_aKeys[Slot] == Key)
+				return;
+			Slot = (Slot + 1) & m_Mask;
 		}
+		m_aKeys[Slot] = Key;
+		m_aIndices[Slot] = Index;
 	}
-}
 
-static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
-{
-	size_t HashId = CalcHashId(Key);
-	for(int i = 0; i < pHashlist[HashId].m_Num; i++)
+	int Find(int Key) const
 	{
-		if(pHashlist[HashId].m_aKeys[i] == Key)
-			return pHashlist[HashId].m_aIndex[i];
+		unsigned Slot = this->Slot(Key);
+		while(m_aIndices[Slot] != -1)
+		{
+			if(m_aKeys[Slot] == Key)
+				return m_aIndices[Slot];
+			Slot = (Slot + 1) & m_Mask;
+		}
+		return -1;
 	}
+};
 
-	return -1;
+// Number of bits the data rate statistic counts for a diffed int, the
+// size of the packed CVariableInt, except for zeros which count as 1 bit.
+static inline uint64_t DiffDataRate(int Diff)
+{
+	if(Diff == 0)
+		return 1;
+	const unsigned Value = Diff ^ (Diff >> 31); // drop the sign like CVariableInt::Pack
+	return 8 * (1 + (Value >= (1u << 6)) + (Value >= (1u << 13)) + (Value >= (1u << 20)) + (Value >= (1u << 27)));
 }
 
 int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size)
 {
 	int Needed = 0;
+#if defined(CONF_SNAPSHOT_SSE2)
+	__m128i NeededVec = _mm_setzero_si128();
+	for(; Size >= 4; Size -= 4)
+	{
+		const __m128i Diff = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)pCurrent), _mm_loadu_si128((const __m128i *)pPast));
+		_mm_storeu_si128((__m128i *)pOut, Diff);
+		NeededVec = _mm_or_si128(NeededVec, Diff);
+		pOut += 4;
+		pPast += 4;
+		pCurrent += 4;
+	}
+	NeededVec = _mm_or_si128(NeededVec, _mm_srli_si128(NeededVec, 8));
+	NeededVec = _mm_or_si128(NeededVec, _mm_srli_si128(NeededVec, 4));
+	Needed = _mm_cvtsi128_si32(NeededVec);
+#elif defined(CONF_SNAPSHOT_NEON)
+	uint32x4_t NeededVec = vdupq_n_u32(0);
+	for(; Size >= 4; Size -= 4)
+	{
+		const uint32x4_t Diff = vsubq_u32(vld1q_u32((const uint32_t *)pCurrent), vld1q_u32((const uint32_t *)pPast));
+		vst1q_u32((uint32_t *)pOut, Diff);
+		NeededVec = vorrq_u32(NeededVec, Diff);
+		pOut += 4;
+		pPast += 4;
+		pCurrent += 4;
+	}
+	const uint32x2_t NeededHalf = vorr_u32(vget_low_u32(NeededVec), vget_high_u32(NeededVec));
+	Needed = vget_lane_u32(NeededHalf, 0) | vget_lane_u32(NeededHalf, 1);
+#endif
 	while(Size)
 	{
 		// subtraction with wrapping by casting to unsigned
@@ -233,20 +294,32 @@ int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, i
 
 void CSnapshotDelta::UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
 {
+	uint64_t DataRate = 0;
+	for(int i = 0; i < Size; i++)
+		DataRate += DiffDataRate(pDiff[i]);
+	*pDataRate += DataRate;
+
+#if defined(CONF_SNAPSHOT_SSE2)
+	for(; Size >= 4; Size -= 4)
+	{
+		_mm_storeu_si128((__m128i *)pOut, _mm_add_epi32(_mm_loadu_si128((const __m128i *)pPast), _mm_loadu_si128((const __m128i *)pDiff)));
+		pOut += 4;
+		pPast += 4;
+		pDiff += 4;
+	}
+#elif defined(CONF_SNAPSHOT_NEON)
+	for(; Size >= 4; Size -= 4)
+	{
+		vst1q_u32((uint32_t *)pOut, vaddq_u32(vld1q_u32((const uint32_t *)pPast), vld1q_u32((const uint32_t *)pDiff)));
+		pOut += 4;
+		pPast += 4;
+		pDiff += 4;
+	}
+#endif
 	while(Size)
 	{
 		// addition with wrapping by casting to unsigned
 		*pOut = (unsigned)*pPast + (unsigned)*pDiff;
-
-		if(*pDiff == 0)
-			*pDataRate += 1;
-		else
-		{
-			unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
-			unsigned char *pEnd = CVariableInt::Pack(aBuf, *pDiff, sizeof(aBuf));
-			*pDataRate += (uint64_t)(pEnd - (unsigned char *)aBuf) * 8;
-		}
-
 		pOut++;
 		pPast++;
 		pDiff++;
@@ -291,7 +364,6 @@ const CSnapshotDelta::CData *CSnapshotDelta::EmptyDelta() const
 	return &m_Empty;
 }
 
-// TODO: OPT: this should be made much faster
 int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData)
 {
 	CData *pDelta = (CData *)pDstData;
@@ -301,14 +373,14 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 	pDelta->m_NumUpdateItems = 0;
 	pDelta->m_NumTempItems = 0;
 
-	CItemList aHashlist[HASHLIST_SIZE];
-	GenerateHash(aHashlist, pTo);
+	CItemIndex Index;
+	Index.Init(pTo);
 
 	// pack deleted stuff
 	for(int i = 0; i < pFrom->NumItems(); i++)
 	{
 		const CSnapshotItem *pFromItem = pFrom->GetItem(i);
-		if(GetItemIndexHashed(pFromItem->Key(), aHashlist) == -1)
+		if(Index.Find(pFromItem->Key()) == -1)
 		{
 			// deleted
 			pDelta->m_NumDeletedItems++;
@@ -317,7 +389,7 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 		}
 	}
 
-	GenerateHash(aHashlist, pFrom);
+	Index.Init(pFrom);
 
 	// fetch previous indices
 	// we do this as a separate pass because it helps the cache
@@ -326,7 +398,7 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 	for(int i = 0; i < NumItems; i++)
 	{
 		const CSnapshotItem *pCurItem = pTo->GetItem(i); // O(1) .. O(n)
-		aPastIndices[i] = GetItemIndexHashed(pCurItem->Key(), aHashlist); // O(n) .. O(n^n)
+		aPastIndices[i] = Index.Find(pCurItem->Key());
 	}
 
 	for(int i = 0; i < NumItems; i++)
@@ -516,30 +588,27 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 	CSnapshotBuilder Builder;
 	Builder.Init();
 
-	// unpack deleted stuff
+	// unpack deleted stuff, a snapshot can't have more items to delete
 	int *pDeleted = pData;
-	if(pDelta->m_NumDeletedItems < 0)
+	if(pDelta->m_NumDeletedItems < 0 || pDelta->m_NumDeletedItems > CSnapshot::MAX_ITEMS)
 		return -201;
 	pData += pDelta->m_NumDeletedItems;
 	if(pData > pEnd)
 		return -101;
 
-	// copy all non deleted stuff
+	CItemIndex DeletedIndex;
+	DeletedIndex.Init(pDelta->m_NumDeletedItems);
+	for(int d = 0; d < pDelta->m_NumDeletedItems; d++)
+		DeletedIndex.Insert(pDeleted[d], d);
+
+	// copy all non deleted stuff, remembering where it went for the updates
+	int *apKeptData[CSnapshot::MAX_ITEMS];
 	for(int i = 0; i < pFrom->NumItems(); i++)
 	{
 		const CSnapshotItem *pFromItem = pFrom->GetItem(i);
 		const int ItemSize = pFrom->GetItemSize(i);
-		bool Keep = true;
-		for(int d = 0; d < pDelta->m_NumDeletedItems; d++)
-		{
-			if(pDeleted[d] == pFromItem->Key())
-			{
-				Keep = false;
-				break;
-			}
-		}
-
-		if(Keep)
+		apKeptData[i] = nullptr;
+		if(pDelta->m_NumDeletedItems == 0 || DeletedIndex.Find(pFromItem->Key()) == -1)
 		{
 			void *pObj = Builder.NewItem(pFromItem->Type(), pFromItem->Id(), ItemSize);
 			if(!pObj)
@@ -547,9 +616,19 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 
 			// keep it
 			mem_copy(pObj, pFromItem->Data(), ItemSize);
+			apKeptData[i] = (int *)pObj;
 		}
 	}
 
+	CItemIndex FromIndex;
+	FromIndex.Init(pFrom);
+
+	// items that weren't in the old snapshot
+	CItemIndex AddedIndex;
+	AddedIndex.Init(std::clamp(pDelta->m_NumUpdateItems, 0, (int)CSnapshot::MAX_ITEMS));
+	int *apAddedData[CSnapshot::MAX_ITEMS];
+	int NumAddedItems = 0;
+
 	// unpack updated stuff
 	for(int i = 0; i < pDelta->m_NumUpdateItems; i++)
 	{
@@ -583,18 +662,31 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 		const int Key = (Type << 16) | Id;
 
 		// create the item if needed
-		int *pNewData = Builder.GetItemData(Key);
+		const int PastIndex = FromIndex.Find(Key);
+		int *pNewData = PastIndex != -1 ? apKeptData[PastIndex] : nullptr;
+		if(!pNewData)
+		{
+			const int AddedIndexFound = AddedIndex.Find(Key);
+			if(AddedIndexFound != -1)
+				pNewData = apAddedData[AddedIndexFound];
+		}
 		if(!pNewData)
+		{
 			pNewData = (int *)Builder.NewItem(Type, Id, ItemSize);
+			if(pNewData)
+			{
+				AddedIndex.Insert(Key, NumAddedItems);
+				apAddedData[NumAddedItems++] = pNewData;
+			}
+		}
 
 		if(!pNewData)
 			return -302;
 
-		const int FromIndex = pFrom->GetItemIndex(Key);
-		if(FromIndex != -1)
+		if(PastIndex != -1)
 		{
 			// we got an update so we need to apply the diff
-			UndiffItem(pFrom->GetItem(FromIndex)->Data(), pData, pNewData, ItemSize / sizeof(int32_t), &m_aSnapshotDataRate[Type]);
+			UndiffItem(pFrom->GetItem(PastIndex)->Data(), pData, pNewData, ItemSize / sizeof(int32_t), &m_aSnapshotDataRate[Type]);
 		}
 		else // no previous, just copy the pData
 		{
@@ -612,10 +704,99 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 
 // CSnapshotStorage
 
+static size_t AlignHolderSize(size_t Size)
+{
+	return (Size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+}
+
+CSnapshotStorage::~CSnapshotStorage()
+{
+	PurgeAll();
+	free(m_pCurrentBlock);
+	while(m_pFreeBlocks)
+	{
+		CBlock *pNext = m_pFreeBlocks->m_pNextFree;
+		free(m_pFreeBlocks);
+		m_pFreeBlocks = pNext;
+	}
+}
+
 void CSnapshotStorage::Init()
 {
 	m_pFirst = nullptr;
 	m_pLast = nullptr;
+	m_pCurrentBlock = nullptr;
+	m_pFreeBlocks = nullptr;
+	m_NumFreeBlocks = 0;
+}
+
+CSnapshotStorage::CHolder *CSnapshotStorage::AllocHolder(size_t Size)
+{
+	const size_t BlockHeaderSize = AlignHolderSize(sizeof(CBlock));
+	Size = AlignHolderSize(Size);
+	if(!m_pCurrentBlock || m_pCurrentBlock->m_Used + Size > m_pCurrentBlock->m_Capacity)
+	{
+		CBlock *pFull = m_pCurrentBlock;
+		m_pCurrentBlock = nullptr;
+
+		// reuse a free block if it's big enough
+		CBlock **ppFree = &m_pFreeBlocks;
+		while(*ppFree)
+		{
+			if((*ppFree)->m_Capacity >= BlockHeaderSize + Size)
+			{
+				m_pCurrentBlock = *ppFree;
+				*ppFree = m_pCurrentBlock->m_pNextFree;
+				m_NumFreeBlocks--;
+				break;
+			}
+			ppFree = &(*ppFree)->m_pNextFree;
+		}
+		if(!m_pCurrentBlock)
+		{
+			const size_t Capacity = maximum<size_t>(BLOCK_SIZE, BlockHeaderSize + Size);
+			m_pCurrentBlock = static_cast<CBlock *>(malloc(Capacity));
+			m_pCurrentBlock->m_Capacity = Capacity;
+		}
+		m_pCurrentBlock->m_Used = BlockHeaderSize;
+		m_pCurrentBlock->m_NumHolders = 0;
+		m_pCurrentBlock->m_pNextFree = nullptr;
+
+		// the previous block is released by its last holder
+		if(pFull && pFull->m_NumHolders == 0)
+			ReleaseBlock(pFull);
+	}
+
+	CHolder *pHolder = reinterpret_cast<CHolder *>(reinterpret_cast<char *>(m_pCurrentBlock) + m_pCurrentBlock->m_Used);
+	pHolder->m_pBlock = m_pCurrentBlock;
+	m_pCurrentBlock->m_Used += Size;
+	m_pCurrentBlock->m_NumHolders++;
+	return pHolder;
+}
+
+void CSnapshotStorage::FreeHolder(CHolder *pHolder)
+{
+	CBlock *pBlock = pHolder->m_pBlock;
+	pBlock->m_NumHolders--;
+	if(pBlock->m_NumHolders > 0)
+		return;
+
+	if(pBlock == m_pCurrentBlock)
+		pBlock->m_Used = AlignHolderSize(sizeof(CBlock)); // start over in place
+	else
+		ReleaseBlock(pBlock);
+}
+
+void CSnapshotStorage::ReleaseBlock(CBlock *pBlock)
+{
+	if(m_NumFreeBlocks >= MAX_FREE_BLOCKS)
+	{
+		free(pBlock);
+		return;
+	}
+	pBlock->m_pNextFree = m_pFreeBlocks;
+	m_pFreeBlocks = pBlock;
+	m_NumFreeBlocks++;
 }
 
 void CSnapshotStorage::PurgeAll()
@@ -623,9 +804,7 @@ void CSnapshotStorage::PurgeAll()
 	while(m_pFirst)
 	{
 		CHolder *pNext = m_pFirst->m_pNext;
-		free(m_pFirst->m_pSnap);
-		free(m_pFirst->m_pAltSnap);
-		free(m_pFirst);
+		FreeHolder(m_pFirst);
 		m_pFirst = pNext;
 	}
 	m_pLast = nullptr;
@@ -640,9 +819,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 		CHolder *pNext = pHolder->m_pNext;
 		if(pHolder->m_Tick >= Tick)
 			return; // no more to remove
-		free(pHolder->m_pSnap);
-		free(pHolder->m_pAltSnap);
-		free(pHolder);
+		FreeHolder(pHolder);
 
 		// did we come to the end of the list?
 		if(!pNext)
@@ -663,17 +840,21 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 	dbg_assert(DataSize <= (size_t)CSnapshot::MAX_SIZE, "Snapshot data size invalid");
 	dbg_assert(AltDataSize <= (size_t)CSnapshot::MAX_SIZE, "Alt snapshot data size invalid");
 
-	CHolder *pHolder = static_cast<CHolder *>(malloc(sizeof(CHolder)));
+	// the holder, the snapshot and the alternative snapshot are stored together
+	const size_t HolderSize = AlignHolderSize(sizeof(CHolder));
+	const size_t SnapSize = AlignHolderSize(DataSize);
+	CHolder *pHolder = AllocHolder(HolderSize + SnapSize + AltDataSize);
+	char *pHolderData = reinterpret_cast<char *>(pHolder);
 	pHolder->m_Tick = Tick;
 	pHolder->m_Tagtime = Tagtime;
 
-	pHolder->m_pSnap = static_cast<CSnapshot *>(malloc(DataSize));
+	pHolder->m_pSnap = reinterpret_cast<CSnapshot *>(pHolderData + HolderSize);
 	mem_copy(pHolder->m_pSnap, pData, DataSize);
 	pHolder->m_SnapSize = DataSize;
 
 	if(AltDataSize) // create alternative if wanted
 	{
-		pHolder->m_pAltSnap = static_cast<CSnapshot *>(malloc(AltDataSize));
+		pHolder->m_pAltSnap = reinterpret_cast<CSnapshot *>(pHolderData + HolderSize + SnapSize);
 		mem_copy(pHolder->m_pAltSnap, pAltData, AltDataSize);
 		pHolder->m_AltSnapSize = AltDataSize;
 	}
@@ -734,6 +915,12 @@ void CSnapshotBuilder::Init(bool Sixup)
 	}
 }
 
+void CSnapshotBuilder::CopyExtendedItemTypes(const CSnapshotBuilder &Other)
+{
+	mem_copy(m_aExtendedItemTypes, Other.m_aExtendedItemTypes, sizeof(m_aExtendedItemTypes[0]) * Other.m_NumExtendedItemTypes);
+	m_NumExtendedItemTypes = Other.m_NumExtendedItemTypes;
+}
+
 CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
 {
 	return (CSnapshotItem *)&(m_aData[m_aOffsets[Index]]);
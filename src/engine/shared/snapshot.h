@@ -117,6 +117,8 @@ public:
 
 class CSnapshotStorage
 {
+	class CBlock;
+
 public:
 	class CHolder
 	{
@@ -132,18 +134,47 @@ public:
 
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+
+		CBlock *m_pBlock;
 	};
 
 	CHolder *m_pFirst;
 	CHolder *m_pLast;
 
 	CSnapshotStorage() { Init(); }
-	~CSnapshotStorage() { PurgeAll(); }
+	~CSnapshotStorage();
 	void Init();
 	void PurgeAll();
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64_t Tagtime, size_t DataSize, const void *pData, size_t AltDataSize, const void *pAltData);
 	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const;
+
+private:
+	// Holders are carved out of large blocks in the order they are added.
+	// As they are also purged in that order, a block can be reused as soon
+	// as its last holder is gone, which avoids allocating on every tick.
+	class CBlock
+	{
+	public:
+		size_t m_Capacity;
+		size_t m_Used;
+		int m_NumHolders;
+		CBlock *m_pNextFree;
+	};
+
+	enum
+	{
+		BLOCK_SIZE = 128 * 1024,
+		MAX_FREE_BLOCKS = 2,
+	};
+
+	CBlock *m_pCurrentBlock;
+	CBlock *m_pFreeBlocks;
+	int m_NumFreeBlocks;
+
+	CHolder *AllocHolder(size_t Size);
+	void FreeHolder(CHolder *pHolder);
+	void ReleaseBlock(CBlock *pBlock);
 };
 
 class CSnapshotBuilder
@@ -173,11 +204,14 @@ public:
 
 	void Init(bool Sixup = false);
 	void Init7(const CSnapshot *pSnapshot);
+	// use the same indices for the extended item types as another builder
+	void CopyExtendedItemTypes(const CSnapshotBuilder &Other);
 
 	void *NewItem(int Type, int Id, int Size);
 
 	CSnapshotItem *GetItem(int Index);
 	int *GetItemData(int Key);
+	int NumItems() const { return m_NumItems; }
 
 	int Finish(void *pSnapdata);
 };
@@ -6,6 +6,8 @@
 #include <base/system.h>
 
 #include <engine/client/updater.h>
+#include <engine/shared/config.h>
+#include <engine/shared/digest_cache.h>
 #include <engine/shared/linereader.h>
 #include <engine/storage.h>
 
@@ -25,6 +27,8 @@ class CStorage : public IStorage
 	char m_aDatadir[IO_MAX_PATH_LENGTH] = "";
 	char m_aCurrentdir[IO_MAX_PATH_LENGTH] = "";
 	char m_aBinarydir[IO_MAX_PATH_LENGTH] = "";
+	bool m_UseDigestCache = false;
+	CDigestCache m_DigestCache;
 
 public:
 	bool Init(EInitializationType InitializationType, int NumArgs, const char **ppArguments)
@@ -63,6 +67,10 @@ public:
 				log_error("storage", "failed to create the user directory");
 				return false;
 			}
+
+			char aDigestCache[IO_MAX_PATH_LENGTH];
+			m_DigestCache.Init(GetPath(TYPE_SAVE, "digest_cache.txt", aDigestCache, sizeof(aDigestCache)));
+			m_UseDigestCache = true;
 		}
 
 		bool Success = true;
@@ -659,6 +667,21 @@ public:
 		return true;
 	}
 
+	bool FindDigest(const char *pPath, const IO_FILE_INFO &Info, SHA256_DIGEST *pSha256, unsigned *pCrc) override
+	{
+		// strict mode always hashes and only checks the cache when adding
+		if(!m_UseDigestCache || g_Config.m_DigestCache != 1)
+			return false;
+		return m_DigestCache.Find(pPath, Info, pSha256, pCrc);
+	}
+
+	void AddDigest(const char *pPath, const IO_FILE_INFO &Info, const SHA256_DIGEST &Sha256, unsigned Crc) override
+	{
+		if(!m_UseDigestCache || g_Config.m_DigestCache == 0)
+			return;
+		m_DigestCache.Add(pPath, Info, Sha256, Crc);
+	}
+
 	struct CFindCBData
 	{
 		CStorage *m_pStorage;
@@ -0,0 +1,337 @@
+#include "teehistorian_file.h"
+
+#include <engine/shared/uuid_manager.h>
+
+#include <zlib.h>
+
+/*
+	Compressed teehistorian files:
+
+	uuid			teehistorian-frames@ddnet.tw
+	frames			tick (4), compressed size (4), uncompressed size (4), zlib data
+	index			per frame: tick (4), file offset (8), compressed size (4), uncompressed size (4)
+	trailer			number of frames (4), offset of the index (8), uuid
+
+	All integers are big-endian.
+*/
+
+static const CUuid TEEHISTORIAN_FRAMES_UUID = CalculateUuid("teehistorian-frames@ddnet.tw");
+
+enum
+{
+	FRAME_HEADER_SIZE = 12,
+	INDEX_ENTRY_SIZE = 20,
+	TRAILER_SIZE = 12 + sizeof(CUuid),
+};
+
+static void Int64ToBytesBe(unsigned char *pBytes, int64_t Value)
+{
+	uint_to_bytes_be(pBytes, (uint64_t)Value >> 32);
+	uint_to_bytes_be(pBytes + 4, (uint64_t)Value & 0xffffffff);
+}
+
+static int64_t BytesBeToInt64(const unsigned char *pBytes)
+{
+	return (int64_t)(((uint64_t)bytes_be_to_uint(pBytes) << 32) | bytes_be_to_uint(pBytes + 4));
+}
+
+void CTeeHistorianWriter::Open(IOHANDLE File, bool Compressed, size_t FrameSize)
+{
+	m_File = File;
+	m_Compressed = Compressed;
+	m_Error = 0;
+	if(!m_Compressed)
+	{
+		m_pAio = aio_new(File);
+		return;
+	}
+
+	io_write(m_File, &TEEHISTORIAN_FRAMES_UUID, sizeof(TEEHISTORIAN_FRAMES_UUID));
+	m_Offset = sizeof(TEEHISTORIAN_FRAMES_UUID);
+	m_vIndex.clear();
+	m_FrameSize = FrameSize;
+	m_CurrentFrame.m_Tick = -1;
+	m_CurrentFrame.m_vData.clear();
+	{
+		const CLockScope LockScope(m_Lock);
+		m_Finish = false;
+	}
+	m_pThread = thread_init(ThreadMain, this, "teehistorian writer");
+}
+
+void CTeeHistorianWriter::Write(const void *pData, int DataSize)
+{
+	if(!m_Compressed)
+	{
+		aio_write(m_pAio, pData, DataSize);
+		return;
+	}
+	const unsigned char *pBytes = static_cast<const unsigned char *>(pData);
+	m_CurrentFrame.m_vData.insert(m_CurrentFrame.m_vData.end(), pBytes, pBytes + DataSize);
+}
+
+void CTeeHistorianWriter::BeginTick(int Tick)
+{
+	if(!m_Compressed || m_CurrentFrame.m_vData.size() < m_FrameSize)
+		return;
+	QueueFrame();
+	m_CurrentFrame.m_Tick = Tick;
+}
+
+void CTeeHistorianWriter::QueueFrame()
+{
+	{
+		const CLockScope LockScope(m_Lock);
+		m_vQueuedFrames.push_back(std::move(m_CurrentFrame));
+	}
+	m_Semaphore.Signal();
+	m_CurrentFrame.m_vData = std::vector<unsigned char>();
+	m_CurrentFrame.m_vData.reserve(m_FrameSize);
+}
+
+int CTeeHistorianWriter::Error() const
+{
+	if(!m_Compressed)
+		return aio_error(m_pAio);
+	return m_Error;
+}
+
+int CTeeHistorianWriter::Close()
+{
+	if(!m_Compressed)
+	{
+		aio_close(m_pAio);
+		aio_wait(m_pAio);
+		const int Error = aio_error(m_pAio);
+		aio_free(m_pAio);
+		m_pAio = nullptr;
+		return Error;
+	}
+
+	if(!m_CurrentFrame.m_vData.empty())
+		QueueFrame();
+	{
+		const CLockScope LockScope(m_Lock);
+		m_Finish = true;
+	}
+	m_Semaphore.Signal();
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+
+	if(io_close(m_File) != 0 && m_Error == 0)
+		m_Error = -1;
+	m_File = nullptr;
+	return m_Error;
+}
+
+void CTeeHistorianWriter::ThreadMain(void *pUser)
+{
+	static_cast<CTeeHistorianWriter *>(pUser)->Run();
+}
+
+void CTeeHistorianWriter::Run()
+{
+	std::vector<CFrame> vFrames;
+	bool Finish = false;
+	while(!Finish)
+	{
+		m_Semaphore.Wait();
+		{
+			const CLockScope LockScope(m_Lock);
+			std::swap(vFrames, m_vQueuedFrames);
+			Finish = m_Finish;
+		}
+		for(const CFrame &Frame : vFrames)
+			WriteFrame(Frame);
+		vFrames.clear();
+	}
+	WriteIndex();
+}
+
+void CTeeHistorianWriter::WriteFrame(const CFrame &Frame)
+{
+	uLongf CompressedSize = compressBound(Frame.m_vData.size());
+	std::vector<unsigned char> vCompressed(FRAME_HEADER_SIZE + CompressedSize);
+	if(compress(vCompressed.data() + FRAME_HEADER_SIZE, &CompressedSize, Frame.m_vData.data(), Frame.m_vData.size()) != Z_OK)
+	{
+		m_Error = -1;
+		return;
+	}
+	uint_to_bytes_be(vCompressed.data(), Frame.m_Tick);
+	uint_to_bytes_be(vCompressed.data() + 4, CompressedSize);
+	uint_to_bytes_be(vCompressed.data() + 8, Frame.m_vData.size());
+
+	const unsigned Size = FRAME_HEADER_SIZE + CompressedSize;
+	if(io_write(m_File, vCompressed.data(), Size) != Size || io_flush(m_File) != 0)
+		m_Error = io_error(m_File) ? io_error(m_File) : -1;
+
+	m_vIndex.push_back({Frame.m_Tick, m_Offset, (unsigned)CompressedSize, (unsigned)Frame.m_vData.size()});
+	m_Offset += Size;
+}
+
+void CTeeHistorianWriter::WriteIndex()
+{
+	std::vector<unsigned char> vIndex(m_vIndex.size() * INDEX_ENTRY_SIZE + TRAILER_SIZE);
+	unsigned char *pEntry = vIndex.data();
+	for(const CIndexEntry &Entry : m_vIndex)
+	{
+		uint_to_bytes_be(pEntry, Entry.m_Tick);
+		Int64ToBytesBe(pEntry + 4, Entry.m_Offset);
+		uint_to_bytes_be(pEntry + 12, Entry.m_Size);
+		uint_to_bytes_be(pEntry + 16, Entry.m_DataSize);
+		pEntry += INDEX_ENTRY_SIZE;
+	}
+	uint_to_bytes_be(pEntry, m_vIndex.size());
+	Int64ToBytesBe(pEntry + 4, m_Offset);
+	mem_copy(pEntry + 12, &TEEHISTORIAN_FRAMES_UUID, sizeof(TEEHISTORIAN_FRAMES_UUID));
+	if(io_write(m_File, vIndex.data(), vIndex.size()) != vIndex.size())
+		m_Error = -1;
+}
+
+CTeeHistorianReader::~CTeeHistorianReader()
+{
+	Close();
+}
+
+bool CTeeHistorianReader::Open(IOHANDLE File)
+{
+	Close();
+	m_File = File;
+
+	const int64_t Length = io_length(m_File);
+	CUuid Uuid;
+	if(Length < 0 || io_read(m_File, &Uuid, sizeof(Uuid)) != sizeof(Uuid) || Uuid != TEEHISTORIAN_FRAMES_UUID)
+	{
+		// not compressed, the whole file is one frame
+		m_Compressed = false;
+		m_vFrames.push_back({-1, 0, Length, 0, Length});
+		return Length >= 0;
+	}
+
+	m_Compressed = true;
+	if(ReadIndex(Length))
+		return true;
+	m_vFrames.clear();
+	return ScanFrames(Length);
+}
+
+bool CTeeHistorianReader::ReadIndex(int64_t Length)
+{
+	if(Length < (int64_t)(sizeof(CUuid) + TRAILER_SIZE))
+		return false;
+	unsigned char aTrailer[TRAILER_SIZE];
+	if(io_seek(m_File, Length - TRAILER_SIZE, IOSEEK_START) != 0 || io_read(m_File, aTrailer, sizeof(aTrailer)) != sizeof(aTrailer))
+		return false;
+	CUuid Uuid;
+	mem_copy(&Uuid, aTrailer + 12, sizeof(Uuid));
+	const unsigned NumFrames = bytes_be_to_uint(aTrailer);
+	const int64_t IndexOffset = BytesBeToInt64(aTrailer + 4);
+	if(Uuid != TEEHISTORIAN_FRAMES_UUID || IndexOffset < (int64_t)sizeof(CUuid) || IndexOffset + (int64_t)NumFrames * INDEX_ENTRY_SIZE + TRAILER_SIZE != Length)
+		return false;
+
+	std::vector<unsigned char> vIndex((size_t)NumFrames * INDEX_ENTRY_SIZE);
+	if(io_seek(m_File, IndexOffset, IOSEEK_START) != 0 || io_read(m_File, vIndex.data(), vIndex.size()) != vIndex.size())
+		return false;
+	int64_t DataOffset = 0;
+	for(unsigned i = 0; i < NumFrames; i++)
+	{
+		const unsigned char *pEntry = vIndex.data() + (size_t)i * INDEX_ENTRY_SIZE;
+		CFrame Frame;
+		Frame.m_Tick = bytes_be_to_uint(pEntry);
+		Frame.m_Offset = BytesBeToInt64(pEntry + 4);
+		Frame.m_Size = bytes_be_to_uint(pEntry + 12);
+		Frame.m_DataOffset = DataOffset;
+		Frame.m_DataSize = bytes_be_to_uint(pEntry + 16);
+		if(Frame.m_Offset < (int64_t)sizeof(CUuid) || Frame.m_Offset + FRAME_HEADER_SIZE + Frame.m_Size > IndexOffset)
+			return false;
+		DataOffset += Frame.m_DataSize;
+		m_vFrames.push_back(Frame);
+	}
+	return true;
+}
+
+bool CTeeHistorianReader::ScanFrames(int64_t Length)
+{
+	int64_t Offset = sizeof(CUuid);
+	int64_t DataOffset = 0;
+	while(Offset + FRAME_HEADER_SIZE <= Length)
+	{
+		unsigned char aHeader[FRAME_HEADER_SIZE];
+		if(io_seek(m_File, Offset, IOSEEK_START) != 0 || io_read(m_File, aHeader, sizeof(aHeader)) != sizeof(aHeader))
+			break;
+		CFrame Frame;
+		Frame.m_Tick = bytes_be_to_uint(aHeader);
+		Frame.m_Offset = Offset;
+		Frame.m_Size = bytes_be_to_uint(aHeader + 4);
+		Frame.m_DataOffset = DataOffset;
+		Frame.m_DataSize = bytes_be_to_uint(aHeader + 8);
+		// the last frame may be incomplete
+		if(Offset + FRAME_HEADER_SIZE + Frame.m_Size > Length)
+			break;
+		Offset += FRAME_HEADER_SIZE + Frame.m_Size;
+		DataOffset += Frame.m_DataSize;
+		m_vFrames.push_back(Frame);
+	}
+	return true;
+}
+
+void CTeeHistorianReader::Close()
+{
+	if(m_File)
+		io_close(m_File);
+	m_File = nullptr;
+	m_vFrames.clear();
+}
+
+int CTeeHistorianReader::FindFrame(int Tick) const
+{
+	// the frames are sorted by tick, find the last one that starts before or at the tick
+	int Low = 0;
+	int High = (int)m_vFrames.size() - 1;
+	int Found = 0;
+	while(Low <= High)
+	{
+		const int Middle = Low + (High - Low) / 2;
+		if(m_vFrames[Middle].m_Tick <= Tick)
+		{
+			Found = Middle;
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle - 1;
+		}
+	}
+	return Found;
+}
+
+bool CTeeHistorianReader::ReadFrame(int Index, std::vector<unsigned char> &vData)
+{
+	if(Index < 0 || Index >= (int)m_vFrames.size())
+		return false;
+	const CFrame &Frame = m_vFrames[Index];
+	vData.resize(Frame.m_DataSize);
+	if(!m_Compressed)
+	{
+		return io_seek(m_File, Frame.m_Offset, IOSEEK_START) == 0 && io_read(m_File, vData.data(), vData.size()) == vData.size();
+	}
+
+	std::vector<unsigned char> vCompressed(Frame.m_Size);
+	if(io_seek(m_File, Frame.m_Offset + FRAME_HEADER_SIZE, IOSEEK_START) != 0 || io_read(m_File, vCompressed.data(), vCompressed.size()) != vCompressed.size())
+		return false;
+	uLongf DataSize = Frame.m_DataSize;
+	return uncompress(vData.data(), &DataSize, vCompressed.data(), vCompressed.size()) == Z_OK && DataSize == (uLongf)Frame.m_DataSize;
+}
+
+bool CTeeHistorianReader::ReadAll(std::vector<unsigned char> &vData)
+{
+	vData.clear();
+	std::vector<unsigned char> vFrame;
+	for(int i = 0; i < (int)m_vFrames.size(); i++)
+	{
+		if(!ReadFrame(i, vFrame))
+			return false;
+		vData.insert(vData.end(), vFrame.begin(), vFrame.end());
+	}
+	return true;
+}
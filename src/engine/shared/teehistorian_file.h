@@ -0,0 +1,165 @@
+#ifndef ENGINE_SHARED_TEEHISTORIAN_FILE_H
+#define ENGINE_SHARED_TEEHISTORIAN_FILE_H
+
+#include <base/lock.h>
+#include <base/system.h>
+#include <base/tl/threading.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Writes teehistorian data to a file, either as it is or compressed.
+ *
+ * Compressed files consist of frames that can be decompressed
+ * independently. Every frame starts at the beginning of a tick, and an
+ * index of the frames is appended when the file is closed, so readers can
+ * find the data of a tick without decompressing the whole file. The frames
+ * are compressed and written on a separate thread.
+ */
+class CTeeHistorianWriter
+{
+	class CFrame
+	{
+	public:
+		int m_Tick;
+		std::vector<unsigned char> m_vData;
+	};
+
+	class CIndexEntry
+	{
+	public:
+		int m_Tick;
+		int64_t m_Offset;
+		unsigned m_Size;
+		unsigned m_DataSize;
+	};
+
+	IOHANDLE m_File = nullptr;
+	bool m_Compressed = false;
+	ASYNCIO *m_pAio = nullptr;
+
+	size_t m_FrameSize = 0;
+	CFrame m_CurrentFrame;
+
+	void *m_pThread = nullptr;
+	CLock m_Lock;
+	CSemaphore m_Semaphore;
+	std::vector<CFrame> m_vQueuedFrames GUARDED_BY(m_Lock);
+	bool m_Finish GUARDED_BY(m_Lock) = false;
+	std::atomic<int> m_Error = 0;
+
+	// only used by the writer thread
+	std::vector<CIndexEntry> m_vIndex;
+	int64_t m_Offset = 0;
+
+	static void ThreadMain(void *pUser);
+	void Run() REQUIRES(!m_Lock);
+	void WriteFrame(const CFrame &Frame);
+	void WriteIndex();
+	void QueueFrame() REQUIRES(!m_Lock);
+
+public:
+	static constexpr size_t DEFAULT_FRAME_SIZE = 1024 * 1024;
+
+	/**
+	 * Starts writing to a file.
+	 *
+	 * @param File Handle of the file, it's closed by @link Close @endlink.
+	 * @param Compressed Whether the data is compressed in frames.
+	 * @param FrameSize Minimum amount of uncompressed data in a frame.
+	 */
+	void Open(IOHANDLE File, bool Compressed, size_t FrameSize = DEFAULT_FRAME_SIZE) REQUIRES(!m_Lock);
+
+	/**
+	 * Queues data for writing.
+	 */
+	void Write(const void *pData, int DataSize);
+
+	/**
+	 * Marks the beginning of a tick, all data written afterwards belongs to it.
+	 * Compressed frames are only finished here.
+	 */
+	void BeginTick(int Tick) REQUIRES(!m_Lock);
+
+	/**
+	 * @return `0` if writing succeeded so far, or non-`0` on error.
+	 */
+	int Error() const;
+
+	/**
+	 * Writes the remaining data and the index, and closes the file.
+	 *
+	 * @return `0` on success, or non-`0` on error.
+	 */
+	int Close() REQUIRES(!m_Lock);
+};
+
+/**
+ * Reads teehistorian files written by @link CTeeHistorianWriter @endlink,
+ * compressed or not.
+ *
+ * Uncompressed files are presented as a single frame. Compressed files
+ * without an index, e.g. because the server crashed, are read by scanning
+ * the frames.
+ */
+class CTeeHistorianReader
+{
+public:
+	class CFrame
+	{
+	public:
+		// first tick of the frame, `-1` for the frame at the start of the file
+		int m_Tick;
+		int64_t m_Offset;
+		int64_t m_Size;
+		int64_t m_DataOffset;
+		int64_t m_DataSize;
+	};
+
+private:
+	IOHANDLE m_File = nullptr;
+	bool m_Compressed = false;
+	std::vector<CFrame> m_vFrames;
+
+	bool ReadIndex(int64_t Length);
+	bool ScanFrames(int64_t Length);
+
+public:
+	~CTeeHistorianReader();
+
+	/**
+	 * Opens a teehistorian file and reads its index.
+	 *
+	 * @param File Handle of the file, it's closed by the reader.
+	 *
+	 * @return `true` on success.
+	 */
+	bool Open(IOHANDLE File);
+	void Close();
+
+	bool IsCompressed() const { return m_Compressed; }
+	const std::vector<CFrame> &Frames() const { return m_vFrames; }
+
+	/**
+	 * @return Index of the frame that contains the start of the tick.
+	 */
+	int FindFrame(int Tick) const;
+
+	/**
+	 * Reads the uncompressed data of a frame.
+	 *
+	 * @return `true` on success.
+	 */
+	bool ReadFrame(int Index, std::vector<unsigned char> &vData);
+
+	/**
+	 * Reads the uncompressed data of the whole file.
+	 *
+	 * @return `true` on success.
+	 */
+	bool ReadAll(std::vector<unsigned char> &vData);
+};
+
+#endif
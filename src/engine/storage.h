@@ -60,6 +60,9 @@ public:
 	virtual char *ReadFileStr(const char *pFilename, int Type) = 0;
 	virtual bool RetrieveTimes(const char *pFilename, int Type, time_t *pCreated, time_t *pModified) = 0;
 	virtual bool CalculateHashes(const char *pFilename, int Type, SHA256_DIGEST *pSha256, unsigned *pCrc = nullptr) = 0;
+	// hashes of unchanged files by their complete path, only cached by client and server storages
+	virtual bool FindDigest(const char *pPath, const IO_FILE_INFO &Info, SHA256_DIGEST *pSha256, unsigned *pCrc) = 0;
+	virtual void AddDigest(const char *pPath, const IO_FILE_INFO &Info, const SHA256_DIGEST &Sha256, unsigned Crc) = 0;
 	virtual bool FindFile(const char *pFilename, const char *pPath, int Type, char *pBuffer, int BufferSize) = 0;
 	virtual size_t FindFiles(const char *pFilename, const char *pPath, int Type, std::set<std::string> *pEntries) = 0;
 	virtual bool RemoveFile(const char *pFilename, int Type) = 0;
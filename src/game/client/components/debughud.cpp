@@ -78,6 +78,16 @@ void CDebugHud::RenderNetCorrections()
 	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->NetobjNumCorrections());
 	RenderRow("Netobj corrections", aBuf);
 	RenderRow(" on:", GameClient()->NetobjCorrectedOn());
+
+	const int PredictionAllocations = GameClient()->NumPredictionAllocations();
+	str_format(aBuf, sizeof(aBuf), "%d", PredictionAllocations - m_LastPredictionAllocations);
+	RenderRow("Prediction allocs/frame:", aBuf);
+	m_LastPredictionAllocations = PredictionAllocations;
+
+	const int PredictedTicks = GameClient()->NumPredictedTicks();
+	str_format(aBuf, sizeof(aBuf), "%d", PredictedTicks - m_LastPredictedTicks);
+	RenderRow("Predicted ticks/frame:", aBuf);
+	m_LastPredictedTicks = PredictedTicks;
 }
 
 void CDebugHud::RenderTuning()
@@ -19,6 +19,8 @@ class CDebugHud : public CComponent
 	float m_OldVelrampStart;
 	float m_OldVelrampRange;
 	float m_OldVelrampCurvature;
+	int m_LastPredictionAllocations = 0;
+	int m_LastPredictedTicks = 0;
 
 public:
 	CDebugHud();
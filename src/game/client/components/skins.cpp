@@ -26,6 +26,8 @@ CSkins::CAbstractSkinLoadJob::CAbstractSkinLoadJob(CSkins *pSkins, const char *p
 {
 	str_copy(m_aName, pName);
 	Abortable(true);
+	// skins are loaded and downloaded in bulk, don't delay more urgent jobs
+	SetPriority(PRIORITY_LOW);
 }
 
 CSkins::CAbstractSkinLoadJob::~CAbstractSkinLoadJob()
@@ -703,6 +703,8 @@ void CGameClient::OnReset()
 
 	m_Teams.Reset();
 	m_GameWorld.Clear();
+	m_pPredictionCache.reset();
+	m_PredictionBaseSerial++;
 	m_GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
 	m_PredictedWorld.CopyWorld(&m_GameWorld);
 	m_PrevPredictedWorld.CopyWorld(&m_PredictedWorld);
@@ -2488,11 +2490,17 @@ void CGameClient::OnPredict()
 	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
 	m_PredictedWorld.CopyWorld(&m_GameWorld);
 
+	// identifies the world the prediction starts from
+	uint64_t BaseIdentity = CPredictionCache::CRing::ChainKey(CPredictionCache::CRing::EMPTY_KEY, m_PredictionBaseSerial);
+
 	// don't predict inactive players, or entities from other teams
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		if(CCharacter *pChar = m_PredictedWorld.GetCharacterById(i))
 			if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
+			{
 				pChar->Destroy();
+				BaseIdentity = CPredictionCache::CRing::ChainKey(BaseIdentity, i);
+			}
 
 	CProjectile *pProjNext = nullptr;
 	for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
@@ -2501,6 +2509,7 @@ void CGameClient::OnPredict()
 		if(IsOtherTeam(pProj->GetOwner()))
 		{
 			pProj->Destroy();
+			BaseIdentity = CPredictionCache::CRing::ChainKey(BaseIdentity, pProj->GetOwner());
 		}
 	}
 
@@ -2521,7 +2530,42 @@ void CGameClient::OnPredict()
 	if(g_Config.m_TcFastInput && !g_Config.m_TcFastInputOthers)
 		FinalTickOthers = FinalTickSelf - g_Config.m_TcFastInput;
 
-	for(int Tick = Client()->GameTick(g_Config.m_ClDummy) + 1; Tick <= FinalTickSelf; Tick++)
+	// everything that is fed into the simulation of a tick
+	auto GetTickInput = [&](int Tick, CPredictionCache::CTickInput *pInput) {
+		pInput->m_pInput = (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping);
+		pInput->m_pDummyInput = !pDummyChar ? nullptr : (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping ^ 1);
+		if(g_Config.m_TcFastInput && Tick == FinalTickSelf)
+			pInput->m_pInput = &m_Controls.m_FastInput;
+		pInput->m_CanMoveInFreeze = g_Config.m_ClPredictFreeze == 2 && Client()->PredGameTick(g_Config.m_ClDummy) - 1 - Client()->PredGameTick(g_Config.m_ClDummy) % 2 <= Tick;
+		if(g_Config.m_ClAntiPingPreInput)
+		{
+			for(int i = 0; i < MAX_CLIENTS; i++)
+			{
+				const CNetMsg_Sv_PreInput &PreInput = m_aClients[i].m_aPreInputs[Tick % 200];
+				if(PreInput.m_IntendedTick == Tick)
+					pInput->m_apPreInputs[i] = &PreInput;
+			}
+		}
+	};
+
+	int FirstTick = Client()->GameTick(g_Config.m_ClDummy) + 1;
+	if(g_Config.m_TcPredictionIncremental)
+	{
+		if(!m_pPredictionCache)
+			m_pPredictionCache = std::make_unique<CPredictionCache>();
+
+		// the ticks that store the previous and current characters always have to be simulated
+		const int LocalId = pLocalChar->GetCid();
+		const int DummyId = pDummyChar ? pDummyChar->GetCid() : -1;
+		FirstTick = m_pPredictionCache->Begin(&m_PredictedWorld, &m_GameWorld, BaseIdentity, FirstTick, minimum(FinalTickRegular, FinalTickOthers) - 1, LocalId, DummyId, GetTickInput);
+		pLocalChar = m_PredictedWorld.GetCharacterById(LocalId);
+		if(pDummyChar)
+			pDummyChar = m_PredictedWorld.GetCharacterById(DummyId);
+	}
+	else
+		m_pPredictionCache.reset();
+
+	for(int Tick = FirstTick; Tick <= FinalTickSelf; Tick++)
 	{
 		// fetch the previous characters
 		if(Tick == FinalTickSelf)
@@ -2632,6 +2676,14 @@ void CGameClient::OnPredict()
 		}
 
 		m_PredictedWorld.Tick();
+		m_NumPredictedTicks++;
+
+		if(m_pPredictionCache)
+		{
+			CPredictionCache::CTickInput TickInput;
+			GetTickInput(Tick, &TickInput);
+			m_pPredictionCache->Store(Tick, &m_PredictedWorld, TickInput);
+		}
 
 		// fetch the current characters
 		if(Tick == FinalTickSelf)
@@ -3671,8 +3723,19 @@ void CGameClient::UpdateLocalTuning()
 	}
 }
 
+int CGameClient::NumPredictionAllocations() const
+{
+	return m_GameWorld.EntityPool()->NumAllocations() +
+	       m_PredictedWorld.EntityPool()->NumAllocations() +
+	       m_PrevPredictedWorld.EntityPool()->NumAllocations() +
+	       m_ExtraPredictedWorld.EntityPool()->NumAllocations() +
+	       m_PredSmoothingWorld.EntityPool()->NumAllocations();
+}
+
 void CGameClient::UpdatePrediction()
 {
+	m_PredictionBaseSerial++;
+
 	m_GameWorld.m_WorldConfig.m_IsVanilla = m_GameInfo.m_PredictVanilla;
 	m_GameWorld.m_WorldConfig.m_IsDDRace = m_GameInfo.m_PredictDDRace;
 	m_GameWorld.m_WorldConfig.m_IsFNG = m_GameInfo.m_PredictFNG;
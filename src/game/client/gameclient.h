@@ -9,6 +9,7 @@
 #include <base/vmath.h>
 
 #include <bitset>
+#include <memory>
 #include <vector>
 
 #include <engine/client.h>
@@ -21,6 +22,7 @@
 #include <generated/protocolglue.h>
 
 #include <game/client/prediction/gameworld.h>
+#include <game/client/prediction/prediction_cache.h>
 #include <game/client/race.h>
 #include <game/collision.h>
 #include <game/gamecore.h>
@@ -272,6 +274,11 @@ private:
 	int m_PredictedTick;
 	int m_aLastNewPredictedTick[NUM_DUMMIES];
 
+	// incremental prediction
+	std::unique_ptr<CPredictionCache> m_pPredictionCache;
+	int m_PredictionBaseSerial = 0;
+	int m_NumPredictedTicks = 0;
+
 	int m_LastRoundStartTick;
 	int m_LastRaceTick;
 
@@ -746,6 +753,8 @@ public:
 
 	std::vector<SSwitchers> &Switchers() { return m_GameWorld.m_Core.m_vSwitchers; }
 	std::vector<SSwitchers> &PredSwitchers() { return m_PredictedWorld.m_Core.m_vSwitchers; }
+	int NumPredictionAllocations() const;
+	int NumPredictedTicks() const { return m_NumPredictedTicks; }
 
 	void DummyResetInput() override;
 	void Echo(const char *pString) override;
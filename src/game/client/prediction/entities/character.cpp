@@ -364,7 +364,7 @@ void CCharacter::FireWeapon()
 		{
 			int Lifetime = (int)(GameWorld()->GameTickSpeed() * GetTuning(GetOverriddenTuneZone())->m_GunLifetime);
 
-			new CProjectile(
+			new(GameWorld()) CProjectile(
 				GameWorld(),
 				WEAPON_GUN, //Type
 				GetCid(), //Owner
@@ -392,7 +392,7 @@ void CCharacter::FireWeapon()
 				a += aSpreading[i + 2];
 				float v = 1 - (absolute(i) / (float)ShotSpread);
 				float Speed = mix((float)GlobalTuning()->m_ShotgunSpeeddiff, 1.0f, v);
-				new CProjectile(
+				new(GameWorld()) CProjectile(
 					GameWorld(),
 					WEAPON_SHOTGUN, //Type
 					GetCid(), //Owner
@@ -409,7 +409,7 @@ void CCharacter::FireWeapon()
 		{
 			float LaserReach = GetTuning(GetOverriddenTuneZone())->m_LaserReach;
 
-			new CLaser(GameWorld(), m_Pos, Direction, LaserReach, GetCid(), WEAPON_SHOTGUN);
+			new(GameWorld()) CLaser(GameWorld(), m_Pos, Direction, LaserReach, GetCid(), WEAPON_SHOTGUN);
 		}
 	}
 	break;
@@ -418,7 +418,7 @@ void CCharacter::FireWeapon()
 	{
 		int Lifetime = (int)(GameWorld()->GameTickSpeed() * GetTuning(GetOverriddenTuneZone())->m_GrenadeLifetime);
 
-		new CProjectile(
+		new(GameWorld()) CProjectile(
 			GameWorld(),
 			WEAPON_GRENADE, //Type
 			GetCid(), //Owner
@@ -436,7 +436,7 @@ void CCharacter::FireWeapon()
 	{
 		float LaserReach = GetTuning(GetOverriddenTuneZone())->m_LaserReach;
 
-		new CLaser(GameWorld(), m_Pos, Direction, LaserReach, GetCid(), WEAPON_LASER);
+		new(GameWorld()) CLaser(GameWorld(), m_Pos, Direction, LaserReach, GetCid(), WEAPON_LASER);
 	}
 	break;
 
@@ -1497,6 +1497,20 @@ bool CCharacter::Match(CCharacter *pChar) const
 	return distance(pChar->m_Core.m_Pos, m_Core.m_Pos) <= 32.f;
 }
 
+bool CCharacter::SameState(const CEntity *pOther) const
+{
+	const CCharacter *pChar = static_cast<const CCharacter *>(pOther);
+	return CEntity::SameState(pOther) &&
+	       State() == pChar->State() &&
+	       m_Core.SameState(pChar->m_Core) &&
+	       mem_comp(m_aHitObjects, pChar->m_aHitObjects, sizeof(m_aHitObjects)) == 0 &&
+	       mem_comp(&m_LatestPrevInput, &pChar->m_LatestPrevInput, sizeof(m_LatestPrevInput)) == 0 &&
+	       mem_comp(&m_LatestInput, &pChar->m_LatestInput, sizeof(m_LatestInput)) == 0 &&
+	       mem_comp(&m_PrevInput, &pChar->m_PrevInput, sizeof(m_PrevInput)) == 0 &&
+	       mem_comp(&m_Input, &pChar->m_Input, sizeof(m_Input)) == 0 &&
+	       mem_comp(&m_SavedInput, &pChar->m_SavedInput, sizeof(m_SavedInput)) == 0;
+}
+
 void CCharacter::SetActiveWeapon(int ActiveWeapon)
 {
 	if(ActiveWeapon < WEAPON_HAMMER || ActiveWeapon >= NUM_WEAPONS)
@@ -123,6 +123,7 @@ public:
 	bool m_CanMoveInFreeze;
 
 	bool Match(CCharacter *pChar) const;
+	bool SameState(const CEntity *pOther) const override;
 	void ResetPrediction();
 	void SetTuneZone(int Zone);
 	int GetOverriddenTuneZone() const;
@@ -184,6 +185,17 @@ private:
 
 	int m_LastWeaponSwitchTick;
 	int m_LastTuneZoneTick;
+
+	// the members the simulation depends on, except for the core, the arrays and
+	// the inputs compared by SameState, extend when adding members
+	auto State() const
+	{
+		return std::tie(m_IsLocal, m_NinjaJetpack, m_FreezeTime, m_FrozenLastTick, m_PrevPos, m_PrevPrevPos, m_TeleCheckpoint,
+			m_TileIndex, m_TileFIndex, m_LastRefillJumps, m_LastSnapWeapon, m_KeepHooked, m_GameTeam, m_CanMoveInFreeze,
+			m_FreezeAccumulation, m_AliveAccumulation, m_NumObjectsHit, m_LastWeapon, m_QueuedWeapon, m_ReloadTimer,
+			m_AttackTick, m_MoveRestrictions, m_NumInputs, m_TuneZone, m_TuneZoneOverride, m_StrongWeakId,
+			m_LastWeaponSwitchTick, m_LastTuneZoneTick);
+	}
 };
 
 #endif
@@ -151,6 +151,11 @@ void CDragger::Read(const CLaserData *pData)
 	m_TargetId = pData->m_Owner;
 }
 
+bool CDragger::SameState(const CEntity *pOther) const
+{
+	return CEntity::SameState(pOther) && State() == static_cast<const CDragger *>(pOther)->State();
+}
+
 bool CDragger::Match(CDragger *pDragger)
 {
 	return pDragger->m_Strength == m_Strength && pDragger->m_Number == m_Number && pDragger->m_IgnoreWalls == m_IgnoreWalls;
@@ -13,6 +13,8 @@ class CDragger : public CEntity
 	bool m_IgnoreWalls;
 	int m_TargetId;
 
+	auto State() const { return std::tie(m_Core, m_Strength, m_IgnoreWalls, m_TargetId); }
+
 	void LookForPlayersToDrag();
 	void DraggerBeamTick();
 	void DraggerBeamReset();
@@ -20,6 +22,7 @@ class CDragger : public CEntity
 public:
 	CDragger(CGameWorld *pGameWorld, int Id, const CLaserData *pData);
 	bool Match(CDragger *pDragger);
+	bool SameState(const CEntity *pOther) const override;
 	void Read(const CLaserData *pData);
 	float GetStrength() const { return m_Strength; }
 
@@ -199,6 +199,11 @@ CLaser::CLaser(CGameWorld *pGameWorld, int Id, CLaserData *pLaser) :
 	m_Id = Id;
 }
 
+bool CLaser::SameState(const CEntity *pOther) const
+{
+	return CEntity::SameState(pOther) && State() == static_cast<const CLaser *>(pOther)->State();
+}
+
 bool CLaser::Match(CLaser *pLaser)
 {
 	if(pLaser->m_EvalTick != m_EvalTick)
@@ -21,6 +21,7 @@ public:
 	const int &GetEvalTick() const { return m_EvalTick; }
 	CLaser(CGameWorld *pGameWorld, int Id, CLaserData *pLaser);
 	bool Match(CLaser *pLaser);
+	bool SameState(const CEntity *pOther) const override;
 	CLaserData GetData() const;
 
 protected:
@@ -41,6 +42,8 @@ private:
 	vec2 m_PrevPos;
 	int m_Type;
 	int m_TuneZone;
+
+	auto State() const { return std::tie(m_From, m_Dir, m_Energy, m_Bounces, m_EvalTick, m_Owner, m_ZeroEnergyBounceInLastTick, m_PrevPos, m_Type, m_TuneZone); }
 };
 
 #endif
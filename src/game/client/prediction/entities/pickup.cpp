@@ -168,6 +168,11 @@ void CPickup::FillInfo(CNetObj_Pickup *pPickup)
 	pPickup->m_Subtype = m_Subtype;
 }
 
+bool CPickup::SameState(const CEntity *pOther) const
+{
+	return CEntity::SameState(pOther) && State() == static_cast<const CPickup *>(pOther)->State();
+}
+
 bool CPickup::Match(CPickup *pPickup)
 {
 	if(pPickup->m_Type != m_Type || pPickup->m_Subtype != m_Subtype)
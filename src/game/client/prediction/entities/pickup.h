@@ -17,6 +17,7 @@ public:
 	CPickup(CGameWorld *pGameWorld, int Id, const CPickupData *pPickup);
 	void FillInfo(CNetObj_Pickup *pPickup);
 	bool Match(CPickup *pPickup);
+	bool SameState(const CEntity *pOther) const override;
 	bool InDDNetTile() const { return m_IsCoreActive; }
 
 	int Type() const { return m_Type; }
@@ -33,6 +34,8 @@ private:
 	void Move();
 	vec2 m_Core;
 	bool m_IsCoreActive;
+
+	auto State() const { return std::tie(m_Type, m_Subtype, m_Flags, m_Core, m_IsCoreActive); }
 };
 
 #endif
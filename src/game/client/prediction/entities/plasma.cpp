@@ -32,6 +32,11 @@ CPlasma::CPlasma(CGameWorld *pGameWorld, int Id, const CLaserData *pData) :
 	m_Core = normalize(pTarget->m_Pos - m_Pos);
 }
 
+bool CPlasma::SameState(const CEntity *pOther) const
+{
+	return CEntity::SameState(pOther) && State() == static_cast<const CPlasma *>(pOther)->State();
+}
+
 bool CPlasma::Match(const CPlasma *pPlasma) const
 {
 	return pPlasma->m_EvalTick == m_EvalTick && pPlasma->m_Number == m_Number &&
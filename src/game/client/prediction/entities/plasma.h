@@ -15,6 +15,8 @@ class CPlasma : public CEntity
 	int m_EvalTick;
 	int m_LifeTime;
 
+	auto State() const { return std::tie(m_Core, m_Freeze, m_Explosive, m_ForClientId, m_EvalTick, m_LifeTime); }
+
 	void Move();
 	bool HitCharacter(CCharacter *pTarget);
 	bool HitObstacle(CCharacter *pTarget);
@@ -23,6 +25,7 @@ public:
 	CPlasma(CGameWorld *pGameWorld, int Id, const CLaserData *pData);
 
 	bool Match(const CPlasma *pPlasma) const;
+	bool SameState(const CEntity *pOther) const override;
 	void Read(const CLaserData *pData);
 
 	void Reset();
@@ -214,6 +214,11 @@ CProjectileData CProjectile::GetData() const
 	return Result;
 }
 
+bool CProjectile::SameState(const CEntity *pOther) const
+{
+	return CEntity::SameState(pOther) && State() == static_cast<const CProjectile *>(pOther)->State();
+}
+
 bool CProjectile::Match(CProjectile *pProj)
 {
 	if(pProj->m_Type != m_Type)
@@ -32,6 +32,7 @@ public:
 	void Tick() override;
 
 	bool Match(CProjectile *pProj);
+	bool SameState(const CEntity *pOther) const override;
 	void SetBouncing(int Value);
 
 	const vec2 &GetDirection() const { return m_Direction; }
@@ -54,6 +55,8 @@ private:
 	int m_Bouncing;
 	bool m_Freeze;
 	int m_TuneZone;
+
+	auto State() const { return std::tie(m_Direction, m_LifeSpan, m_Owner, m_Type, m_SoundImpact, m_Force, m_StartTick, m_Explosive, m_Bouncing, m_Freeze, m_TuneZone); }
 };
 
 #endif
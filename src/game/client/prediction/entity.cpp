@@ -36,6 +36,11 @@ CEntity::~CEntity()
 		GameWorld()->RemoveEntity(this);
 }
 
+bool CEntity::SameState(const CEntity *pOther) const
+{
+	return State() == pOther->State();
+}
+
 bool CEntity::GameLayerClipped(vec2 CheckPos)
 {
 	return round_to_int(CheckPos.x) / 32 < -200 || round_to_int(CheckPos.x) / 32 > Collision()->GetWidth() + 200 ||
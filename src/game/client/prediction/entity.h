@@ -3,20 +3,30 @@
 #ifndef GAME_CLIENT_PREDICTION_ENTITY_H
 #define GAME_CLIENT_PREDICTION_ENTITY_H
 
+#include "entity_pool.h"
 #include "gameworld.h"
 
 #include <base/vmath.h>
 
-#include <game/alloc.h>
+#include <game/entity_grid.h>
+
+#include <tuple>
 
 class CEntity
 {
-	MACRO_ALLOC_HEAP()
+public:
+	// entities are allocated from the entity pool of the world they are created in
+	void *operator new(size_t Size, CGameWorld *pGameWorld) { return pGameWorld->EntityPool()->Allocate(Size); }
+	void operator delete(void *pPtr, CGameWorld *pGameWorld) { CEntityPool::Free(pPtr); }
+	void operator delete(void *pPtr) { CEntityPool::Free(pPtr); } // NOLINT(misc-new-delete-overloads)
 
 private:
 	friend CGameWorld; // entity list handling
+	template<typename, int>
+	friend class CEntityGrid;
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	CEntityGridNode<CEntity> m_GridNode;
 
 protected:
 	CGameWorld *m_pGameWorld;
@@ -41,6 +51,8 @@ public:
 	const vec2 &GetPos() const { return m_Pos; }
 	float GetProximityRadius() const { return m_ProximityRadius; }
 	virtual bool CanCollide(int ClientId) { return true; }
+	// whether this entity continues exactly like pOther, an entity of the same type
+	virtual bool SameState(const CEntity *pOther) const;
 
 	virtual void Destroy() { delete this; }
 	virtual void PreTick() {}
@@ -58,6 +70,11 @@ public:
 	int m_LastRenderTick;
 	CEntity *m_pParent;
 	CEntity *m_pChild;
+
+	// the members the simulation depends on, compared by SameState. The entities
+	// tie their own members the same way, a new member has to be added there
+	auto State() const { return std::tie(m_ObjType, m_Id, m_MarkedForDestroy, m_Pos, m_ProximityRadius, m_Number, m_Layer, m_SnapTicks); }
+
 	CEntity *NextEntity() { return m_pNextTypeEntity; }
 	void Keep()
 	{
@@ -0,0 +1,78 @@
+#include "entity_pool.h"
+
+#include <base/system.h>
+
+#include <cstdlib>
+
+CEntityPool::~CEntityPool()
+{
+	for(int i = 0; i < m_NumSlabs; i++)
+		for(char *pChunk : m_aSlabs[i].m_vpChunks)
+			free(pChunk);
+}
+
+CEntityPool::CSlab *CEntityPool::FindSlab(size_t Size)
+{
+	for(int i = 0; i < m_NumSlabs; i++)
+		if(m_aSlabs[i].m_ObjectSize == Size)
+			return &m_aSlabs[i];
+
+	dbg_assert(m_NumSlabs < MAX_SLABS, "too many entity sizes for the entity pool");
+	CSlab *pSlab = &m_aSlabs[m_NumSlabs++];
+	pSlab->m_ObjectSize = Size;
+	pSlab->m_SlotSize = sizeof(SSlotHeader) + (Size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+	return pSlab;
+}
+
+void *CEntityPool::Allocate(size_t Size)
+{
+	CSlab *pSlab = FindSlab(Size);
+
+	SSlotHeader *pSlot;
+	if(pSlab->m_pFirstFree)
+	{
+		pSlot = pSlab->m_pFirstFree;
+		pSlab->m_pFirstFree = pSlot->m_pNextFree;
+	}
+	else
+	{
+		if(pSlab->m_NextSlot == SLOTS_PER_CHUNK)
+		{
+			pSlab->m_CurrentChunk++;
+			pSlab->m_NextSlot = 0;
+		}
+		if(pSlab->m_CurrentChunk == pSlab->m_vpChunks.size())
+		{
+			pSlab->m_vpChunks.push_back(static_cast<char *>(malloc(pSlab->m_SlotSize * SLOTS_PER_CHUNK)));
+			m_NumAllocations++;
+		}
+		pSlot = reinterpret_cast<SSlotHeader *>(pSlab->m_vpChunks[pSlab->m_CurrentChunk] + pSlab->m_NextSlot * pSlab->m_SlotSize);
+		pSlab->m_NextSlot++;
+	}
+
+	pSlot->m_pSlab = pSlab;
+	pSlot->m_pNextFree = nullptr;
+	void *pObj = pSlot + 1;
+	mem_zero(pObj, Size);
+	return pObj;
+}
+
+void CEntityPool::Free(void *pPtr)
+{
+	if(!pPtr)
+		return;
+	SSlotHeader *pSlot = static_cast<SSlotHeader *>(pPtr) - 1;
+	CSlab *pSlab = pSlot->m_pSlab;
+	pSlot->m_pNextFree = pSlab->m_pFirstFree;
+	pSlab->m_pFirstFree = pSlot;
+}
+
+void CEntityPool::Reset()
+{
+	for(int i = 0; i < m_NumSlabs; i++)
+	{
+		m_aSlabs[i].m_CurrentChunk = 0;
+		m_aSlabs[i].m_NextSlot = 0;
+		m_aSlabs[i].m_pFirstFree = nullptr;
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef GAME_CLIENT_PREDICTION_ENTITY_POOL_H
+#define GAME_CLIENT_PREDICTION_ENTITY_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Slab allocator for the entities of one prediction world.
+ *
+ * Every entity class gets its own pool of fixed-size slots (the pools are
+ * keyed by object size). Slots are recycled through a free list and the whole
+ * pool can be rewound at once, so the worlds that are copied every frame
+ * stop allocating after the first few frames.
+ */
+class CEntityPool
+{
+public:
+	CEntityPool() = default;
+	CEntityPool(const CEntityPool &) = delete;
+	CEntityPool &operator=(const CEntityPool &) = delete;
+	~CEntityPool();
+
+	void *Allocate(size_t Size);
+	static void Free(void *pPtr);
+
+	/**
+	 * Marks every slot as unused without touching the memory.
+	 *
+	 * @remark Must only be called when no entity allocated from this pool is alive.
+	 */
+	void Reset();
+
+	/**
+	 * @return Number of heap allocations done by this pool since its creation.
+	 */
+	int NumAllocations() const { return m_NumAllocations; }
+
+private:
+	enum
+	{
+		MAX_SLABS = 16,
+		SLOTS_PER_CHUNK = 32,
+	};
+
+	class CSlab;
+
+	struct alignas(std::max_align_t) SSlotHeader
+	{
+		CSlab *m_pSlab;
+		SSlotHeader *m_pNextFree;
+	};
+
+	class CSlab
+	{
+	public:
+		size_t m_ObjectSize = 0;
+		size_t m_SlotSize = 0;
+		std::vector<char *> m_vpChunks;
+		size_t m_CurrentChunk = 0;
+		size_t m_NextSlot = 0;
+		SSlotHeader *m_pFirstFree = nullptr;
+	};
+
+	CSlab *FindSlab(size_t Size);
+
+	CSlab m_aSlabs[MAX_SLABS];
+	int m_NumSlabs = 0;
+	int m_NumAllocations = 0;
+};
+
+#endif
@@ -12,6 +12,8 @@
 #include "entities/projectile.h"
 #include "entity.h"
 
+#include <base/system.h>
+
 #include <engine/shared/config.h>
 
 #include <game/client/laser_data.h>
@@ -34,8 +36,11 @@ CGameWorld::CGameWorld()
 		pCharacter = nullptr;
 	m_pCollision = nullptr;
 	m_GameTick = 0;
+	m_WorldConfig = {};
+	m_IsValidCopy = false;
 	m_pParent = nullptr;
 	m_pChild = nullptr;
+	m_LocalClientId = -1;
 }
 
 CGameWorld::~CGameWorld()
@@ -76,6 +81,25 @@ int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max,
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
+	UpdateGrid(Type);
+	const float Range = Radius + m_Grid.MaxProximityRadius(Type);
+	m_vpQueryResult.clear();
+	const bool Found = m_Grid.Query(Type, Pos - vec2(Range, Range), Pos + vec2(Range, Range), [&](CEntity *pEnt) {
+		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
+			m_vpQueryResult.push_back(pEnt);
+	});
+	if(Found)
+	{
+		// same result as walking the list
+		std::sort(m_vpQueryResult.begin(), m_vpQueryResult.end(), m_Grid.ListOrder);
+		int Num = m_vpQueryResult.size();
+		if(Max > 0 && Num > Max)
+			Num = Max;
+		if(ppEnts)
+			std::copy(m_vpQueryResult.begin(), m_vpQueryResult.begin() + Num, ppEnts);
+		return Num;
+	}
+
 	int Num = 0;
 	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
 	{
@@ -122,6 +146,7 @@ void CGameWorld::InsertEntity(CEntity *pEnt, bool Last)
 		pEnt->m_pPrevTypeEntity = pLast;
 		pEnt->m_pNextTypeEntity = nullptr;
 	}
+	m_Grid.Insert(pEnt, pEnt->m_ObjType, Last);
 
 	if(pEnt->m_ObjType == ENTTYPE_CHARACTER)
 	{
@@ -157,6 +182,10 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
 
+	m_Grid.Remove(pEnt);
+	if(m_pTickedEntity == pEnt)
+		m_pTickedEntity = nullptr;
+
 	if(pEnt->m_pParent)
 	{
 		if(m_IsValidCopy && m_pParent && m_pParent->m_pChild == this)
@@ -171,6 +200,27 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 	}
 }
 
+void CGameWorld::UpdateGrid(int Type)
+{
+	// during the tick only the entity whose callback is running can have moved
+	if(m_Ticking)
+	{
+		if(m_pTickedEntity)
+			m_Grid.Update(m_pTickedEntity);
+		return;
+	}
+	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		m_Grid.Update(pEnt);
+}
+
+void CGameWorld::UpdateTickedEntity()
+{
+	// the entity might have been destroyed by its own callback
+	if(m_pTickedEntity)
+		m_Grid.Update(m_pTickedEntity);
+	m_pTickedEntity = nullptr;
+}
+
 void CGameWorld::RemoveCharacter(CCharacter *pChar)
 {
 	int Id = pChar->GetCid();
@@ -198,6 +248,11 @@ void CGameWorld::RemoveEntities()
 
 void CGameWorld::Tick()
 {
+	// entities can be moved from outside of the world tick
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		UpdateGrid(i);
+	m_Ticking = true;
+
 	// update all objects
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 	{
@@ -209,7 +264,9 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickedEntity = pEnt;
 				((CCharacter *)pEnt)->PreTick();
+				UpdateTickedEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 		}
@@ -218,7 +275,9 @@ void CGameWorld::Tick()
 		for(; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			m_pTickedEntity = pEnt;
 			pEnt->Tick();
+			UpdateTickedEntity();
 			pEnt = m_pNextTraverseEntity;
 		}
 	}
@@ -227,10 +286,13 @@ void CGameWorld::Tick()
 		for(; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			m_pTickedEntity = pEnt;
 			pEnt->TickDeferred();
+			UpdateTickedEntity();
 			pEnt->m_SnapTicks++;
 			pEnt = m_pNextTraverseEntity;
 		}
+	m_Ticking = false;
 
 	RemoveEntities();
 
@@ -267,17 +329,15 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
-	{
+	auto Check = [&](CEntity *pEntity) {
 		if(pEntity == pNotThis)
-			continue;
+			return;
 
 		if(pThisOnly && pEntity != pThisOnly)
-			continue;
+			return;
 
 		if(CollideWith != -1 && !pEntity->CanCollide(CollideWith))
-			continue;
+			return;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pEntity->m_Pos, IntersectPos))
@@ -286,7 +346,8 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 			if(Len < pEntity->m_ProximityRadius + Radius)
 			{
 				Len = distance(Pos0, IntersectPos);
-				if(Len < ClosestLen)
+				// on a tie the entity that comes first in the list wins
+				if(Len < ClosestLen || (Len == ClosestLen && pClosest && m_Grid.ListOrder(pEntity, pClosest)))
 				{
 					NewPos = IntersectPos;
 					ClosestLen = Len;
@@ -294,7 +355,18 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 				}
 			}
 		}
-	}
+	};
+
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
+	UpdateGrid(Type);
+	const float Range = Radius + m_Grid.MaxProximityRadius(Type);
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - vec2(Range, Range);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + vec2(Range, Range);
+	if(!m_Grid.Query(Type, Min, Max, Check))
+		for(CEntity *pEntity = FindFirst(Type); pEntity; pEntity = pEntity->TypeNext())
+			Check(pEntity);
 
 	return pClosest;
 }
@@ -302,22 +374,30 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
-	{
-		if(pChr == pNotThis)
-			continue;
+	auto Check = [&](CEntity *pEnt) {
+		if(pEnt == pNotThis)
+			return;
 
 		vec2 IntersectPos;
-		if(closest_point_on_line(Pos0, Pos1, pChr->m_Pos, IntersectPos))
+		if(closest_point_on_line(Pos0, Pos1, pEnt->m_Pos, IntersectPos))
 		{
-			float Len = distance(pChr->m_Pos, IntersectPos);
-			if(Len < pChr->m_ProximityRadius + Radius)
+			float Len = distance(pEnt->m_Pos, IntersectPos);
+			if(Len < pEnt->m_ProximityRadius + Radius)
 			{
-				vpCharacters.push_back(pChr);
+				vpCharacters.push_back((CCharacter *)pEnt);
 			}
 		}
-	}
+	};
+
+	UpdateGrid(ENTTYPE_CHARACTER);
+	const float Range = Radius + m_Grid.MaxProximityRadius(ENTTYPE_CHARACTER);
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - vec2(Range, Range);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + vec2(Range, Range);
+	if(m_Grid.Query(ENTTYPE_CHARACTER, Min, Max, Check))
+		std::sort(vpCharacters.begin(), vpCharacters.end(), m_Grid.ListOrder);
+	else
+		for(CEntity *pEnt = FindFirst(ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+			Check(pEnt);
 	return vpCharacters;
 }
 
@@ -413,7 +493,7 @@ void CGameWorld::NetCharAdd(int ObjId, CNetObj_Character *pCharObj, CNetObj_DDNe
 		}
 		else
 		{
-			pChar = new CCharacter(this, ObjId, pCharObj, pExtended);
+			pChar = new(this) CCharacter(this, ObjId, pCharObj, pExtended);
 			InsertEntity(pChar);
 		}
 
@@ -479,7 +559,7 @@ void CGameWorld::NetObjAdd(int ObjId, int ObjType, const void *pObjData, const C
 					NetProj.m_Owner = pClosest->m_Id;
 			}
 		}
-		CProjectile *pProj = new CProjectile(NetProj);
+		CProjectile *pProj = new(this) CProjectile(NetProj);
 		InsertEntity(pProj);
 	}
 	else if((ObjType == NETOBJTYPE_PICKUP || ObjType == NETOBJTYPE_DDNETPICKUP) && m_WorldConfig.m_PredictWeapons)
@@ -497,7 +577,7 @@ void CGameWorld::NetObjAdd(int ObjId, int ObjType, const void *pObjData, const C
 				return;
 			}
 		}
-		CEntity *pEnt = new CPickup(NetPickup);
+		CEntity *pEnt = new(this) CPickup(NetPickup);
 		InsertEntity(pEnt, true);
 	}
 	else if((ObjType == NETOBJTYPE_LASER || ObjType == NETOBJTYPE_DDNETLASER) && m_WorldConfig.m_PredictWeapons)
@@ -551,7 +631,7 @@ void CGameWorld::NetObjAdd(int ObjId, int ObjType, const void *pObjData, const C
 					pDragger->Read(&Data);
 					return;
 				}
-				CEntity *pEnt = new CDragger(NetDragger);
+				CEntity *pEnt = new(this) CDragger(NetDragger);
 				InsertEntity(pEnt);
 			}
 		}
@@ -565,7 +645,7 @@ void CGameWorld::NetObjAdd(int ObjId, int ObjType, const void *pObjData, const C
 				pDoor->Read(&Data);
 				return;
 			}
-			CDoor *pEnt = new CDoor(NetDoor);
+			CDoor *pEnt = new(this) CDoor(NetDoor);
 			pEnt->ResetCollision();
 			InsertEntity(pEnt);
 		}
@@ -579,7 +659,7 @@ void CGameWorld::NetObjAdd(int ObjId, int ObjType, const void *pObjData, const C
 				pPlasma->Read(&Data);
 				return;
 			}
-			CPlasma *pEnt = new CPlasma(NetPlasma);
+			CPlasma *pEnt = new(this) CPlasma(NetPlasma);
 			InsertEntity(pEnt);
 		}
 	}
@@ -646,15 +726,15 @@ void CGameWorld::CopyWorldClean(CGameWorld *pFrom)
 		{
 			CEntity *pCopy = 0;
 			if(Type == ENTTYPE_PROJECTILE)
-				pCopy = new CProjectile(*((CProjectile *)pEnt));
+				pCopy = new(this) CProjectile(*((CProjectile *)pEnt));
 			else if(Type == ENTTYPE_LASER)
-				pCopy = new CLaser(*((CLaser *)pEnt));
+				pCopy = new(this) CLaser(*((CLaser *)pEnt));
 			else if(Type == ENTTYPE_DRAGGER)
-				pCopy = new CDragger(*((CDragger *)pEnt));
+				pCopy = new(this) CDragger(*((CDragger *)pEnt));
 			else if(Type == ENTTYPE_CHARACTER)
-				pCopy = new CCharacter(*((CCharacter *)pEnt));
+				pCopy = new(this) CCharacter(*((CCharacter *)pEnt));
 			else if(Type == ENTTYPE_PICKUP)
-				pCopy = new CPickup(*((CPickup *)pEnt));
+				pCopy = new(this) CPickup(*((CPickup *)pEnt));
 			if(pCopy)
 			{
 				pCopy->m_pParent = nullptr;
@@ -665,16 +745,9 @@ void CGameWorld::CopyWorldClean(CGameWorld *pFrom)
 	}
 }
 
-void CGameWorld::CopyWorld(CGameWorld *pFrom)
+// copies the world state and the entities of pFrom, the copies are linked to their origin if Link is set
+void CGameWorld::CopyEntities(CGameWorld *pFrom, bool Link)
 {
-	if(pFrom == this || !pFrom)
-		return;
-	m_IsValidCopy = false;
-	m_pParent = pFrom;
-	if(m_pParent->m_pChild && m_pParent->m_pChild != this)
-		m_pParent->m_pChild->m_IsValidCopy = false;
-	pFrom->m_pChild = this;
-
 	m_GameTick = pFrom->m_GameTick;
 	m_pCollision = pFrom->m_pCollision;
 	m_WorldConfig = pFrom->m_WorldConfig;
@@ -696,28 +769,106 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 		{
 			CEntity *pCopy = nullptr;
 			if(Type == ENTTYPE_PROJECTILE)
-				pCopy = new CProjectile(*((CProjectile *)pEnt));
+				pCopy = new(this) CProjectile(*((CProjectile *)pEnt));
 			else if(Type == ENTTYPE_LASER)
-				pCopy = new CLaser(*((CLaser *)pEnt));
+				pCopy = new(this) CLaser(*((CLaser *)pEnt));
 			else if(Type == ENTTYPE_DRAGGER)
-				pCopy = new CDragger(*((CDragger *)pEnt));
+				pCopy = new(this) CDragger(*((CDragger *)pEnt));
 			else if(Type == ENTTYPE_CHARACTER)
-				pCopy = new CCharacter(*((CCharacter *)pEnt));
+				pCopy = new(this) CCharacter(*((CCharacter *)pEnt));
 			else if(Type == ENTTYPE_PICKUP)
-				pCopy = new CPickup(*((CPickup *)pEnt));
+				pCopy = new(this) CPickup(*((CPickup *)pEnt));
 			else if(Type == ENTTYPE_PLASMA)
-				pCopy = new CPlasma(*((CPlasma *)pEnt));
+				pCopy = new(this) CPlasma(*((CPlasma *)pEnt));
 			if(pCopy)
 			{
-				pCopy->m_pParent = pEnt;
-				pEnt->m_pChild = pCopy;
+				pCopy->m_pParent = Link ? pEnt : nullptr;
+				pCopy->m_pChild = nullptr;
+				if(Link)
+					pEnt->m_pChild = pCopy;
 				this->InsertEntity(pCopy);
 			}
 		}
 	}
+}
+
+void CGameWorld::CopyWorld(CGameWorld *pFrom)
+{
+	if(pFrom == this || !pFrom)
+		return;
+	m_IsValidCopy = false;
+	m_pParent = pFrom;
+	if(m_pParent->m_pChild && m_pParent->m_pChild != this)
+		m_pParent->m_pChild->m_IsValidCopy = false;
+	pFrom->m_pChild = this;
+
+	CopyEntities(pFrom, true);
+	m_IsValidCopy = true;
+}
+
+// copies all entities like CopyWorld, but without linking them to the entities of pFrom
+void CGameWorld::CopyWorldDetached(CGameWorld *pFrom)
+{
+	if(pFrom == this || !pFrom)
+		return;
+	m_IsValidCopy = false;
+
+	CopyEntities(pFrom, false);
+}
+
+// continues a prediction from a cached world, as if it had been simulated from a CopyWorld of pParent
+void CGameWorld::ResumeWorld(CGameWorld *pCached, CGameWorld *pParent)
+{
+	CopyWorldDetached(pCached);
+
+	m_pParent = pParent;
+	if(m_pParent->m_pChild && m_pParent->m_pChild != this)
+		m_pParent->m_pChild->m_IsValidCopy = false;
+	pParent->m_pChild = this;
+
+	// entities that already existed in the parent world keep their link to it
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		for(CEntity *pEnt = FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+		{
+			if(pEnt->m_Id < 0)
+				continue;
+			CEntity *pOrigin = pParent->GetEntity(pEnt->m_Id, Type);
+			if(pOrigin)
+			{
+				pEnt->m_pParent = pOrigin;
+				pOrigin->m_pChild = pEnt;
+			}
+		}
+		// entities that were removed in the skipped ticks
+		for(CEntity *pOrigin = pParent->FindFirst(Type); pOrigin; pOrigin = pOrigin->TypeNext())
+			if(!pOrigin->m_pChild && pOrigin->m_DestroyTick == -1)
+				pOrigin->m_DestroyTick = GameTick();
+	}
 	m_IsValidCopy = true;
 }
 
+bool CGameWorld::SameState(CGameWorld *pOther)
+{
+	if(m_GameTick != pOther->m_GameTick)
+		return false;
+	if(m_WorldConfig != pOther->m_WorldConfig || m_Teams != pOther->m_Teams || m_Core.m_vSwitchers != pOther->m_Core.m_vSwitchers)
+		return false;
+
+	// the entities have to be equal and in the same order, since the order matters for the simulation
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		CEntity *pEnt = FindFirst(Type);
+		CEntity *pOtherEnt = pOther->FindFirst(Type);
+		for(; pEnt && pOtherEnt; pEnt = pEnt->TypeNext(), pOtherEnt = pOtherEnt->TypeNext())
+			if(!pEnt->SameState(pOtherEnt))
+				return false;
+		if(pEnt || pOtherEnt)
+			return false;
+	}
+	return true;
+}
+
 CEntity *CGameWorld::FindMatch(int ObjId, int ObjType, const void *pObjData)
 {
 	switch(ObjType)
@@ -804,10 +955,12 @@ void CGameWorld::OnModified() const
 
 void CGameWorld::Clear()
 {
-	// delete all entities
+	// destroy all entities, their memory is given back to the pool at once
 	for(auto &pFirstEntityType : m_apFirstEntityTypes)
 		while(pFirstEntityType)
-			delete pFirstEntityType; // NOLINT(clang-analyzer-cplusplus.NewDelete)
+			pFirstEntityType->~CEntity();
+	m_EntityPool.Reset();
+	m_Grid.Clear();
 }
 
 bool CGameWorld::EmulateBug(int Bug) const
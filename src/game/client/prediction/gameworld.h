@@ -3,6 +3,9 @@
 #ifndef GAME_CLIENT_PREDICTION_GAMEWORLD_H
 #define GAME_CLIENT_PREDICTION_GAMEWORLD_H
 
+#include "entity_pool.h"
+
+#include <game/entity_grid.h>
 #include <game/gamecore.h>
 #include <game/teamscore.h>
 
@@ -69,7 +72,7 @@ public:
 	void CreateExplosion(vec2 Pos, int Owner, int Weapon, bool NoDamage, int ActivatedTeam, CClientMask Mask);
 
 	// for client side prediction
-	struct
+	struct CWorldConfig
 	{
 		bool m_IsDDRace;
 		bool m_IsVanilla;
@@ -83,6 +86,8 @@ public:
 		bool m_UseTuneZones;
 		bool m_BugDDRaceInput;
 		bool m_NoWeakHookAndBounce;
+
+		bool operator==(const CWorldConfig &Other) const = default;
 	} m_WorldConfig;
 
 	bool m_IsValidCopy;
@@ -99,6 +104,9 @@ public:
 	void NetObjEnd();
 	void CopyWorld(CGameWorld *pFrom);
 	void CopyWorldClean(CGameWorld *pFrom); // TClient
+	void CopyWorldDetached(CGameWorld *pFrom);
+	void ResumeWorld(CGameWorld *pCached, CGameWorld *pParent);
+	bool SameState(CGameWorld *pOther);
 	CEntity *FindMatch(int ObjId, int ObjType, const void *pObjData);
 	void Clear();
 
@@ -111,17 +119,31 @@ public:
 
 	bool EmulateBug(int Bug) const;
 
+	CEntityPool *EntityPool() { return &m_EntityPool; }
+	const CEntityPool *EntityPool() const { return &m_EntityPool; }
+
 private:
 	void RemoveEntities();
+	void CopyEntities(CGameWorld *pFrom, bool Link);
+	void UpdateGrid(int Type);
+	void UpdateTickedEntity();
 
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// spatial index for the queries, see the server game world
+	CEntityGrid<CEntity, NUM_ENTTYPES> m_Grid;
+	CEntity *m_pTickedEntity = nullptr;
+	bool m_Ticking = false;
+	std::vector<CEntity *> m_vpQueryResult;
+
 	CCharacter *m_apCharacters[MAX_CLIENTS];
 
 	CCollision *m_pCollision;
 	CTuningParams *m_pTuningList;
 	const CMapBugs *m_pMapBugs;
+
+	CEntityPool m_EntityPool;
 };
 
 class CCharOrder
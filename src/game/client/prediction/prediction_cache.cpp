@@ -0,0 +1,69 @@
+#include "prediction_cache.h"
+
+#include "entities/character.h"
+
+CPredictionCache::CPredictionCache() :
+	m_pRing(std::make_unique<CRing>())
+{
+}
+
+uint64_t CPredictionCache::TickKey(uint64_t Key, int Tick, const CTickInput &Input)
+{
+	Key = CRing::ChainKey(Key, Tick);
+	Key = CRing::ChainKey(Key, Input.m_CanMoveInFreeze);
+	Key = CRing::ChainKey(Key, Input.m_pInput != nullptr);
+	if(Input.m_pInput)
+		Key = CRing::ChainKey(Key, *Input.m_pInput);
+	Key = CRing::ChainKey(Key, Input.m_pDummyInput != nullptr);
+	if(Input.m_pDummyInput)
+		Key = CRing::ChainKey(Key, *Input.m_pDummyInput);
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(Input.m_apPreInputs[i])
+		{
+			Key = CRing::ChainKey(Key, i);
+			Key = CRing::ChainKey(Key, *Input.m_apPreInputs[i]);
+		}
+	}
+	return Key;
+}
+
+int CPredictionCache::Begin(CGameWorld *pWorld, CGameWorld *pParent, uint64_t BaseIdentity, int FirstTick, int LastCachedTick, int LocalId, int DummyId, const FTickInput &TickInput)
+{
+	BaseIdentity = CRing::ChainKey(BaseIdentity, pWorld->GameTick());
+	BaseIdentity = CRing::ChainKey(BaseIdentity, LocalId);
+	BaseIdentity = CRing::ChainKey(BaseIdentity, DummyId);
+	if(BaseIdentity != m_BaseIdentity)
+	{
+		// a new base world can continue the cached ticks if it ended up in the same state as the previous prediction
+		m_BaseIdentity = BaseIdentity;
+		m_BaseKey = BaseIdentity;
+		uint64_t CachedKey;
+		CGameWorld *pCachedBase = m_pRing->Get(FirstTick - 1, &CachedKey);
+		if(pCachedBase && pWorld->SameState(pCachedBase))
+			m_BaseKey = CachedKey;
+	}
+
+	m_Key = m_BaseKey;
+	CGameWorld *pCached;
+	const int ResumeTick = m_pRing->FindResumeTick(
+		FirstTick, LastCachedTick, m_Key, [&](int Tick, uint64_t Key) {
+			CTickInput Input;
+			TickInput(Tick, &Input);
+			return TickKey(Key, Tick, Input);
+		},
+		&pCached);
+	if(!pCached || !pCached->GetCharacterById(LocalId) || (DummyId >= 0 && !pCached->GetCharacterById(DummyId)))
+	{
+		m_Key = m_BaseKey;
+		return FirstTick;
+	}
+	pWorld->ResumeWorld(pCached, pParent);
+	return ResumeTick;
+}
+
+void CPredictionCache::Store(int Tick, CGameWorld *pWorld, const CTickInput &Input)
+{
+	m_Key = TickKey(m_Key, Tick, Input);
+	m_pRing->Store(Tick, m_Key)->CopyWorldDetached(pWorld);
+}
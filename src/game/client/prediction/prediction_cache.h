@@ -0,0 +1,81 @@
+#ifndef GAME_CLIENT_PREDICTION_PREDICTION_CACHE_H
+#define GAME_CLIENT_PREDICTION_PREDICTION_CACHE_H
+
+#include "gameworld.h"
+
+#include <engine/shared/protocol.h>
+
+#include <generated/protocol.h>
+
+#include <game/prediction_ring.h>
+
+#include <functional>
+#include <memory>
+
+/**
+ * Worlds of the previous predictions, so a prediction can continue from the
+ * last tick whose inputs didn't change instead of simulating every tick
+ * from the snapshot again.
+ */
+class CPredictionCache
+{
+public:
+	enum
+	{
+		NUM_TICKS = 64,
+	};
+
+	/**
+	 * Everything that is fed into the simulation of a tick.
+	 */
+	class CTickInput
+	{
+	public:
+		bool m_CanMoveInFreeze = false;
+		const CNetObj_PlayerInput *m_pInput = nullptr;
+		const CNetObj_PlayerInput *m_pDummyInput = nullptr;
+		// preinputs of the other players intended for the tick, `nullptr` for players without one
+		const CNetMsg_Sv_PreInput *m_apPreInputs[MAX_CLIENTS] = {};
+	};
+
+	typedef std::function<void(int Tick, CTickInput *pInput)> FTickInput;
+	typedef CPredictionRing<CGameWorld, NUM_TICKS> CRing;
+
+	CPredictionCache();
+
+	/**
+	 * Extends the key of the previous tick with the input of a tick.
+	 */
+	static uint64_t TickKey(uint64_t Key, int Tick, const CTickInput &Input);
+
+	/**
+	 * Starts a prediction, continuing from a cached world if possible.
+	 *
+	 * @param pWorld Copy of pParent without the entities that aren't predicted. Replaced by the cached world to continue from.
+	 * @param pParent The world of the last snapshot.
+	 * @param BaseIdentity Identifies the snapshot and the removed entities.
+	 * @param FirstTick The first tick after the snapshot.
+	 * @param LastCachedTick The last tick that may be taken from the cache.
+	 * @param LocalId Id of the local character.
+	 * @param DummyId Id of the predicted dummy character, or `-1`.
+	 * @param TickInput Provides the input of a tick.
+	 *
+	 * @return The first tick that has to be simulated.
+	 */
+	int Begin(CGameWorld *pWorld, CGameWorld *pParent, uint64_t BaseIdentity, int FirstTick, int LastCachedTick, int LocalId, int DummyId, const FTickInput &TickInput);
+
+	/**
+	 * Stores the world after simulating a tick.
+	 */
+	void Store(int Tick, CGameWorld *pWorld, const CTickInput &Input);
+
+private:
+	std::unique_ptr<CRing> m_pRing;
+	uint64_t m_BaseIdentity = 0;
+	// key of the base world, the key of a cached world if the base world continues it
+	uint64_t m_BaseKey = 0;
+	// key of the last simulated tick
+	uint64_t m_Key = 0;
+};
+
+#endif
@@ -36,6 +36,14 @@ vec2 ClampVel(int MoveRestriction, vec2 Vel)
 	return Vel;
 }
 
+enum
+{
+	// the game tile as returned by CCollision::GetTile, TILE_SOLID to TILE_NOLASER
+	COLFLAG_GAME_TILE = 0x7,
+	COLFLAG_FRONT_DEATH = 1 << 3,
+	COLFLAG_FRONT_NOLASER = 1 << 4,
+};
+
 CCollision::CCollision()
 {
 	m_pDoor = nullptr;
@@ -94,6 +102,10 @@ void CCollision::Init(class CLayers *pLayers)
 			m_pFront = static_cast<CTile *>(m_pLayers->Map()->GetData(m_pLayers->FrontLayer()->m_Front));
 	}
 
+	m_vCollisionFlags.resize((size_t)m_Width * m_Height);
+	for(int i = 0; i < m_Width * m_Height; i++)
+		UpdateCollisionFlags(i);
+
 	for(int i = 0; i < m_Width * m_Height; i++)
 	{
 		int Index;
@@ -169,6 +181,20 @@ void CCollision::Unload()
 	m_pTune = nullptr;
 	delete[] m_pDoor;
 	m_pDoor = nullptr;
+
+	m_vCollisionFlags.clear();
+}
+
+void CCollision::UpdateCollisionFlags(int Index)
+{
+	unsigned char Flags = 0;
+	if(m_pTiles[Index].m_Index >= TILE_SOLID && m_pTiles[Index].m_Index <= TILE_NOLASER)
+		Flags |= m_pTiles[Index].m_Index;
+	if(m_pFront && m_pFront[Index].m_Index == TILE_DEATH)
+		Flags |= COLFLAG_FRONT_DEATH;
+	else if(m_pFront && m_pFront[Index].m_Index == TILE_NOLASER)
+		Flags |= COLFLAG_FRONT_NOLASER;
+	m_vCollisionFlags[Index] = Flags;
 }
 
 void CCollision::FillAntibot(CAntibotMapData *pMapData) const
@@ -313,16 +339,38 @@ int CCollision::GetMoveRestrictions(CALLBACK_SWITCHACTIVE pfnSwitchActive, void
 
 int CCollision::GetTile(int x, int y) const
 {
-	if(!m_pTiles)
-		return 0;
+	return GetCollisionFlags(x, y) & COLFLAG_GAME_TILE;
+}
 
-	int Nx = std::clamp(x / 32, 0, m_Width - 1);
-	int Ny = std::clamp(y / 32, 0, m_Height - 1);
-	const int Index = Ny * m_Width + Nx;
+// Returns how many of the following samples of a line are guaranteed to round
+// to the same tile as the current sample at pixel (x, y). All intersection
+// tests only depend on the tile of a sample, so these samples can be skipped
+// once the current one didn't hit anything.
+static int SamplesInSameTile(int x, int y, vec2 Pos, vec2 Step)
+{
+	// truncating division maps negative coordinates to tile 0 as well and
+	// large coordinates don't have enough float precision
+	if(x < 0 || y < 0 || Pos.x > 1e6f || Pos.y > 1e6f)
+		return 0;
 
-	if(m_pTiles[Index].m_Index >= TILE_SOLID && m_pTiles[Index].m_Index <= TILE_NOLASER)
-		return m_pTiles[Index].m_Index;
-	return 0;
+	// only stays at this value for lines of zero length
+	int Samples = 64 * 32;
+	const int aPixel[2] = {x, y};
+	for(int Axis = 0; Axis < 2; Axis++)
+	{
+		const float Delta = Step[Axis];
+		if(Delta == 0.0f)
+			continue;
+		// a sample rounds to this tile while it is in [TileStart - 0.5, TileStart + 31.5)
+		const float TileStart = aPixel[Axis] / 32 * 32;
+		float Room = Delta > 0.0f ? TileStart + 31.5f - Pos[Axis] : Pos[Axis] - (TileStart - 0.5f);
+		// keep a margin for the rounding errors of mix()
+		Room -= 1.0f;
+		if(!(Room > 0.0f))
+			return 0;
+		Samples = std::min(Samples, (int)std::min(Room / std::abs(Delta), (float)Samples));
+	}
+	return Samples;
 }
 
 // TODO: rewrite this smarter!
@@ -330,7 +378,7 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
+	const vec2 Step = (Pos1 - Pos0) / (float)End;
 	for(int i = 0; i <= End; i++)
 	{
 		float a = i / (float)End;
@@ -344,11 +392,11 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / (float)End);
 			return GetCollisionAt(ix, iy);
 		}
 
-		Last = Pos;
+		i += SamplesInSameTile(ix, iy, Pos, Step);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -361,7 +409,7 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
+	const vec2 Step = (Pos1 - Pos0) / (float)End;
 	int dx = 0, dy = 0; // Offset for checking the "through" tile
 	ThroughOffset(Pos0, Pos1, &dx, &dy);
 	for(int i = 0; i <= End; i++)
@@ -385,7 +433,7 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / (float)End);
 			return TILE_TELEINHOOK;
 		}
 
@@ -404,11 +452,11 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / (float)End);
 			return Hit;
 		}
 
-		Last = Pos;
+		i += SamplesInSameTile(ix, iy, Pos, Step);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -421,7 +469,7 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
+	const vec2 Step = (Pos1 - Pos0) / (float)End;
 	for(int i = 0; i <= End; i++)
 	{
 		float a = i / (float)End;
@@ -443,7 +491,7 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / (float)End);
 			return TILE_TELEINWEAPON;
 		}
 
@@ -452,11 +500,11 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / (float)End);
 			return GetCollisionAt(ix, iy);
 		}
 
-		Last = Pos;
+		i += SamplesInSameTile(ix, iy, Pos, Step);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1038,12 +1086,11 @@ int CCollision::GetFrontIndex(int Nx, int Ny) const
 
 int CCollision::GetFrontTile(int x, int y) const
 {
-	if(!m_pFront)
-		return 0;
-	int Nx = std::clamp(x / 32, 0, m_Width - 1);
-	int Ny = std::clamp(y / 32, 0, m_Height - 1);
-	if(m_pFront[Ny * m_Width + Nx].m_Index == TILE_DEATH || m_pFront[Ny * m_Width + Nx].m_Index == TILE_NOLASER)
-		return m_pFront[Ny * m_Width + Nx].m_Index;
+	const unsigned char Flags = GetCollisionFlags(x, y);
+	if(Flags & COLFLAG_FRONT_DEATH)
+		return TILE_DEATH;
+	else if(Flags & COLFLAG_FRONT_NOLASER)
+		return TILE_NOLASER;
 	else
 		return 0;
 }
@@ -1079,6 +1126,7 @@ void CCollision::SetCollisionAt(float x, float y, int Index)
 	int Ny = std::clamp(round_to_int(y) / 32, 0, m_Height - 1);
 
 	m_pTiles[Ny * m_Width + Nx].m_Index = Index;
+	UpdateCollisionFlags(Ny * m_Width + Nx);
 }
 
 void CCollision::SetDoorCollisionAt(float x, float y, int Type, int Flags, int Number)
@@ -1140,7 +1188,7 @@ void ThroughOffset(vec2 Pos0, vec2 Pos1, int *pOffsetX, int *pOffsetY)
 int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
+	const vec2 Step = (Pos1 - Pos0) / Distance;
 
 	const int DistanceRounded = std::ceil(Distance);
 	for(int i = 0; i < DistanceRounded; i++)
@@ -1154,13 +1202,13 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / Distance);
 			if(GetFrontIndex(Nx, Ny) == TILE_NOLASER)
 				return GetFrontCollisionAt(Pos.x, Pos.y);
 			else
 				return GetCollisionAt(Pos.x, Pos.y);
 		}
-		Last = Pos;
+		i += SamplesInSameTile(round_to_int(Pos.x), round_to_int(Pos.y), Pos, Step);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1172,7 +1220,7 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
+	const vec2 Step = (Pos1 - Pos0) / Distance;
 
 	const int DistanceRounded = std::ceil(Distance);
 	for(int i = 0; i < DistanceRounded; i++)
@@ -1184,13 +1232,13 @@ int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / Distance);
 			if(IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
 				return GetCollisionAt(Pos.x, Pos.y);
 			else
 				return GetFrontCollisionAt(Pos.x, Pos.y);
 		}
-		Last = Pos;
+		i += SamplesInSameTile(round_to_int(Pos.x), round_to_int(Pos.y), Pos, Step);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1202,7 +1250,7 @@ int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
+	const vec2 Step = (Pos1 - Pos0) / Distance;
 
 	const int DistanceRounded = std::ceil(Distance);
 	for(int i = 0; i < DistanceRounded; i++)
@@ -1214,7 +1262,7 @@ int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pO
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = i == 0 ? Pos0 : mix(Pos0, Pos1, (i - 1) / Distance);
 			if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)) && !GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y)))
 				return -1;
 			else if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)))
@@ -1222,7 +1270,7 @@ int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pO
 			else
 				return GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y));
 		}
-		Last = Pos;
+		i += SamplesInSameTile(round_to_int(Pos.x), round_to_int(Pos.y), Pos, Step);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
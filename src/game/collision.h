@@ -7,6 +7,7 @@
 
 #include <engine/shared/protocol.h>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -158,6 +159,20 @@ private:
 	CTuneTile *m_pTune;
 	CDoorTile *m_pDoor;
 
+	// COLFLAG_* byte per tile with the game and front layer information the
+	// hot collision probes need, a quarter of the size of the tile layer
+	std::vector<unsigned char> m_vCollisionFlags;
+
+	unsigned char GetCollisionFlags(int x, int y) const
+	{
+		if(m_vCollisionFlags.empty())
+			return 0;
+		int Nx = std::clamp(x / 32, 0, m_Width - 1);
+		int Ny = std::clamp(y / 32, 0, m_Height - 1);
+		return m_vCollisionFlags[Ny * m_Width + Nx];
+	}
+	void UpdateCollisionFlags(int Index);
+
 	// TILE_TELEIN
 	std::map<int, std::vector<vec2>> m_TeleIns;
 	// TILE_TELEOUT
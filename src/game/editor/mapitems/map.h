@@ -32,17 +32,19 @@ class CLayerTele;
 class CLayerTune;
 class CQuad;
 class IEditorEnvelopeReference;
+class IEngine;
 
 class CDataFileWriterFinishJob : public IJob
 {
 	char m_aRealFilename[IO_MAX_PATH_LENGTH];
 	char m_aTempFilename[IO_MAX_PATH_LENGTH];
+	IEngine *m_pEngine;
 	CDataFileWriter m_Writer;
 
 	void Run() override;
 
 public:
-	CDataFileWriterFinishJob(const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer);
+	CDataFileWriterFinishJob(IEngine *pEngine, const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer);
 	const char *GetRealFilename() const { return m_aRealFilename; }
 	const char *GetTempFilename() const { return m_aTempFilename; }
 };
@@ -172,7 +174,7 @@ public:
 	void CheckIntegrity();
 
 	// io
-	bool Save(const char *pFilename, const FErrorHandler &ErrorHandler);
+	bool Save(const char *pFilename, const FErrorHandler &ErrorHandler, bool Autosave = false);
 	bool PerformPreSaveSanityChecks(const FErrorHandler &ErrorHandler);
 	bool Load(const char *pFilename, int StorageType, const FErrorHandler &ErrorHandler);
 	void PerformSanityChecks(const FErrorHandler &ErrorHandler);
@@ -33,17 +33,18 @@ public:
 
 void CDataFileWriterFinishJob::Run()
 {
-	m_Writer.Finish();
+	m_Writer.Finish(m_pEngine);
 }
 
-CDataFileWriterFinishJob::CDataFileWriterFinishJob(const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer) :
+CDataFileWriterFinishJob::CDataFileWriterFinishJob(IEngine *pEngine, const char *pRealFilename, const char *pTempFilename, CDataFileWriter &&Writer) :
+	m_pEngine(pEngine),
 	m_Writer(std::move(Writer))
 {
 	str_copy(m_aRealFilename, pRealFilename);
 	str_copy(m_aTempFilename, pTempFilename);
 }
 
-bool CEditorMap::Save(const char *pFilename, const FErrorHandler &ErrorHandler)
+bool CEditorMap::Save(const char *pFilename, const FErrorHandler &ErrorHandler, bool Autosave)
 {
 	char aFilenameTmp[IO_MAX_PATH_LENGTH];
 	IStorage::FormatTmpPath(aFilenameTmp, sizeof(aFilenameTmp), pFilename);
@@ -56,6 +57,8 @@ bool CEditorMap::Save(const char *pFilename, const FErrorHandler &ErrorHandler)
 	}
 
 	CDataFileWriter Writer;
+	// autosaves are written often and only kept for a while, so save time over file size
+	Writer.SetFastCompression(Autosave);
 	if(!Writer.Open(m_pEditor->Storage(), aFilenameTmp))
 	{
 		char aBuf[IO_MAX_PATH_LENGTH + 64];
@@ -411,7 +414,7 @@ bool CEditorMap::Save(const char *pFilename, const FErrorHandler &ErrorHandler)
 	}
 
 	// finish the data file
-	std::shared_ptr<CDataFileWriterFinishJob> pWriterFinishJob = std::make_shared<CDataFileWriterFinishJob>(pFilename, aFilenameTmp, std::move(Writer));
+	std::shared_ptr<CDataFileWriterFinishJob> pWriterFinishJob = std::make_shared<CDataFileWriterFinishJob>(m_pEditor->Engine(), pFilename, aFilenameTmp, std::move(Writer));
 	m_pEditor->Engine()->AddJob(pWriterFinishJob);
 	m_pEditor->m_WriterFinishJobs.push_back(pWriterFinishJob);
 
@@ -1113,7 +1116,7 @@ bool CEditorMap::PerformAutosave(const std::function<void(const char *pErrorMess
 	str_format(aAutosavePath, sizeof(aAutosavePath), "maps/auto/%s_%s.map", aFilenameNoExt, aDate);
 
 	m_LastSaveTime = Editor()->Client()->GlobalTime();
-	if(Save(aAutosavePath, ErrorHandler))
+	if(Save(aAutosavePath, ErrorHandler, true))
 	{
 		m_ModifiedAuto = false;
 		// Clean up autosaves
@@ -0,0 +1,193 @@
+#ifndef GAME_ENTITY_GRID_H
+#define GAME_ENTITY_GRID_H
+
+#include <base/vmath.h>
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Bookkeeping of an entity inside CEntityGrid.
+ */
+template<typename TEntity>
+struct CEntityGridNode
+{
+	TEntity *m_pPrev = nullptr;
+	TEntity *m_pNext = nullptr;
+	int m_Type = -1;
+	int m_Bucket = -1;
+	// position in the type list of the world, entities closer to the head have a higher order
+	int64_t m_Order = 0;
+};
+
+/**
+ * Uniform grid over the entities of a game world, used to narrow down the
+ * candidates of proximity queries.
+ *
+ * The grid cells are hashed into a fixed number of buckets per entity type,
+ * so positions outside of the map are covered as well. An entity is put into
+ * its cell when it is inserted and whenever the world calls Update after it
+ * may have moved. Queries only return candidates, the exact test has to be
+ * done by the caller on the current position of the entity.
+ *
+ * TEntity has to provide `m_Pos`, `GetProximityRadius()` and a
+ * `CEntityGridNode<TEntity> m_GridNode` member.
+ */
+template<typename TEntity, int NumTypes>
+class CEntityGrid
+{
+public:
+	enum
+	{
+		CELL_SIZE = 256,
+		NUM_BUCKETS = 128,
+		// queries covering more cells fall back to walking the type list
+		MAX_QUERY_CELLS = 32,
+	};
+
+	CEntityGrid()
+	{
+		Clear();
+	}
+
+	void Clear()
+	{
+		for(auto &apBuckets : m_aapBuckets)
+			for(auto &pBucket : apBuckets)
+				pBucket = nullptr;
+		for(auto &MaxRadius : m_aMaxRadius)
+			MaxRadius = 0.0f;
+		m_HeadOrder = 0;
+		m_TailOrder = 0;
+	}
+
+	void Insert(TEntity *pEnt, int Type, bool Last = false)
+	{
+		CEntityGridNode<TEntity> &Node = pEnt->m_GridNode;
+		Node.m_Type = Type;
+		Node.m_Bucket = -1;
+		Node.m_Order = Last ? --m_TailOrder : ++m_HeadOrder;
+		if(pEnt->GetProximityRadius() > m_aMaxRadius[Type])
+			m_aMaxRadius[Type] = pEnt->GetProximityRadius();
+		Link(pEnt, BucketOf(pEnt->m_Pos));
+	}
+
+	void Remove(TEntity *pEnt)
+	{
+		if(pEnt->m_GridNode.m_Bucket < 0)
+			return;
+		Unlink(pEnt);
+	}
+
+	// moves the entity to the cell of its current position
+	void Update(TEntity *pEnt)
+	{
+		CEntityGridNode<TEntity> &Node = pEnt->m_GridNode;
+		if(Node.m_Bucket < 0)
+			return;
+		if(pEnt->GetProximityRadius() > m_aMaxRadius[Node.m_Type])
+			m_aMaxRadius[Node.m_Type] = pEnt->GetProximityRadius();
+		const int Bucket = BucketOf(pEnt->m_Pos);
+		if(Bucket == Node.m_Bucket)
+			return;
+		Unlink(pEnt);
+		Link(pEnt, Bucket);
+	}
+
+	// largest proximity radius of all entities of the type since the last clear
+	float MaxProximityRadius(int Type) const { return m_aMaxRadius[Type]; }
+
+	// whether pA comes before pB in the type list of the world
+	static bool ListOrder(const TEntity *pA, const TEntity *pB)
+	{
+		return pA->m_GridNode.m_Order > pB->m_GridNode.m_Order;
+	}
+
+	/**
+	 * Calls Fn for every entity of the type whose cell overlaps the box, in
+	 * no particular order.
+	 *
+	 * @return `false` if the box is too large, Fn has not been called then.
+	 */
+	template<typename TFn>
+	bool Query(int Type, vec2 Min, vec2 Max, TFn &&Fn) const
+	{
+		const int MinX = CellCoord(Min.x);
+		const int MinY = CellCoord(Min.y);
+		const int MaxX = CellCoord(Max.x);
+		const int MaxY = CellCoord(Max.y);
+		if((int64_t)(MaxX - MinX + 1) * (MaxY - MinY + 1) > MAX_QUERY_CELLS)
+			return false;
+
+		// different cells can share a bucket
+		uint64_t aVisited[NUM_BUCKETS / 64] = {};
+		for(int y = MinY; y <= MaxY; y++)
+		{
+			for(int x = MinX; x <= MaxX; x++)
+			{
+				const int Bucket = BucketOf(x, y);
+				if(aVisited[Bucket / 64] & (1ull << (Bucket % 64)))
+					continue;
+				aVisited[Bucket / 64] |= 1ull << (Bucket % 64);
+				for(TEntity *pEnt = m_aapBuckets[Type][Bucket]; pEnt; pEnt = pEnt->m_GridNode.m_pNext)
+					Fn(pEnt);
+			}
+		}
+		return true;
+	}
+
+private:
+	static int CellCoord(float Value)
+	{
+		// also catches NaN, such entities never pass the exact test anyway
+		const float Limit = 1e8f;
+		if(!(Value > -Limit))
+			Value = -Limit;
+		else if(!(Value < Limit))
+			Value = Limit;
+		return (int)std::floor(Value / CELL_SIZE);
+	}
+
+	static int BucketOf(int x, int y)
+	{
+		return (int)(((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u) % NUM_BUCKETS);
+	}
+
+	static int BucketOf(vec2 Pos)
+	{
+		return BucketOf(CellCoord(Pos.x), CellCoord(Pos.y));
+	}
+
+	void Link(TEntity *pEnt, int Bucket)
+	{
+		CEntityGridNode<TEntity> &Node = pEnt->m_GridNode;
+		TEntity *&pFirst = m_aapBuckets[Node.m_Type][Bucket];
+		Node.m_Bucket = Bucket;
+		Node.m_pPrev = nullptr;
+		Node.m_pNext = pFirst;
+		if(pFirst)
+			pFirst->m_GridNode.m_pPrev = pEnt;
+		pFirst = pEnt;
+	}
+
+	void Unlink(TEntity *pEnt)
+	{
+		CEntityGridNode<TEntity> &Node = pEnt->m_GridNode;
+		if(Node.m_pPrev)
+			Node.m_pPrev->m_GridNode.m_pNext = Node.m_pNext;
+		else
+			m_aapBuckets[Node.m_Type][Node.m_Bucket] = Node.m_pNext;
+		if(Node.m_pNext)
+			Node.m_pNext->m_GridNode.m_pPrev = Node.m_pPrev;
+		Node.m_pPrev = nullptr;
+		Node.m_pNext = nullptr;
+		Node.m_Bucket = -1;
+	}
+
+	TEntity *m_aapBuckets[NumTypes][NUM_BUCKETS];
+	float m_aMaxRadius[NumTypes];
+	int64_t m_HeadOrder;
+	int64_t m_TailOrder;
+};
+
+#endif
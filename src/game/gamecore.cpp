@@ -697,6 +697,16 @@ void CCharacterCore::Quantize()
 	Read(&Core);
 }
 
+bool CCharacterCore::SameState(const CCharacterCore &Other) const
+{
+	for(int i = 0; i < NUM_WEAPONS; i++)
+		if(m_aWeapons[i] != Other.m_aWeapons[i])
+			return false;
+	return State() == Other.State() &&
+	       mem_comp(&m_Input, &Other.m_Input, sizeof(m_Input)) == 0 &&
+	       mem_comp(&m_Tuning, &Other.m_Tuning, sizeof(m_Tuning)) == 0;
+}
+
 void CCharacterCore::SetHookedPlayer(int HookedPlayer)
 {
 	if(HookedPlayer != m_HookedPlayer)
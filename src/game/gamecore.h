@@ -14,6 +14,7 @@
 #include <game/teamscore.h>
 
 #include <set>
+#include <tuple>
 #include <vector>
 
 class CCollision;
@@ -142,6 +143,8 @@ struct SSwitchers
 	int m_aEndTick[NUM_DDRACE_TEAMS];
 	int m_aType[NUM_DDRACE_TEAMS];
 	int m_aLastUpdateTick[NUM_DDRACE_TEAMS];
+
+	bool operator==(const SSwitchers &Other) const = default;
 };
 
 class CWorldCore
@@ -203,15 +206,19 @@ public:
 		int m_Ammo;
 		int m_Ammocost;
 		bool m_Got;
+
+		bool operator==(const CWeaponStat &Other) const = default;
 	} m_aWeapons[NUM_WEAPONS];
 
 	// ninja
-	struct
+	struct CNinja
 	{
 		vec2 m_ActivationDir;
 		int m_ActivationTick;
 		int m_CurrentMoveTime;
 		int m_OldVelAmount;
+
+		bool operator==(const CNinja &Other) const = default;
 	} m_Ninja;
 
 	bool m_NewHook;
@@ -237,6 +244,8 @@ public:
 	void Read(const CNetObj_CharacterCore *pObjCore);
 	void Write(CNetObj_CharacterCore *pObjCore) const;
 	void Quantize();
+	// whether the core continues exactly like Other, see State
+	bool SameState(const CCharacterCore &Other) const;
 
 	// DDRace
 	int m_Id;
@@ -276,6 +285,18 @@ private:
 	int m_MoveRestrictions;
 	int m_HookedPlayer;
 	static bool IsSwitchActiveCb(int Number, void *pUser);
+
+	// the members the simulation depends on, except for the arrays and
+	// input structs compared by SameState, extend when adding members
+	auto State() const
+	{
+		return std::tie(m_Pos, m_Vel, m_HookPos, m_HookDir, m_HookTeleBase, m_HookTick, m_HookState, m_AttachedPlayers,
+			m_ActiveWeapon, m_Ninja, m_NewHook, m_Jumped, m_JumpedTotal, m_Jumps, m_Direction, m_Angle, m_TriggeredEvents,
+			m_Id, m_Reset, m_Colliding, m_LeftWall, m_Solo, m_Jetpack, m_CollisionDisabled, m_EndlessHook, m_EndlessJump,
+			m_HammerHitDisabled, m_GrenadeHitDisabled, m_LaserHitDisabled, m_ShotgunHitDisabled, m_HookHitDisabled,
+			m_Super, m_Invincible, m_HasTelegunGun, m_HasTelegunGrenade, m_HasTelegunLaser, m_FreezeStart, m_FreezeEnd,
+			m_IsInFreeze, m_DeepFrozen, m_LiveFrozen, m_MoveRestrictions, m_HookedPlayer);
+	}
 };
 
 // input count
@@ -0,0 +1,115 @@
+#ifndef GAME_PREDICTION_RING_H
+#define GAME_PREDICTION_RING_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Tick-indexed cache of the worlds produced by a prediction replay.
+ *
+ * Every stored world is tagged with a key that chains the key of the
+ * previous tick with everything that was fed into the simulation of its
+ * tick (inputs and flags). A later replay that starts from the same base
+ * world can skip all ticks whose chained key is unchanged and continue from
+ * the last stored world instead of simulating every tick again.
+ */
+template<typename TWorld, int NumTicks>
+class CPredictionRing
+{
+public:
+	static constexpr uint64_t EMPTY_KEY = 14695981039346656037ull;
+
+	/**
+	 * Extends a key with the given data (FNV-1a).
+	 */
+	static uint64_t ChainKey(uint64_t Key, const void *pData, size_t Size)
+	{
+		const unsigned char *pBytes = static_cast<const unsigned char *>(pData);
+		for(size_t i = 0; i < Size; i++)
+		{
+			Key ^= pBytes[i];
+			Key *= 1099511628211ull;
+		}
+		return Key;
+	}
+
+	template<typename T>
+	static uint64_t ChainKey(uint64_t Key, const T &Data)
+	{
+		return ChainKey(Key, &Data, sizeof(Data));
+	}
+
+	void Reset()
+	{
+		for(auto &Entry : m_aEntries)
+			Entry.m_Tick = -1;
+	}
+
+	/**
+	 * @return The world stored for the tick, regardless of its key, or `nullptr`.
+	 */
+	TWorld *Get(int Tick, uint64_t *pKey = nullptr)
+	{
+		SEntry &Entry = m_aEntries[Index(Tick)];
+		if(Entry.m_Tick != Tick)
+			return nullptr;
+		if(pKey)
+			*pKey = Entry.m_Key;
+		return &Entry.m_World;
+	}
+
+	/**
+	 * Claims the slot of the tick, the caller has to fill the returned world.
+	 */
+	TWorld *Store(int Tick, uint64_t Key)
+	{
+		SEntry &Entry = m_aEntries[Index(Tick)];
+		Entry.m_Tick = Tick;
+		Entry.m_Key = Key;
+		return &Entry.m_World;
+	}
+
+	/**
+	 * Finds how far a replay can be taken from the cache.
+	 *
+	 * @param FirstTick The first tick the replay would simulate.
+	 * @param LastTick The last tick that may be taken from the cache.
+	 * @param Key The key of the base world. Updated to the key of the returned world.
+	 * @param TickKey Callable returning the key of a tick given the key of the previous tick.
+	 * @param ppWorld Receives the cached world of the tick before the returned one, or `nullptr`.
+	 *
+	 * @return The first tick that has to be simulated.
+	 */
+	template<typename FTickKey>
+	int FindResumeTick(int FirstTick, int LastTick, uint64_t &Key, FTickKey &&TickKey, TWorld **ppWorld)
+	{
+		*ppWorld = nullptr;
+		if(LastTick - FirstTick >= NumTicks)
+			return FirstTick;
+		int Tick = FirstTick;
+		for(; Tick <= LastTick; Tick++)
+		{
+			const uint64_t NextKey = TickKey(Tick, Key);
+			uint64_t StoredKey;
+			TWorld *pWorld = Get(Tick, &StoredKey);
+			if(!pWorld || StoredKey != NextKey)
+				break;
+			Key = NextKey;
+			*ppWorld = pWorld;
+		}
+		return Tick;
+	}
+
+private:
+	static int Index(int Tick) { return ((Tick % NumTicks) + NumTicks) % NumTicks; }
+
+	struct SEntry
+	{
+		int m_Tick = -1;
+		uint64_t m_Key = 0;
+		TWorld m_World;
+	};
+	SEntry m_aEntries[NumTicks];
+};
+
+#endif
@@ -600,6 +600,25 @@ void CGameContext::ConAntibot(IConsole::IResult *pResult, void *pUserData)
 	pSelf->Antibot()->ConsoleCommand(pResult->GetString(0));
 }
 
+void CGameContext::ConDumpSnapStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	const CGameWorld::CSnapStats &Stats = pSelf->m_World.SnapStats();
+	if(Stats.m_NumSnaps == 0)
+	{
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap", "No snapshots since the last dump");
+		return;
+	}
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%d snapshots, per snapshot: %.1f entities, %.1f visited, %.1f emitted",
+		(int)Stats.m_NumSnaps,
+		Stats.m_NumEntities / (double)Stats.m_NumSnaps,
+		Stats.m_NumVisited / (double)Stats.m_NumSnaps,
+		Stats.m_NumEmitted / (double)Stats.m_NumSnaps);
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap", aBuf);
+	pSelf->m_World.ResetSnapStats();
+}
+
 void CGameContext::ConDumpLog(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
@@ -234,6 +234,12 @@ void CDragger::Snap(int SnappingClient)
 		m_Pos, m_Pos, StartTick, -1, LASERTYPE_DRAGGER, Subtype, m_Number);
 }
 
+bool CDragger::GetSnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = *pMax = m_Pos;
+	return true;
+}
+
 void CDragger::SwapClients(int Client1, int Client2)
 {
 	std::swap(m_apDraggerBeam[Client1], m_apDraggerBeam[Client2]);
@@ -138,6 +138,15 @@ void CDraggerBeam::Snap(int SnappingClient)
 		TargetPos, m_Pos, StartTick, m_ForClientId, LASERTYPE_DRAGGER, Subtype, m_Number);
 }
 
+bool CDraggerBeam::GetSnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	CCharacter *pTarget = GameServer()->GetPlayerChar(m_ForClientId);
+	const vec2 TargetPos = pTarget ? pTarget->m_Pos : m_Pos;
+	*pMin = vec2(minimum(m_Pos.x, TargetPos.x), minimum(m_Pos.y, TargetPos.y));
+	*pMax = vec2(maximum(m_Pos.x, TargetPos.x), maximum(m_Pos.y, TargetPos.y));
+	return true;
+}
+
 void CDraggerBeam::SwapClients(int Client1, int Client2)
 {
 	m_ForClientId = m_ForClientId == Client1 ? Client2 : (m_ForClientId == Client2 ? Client1 : m_ForClientId);
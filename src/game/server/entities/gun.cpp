@@ -172,3 +172,9 @@ void CGun::Snap(int SnappingClient)
 	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
 		m_Pos, m_Pos, StartTick, -1, LASERTYPE_GUN, Subtype, m_Number);
 }
+
+bool CGun::GetSnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = *pMax = m_Pos;
+	return true;
+}
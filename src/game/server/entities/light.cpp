@@ -141,3 +141,10 @@ void CLight::Snap(int SnappingClient)
 	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
 		m_Pos, From, StartTick, -1, LASERTYPE_FREEZE, 0, m_Number);
 }
+
+bool CLight::GetSnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = vec2(minimum(m_Pos.x, m_To.x), minimum(m_Pos.y, m_To.y));
+	*pMax = vec2(maximum(m_Pos.x, m_To.x), maximum(m_Pos.y, m_To.y));
+	return true;
+}
@@ -188,6 +188,12 @@ void CPickup::Snap(int SnappingClient)
 	GameServer()->SnapPickup(CSnapContext(SnappingClientVersion, Sixup, SnappingClient), GetId(), m_Pos, m_Type, m_Subtype, m_Number, m_Flags);
 }
 
+bool CPickup::GetSnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = *pMax = m_Pos;
+	return true;
+}
+
 void CPickup::Move()
 {
 	if(Server()->Tick() % (int)(Server()->TickSpeed() * 0.15f) == 0)
@@ -16,6 +16,7 @@ public:
 	void Tick() override;
 	void TickPaused() override;
 	void Snap(int SnappingClient) override;
+	bool GetSnapBounds(vec2 *pMin, vec2 *pMax) override;
 
 	int Type() const { return m_Type; }
 	int Subtype() const { return m_Subtype; }
@@ -126,6 +126,12 @@ void CPlasma::Snap(int SnappingClient)
 		m_Pos, m_Pos, m_EvalTick, m_ForClientId, LASERTYPE_PLASMA, Subtype, m_Number);
 }
 
+bool CPlasma::GetSnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = *pMax = m_Pos;
+	return true;
+}
+
 void CPlasma::SwapClients(int Client1, int Client2)
 {
 	m_ForClientId = m_ForClientId == Client1 ? Client2 : (m_ForClientId == Client2 ? Client1 : m_ForClientId);
@@ -9,6 +9,7 @@
 #include <base/vmath.h>
 
 #include <game/alloc.h>
+#include <game/entity_grid.h>
 
 class CCollision;
 class CGameContext;
@@ -23,8 +24,11 @@ class CEntity
 
 private:
 	friend CGameWorld; // entity list handling
+	template<typename, int>
+	friend class CEntityGrid;
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	CEntityGridNode<CEntity> m_GridNode;
 
 	/* Identity */
 	CGameWorld *m_pGameWorld;
@@ -123,6 +127,21 @@ public: // TODO: Maybe make protected
 	*/
 	virtual void Snap(int SnappingClient) {}
 
+	/*
+		Function: GetSnapBounds
+			Gives the area that has to be in view of a client for Snap
+			to add anything to its snapshot. The game world skips Snap
+			for clients that can't see any of it. Queried once per tick.
+
+		Arguments:
+			pMin - Receives the top left corner of the area.
+			pMax - Receives the bottom right corner of the area.
+
+		Returns:
+			False if Snap has to be called for every client.
+	*/
+	virtual bool GetSnapBounds(vec2 *pMin, vec2 *pMax) { return false; }
+
 	/*
 		Function: SwapClients
 			Called when two players have swapped their client ids.
@@ -174,7 +174,7 @@ void CGameContext::Clear()
 void CGameContext::TeeHistorianWrite(const void *pData, int DataSize, void *pUser)
 {
 	CGameContext *pSelf = (CGameContext *)pUser;
-	aio_write(pSelf->m_pTeeHistorianFile, pData, DataSize);
+	pSelf->m_TeeHistorianWriter.Write(pData, DataSize);
 }
 
 void CGameContext::CommandCallback(int ClientId, int FlagMask, const char *pCmd, IConsole::IResult *pResult, void *pUser)
@@ -1092,7 +1092,7 @@ void CGameContext::OnTick()
 
 	if(m_TeeHistorianActive)
 	{
-		int Error = aio_error(m_pTeeHistorianFile);
+		int Error = m_TeeHistorianWriter.Error();
 		if(Error)
 		{
 			dbg_msg("teehistorian", "error writing to file, err=%d", Error);
@@ -1104,6 +1104,7 @@ void CGameContext::OnTick()
 			m_TeeHistorian.EndInputs();
 			m_TeeHistorian.EndTick();
 		}
+		m_TeeHistorianWriter.BeginTick(Server()->Tick());
 		m_TeeHistorian.BeginTick(Server()->Tick());
 		m_TeeHistorian.BeginPlayers();
 	}
@@ -3888,6 +3889,7 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("votes", "?i[page]", CFGFLAG_SERVER, ConVotes, this, "Show all votes (page 0 by default, 20 entries per page)");
 	Console()->Register("dump_antibot", "", CFGFLAG_SERVER | CFGFLAG_STORE, ConDumpAntibot, this, "Dumps the antibot status");
 	Console()->Register("antibot", "r[command]", CFGFLAG_SERVER | CFGFLAG_STORE, ConAntibot, this, "Sends a command to the antibot");
+	Console()->Register("dump_snap_stats", "", CFGFLAG_SERVER, ConDumpSnapStats, this, "Shows how many entities were snapped per snapshot since the last dump");
 
 	Console()->Chain("sv_motd", ConchainSpecialMotdupdate, this);
 
@@ -4204,7 +4206,7 @@ void CGameContext::OnInit(const void *pPersistentData)
 		FormatUuid(m_GameUuid, aGameUuid, sizeof(aGameUuid));
 
 		char aFilename[IO_MAX_PATH_LENGTH];
-		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian", aGameUuid);
+		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian%s", aGameUuid, g_Config.m_SvTeeHistorianCompression ? ".z" : "");
 
 		IOHANDLE THFile = Storage()->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 		if(!THFile)
@@ -4217,7 +4219,7 @@ void CGameContext::OnInit(const void *pPersistentData)
 		{
 			dbg_msg("teehistorian", "recording to '%s'", aFilename);
 		}
-		m_pTeeHistorianFile = aio_new(THFile);
+		m_TeeHistorianWriter.Open(THFile, g_Config.m_SvTeeHistorianCompression);
 
 		char aVersion[128];
 		if(GIT_SHORTREV_HASH)
@@ -4514,7 +4516,7 @@ bool CGameContext::OnMapChange(char *pNewMapName, int MapNameSize)
 		log_error("mapchange", "Failed to import settings from '%s': failed to open map '%s' for writing", aConfig, aTemp);
 		return false;
 	}
-	Writer.Finish();
+	Writer.Finish(Engine());
 	log_info("mapchange", "Imported settings from '%s' into '%s'", aConfig, aTemp);
 
 	str_copy(pNewMapName, aTemp, MapNameSize);
@@ -4536,15 +4538,12 @@ void CGameContext::OnShutdown(void *pPersistentData)
 	if(m_TeeHistorianActive)
 	{
 		m_TeeHistorian.Finish();
-		aio_close(m_pTeeHistorianFile);
-		aio_wait(m_pTeeHistorianFile);
-		int Error = aio_error(m_pTeeHistorianFile);
+		int Error = m_TeeHistorianWriter.Close();
 		if(Error)
 		{
 			dbg_msg("teehistorian", "error closing file, err=%d", Error);
 			Server()->SetErrorShutdown("teehistorian close error");
 		}
-		aio_free(m_pTeeHistorianFile);
 	}
 
 	// Stop any demos being recorded.
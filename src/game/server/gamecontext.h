@@ -9,6 +9,7 @@
 
 #include <engine/console.h>
 #include <engine/server.h>
+#include <engine/shared/teehistorian_file.h>
 
 #include <generated/protocol.h>
 
@@ -122,7 +123,7 @@ class CGameContext : public IGameServer
 
 	bool m_TeeHistorianActive;
 	CTeeHistorian m_TeeHistorian;
-	ASYNCIO *m_pTeeHistorianFile;
+	CTeeHistorianWriter m_TeeHistorianWriter;
 	CUuid m_GameUuid;
 	CMapBugs m_MapBugs;
 	CPrng m_Prng;
@@ -166,6 +167,7 @@ class CGameContext : public IGameServer
 	static void ConDrySave(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpAntibot(IConsole::IResult *pResult, void *pUserData);
 	static void ConAntibot(IConsole::IResult *pResult, void *pUserData);
+	static void ConDumpSnapStats(IConsole::IResult *pResult, void *pUserData);
 	static void ConchainSpecialMotdupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSettingUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainPracticeByDefaultUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -7,6 +7,7 @@
 #include "entity.h"
 #include "gamecontext.h"
 #include "gamecontroller.h"
+#include "player.h"
 
 #include <engine/shared/config.h>
 
@@ -61,6 +62,25 @@ int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max,
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
+	UpdateGrid(Type);
+	const float Range = Radius + m_Grid.MaxProximityRadius(Type);
+	m_vpQueryResult.clear();
+	const bool Found = m_Grid.Query(Type, Pos - vec2(Range, Range), Pos + vec2(Range, Range), [&](CEntity *pEnt) {
+		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
+			m_vpQueryResult.push_back(pEnt);
+	});
+	if(Found)
+	{
+		// same result as walking the list
+		std::sort(m_vpQueryResult.begin(), m_vpQueryResult.end(), m_Grid.ListOrder);
+		int Num = m_vpQueryResult.size();
+		if(Max > 0 && Num > Max)
+			Num = Max;
+		if(ppEnts)
+			std::copy(m_vpQueryResult.begin(), m_vpQueryResult.begin() + Num, ppEnts);
+		return Num;
+	}
+
 	int Num = 0;
 	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
 	{
@@ -90,6 +110,9 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = nullptr;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+
+	m_Grid.Insert(pEnt, pEnt->m_ObjType);
+	m_SnapIndexDirty = true;
 }
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
@@ -112,29 +135,168 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
+
+	m_Grid.Remove(pEnt);
+	if(m_pTickedEntity == pEnt)
+		m_pTickedEntity = nullptr;
+	m_SnapIndexDirty = true;
 }
 
-//
-void CGameWorld::Snap(int SnappingClient)
+void CGameWorld::UpdateGrid(int Type)
 {
-	for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
+	// during the tick only the entity whose callback is running can have moved
+	if(m_Ticking)
 	{
-		m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-		pEnt->Snap(SnappingClient);
-		pEnt = m_pNextTraverseEntity;
+		if(m_pTickedEntity)
+			m_Grid.Update(m_pTickedEntity);
+		return;
 	}
+	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		m_Grid.Update(pEnt);
+}
+
+void CGameWorld::UpdateTickedEntity()
+{
+	// the entity might have been destroyed by its own callback
+	if(m_pTickedEntity)
+		m_Grid.Update(m_pTickedEntity);
+	m_pTickedEntity = nullptr;
+}
+
+static int SnapCellCoord(float Value, int NumCells)
+{
+	// entities outside of the map are put into the border cells, also catches NaN
+	if(!(Value >= 0.0f))
+		return 0;
+	if(!(Value < (float)NumCells * CGameWorld::SNAP_CELL_SIZE))
+		return NumCells - 1;
+	return (int)(Value / CGameWorld::SNAP_CELL_SIZE);
+}
 
+void CGameWorld::UpdateSnapIndex()
+{
+	if(!m_SnapIndexDirty && m_SnapIndexTick == Server()->Tick())
+		return;
+	m_SnapIndexDirty = false;
+	m_SnapIndexTick = Server()->Tick();
+
+	const CCollision *pCollision = GameServer()->Collision();
+	m_SnapCellsX = maximum(1, (pCollision->GetWidth() * 32 + SNAP_CELL_SIZE - 1) / SNAP_CELL_SIZE);
+	m_SnapCellsY = maximum(1, (pCollision->GetHeight() * 32 + SNAP_CELL_SIZE - 1) / SNAP_CELL_SIZE);
+	const int NumCells = m_SnapCellsX * m_SnapCellsY;
+
+	m_vSnapEntities.clear();
+	m_vSnapUncelled.clear();
+	m_SnapMaxExtent = 0.0f;
+	const auto &&AddEntities = [&](int Type) {
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			CSnapEntity Entity;
+			Entity.m_pEntity = pEnt;
+			Entity.m_Bounded = pEnt->GetSnapBounds(&Entity.m_Min, &Entity.m_Max);
+			Entity.m_Cell = -1;
+			if(Entity.m_Bounded)
+			{
+				const vec2 Extent = (Entity.m_Max - Entity.m_Min) / 2.0f;
+				if(maximum(Extent.x, Extent.y) <= SNAP_CELL_SIZE)
+				{
+					const vec2 Center = (Entity.m_Min + Entity.m_Max) / 2.0f;
+					Entity.m_Cell = SnapCellCoord(Center.y, m_SnapCellsY) * m_SnapCellsX + SnapCellCoord(Center.x, m_SnapCellsX);
+					m_SnapMaxExtent = maximum(m_SnapMaxExtent, Extent.x, Extent.y);
+				}
+			}
+			if(Entity.m_Cell < 0)
+				m_vSnapUncelled.push_back(m_vSnapEntities.size());
+			m_vSnapEntities.push_back(Entity);
+		}
+	};
+	AddEntities(ENTTYPE_CHARACTER);
 	for(int i = 0; i < NUM_ENTTYPES; i++)
-	{
-		if(i == ENTTYPE_CHARACTER)
-			continue;
+		if(i != ENTTYPE_CHARACTER)
+			AddEntities(i);
+
+	// counting sort by cell, afterwards m_vSnapCellStart[c] is the first entry of cell c
+	m_vSnapCellStart.assign(NumCells + 1, 0);
+	for(const CSnapEntity &Entity : m_vSnapEntities)
+		if(Entity.m_Cell >= 0)
+			m_vSnapCellStart[Entity.m_Cell]++;
+	for(int c = 1; c <= NumCells; c++)
+		m_vSnapCellStart[c] += m_vSnapCellStart[c - 1];
+	m_vSnapCellEntities.resize(m_vSnapCellStart[NumCells]);
+	for(int i = (int)m_vSnapEntities.size() - 1; i >= 0; i--)
+		if(m_vSnapEntities[i].m_Cell >= 0)
+			m_vSnapCellEntities[--m_vSnapCellStart[m_vSnapEntities[i].m_Cell]] = i;
+}
+
+void CGameWorld::SnapEntity(CEntity *pEnt, int SnappingClient)
+{
+	const int NumItems = Server()->SnapNumItems();
+	pEnt->Snap(SnappingClient);
+	m_SnapStats.m_NumVisited++;
+	if(Server()->SnapNumItems() != NumItems)
+		m_SnapStats.m_NumEmitted++;
+}
 
-		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt;)
+//
+void CGameWorld::Snap(int SnappingClient)
+{
+	m_SnapStats.m_NumSnaps++;
+	const CPlayer *pPlayer = SnappingClient == SERVER_DEMO_CLIENT ? nullptr : GameServer()->m_apPlayers[SnappingClient];
+	if(!Config()->m_SvSnapCulling || !pPlayer || pPlayer->m_ShowAll)
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->Snap(SnappingClient);
+			m_SnapStats.m_NumEntities++;
+			SnapEntity(pEnt, SnappingClient);
 			pEnt = m_pNextTraverseEntity;
 		}
+
+		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			if(i == ENTTYPE_CHARACTER)
+				continue;
+
+			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt;)
+			{
+				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_SnapStats.m_NumEntities++;
+				SnapEntity(pEnt, SnappingClient);
+				pEnt = m_pNextTraverseEntity;
+			}
+		}
+		return;
+	}
+
+	UpdateSnapIndex();
+	m_SnapStats.m_NumEntities += m_vSnapEntities.size();
+
+	// lines are clipped against a square around the view, see NetworkClippedLine,
+	// the extra unit covers rounding differences to the exact checks in Snap
+	const float Range = maximum(pPlayer->m_ShowDistance.x, pPlayer->m_ShowDistance.y) + 1.0f;
+	const vec2 ViewMin = pPlayer->m_ViewPos - vec2(Range, Range);
+	const vec2 ViewMax = pPlayer->m_ViewPos + vec2(Range, Range);
+
+	m_vSnapCandidates = m_vSnapUncelled;
+	const int MinX = SnapCellCoord(ViewMin.x - m_SnapMaxExtent, m_SnapCellsX);
+	const int MinY = SnapCellCoord(ViewMin.y - m_SnapMaxExtent, m_SnapCellsY);
+	const int MaxX = SnapCellCoord(ViewMax.x + m_SnapMaxExtent, m_SnapCellsX);
+	const int MaxY = SnapCellCoord(ViewMax.y + m_SnapMaxExtent, m_SnapCellsY);
+	for(int y = MinY; y <= MaxY; y++)
+	{
+		const int *pFirst = m_vSnapCellEntities.data() + m_vSnapCellStart[y * m_SnapCellsX + MinX];
+		const int *pLast = m_vSnapCellEntities.data() + m_vSnapCellStart[y * m_SnapCellsX + MaxX + 1];
+		m_vSnapCandidates.insert(m_vSnapCandidates.end(), pFirst, pLast);
+	}
+	// keep the order of the items the same as without culling
+	std::sort(m_vSnapCandidates.begin(), m_vSnapCandidates.end());
+
+	for(int Index : m_vSnapCandidates)
+	{
+		const CSnapEntity &Entity = m_vSnapEntities[Index];
+		if(Entity.m_Bounded && (Entity.m_Max.x < ViewMin.x || Entity.m_Min.x > ViewMax.x || Entity.m_Max.y < ViewMin.y || Entity.m_Min.y > ViewMax.y))
+			continue;
+		SnapEntity(Entity.m_pEntity, SnappingClient);
 	}
 }
 
@@ -205,6 +367,11 @@ void CGameWorld::Tick()
 	if(m_ResetRequested)
 		Reset();
 
+	// entities can be moved from outside of the world tick
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		UpdateGrid(i);
+	m_Ticking = true;
+
 	if(!m_Paused)
 	{
 		// update all objects
@@ -218,7 +385,9 @@ void CGameWorld::Tick()
 				for(; pEnt;)
 				{
 					m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+					m_pTickedEntity = pEnt;
 					((CCharacter *)pEnt)->PreTick();
+					UpdateTickedEntity();
 					pEnt = m_pNextTraverseEntity;
 				}
 			}
@@ -227,7 +396,9 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickedEntity = pEnt;
 				pEnt->Tick();
+				UpdateTickedEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 		}
@@ -236,7 +407,9 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickedEntity = pEnt;
 				pEnt->TickDeferred();
+				UpdateTickedEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 	}
@@ -247,10 +420,14 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTickedEntity = pEnt;
 				pEnt->TickPaused();
+				UpdateTickedEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 	}
+	m_Ticking = false;
+	m_SnapIndexDirty = true;
 
 	RemoveEntities();
 
@@ -300,17 +477,15 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
-	{
+	auto Check = [&](CEntity *pEntity) {
 		if(pEntity == pNotThis)
-			continue;
+			return;
 
 		if(pThisOnly && pEntity != pThisOnly)
-			continue;
+			return;
 
 		if(CollideWith != -1 && !pEntity->CanCollide(CollideWith))
-			continue;
+			return;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pEntity->m_Pos, IntersectPos))
@@ -319,7 +494,8 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 			if(Len < pEntity->m_ProximityRadius + Radius)
 			{
 				Len = distance(Pos0, IntersectPos);
-				if(Len < ClosestLen)
+				// on a tie the entity that comes first in the list wins
+				if(Len < ClosestLen || (Len == ClosestLen && pClosest && m_Grid.ListOrder(pEntity, pClosest)))
 				{
 					NewPos = IntersectPos;
 					ClosestLen = Len;
@@ -327,7 +503,18 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 				}
 			}
 		}
-	}
+	};
+
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
+	UpdateGrid(Type);
+	const float Range = Radius + m_Grid.MaxProximityRadius(Type);
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - vec2(Range, Range);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + vec2(Range, Range);
+	if(!m_Grid.Query(Type, Min, Max, Check))
+		for(CEntity *pEntity = FindFirst(Type); pEntity; pEntity = pEntity->TypeNext())
+			Check(pEntity);
 
 	return pClosest;
 }
@@ -338,22 +525,26 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 	float ClosestRange = Radius * 2;
 	CCharacter *pClosest = nullptr;
 
-	CCharacter *p = (CCharacter *)FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
-	{
-		if(p == pNotThis)
-			continue;
+	auto Check = [&](CEntity *pEnt) {
+		if(pEnt == pNotThis)
+			return;
 
-		float Len = distance(Pos, p->m_Pos);
-		if(Len < p->m_ProximityRadius + Radius)
+		float Len = distance(Pos, pEnt->m_Pos);
+		if(Len < pEnt->m_ProximityRadius + Radius)
 		{
-			if(Len < ClosestRange)
+			if(Len < ClosestRange || (Len == ClosestRange && pClosest && m_Grid.ListOrder(pEnt, pClosest)))
 			{
 				ClosestRange = Len;
-				pClosest = p;
+				pClosest = (CCharacter *)pEnt;
 			}
 		}
-	}
+	};
+
+	UpdateGrid(ENTTYPE_CHARACTER);
+	const float Range = Radius + m_Grid.MaxProximityRadius(ENTTYPE_CHARACTER);
+	if(!m_Grid.Query(ENTTYPE_CHARACTER, Pos - vec2(Range, Range), Pos + vec2(Range, Range), Check))
+		for(CEntity *pEnt = FindFirst(ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+			Check(pEnt);
 
 	return pClosest;
 }
@@ -361,22 +552,30 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
-	{
-		if(pChr == pNotThis)
-			continue;
+	auto Check = [&](CEntity *pEnt) {
+		if(pEnt == pNotThis)
+			return;
 
 		vec2 IntersectPos;
-		if(closest_point_on_line(Pos0, Pos1, pChr->m_Pos, IntersectPos))
+		if(closest_point_on_line(Pos0, Pos1, pEnt->m_Pos, IntersectPos))
 		{
-			float Len = distance(pChr->m_Pos, IntersectPos);
-			if(Len < pChr->m_ProximityRadius + Radius)
+			float Len = distance(pEnt->m_Pos, IntersectPos);
+			if(Len < pEnt->m_ProximityRadius + Radius)
 			{
-				vpCharacters.push_back(pChr);
+				vpCharacters.push_back((CCharacter *)pEnt);
 			}
 		}
-	}
+	};
+
+	UpdateGrid(ENTTYPE_CHARACTER);
+	const float Range = Radius + m_Grid.MaxProximityRadius(ENTTYPE_CHARACTER);
+	const vec2 Min = vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - vec2(Range, Range);
+	const vec2 Max = vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + vec2(Range, Range);
+	if(m_Grid.Query(ENTTYPE_CHARACTER, Min, Max, Check))
+		std::sort(vpCharacters.begin(), vpCharacters.end(), m_Grid.ListOrder);
+	else
+		for(CEntity *pEnt = FindFirst(ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+			Check(pEnt);
 	return vpCharacters;
 }
 
@@ -5,6 +5,7 @@
 
 #include "save.h"
 
+#include <game/entity_grid.h>
 #include <game/gamecore.h>
 
 #include <vector>
@@ -31,13 +32,64 @@ public:
 		NUM_ENTTYPES
 	};
 
+	enum
+	{
+		// cells of the map used to find the entities near the view of a client
+		SNAP_CELL_SIZE = 512,
+	};
+
+	// summed up over all snaps since the last reset
+	struct CSnapStats
+	{
+		int64_t m_NumSnaps = 0;
+		int64_t m_NumEntities = 0;
+		// entities whose Snap was called
+		int64_t m_NumVisited = 0;
+		// entities that added items to the snapshot
+		int64_t m_NumEmitted = 0;
+	};
+
 private:
 	void Reset();
 	void RemoveEntities();
+	void UpdateGrid(int Type);
+	void UpdateTickedEntity();
+	void UpdateSnapIndex();
+	void SnapEntity(CEntity *pEnt, int SnappingClient);
 
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// spatial index for the queries, only entities that may have moved since the last update are refreshed
+	CEntityGrid<CEntity, NUM_ENTTYPES> m_Grid;
+	CEntity *m_pTickedEntity = nullptr;
+	bool m_Ticking = false;
+	std::vector<CEntity *> m_vpQueryResult;
+
+	// entities in snap order with the area they can be seen in, rebuilt once per tick
+	struct CSnapEntity
+	{
+		CEntity *m_pEntity;
+		bool m_Bounded;
+		vec2 m_Min;
+		vec2 m_Max;
+		int m_Cell;
+	};
+	std::vector<CSnapEntity> m_vSnapEntities;
+	// entities that are unbounded or too large for the cells
+	std::vector<int> m_vSnapUncelled;
+	// entities sorted by cell, m_vSnapCellStart has an extra entry for the end
+	std::vector<int> m_vSnapCellStart;
+	std::vector<int> m_vSnapCellEntities;
+	std::vector<int> m_vSnapCandidates;
+	int m_SnapCellsX = 0;
+	int m_SnapCellsY = 0;
+	// largest half size of the bounds of the entities in the cells
+	float m_SnapMaxExtent = 0.0f;
+	int m_SnapIndexTick = -1;
+	bool m_SnapIndexDirty = true;
+	CSnapStats m_SnapStats;
+
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
@@ -149,8 +201,9 @@ public:
 
 	/*
 		Function: Snap
-			Calls Snap on all the entities in the world to create
-			the snapshot.
+			Calls Snap on the entities in the world to create the
+			snapshot. Entities whose snap bounds are far out of
+			the view of the client are skipped.
 
 		Arguments:
 			SnappingClient - ID of the client which snapshot
@@ -158,6 +211,9 @@ public:
 	*/
 	void Snap(int SnappingClient);
 
+	const CSnapStats &SnapStats() const { return m_SnapStats; }
+	void ResetSnapStats() { m_SnapStats = CSnapStats(); }
+
 	/*
 		Function: Tick
 			Calls Tick on all the entities in the world to progress
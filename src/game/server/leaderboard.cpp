@@ -0,0 +1,186 @@
+#include "leaderboard.h"
+
+#include <algorithm>
+
+bool CLeaderboard::CEntry::operator<(const CEntry &Other) const
+{
+	if(m_Time != Other.m_Time)
+		return m_Time < Other.m_Time;
+	return m_Name < Other.m_Name;
+}
+
+// the same priorities for every run, spread like random numbers
+static uint32_t NodePriority(int Node)
+{
+	uint64_t x = (uint64_t)Node + 0x9e3779b97f4a7c15ull;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return (uint32_t)(x ^ (x >> 31));
+}
+
+void CLeaderboard::Load(std::vector<CEntry> &&vEntries)
+{
+	std::sort(vEntries.begin(), vEntries.end());
+
+	m_vNodes.clear();
+	m_vNodes.reserve(vEntries.size());
+	m_NodeIndices.clear();
+	m_NodeIndices.reserve(vEntries.size());
+	m_Root = -1;
+	for(CEntry &Entry : vEntries)
+	{
+		// only the best time of each player counts
+		const int Node = m_vNodes.size();
+		if(!m_NodeIndices.emplace(Entry.m_Name, Node).second)
+			continue;
+		m_vNodes.push_back({std::move(Entry), NodePriority(Node), 1, {-1, -1}});
+		Insert(Node);
+	}
+}
+
+void CLeaderboard::Add(const char *pName, float Time)
+{
+	auto [It, Inserted] = m_NodeIndices.emplace(pName, m_vNodes.size());
+	if(Inserted)
+	{
+		const int Node = It->second;
+		m_vNodes.push_back({{Time, pName}, NodePriority(Node), 1, {-1, -1}});
+		Insert(Node);
+		return;
+	}
+
+	const int Node = It->second;
+	if(m_vNodes[Node].m_Entry.m_Time <= Time)
+		return;
+	m_Root = Remove(m_Root, Node);
+	m_vNodes[Node].m_Entry.m_Time = Time;
+	m_vNodes[Node].m_Size = 1;
+	m_vNodes[Node].m_aChildren[0] = -1;
+	m_vNodes[Node].m_aChildren[1] = -1;
+	Insert(Node);
+}
+
+void CLeaderboard::UpdateSize(int Node)
+{
+	CNode &Current = m_vNodes[Node];
+	Current.m_Size = 1 + SubtreeSize(Current.m_aChildren[0]) + SubtreeSize(Current.m_aChildren[1]);
+}
+
+int CLeaderboard::Merge(int Left, int Right)
+{
+	if(Left < 0)
+		return Right;
+	if(Right < 0)
+		return Left;
+	if(m_vNodes[Left].m_Priority > m_vNodes[Right].m_Priority)
+	{
+		m_vNodes[Left].m_aChildren[1] = Merge(m_vNodes[Left].m_aChildren[1], Right);
+		UpdateSize(Left);
+		return Left;
+	}
+	m_vNodes[Right].m_aChildren[0] = Merge(Left, m_vNodes[Right].m_aChildren[0]);
+	UpdateSize(Right);
+	return Right;
+}
+
+void CLeaderboard::Split(int Node, const CEntry &Key, int *pLeft, int *pRight)
+{
+	if(Node < 0)
+	{
+		*pLeft = -1;
+		*pRight = -1;
+		return;
+	}
+	if(m_vNodes[Node].m_Entry < Key)
+	{
+		Split(m_vNodes[Node].m_aChildren[1], Key, &m_vNodes[Node].m_aChildren[1], pRight);
+		*pLeft = Node;
+	}
+	else
+	{
+		Split(m_vNodes[Node].m_aChildren[0], Key, pLeft, &m_vNodes[Node].m_aChildren[0]);
+		*pRight = Node;
+	}
+	UpdateSize(Node);
+}
+
+void CLeaderboard::Insert(int Node)
+{
+	int Left, Right;
+	Split(m_Root, m_vNodes[Node].m_Entry, &Left, &Right);
+	m_Root = Merge(Merge(Left, Node), Right);
+}
+
+int CLeaderboard::Remove(int Tree, int Node)
+{
+	if(Tree == Node)
+		return Merge(m_vNodes[Node].m_aChildren[0], m_vNodes[Node].m_aChildren[1]);
+	const int Side = m_vNodes[Node].m_Entry < m_vNodes[Tree].m_Entry ? 0 : 1;
+	const int Child = Remove(m_vNodes[Tree].m_aChildren[Side], Node);
+	m_vNodes[Tree].m_aChildren[Side] = Child;
+	UpdateSize(Tree);
+	return Tree;
+}
+
+int CLeaderboard::RankOf(float Time) const
+{
+	// one more than the number of better times
+	int Rank = 1;
+	int Node = m_Root;
+	while(Node >= 0)
+	{
+		const CNode &Current = m_vNodes[Node];
+		if(Current.m_Entry.m_Time < Time)
+		{
+			Rank += SubtreeSize(Current.m_aChildren[0]) + 1;
+			Node = Current.m_aChildren[1];
+		}
+		else
+		{
+			Node = Current.m_aChildren[0];
+		}
+	}
+	return Rank;
+}
+
+int CLeaderboard::NodeAt(int Index) const
+{
+	int Node = m_Root;
+	while(true)
+	{
+		const CNode &Current = m_vNodes[Node];
+		const int LeftSize = SubtreeSize(Current.m_aChildren[0]);
+		if(Index < LeftSize)
+		{
+			Node = Current.m_aChildren[0];
+		}
+		else if(Index == LeftSize)
+		{
+			return Node;
+		}
+		else
+		{
+			Index -= LeftSize + 1;
+			Node = Current.m_aChildren[1];
+		}
+	}
+}
+
+std::optional<CLeaderboard::CRank> CLeaderboard::Rank(const char *pName) const
+{
+	auto It = m_NodeIndices.find(pName);
+	if(It == m_NodeIndices.end())
+		return std::nullopt;
+
+	CRank Rank;
+	Rank.m_Time = m_vNodes[It->second].m_Entry.m_Time;
+	Rank.m_Rank = RankOf(Rank.m_Time);
+	// computed in double precision like the databases do
+	Rank.m_PercentRank = Size() > 1 ? (double)(Rank.m_Rank - 1) / (Size() - 1) : 0.0;
+	return Rank;
+}
+
+int CLeaderboard::EntryRank(int Index) const
+{
+	return RankOf(Entry(Index).m_Time);
+}
@@ -0,0 +1,94 @@
+#ifndef GAME_SERVER_LEADERBOARD_H
+#define GAME_SERVER_LEADERBOARD_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Best times of players on a map, ordered like the `RANK() OVER (ORDER BY MIN(Time))`
+ * window of the score queries.
+ *
+ * The entries are kept in a treap that counts the entries of each subtree,
+ * so adding a finish, finding the rank of a time and finding the entry at a
+ * position all take logarithmic time.
+ */
+class CLeaderboard
+{
+public:
+	class CEntry
+	{
+	public:
+		float m_Time;
+		std::string m_Name;
+
+		bool operator<(const CEntry &Other) const;
+	};
+
+	class CRank
+	{
+	public:
+		int m_Rank;
+		float m_Time;
+		// like `PERCENT_RANK()`, `0` for the best player and `1` for the worst
+		float m_PercentRank;
+	};
+
+	/**
+	 * Replaces all entries, only the best time of each player is kept.
+	 */
+	void Load(std::vector<CEntry> &&vEntries);
+
+	/**
+	 * Records a finish, nothing changes if the player already has a better time.
+	 */
+	void Add(const char *pName, float Time);
+
+	int Size() const { return SubtreeSize(m_Root); }
+
+	/**
+	 * @return Rank of the player, or nothing if the player didn't finish.
+	 */
+	std::optional<CRank> Rank(const char *pName) const;
+
+	/**
+	 * @param Index Position in the leaderboard, starting at `0` for the best time.
+	 */
+	const CEntry &Entry(int Index) const { return m_vNodes[NodeAt(Index)].m_Entry; }
+
+	/**
+	 * @return Rank of the entry at the position, tied times share the rank.
+	 */
+	int EntryRank(int Index) const;
+
+private:
+	class CNode
+	{
+	public:
+		CEntry m_Entry;
+		uint32_t m_Priority;
+		// number of entries in the subtree of this node
+		int m_Size;
+		// `-1` if there is no child
+		int m_aChildren[2];
+	};
+
+	// the nodes don't move in the tree, a player always keeps the same node
+	std::vector<CNode> m_vNodes;
+	int m_Root = -1;
+	std::unordered_map<std::string, int> m_NodeIndices;
+
+	int SubtreeSize(int Node) const { return Node < 0 ? 0 : m_vNodes[Node].m_Size; }
+	void UpdateSize(int Node);
+	int Merge(int Left, int Right);
+	// splits into the entries that are less than the key and the rest
+	void Split(int Node, const CEntry &Key, int *pLeft, int *pRight);
+	void Insert(int Node);
+	int Remove(int Tree, int Node);
+	int RankOf(float Time) const;
+	int NodeAt(int Index) const;
+};
+
+#endif // GAME_SERVER_LEADERBOARD_H
@@ -17,6 +17,7 @@
 #include <game/server/gamemodes/DDRace.h>
 #include <game/team_state.h>
 
+#include <algorithm>
 #include <memory>
 
 class IDbConnection;
@@ -35,7 +36,8 @@ void CScore::ExecPlayerThread(
 	const char *pThreadName,
 	int ClientId,
 	const char *pName,
-	int Offset)
+	int Offset,
+	void (*pLeaderboardFunc)(const CScoreLeaderboardResult *, const CSqlPlayerRequest *, CScorePlayerResult *))
 {
 	auto pResult = NewSqlPlayerResult(ClientId);
 	if(pResult == nullptr)
@@ -47,9 +49,37 @@ void CScore::ExecPlayerThread(
 	str_copy(Tmp->m_aRequestingPlayer, Server()->ClientName(ClientId), sizeof(Tmp->m_aRequestingPlayer));
 	Tmp->m_Offset = Offset;
 
+	auto It = std::remove_if(m_vPendingWrites.begin(), m_vPendingWrites.end(), [](const CPendingWrite &Write) {
+		return Write.m_pResult->m_Completed.load();
+	});
+	m_vPendingWrites.erase(It, m_vPendingWrites.end());
+	if(HasPendingWrite(Tmp->m_aName) || HasPendingWrite(Tmp->m_aRequestingPlayer))
+	{
+		// the read workers and the leaderboard may not know about the finish yet
+		m_pPool->ExecuteAfterWrites(pFuncPtr, std::move(Tmp), pThreadName);
+		return;
+	}
+
+	const CScoreLeaderboardResult *pLeaderboard = pLeaderboardFunc ? Leaderboard() : nullptr;
+	if(pLeaderboard && str_comp(Tmp->m_aServer, pLeaderboard->m_aServer) == 0)
+	{
+		// the player processes the result on the next tick, like one from the database
+		pLeaderboardFunc(pLeaderboard, Tmp.get(), pResult.get());
+		pResult->m_Success = true;
+		pResult->m_Completed.store(true);
+		return;
+	}
+
 	m_pPool->Execute(pFuncPtr, std::move(Tmp), pThreadName);
 }
 
+bool CScore::HasPendingWrite(const char *pName) const
+{
+	return std::any_of(m_vPendingWrites.begin(), m_vPendingWrites.end(), [pName](const CPendingWrite &Write) {
+		return Write.m_Name == pName;
+	});
+}
+
 bool CScore::RateLimitPlayer(int ClientId)
 {
 	CPlayer *pPlayer = GameServer()->m_apPlayers[ClientId];
@@ -79,6 +109,7 @@ CScore::CScore(CGameContext *pGameServer, CDbConnectionPool *pPool) :
 	m_pServer(pGameServer->Server())
 {
 	LoadBestTime();
+	LoadLeaderboard();
 
 	uint64_t aSeed[2];
 	secure_random_fill(aSeed, sizeof(aSeed));
@@ -122,6 +153,38 @@ void CScore::LoadBestTime()
 	m_pPool->Execute(CScoreWorker::LoadBestTime, std::move(Tmp), "load best time");
 }
 
+void CScore::LoadLeaderboard()
+{
+	m_pLeaderboard = std::make_shared<CScoreLeaderboardResult>();
+	auto Tmp = std::make_unique<CSqlLeaderboardRequest>(m_pLeaderboard);
+	str_copy(Tmp->m_aMap, Server()->GetMapName(), sizeof(Tmp->m_aMap));
+	str_copy(Tmp->m_aServer, g_Config.m_SvSqlServerName, sizeof(Tmp->m_aServer));
+	m_pPool->Execute(CScoreWorker::LoadLeaderboard, std::move(Tmp), "load leaderboard");
+}
+
+const CScoreLeaderboardResult *CScore::Leaderboard()
+{
+	if(m_pLeaderboard == nullptr || !m_pLeaderboard->m_Completed)
+		return nullptr;
+	if(!m_pLeaderboard->m_Success)
+	{
+		// keep using the database for this map
+		m_pLeaderboard = nullptr;
+		m_vLeaderboardFinishes.clear();
+		return nullptr;
+	}
+	// the query may or may not have seen the finishes, adding them again doesn't hurt
+	auto It = std::remove_if(m_vLeaderboardFinishes.begin(), m_vLeaderboardFinishes.end(), [this](const CLeaderboardFinish &Finish) {
+		if(!Finish.m_pResult->m_Completed)
+			return false;
+		if(Finish.m_pResult->m_Success)
+			m_pLeaderboard->AddFinish(Finish.m_Name.c_str(), Finish.m_Time);
+		return true;
+	});
+	m_vLeaderboardFinishes.erase(It, m_vLeaderboardFinishes.end());
+	return m_pLeaderboard.get();
+}
+
 void CScore::LoadPlayerData(int ClientId, const char *pName)
 {
 	ExecPlayerThread(CScoreWorker::LoadPlayerData, "load player data", ClientId, pName, 0);
@@ -168,6 +231,13 @@ void CScore::SaveScore(int ClientId, int TimeTicks, const char *pTimestamp, cons
 	for(int i = 0; i < NUM_CHECKPOINTS; i++)
 		Tmp->m_aCurrentTimeCp[i] = aTimeCp[i];
 
+	// the finish only counts for the leaderboard once it's saved on one of
+	// the databases, the finishes saved by now are added here
+	Leaderboard();
+	if(m_pLeaderboard != nullptr)
+		m_vLeaderboardFinishes.push_back({pCurPlayer->m_ScoreFinishResult, Tmp->m_aName, Tmp->m_Time});
+	m_vPendingWrites.push_back({pCurPlayer->m_ScoreFinishResult, Tmp->m_aName});
+
 	m_pPool->ExecuteWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score");
 }
 
@@ -184,9 +254,13 @@ void CScore::SaveTeamScore(int Team, int *pClientIds, unsigned int Size, int Tim
 
 	GameServer()->TeehistorianRecordTeamFinish(Team, TimeTicks);
 
-	auto Tmp = std::make_unique<CSqlTeamScoreData>();
+	auto pResult = std::make_shared<ISqlResult>();
+	auto Tmp = std::make_unique<CSqlTeamScoreData>(pResult);
 	for(unsigned int i = 0; i < Size; i++)
+	{
 		str_copy(Tmp->m_aaNames[i], Server()->ClientName(pClientIds[i]), sizeof(Tmp->m_aaNames[i]));
+		m_vPendingWrites.push_back({pResult, Tmp->m_aaNames[i]});
+	}
 	Tmp->m_Size = Size;
 	Tmp->m_Time = (float)TimeTicks / (float)Server()->TickSpeed();
 	str_copy(Tmp->m_aTimestamp, pTimestamp, sizeof(Tmp->m_aTimestamp));
@@ -201,7 +275,7 @@ void CScore::ShowRank(int ClientId, const char *pName)
 {
 	if(RateLimitPlayer(ClientId))
 		return;
-	ExecPlayerThread(CScoreWorker::ShowRank, "show rank", ClientId, pName, 0);
+	ExecPlayerThread(CScoreWorker::ShowRank, "show rank", ClientId, pName, 0, CScoreWorker::ShowRank);
 }
 
 void CScore::ShowTeamRank(int ClientId, const char *pName)
@@ -215,7 +289,7 @@ void CScore::ShowTop(int ClientId, int Offset)
 {
 	if(RateLimitPlayer(ClientId))
 		return;
-	ExecPlayerThread(CScoreWorker::ShowTop, "show top5", ClientId, "", Offset);
+	ExecPlayerThread(CScoreWorker::ShowTop, "show top5", ClientId, "", Offset, CScoreWorker::ShowTop);
 }
 
 void CScore::ShowTeamTop5(int ClientId, int Offset)
@@ -25,15 +25,43 @@ class CScore
 	CPrng m_Prng;
 	void GeneratePassphrase(char *pBuf, int BufSize);
 
+	// best times on the current map, usable once the database query completed
+	std::shared_ptr<CScoreLeaderboardResult> m_pLeaderboard;
+	class CLeaderboardFinish
+	{
+	public:
+		std::shared_ptr<ISqlResult> m_pResult;
+		std::string m_Name;
+		float m_Time;
+	};
+	// finishes that count for the leaderboard once they are saved
+	std::vector<CLeaderboardFinish> m_vLeaderboardFinishes;
+	void LoadLeaderboard();
+	// returns the leaderboard if it's loaded, with the finishes saved so far
+	const CScoreLeaderboardResult *Leaderboard();
+
+	class CPendingWrite
+	{
+	public:
+		std::shared_ptr<ISqlResult> m_pResult;
+		std::string m_Name;
+	};
+	// finishes that aren't written yet, reads about these players have to wait for them
+	std::vector<CPendingWrite> m_vPendingWrites;
+	bool HasPendingWrite(const char *pName) const;
+
 	// returns new SqlResult bound to the player, if no current Thread is active for this player
 	std::shared_ptr<CScorePlayerResult> NewSqlPlayerResult(int ClientId);
-	// Creates for player database requests
+	// Creates for player database requests, they are answered from the
+	// leaderboard instead if a function for it is given and it's loaded.
+	// Requests about players with pending writes are executed after these.
 	void ExecPlayerThread(
 		bool (*pFuncPtr)(IDbConnection *, const ISqlData *, char *pError, int ErrorSize),
 		const char *pThreadName,
 		int ClientId,
 		const char *pName,
-		int Offset);
+		int Offset,
+		void (*pLeaderboardFunc)(const CScoreLeaderboardResult *, const CSqlPlayerRequest *, CScorePlayerResult *) = nullptr);
 
 	// returns true if the player should be rate limited
 	bool RateLimitPlayer(int ClientId);
@@ -54,6 +54,16 @@ void CScorePlayerResult::SetVariant(Variant v)
 	}
 }
 
+void CScoreLeaderboardResult::AddFinish(const char *pName, float Time)
+{
+	// the database only keeps two decimals of the time
+	char aTime[32];
+	str_format(aTime, sizeof(aTime), "%.2f", Time);
+	const float StoredTime = str_tofloat(aTime);
+	m_Global.Add(pName, StoredTime);
+	m_Regional.Add(pName, StoredTime);
+}
+
 CTeamrank::CTeamrank() :
 	m_NumNames(0)
 {
@@ -171,6 +181,53 @@ bool CScoreWorker::LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
+bool CScoreWorker::LoadLeaderboard(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlLeaderboardRequest *>(pGameData);
+	auto *pResult = dynamic_cast<CScoreLeaderboardResult *>(pGameData->m_pResult.get());
+
+	char aServerLike[16];
+	str_format(aServerLike, sizeof(aServerLike), "%%%s%%", pData->m_aServer);
+
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf),
+		"SELECT Name, MIN(Time) "
+		"FROM %s_race "
+		"WHERE Map = ? "
+		"AND Server LIKE ? "
+		"GROUP BY Name",
+		pSqlServer->GetPrefix());
+
+	// global leaderboard first, then the regional one
+	CLeaderboard *apLeaderboards[] = {&pResult->m_Global, &pResult->m_Regional};
+	const char *apServerLike[] = {"%", aServerLike};
+	for(int i = 0; i < 2; i++)
+	{
+		if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+		{
+			return false;
+		}
+		pSqlServer->BindString(1, pData->m_aMap);
+		pSqlServer->BindString(2, apServerLike[i]);
+
+		std::vector<CLeaderboard::CEntry> vEntries;
+		bool End = false;
+		while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
+		{
+			char aName[MAX_NAME_LENGTH];
+			pSqlServer->GetString(1, aName, sizeof(aName));
+			vEntries.push_back({pSqlServer->GetFloat(2), aName});
+		}
+		if(!End)
+		{
+			return false;
+		}
+		apLeaderboards[i]->Load(std::move(vEntries));
+	}
+	str_copy(pResult->m_aServer, pData->m_aServer);
+	return true;
+}
+
 // update stuff
 bool CScoreWorker::LoadPlayerData(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
@@ -819,6 +876,64 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 	return true;
 }
 
+static void FormatRank(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult, const std::optional<CLeaderboard::CRank> &Rank, const std::optional<int> &RegionalRank)
+{
+	if(!Rank)
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"%s is not ranked", pData->m_aName);
+		return;
+	}
+
+	char aTime[32];
+	str_time_float(Rank->m_Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
+
+	if(g_Config.m_SvHideScore)
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"Your time: %s", aTime);
+		return;
+	}
+
+	pResult->m_MessageKind = CScorePlayerResult::ALL;
+	// CEIL and FLOOR are not supported in SQLite
+	int BetterThanPercent = std::floor(100.0f - 100.0f * Rank->m_PercentRank);
+
+	if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"%s - %s - better than %d%%",
+			pData->m_aName, aTime, BetterThanPercent);
+	}
+	else
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"%s - %s - better than %d%% - requested by %s",
+			pData->m_aName, aTime, BetterThanPercent, pData->m_aRequestingPlayer);
+	}
+
+	if(g_Config.m_SvRegionalRankings)
+	{
+		char aRegionalRank[16];
+		if(RegionalRank)
+		{
+			str_format(aRegionalRank, sizeof(aRegionalRank), "rank %d", *RegionalRank);
+		}
+		else
+		{
+			str_copy(aRegionalRank, "unranked", sizeof(aRegionalRank));
+		}
+		str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
+			"Global rank %d - %s %s",
+			Rank->m_Rank, pData->m_aServer, aRegionalRank);
+	}
+	else
+	{
+		str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
+			"Global rank %d", Rank->m_Rank);
+	}
+}
+
 bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -856,14 +971,10 @@ bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData
 		return false;
 	}
 
-	char aRegionalRank[16];
-	if(End)
-	{
-		str_copy(aRegionalRank, "unranked", sizeof(aRegionalRank));
-	}
-	else
+	std::optional<int> RegionalRank;
+	if(!End)
 	{
-		str_format(aRegionalRank, sizeof(aRegionalRank), "rank %d", pSqlServer->GetInt(1));
+		RegionalRank = pSqlServer->GetInt(1);
 	}
 
 	const char *pAny = "%";
@@ -881,55 +992,23 @@ bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData
 		return false;
 	}
 
+	std::optional<CLeaderboard::CRank> Rank;
 	if(!End)
 	{
-		int Rank = pSqlServer->GetInt(1);
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aBuf, sizeof(aBuf));
-
-		if(g_Config.m_SvHideScore)
-		{
-			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-				"Your time: %s", aBuf);
-		}
-		else
-		{
-			pResult->m_MessageKind = CScorePlayerResult::ALL;
-			// CEIL and FLOOR are not supported in SQLite
-			int BetterThanPercent = std::floor(100.0f - 100.0f * pSqlServer->GetFloat(3));
-
-			if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%%",
-					pData->m_aName, aBuf, BetterThanPercent);
-			}
-			else
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%% - requested by %s",
-					pData->m_aName, aBuf, BetterThanPercent, pData->m_aRequestingPlayer);
-			}
-
-			if(g_Config.m_SvRegionalRankings)
-			{
-				str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
-					"Global rank %d - %s %s",
-					Rank, pData->m_aServer, aRegionalRank);
-			}
-			else
-			{
-				str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
-					"Global rank %d", Rank);
-			}
-		}
+		Rank = CLeaderboard::CRank{pSqlServer->GetInt(1), pSqlServer->GetFloat(2), pSqlServer->GetFloat(3)};
 	}
-	else
+	FormatRank(pData, pResult, Rank, RegionalRank);
+	return true;
+}
+
+void CScoreWorker::ShowRank(const CScoreLeaderboardResult *pLeaderboard, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult)
+{
+	std::optional<int> RegionalRank;
+	if(std::optional<CLeaderboard::CRank> Rank = pLeaderboard->m_Regional.Rank(pData->m_aName))
 	{
-		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-			"%s is not ranked", pData->m_aName);
+		RegionalRank = Rank->m_Rank;
 	}
-	return true;
+	FormatRank(pData, pResult, pLeaderboard->m_Global.Rank(pData->m_aName), RegionalRank);
 }
 
 bool CScoreWorker::ShowTeamRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
@@ -1015,6 +1094,13 @@ bool CScoreWorker::ShowTeamRank(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
+static void FormatTopLine(char *pBuf, int BufSize, int Rank, const char *pName, float Time)
+{
+	char aTime[32];
+	str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
+	str_format(pBuf, BufSize, "%d. %s Time: %s", Rank, pName, aTime);
+}
+
 bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -1055,18 +1141,14 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
 	Line++;
 
-	char aTime[32];
 	bool End = false;
 
 	while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 
 		Line++;
 	}
@@ -1097,17 +1179,46 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 		Line++;
 	}
 
 	return End;
 }
 
+// adds the lines the `ShowTop` query returns for the offset and count
+static void FormatTopLines(const CLeaderboard &Leaderboard, int Offset, int Count, char (*paMessages)[512], int *pLine)
+{
+	const int LimitStart = maximum(absolute(Offset) - 1, 0);
+	for(int i = LimitStart; i < minimum(LimitStart + Count, Leaderboard.Size()); i++)
+	{
+		const int Index = Offset >= 0 ? i : Leaderboard.Size() - 1 - i;
+		const CLeaderboard::CEntry &Entry = Leaderboard.Entry(Index);
+		FormatTopLine(paMessages[*pLine], sizeof(paMessages[*pLine]), Leaderboard.EntryRank(Index), Entry.m_Name.c_str(), Entry.m_Time);
+		(*pLine)++;
+	}
+}
+
+void CScoreWorker::ShowTop(const CScoreLeaderboardResult *pLeaderboard, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult)
+{
+	int Line = 0;
+	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+	Line++;
+	FormatTopLines(pLeaderboard->m_Global, pData->m_Offset, 5, pResult->m_Data.m_aaMessages, &Line);
+
+	if(!g_Config.m_SvRegionalRankings)
+	{
+		str_copy(pResult->m_Data.m_aaMessages[Line], "-----------------------------------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+		return;
+	}
+
+	str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+		"------------ %s Top ------------", pData->m_aServer);
+	Line++;
+	FormatTopLines(pLeaderboard->m_Regional, pData->m_Offset, 3, pResult->m_Data.m_aaMessages, &Line);
+}
+
 bool CScoreWorker::ShowTeamTop5(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -6,6 +6,7 @@
 #include <engine/shared/protocol.h>
 #include <engine/shared/uuid_manager.h>
 
+#include <game/server/leaderboard.h>
 #include <game/server/save.h>
 #include <game/voting.h>
 
@@ -80,6 +81,30 @@ struct CSqlLoadBestTimeRequest : ISqlData
 	char m_aMap[MAX_MAP_LENGTH];
 };
 
+// best times on the current map, to answer /rank and /top5 without the database
+struct CScoreLeaderboardResult : ISqlResult
+{
+	CLeaderboard m_Global;
+	// only finishes on servers matching `m_aServer`, for the regional rankings
+	CLeaderboard m_Regional;
+	char m_aServer[5] = "";
+
+	// records a finish on this server the way `CScoreWorker::SaveScore` stores it
+	void AddFinish(const char *pName, float Time);
+};
+
+struct CSqlLeaderboardRequest : ISqlData
+{
+	CSqlLeaderboardRequest(std::shared_ptr<CScoreLeaderboardResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+
+	// current map
+	char m_aMap[MAX_MAP_LENGTH];
+	char m_aServer[5];
+};
+
 struct CSqlPlayerRequest : ISqlData
 {
 	CSqlPlayerRequest(std::shared_ptr<CScorePlayerResult> pResult) :
@@ -180,8 +205,8 @@ struct CScoreSaveResult : ISqlResult
 
 struct CSqlTeamScoreData : ISqlData
 {
-	CSqlTeamScoreData() :
-		ISqlData(nullptr)
+	CSqlTeamScoreData(std::shared_ptr<ISqlResult> pResult = nullptr) :
+		ISqlData(std::move(pResult))
 	{
 	}
 
@@ -290,6 +315,7 @@ struct CTeamrank
 struct CScoreWorker
 {
 	static bool LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
+	static bool LoadLeaderboard(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
 	static bool RandomMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 	static bool RandomUnfinishedMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
@@ -308,6 +334,10 @@ struct CScoreWorker
 	static bool ShowTopPoints(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 	static bool GetSaves(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
+	// same answers as above, from the leaderboard of the current map
+	static void ShowRank(const CScoreLeaderboardResult *pLeaderboard, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult);
+	static void ShowTop(const CScoreLeaderboardResult *pLeaderboard, const CSqlPlayerRequest *pData, CScorePlayerResult *pResult);
+
 	static bool SaveTeam(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize);
 	static bool LoadTeam(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize);
 
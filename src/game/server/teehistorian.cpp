@@ -6,6 +6,7 @@
 #include <engine/shared/json.h>
 #include <engine/shared/packer.h>
 #include <engine/shared/snapshot.h>
+#include <engine/shared/uuid_manager.h>
 
 #include <game/gamecore.h>
 
@@ -877,3 +878,202 @@ void CTeeHistorian::Finish()
 
 	Write(Buffer.Data(), Buffer.Size());
 }
+
+bool CTeeHistorianParser::Init(const unsigned char *pData, int DataSize)
+{
+	m_Error = true;
+	m_Finished = false;
+	m_pHeader = nullptr;
+
+	if(DataSize < (int)sizeof(TEEHISTORIAN_UUID) || mem_comp(pData, &TEEHISTORIAN_UUID, sizeof(TEEHISTORIAN_UUID)) != 0)
+		return false;
+	int HeaderEnd = sizeof(TEEHISTORIAN_UUID);
+	while(HeaderEnd < DataSize && pData[HeaderEnd] != 0)
+		HeaderEnd++;
+	if(HeaderEnd == DataSize)
+		return false;
+	m_pHeader = (const char *)pData + sizeof(TEEHISTORIAN_UUID);
+	m_Unpacker.Reset(pData + HeaderEnd + 1, DataSize - HeaderEnd - 1);
+
+	// Tick 0 is implicit at the start, like in the writer.
+	m_Tick = 0;
+	m_LastPlayerClientId = MAX_CLIENTS;
+	m_PendingPlayer = false;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aAlive[i] = false;
+		m_aX[i] = 0;
+		m_aY[i] = 0;
+	}
+	mem_zero(m_aInputs, sizeof(m_aInputs));
+
+	m_Error = false;
+	return true;
+}
+
+bool CTeeHistorianParser::ReadClientId(CRecord *pRecord)
+{
+	pRecord->m_ClientId = m_Unpacker.GetInt();
+	return pRecord->m_ClientId >= 0 && pRecord->m_ClientId < MAX_CLIENTS;
+}
+
+bool CTeeHistorianParser::ReadPlayer(CRecord *pRecord, int Type)
+{
+	const int ClientId = Type >= 0 ? Type : m_Unpacker.GetInt();
+	if(ClientId < 0 || ClientId >= MAX_CLIENTS)
+		return false;
+
+	ERecordType RecordType = RECORD_PLAYER;
+	if(Type >= 0)
+	{
+		if(!m_aAlive[ClientId])
+			return false;
+		m_aX[ClientId] += m_Unpacker.GetInt();
+		m_aY[ClientId] += m_Unpacker.GetInt();
+	}
+	else if(Type == -TEEHISTORIAN_PLAYER_NEW)
+	{
+		m_aAlive[ClientId] = true;
+		m_aX[ClientId] = m_Unpacker.GetInt();
+		m_aY[ClientId] = m_Unpacker.GetInt();
+	}
+	else
+	{
+		m_aAlive[ClientId] = false;
+		RecordType = RECORD_PLAYER_OLD;
+	}
+
+	if(ClientId <= m_LastPlayerClientId)
+	{
+		// Player records are written in ascending order, a client id
+		// that isn't larger than the previous one starts the next tick.
+		m_Tick++;
+		m_PendingPlayer = true;
+		m_PendingType = RecordType;
+		m_PendingClientId = ClientId;
+		pRecord->m_Type = RECORD_TICK;
+		pRecord->m_Tick = m_Tick;
+		pRecord->m_ClientId = -1;
+	}
+	else
+	{
+		pRecord->m_Type = RecordType;
+		pRecord->m_ClientId = ClientId;
+		pRecord->m_X = m_aX[ClientId];
+		pRecord->m_Y = m_aY[ClientId];
+	}
+	m_LastPlayerClientId = ClientId;
+	return true;
+}
+
+bool CTeeHistorianParser::ReadInput(CRecord *pRecord, bool Diff)
+{
+	if(!ReadClientId(pRecord))
+		return false;
+	int *pInput = (int *)&m_aInputs[pRecord->m_ClientId];
+	for(size_t i = 0; i < sizeof(CNetObj_PlayerInput) / sizeof(int32_t); i++)
+	{
+		const int Value = m_Unpacker.GetInt();
+		pInput[i] = Diff ? pInput[i] + Value : Value;
+	}
+	pRecord->m_Type = RECORD_INPUT;
+	pRecord->m_Input = m_aInputs[pRecord->m_ClientId];
+	return true;
+}
+
+bool CTeeHistorianParser::Next(CRecord *pRecord)
+{
+	if(m_PendingPlayer)
+	{
+		m_PendingPlayer = false;
+		pRecord->m_Type = m_PendingType;
+		pRecord->m_Tick = m_Tick;
+		pRecord->m_ClientId = m_PendingClientId;
+		pRecord->m_X = m_aX[m_PendingClientId];
+		pRecord->m_Y = m_aY[m_PendingClientId];
+		return true;
+	}
+	if(m_Error || m_Finished || m_Unpacker.RemainingSize() == 0)
+		return false;
+
+	pRecord->m_Tick = m_Tick;
+	pRecord->m_ClientId = -1;
+	bool Valid = true;
+	const int Type = m_Unpacker.GetInt();
+	if(Type >= 0 || Type == -TEEHISTORIAN_PLAYER_NEW || Type == -TEEHISTORIAN_PLAYER_OLD)
+	{
+		Valid = ReadPlayer(pRecord, Type);
+	}
+	else if(Type == -TEEHISTORIAN_FINISH)
+	{
+		pRecord->m_Type = RECORD_FINISH;
+		m_Finished = true;
+	}
+	else if(Type == -TEEHISTORIAN_TICK_SKIP)
+	{
+		const int TickDelta = m_Unpacker.GetInt();
+		Valid = TickDelta >= 0;
+		m_Tick += TickDelta + 1;
+		m_LastPlayerClientId = -1;
+		pRecord->m_Type = RECORD_TICK;
+		pRecord->m_Tick = m_Tick;
+	}
+	else if(Type == -TEEHISTORIAN_INPUT_DIFF || Type == -TEEHISTORIAN_INPUT_NEW)
+	{
+		Valid = ReadInput(pRecord, Type == -TEEHISTORIAN_INPUT_DIFF);
+	}
+	else if(Type == -TEEHISTORIAN_MESSAGE)
+	{
+		pRecord->m_Type = RECORD_MESSAGE;
+		Valid = ReadClientId(pRecord);
+		pRecord->m_DataSize = m_Unpacker.GetInt();
+		Valid = Valid && pRecord->m_DataSize >= 0;
+		pRecord->m_pData = Valid ? m_Unpacker.GetRaw(pRecord->m_DataSize) : nullptr;
+	}
+	else if(Type == -TEEHISTORIAN_JOIN)
+	{
+		pRecord->m_Type = RECORD_JOIN;
+		Valid = ReadClientId(pRecord);
+	}
+	else if(Type == -TEEHISTORIAN_DROP)
+	{
+		pRecord->m_Type = RECORD_DROP;
+		Valid = ReadClientId(pRecord);
+		pRecord->m_pString = m_Unpacker.GetString(0);
+	}
+	else if(Type == -TEEHISTORIAN_CONSOLE_COMMAND)
+	{
+		pRecord->m_Type = RECORD_CONSOLE_COMMAND;
+		// commands from the server console don't have a valid client id
+		pRecord->m_ClientId = m_Unpacker.GetInt();
+		pRecord->m_FlagMask = m_Unpacker.GetInt();
+		pRecord->m_pString = m_Unpacker.GetString(0);
+		const int NumArguments = m_Unpacker.GetInt();
+		Valid = NumArguments >= 0;
+		pRecord->m_vpArguments.clear();
+		for(int i = 0; Valid && i < NumArguments && !m_Unpacker.Error(); i++)
+			pRecord->m_vpArguments.push_back(m_Unpacker.GetString(0));
+	}
+	else if(Type == -TEEHISTORIAN_EX)
+	{
+		pRecord->m_Type = RECORD_EX;
+		const unsigned char *pUuid = m_Unpacker.GetRaw(sizeof(pRecord->m_Uuid));
+		if(pUuid)
+			mem_copy(&pRecord->m_Uuid, pUuid, sizeof(pRecord->m_Uuid));
+		pRecord->m_ExType = pUuid ? g_UuidManager.LookupUuid(pRecord->m_Uuid) : UUID_UNKNOWN;
+		pRecord->m_DataSize = m_Unpacker.GetInt();
+		Valid = pRecord->m_DataSize >= 0;
+		pRecord->m_pData = Valid ? m_Unpacker.GetRaw(pRecord->m_DataSize) : nullptr;
+	}
+	else
+	{
+		Valid = false;
+	}
+
+	if(!Valid || m_Unpacker.Error())
+	{
+		m_Error = true;
+		return false;
+	}
+	return true;
+}
@@ -4,11 +4,13 @@
 #include <base/hash.h>
 
 #include <engine/console.h>
+#include <engine/shared/packer.h>
 #include <engine/shared/protocol.h>
 
 #include <generated/protocol.h>
 
 #include <ctime>
+#include <vector>
 
 class CConfig;
 class CTuningParams;
@@ -150,4 +152,106 @@ private:
 	CTeam m_aPrevTeams[MAX_CLIENTS];
 };
 
+/**
+ * Reads the records of teehistorian data written by @link CTeeHistorian @endlink.
+ *
+ * Player positions and inputs are stored as differences to the previous
+ * ones, the parser keeps track of them and returns the absolute values.
+ * Ticks that are only implied by the order of the player records are
+ * returned as @link RECORD_TICK @endlink records as well.
+ */
+class CTeeHistorianParser
+{
+public:
+	enum ERecordType
+	{
+		RECORD_TICK,
+		RECORD_PLAYER,
+		RECORD_PLAYER_OLD,
+		RECORD_INPUT,
+		RECORD_MESSAGE,
+		RECORD_JOIN,
+		RECORD_DROP,
+		RECORD_CONSOLE_COMMAND,
+		RECORD_EX,
+		RECORD_FINISH,
+	};
+
+	class CRecord
+	{
+	public:
+		ERecordType m_Type;
+		int m_Tick;
+		int m_ClientId;
+
+		// RECORD_PLAYER
+		int m_X;
+		int m_Y;
+
+		// RECORD_INPUT
+		CNetObj_PlayerInput m_Input;
+
+		// RECORD_MESSAGE and RECORD_EX, points into the parsed data
+		const unsigned char *m_pData;
+		int m_DataSize;
+
+		// RECORD_EX, the type is `UUID_UNKNOWN` for unknown extra records
+		CUuid m_Uuid;
+		int m_ExType;
+
+		// RECORD_DROP reason and RECORD_CONSOLE_COMMAND name
+		const char *m_pString;
+
+		// RECORD_CONSOLE_COMMAND
+		int m_FlagMask;
+		std::vector<const char *> m_vpArguments;
+	};
+
+	/**
+	 * Starts parsing teehistorian data, the data must stay valid while
+	 * the parser is used.
+	 *
+	 * @return `true` if the data starts with a valid header.
+	 */
+	bool Init(const unsigned char *pData, int DataSize);
+
+	/**
+	 * @return The JSON header of the data.
+	 */
+	const char *Header() const { return m_pHeader; }
+
+	/**
+	 * Reads the next record.
+	 *
+	 * @return `false` after the last record or on error.
+	 */
+	bool Next(CRecord *pRecord);
+
+	/**
+	 * @return `true` if the data is invalid or ends in the middle of a record.
+	 */
+	bool Error() const { return m_Error; }
+
+private:
+	CUnpacker m_Unpacker;
+	const char *m_pHeader = nullptr;
+	bool m_Error = false;
+	bool m_Finished = false;
+
+	int m_Tick;
+	int m_LastPlayerClientId;
+	bool m_PendingPlayer;
+	ERecordType m_PendingType;
+	int m_PendingClientId;
+
+	bool m_aAlive[MAX_CLIENTS];
+	int m_aX[MAX_CLIENTS];
+	int m_aY[MAX_CLIENTS];
+	CNetObj_PlayerInput m_aInputs[MAX_CLIENTS];
+
+	bool ReadClientId(CRecord *pRecord);
+	bool ReadPlayer(CRecord *pRecord, int Type);
+	bool ReadInput(CRecord *pRecord, bool Diff);
+};
+
 #endif // GAME_SERVER_TEEHISTORIAN_H
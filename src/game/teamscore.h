@@ -42,6 +42,8 @@ public:
 	void Reset();
 	void SetSolo(int ClientId, bool Value);
 	bool GetSolo(int ClientId) const;
+
+	bool operator==(const CTeamsCore &Other) const = default;
 };
 
 #endif
@@ -0,0 +1,382 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+// The straightforward implementations that check every sample of the line,
+// the optimized ones have to give exactly the same results.
+
+static int RefIntersectLine(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		if(Collision.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Collision.GetCollisionAt(ix, iy);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectLineTeleHook(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	int dx = 0, dy = 0;
+	ThroughOffset(Pos0, Pos1, &dx, &dy);
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+
+		int Index = Collision.GetPureMapIndex(Pos);
+		if(g_Config.m_SvOldTeleportHook)
+			*pTeleNr = Collision.IsTeleport(Index);
+		else
+			*pTeleNr = Collision.IsTeleportHook(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINHOOK;
+		}
+
+		int Hit = 0;
+		if(Collision.CheckPoint(ix, iy))
+		{
+			if(!Collision.IsThrough(ix, iy, dx, dy, Pos0, Pos1))
+				Hit = Collision.GetCollisionAt(ix, iy);
+		}
+		else if(Collision.IsHookBlocker(ix, iy, Pos0, Pos1))
+		{
+			Hit = TILE_NOHOOK;
+		}
+		if(Hit)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Hit;
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectLineTeleWeapon(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+
+		int Index = Collision.GetPureMapIndex(Pos);
+		if(g_Config.m_SvOldTeleportWeapons)
+			*pTeleNr = Collision.IsTeleport(Index);
+		else
+			*pTeleNr = Collision.IsTeleportWeapon(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINWEAPON;
+		}
+
+		if(Collision.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Collision.GetCollisionAt(ix, iy);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectNoLaser(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+	const int DistanceRounded = std::ceil(Distance);
+	for(int i = 0; i < DistanceRounded; i++)
+	{
+		float a = i / Distance;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, Collision.GetWidth() - 1);
+		int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, Collision.GetHeight() - 1);
+		if(Collision.GetIndex(Nx, Ny) == TILE_SOLID || Collision.GetIndex(Nx, Ny) == TILE_NOHOOK || Collision.GetIndex(Nx, Ny) == TILE_NOLASER || Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+				return Collision.GetFrontCollisionAt(Pos.x, Pos.y);
+			else
+				return Collision.GetCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectNoLaserNoWalls(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+	const int DistanceRounded = std::ceil(Distance);
+	for(int i = 0; i < DistanceRounded; i++)
+	{
+		float a = (float)i / Distance;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		if(Collision.IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)) || Collision.IsFrontNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(Collision.IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
+				return Collision.GetCollisionAt(Pos.x, Pos.y);
+			else
+				return Collision.GetFrontCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectAir(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+	const int DistanceRounded = std::ceil(Distance);
+	for(int i = 0; i < DistanceRounded; i++)
+	{
+		float a = (float)i / Distance;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int x = round_to_int(Pos.x);
+		int y = round_to_int(Pos.y);
+		if(Collision.IsSolid(x, y) || (!Collision.GetTile(x, y) && !Collision.GetFrontTile(x, y)))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(!Collision.GetTile(x, y) && !Collision.GetFrontTile(x, y))
+				return -1;
+			else if(!Collision.GetTile(x, y))
+				return Collision.GetTile(x, y);
+			else
+				return Collision.GetFrontTile(x, y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+class CCollisionTest : public ::testing::Test
+{
+protected:
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IKernel> m_pKernel;
+	std::unique_ptr<IStorage> m_pStorage;
+	IEngineMap *m_pMap = nullptr;
+	CLayers m_Layers;
+	CCollision m_Collision;
+
+	void SetUp() override
+	{
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		ASSERT_NE(m_pStorage, nullptr);
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+		m_pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(m_pMap);
+	}
+
+	bool LoadMap(const char *pName)
+	{
+		m_Collision.Unload();
+		m_pMap->Unload();
+
+		char aMap[IO_MAX_PATH_LENGTH];
+		str_format(aMap, sizeof(aMap), "maps/%s.map", pName);
+		if(!m_pMap->Load(aMap))
+			return false;
+		m_Layers.Init(m_pMap, true);
+		m_Collision.Init(&m_Layers);
+		return true;
+	}
+
+	void TearDown() override
+	{
+		m_Collision.Unload();
+		if(m_pMap)
+			m_pMap->Unload();
+	}
+};
+
+static bool SameVec(vec2 a, vec2 b)
+{
+	return mem_comp(&a, &b, sizeof(a)) == 0;
+}
+
+TEST_F(CCollisionTest, IntersectLineDifferential)
+{
+	const char *apMaps[] = {"coverage", "Gold Mine", "LearnToPlay", "Sunny Side Up", "Tsunami", "Tutorial", "ctf1", "ctf5", "dm1", "dm6"};
+	for(const char *pMap : apMaps)
+	{
+		SCOPED_TRACE(pMap);
+		ASSERT_TRUE(LoadMap(pMap));
+
+		CPrng Prng;
+		uint64_t aSeed[2] = {1, 2};
+		Prng.Seed(aSeed);
+		auto Random = [&](float Min, float Max) {
+			return Min + (Max - Min) * (Prng.RandomBits() / (float)0xffffffffu);
+		};
+
+		const float Width = m_Collision.GetWidth() * 32.0f;
+		const float Height = m_Collision.GetHeight() * 32.0f;
+		for(int i = 0; i < 5000; i++)
+		{
+			vec2 Pos0 = vec2(Random(-320.0f, Width + 320.0f), Random(-320.0f, Height + 320.0f));
+			vec2 Pos1;
+			switch(i % 6)
+			{
+			case 0: // hook and laser length
+				Pos1 = Pos0 + direction(Random(0.0f, 2 * pi)) * Random(0.0f, 800.0f);
+				break;
+			case 1: // across the map
+				Pos1 = vec2(Random(-320.0f, Width + 320.0f), Random(-320.0f, Height + 320.0f));
+				break;
+			case 2: // along an axis
+				Pos1 = Pos0 + (i % 4 < 2 ? vec2(Random(-800.0f, 800.0f), 0.0f) : vec2(0.0f, Random(-800.0f, 800.0f)));
+				break;
+			case 3: // on the rounding edges of tiles
+				Pos0 = vec2(round_to_int(Pos0.x / 32) * 32 - 0.5f, round_to_int(Pos0.y / 32) * 32 + 31.5f);
+				Pos1 = Pos0 + vec2(round_to_int(Random(-20.0f, 20.0f)) * 32.0f, round_to_int(Random(-20.0f, 20.0f)) * 32.0f);
+				break;
+			case 4: // diagonal
+				Pos1 = Pos0 + vec2(1.0f, i % 4 < 2 ? 1.0f : -1.0f) * Random(-500.0f, 500.0f);
+				break;
+			default: // short or empty
+				Pos1 = Pos0 + vec2(Random(-2.0f, 2.0f), Random(-2.0f, 2.0f)) * (float)(i % 3);
+				break;
+			}
+
+			vec2 aOut[4];
+			int aTeleNr[2];
+			int aResult[2];
+
+			aResult[0] = RefIntersectLine(m_Collision, Pos0, Pos1, &aOut[0], &aOut[1]);
+			aResult[1] = m_Collision.IntersectLine(Pos0, Pos1, &aOut[2], &aOut[3]);
+			ASSERT_EQ(aResult[0], aResult[1]) << "IntersectLine " << i;
+			ASSERT_TRUE(SameVec(aOut[0], aOut[2]) && SameVec(aOut[1], aOut[3])) << "IntersectLine " << i;
+
+			for(int Old = 0; Old < 2; Old++)
+			{
+				g_Config.m_SvOldTeleportHook = Old;
+				g_Config.m_SvOldTeleportWeapons = Old;
+
+				aResult[0] = RefIntersectLineTeleHook(m_Collision, Pos0, Pos1, &aOut[0], &aOut[1], &aTeleNr[0]);
+				aResult[1] = m_Collision.IntersectLineTeleHook(Pos0, Pos1, &aOut[2], &aOut[3], &aTeleNr[1]);
+				ASSERT_EQ(aResult[0], aResult[1]) << "IntersectLineTeleHook " << i;
+				ASSERT_EQ(aTeleNr[0], aTeleNr[1]) << "IntersectLineTeleHook " << i;
+				ASSERT_TRUE(SameVec(aOut[0], aOut[2]) && SameVec(aOut[1], aOut[3])) << "IntersectLineTeleHook " << i;
+
+				aResult[0] = RefIntersectLineTeleWeapon(m_Collision, Pos0, Pos1, &aOut[0], &aOut[1], &aTeleNr[0]);
+				aResult[1] = m_Collision.IntersectLineTeleWeapon(Pos0, Pos1, &aOut[2], &aOut[3], &aTeleNr[1]);
+				ASSERT_EQ(aResult[0], aResult[1]) << "IntersectLineTeleWeapon " << i;
+				ASSERT_EQ(aTeleNr[0], aTeleNr[1]) << "IntersectLineTeleWeapon " << i;
+				ASSERT_TRUE(SameVec(aOut[0], aOut[2]) && SameVec(aOut[1], aOut[3])) << "IntersectLineTeleWeapon " << i;
+			}
+			g_Config.m_SvOldTeleportHook = 0;
+			g_Config.m_SvOldTeleportWeapons = 0;
+
+			aResult[0] = RefIntersectNoLaser(m_Collision, Pos0, Pos1, &aOut[0], &aOut[1]);
+			aResult[1] = m_Collision.IntersectNoLaser(Pos0, Pos1, &aOut[2], &aOut[3]);
+			ASSERT_EQ(aResult[0], aResult[1]) << "IntersectNoLaser " << i;
+			ASSERT_TRUE(SameVec(aOut[0], aOut[2]) && SameVec(aOut[1], aOut[3])) << "IntersectNoLaser " << i;
+
+			aResult[0] = RefIntersectNoLaserNoWalls(m_Collision, Pos0, Pos1, &aOut[0], &aOut[1]);
+			aResult[1] = m_Collision.IntersectNoLaserNoWalls(Pos0, Pos1, &aOut[2], &aOut[3]);
+			ASSERT_EQ(aResult[0], aResult[1]) << "IntersectNoLaserNoWalls " << i;
+			ASSERT_TRUE(SameVec(aOut[0], aOut[2]) && SameVec(aOut[1], aOut[3])) << "IntersectNoLaserNoWalls " << i;
+
+			aResult[0] = RefIntersectAir(m_Collision, Pos0, Pos1, &aOut[0], &aOut[1]);
+			aResult[1] = m_Collision.IntersectAir(Pos0, Pos1, &aOut[2], &aOut[3]);
+			ASSERT_EQ(aResult[0], aResult[1]) << "IntersectAir " << i;
+			ASSERT_TRUE(SameVec(aOut[0], aOut[2]) && SameVec(aOut[1], aOut[3])) << "IntersectAir " << i;
+		}
+	}
+}
+
+TEST_F(CCollisionTest, TilesMatchLayers)
+{
+	const char *apMaps[] = {"coverage", "Gold Mine", "LearnToPlay", "Sunny Side Up", "Tsunami", "Tutorial", "ctf1", "ctf5", "dm1", "dm6"};
+	for(const char *pMap : apMaps)
+	{
+		SCOPED_TRACE(pMap);
+		ASSERT_TRUE(LoadMap(pMap));
+
+		const CTile *pTiles = m_Collision.GameLayer();
+		const CTile *pFront = m_Collision.FrontLayer();
+		for(int y = 0; y < m_Collision.GetHeight(); y++)
+		{
+			for(int x = 0; x < m_Collision.GetWidth(); x++)
+			{
+				const int Index = y * m_Collision.GetWidth() + x;
+				const int Tile = pTiles[Index].m_Index >= TILE_SOLID && pTiles[Index].m_Index <= TILE_NOLASER ? pTiles[Index].m_Index : 0;
+				const int FrontTile = pFront && (pFront[Index].m_Index == TILE_DEATH || pFront[Index].m_Index == TILE_NOLASER) ? pFront[Index].m_Index : 0;
+				ASSERT_EQ(m_Collision.GetTile(x * 32 + 16, y * 32 + 16), Tile) << x << " " << y;
+				ASSERT_EQ(m_Collision.GetFrontTile(x * 32 + 16, y * 32 + 16), FrontTile) << x << " " << y;
+			}
+		}
+
+		// changed tiles have to be reflected as well
+		m_Collision.SetCollisionAt(16.0f, 16.0f, TILE_NOHOOK);
+		EXPECT_EQ(m_Collision.GetTile(16, 16), TILE_NOHOOK);
+		EXPECT_TRUE(m_Collision.CheckPoint(16.0f, 16.0f));
+		m_Collision.SetCollisionAt(16.0f, 16.0f, TILE_AIR);
+		EXPECT_EQ(m_Collision.GetTile(16, 16), 0);
+		EXPECT_FALSE(m_Collision.CheckPoint(16.0f, 16.0f));
+	}
+}
@@ -1,3 +1,5 @@
+#include <base/system.h>
+
 #include <engine/shared/compression.h>
 
 #include <gtest/gtest.h>
@@ -82,3 +84,91 @@ TEST(CVariableInt, DecompressBufferTooSmall)
 	long CompressedSize = CVariableInt::Decompress(aCompressed, sizeof(aCompressed), aUncompressed, sizeof(aUncompressed));
 	ASSERT_EQ(CompressedSize, -1);
 }
+
+static unsigned FuzzRand(unsigned *pSeed)
+{
+	*pSeed = *pSeed * 1103515245u + 12345u;
+	return *pSeed >> 8;
+}
+
+TEST(CVariableInt, CompressMatchesPack)
+{
+	unsigned Seed = 1;
+	int aData[300];
+	unsigned char aCompressed[sizeof(aData) / sizeof(int) * CVariableInt::MAX_BYTES_PACKED];
+	unsigned char aExpected[sizeof(aCompressed)];
+	for(int Round = 0; Round < 2000; Round++)
+	{
+		// mostly small values with a few large ones, like snapshot deltas
+		const int Num = FuzzRand(&Seed) % std::size(aData);
+		const unsigned LargeChance = 1 + Round % 8;
+		for(int i = 0; i < Num; i++)
+		{
+			const unsigned Value = FuzzRand(&Seed) ^ (FuzzRand(&Seed) << 24);
+			aData[i] = FuzzRand(&Seed) % LargeChance == 0 ? (int)(Value >> (Value % 32)) : (int)(FuzzRand(&Seed) % 129) - 64;
+		}
+
+		long ExpectedSize = 0;
+		for(int i = 0; i < Num; i++)
+			ExpectedSize = CVariableInt::Pack(aExpected + ExpectedSize, aData[i], sizeof(aExpected) - ExpectedSize) - aExpected;
+
+		const long CompressedSize = CVariableInt::Compress(aData, Num * sizeof(int), aCompressed, sizeof(aCompressed));
+		ASSERT_EQ(CompressedSize, ExpectedSize);
+		ASSERT_EQ(mem_comp(aCompressed, aExpected, ExpectedSize), 0);
+
+		// too small by any amount must fail
+		if(ExpectedSize > 0)
+		{
+			const int TooSmall = FuzzRand(&Seed) % ExpectedSize;
+			EXPECT_EQ(CVariableInt::Compress(aData, Num * sizeof(int), aCompressed, TooSmall), -1);
+		}
+	}
+}
+
+TEST(CVariableInt, DecompressMatchesUnpack)
+{
+	unsigned Seed = 2;
+	unsigned char aData[600];
+	int aDecompressed[sizeof(aData)];
+	int aExpected[sizeof(aData)];
+	for(int Round = 0; Round < 2000; Round++)
+	{
+		// arbitrary bytes, with extended bits getting rarer over the rounds
+		const int Size = FuzzRand(&Seed) % std::size(aData);
+		const unsigned ExtendedChance = 1 + Round % 16;
+		for(int i = 0; i < Size; i++)
+		{
+			aData[i] = FuzzRand(&Seed);
+			if(FuzzRand(&Seed) % ExtendedChance != 0)
+				aData[i] &= 0x7F;
+		}
+		const int DstNum = FuzzRand(&Seed) % 4 == 0 ? FuzzRand(&Seed) % (Size + 1) : Size;
+
+		long ExpectedSize = 0;
+		const unsigned char *pSrc = aData;
+		while(pSrc < aData + Size)
+		{
+			if(ExpectedSize >= DstNum)
+			{
+				ExpectedSize = -1;
+				break;
+			}
+			pSrc = CVariableInt::Unpack(pSrc, &aExpected[ExpectedSize], aData + Size - pSrc);
+			if(!pSrc)
+			{
+				ExpectedSize = -1;
+				break;
+			}
+			ExpectedSize++;
+		}
+
+		const long DecompressedSize = CVariableInt::Decompress(aData, Size, aDecompressed, DstNum * sizeof(int));
+		if(ExpectedSize == -1)
+		{
+			ASSERT_EQ(DecompressedSize, -1);
+			continue;
+		}
+		ASSERT_EQ(DecompressedSize, ExpectedSize * (long)sizeof(int));
+		ASSERT_EQ(mem_comp(aDecompressed, aExpected, DecompressedSize), 0);
+	}
+}
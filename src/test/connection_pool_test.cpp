@@ -0,0 +1,232 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/server/databases/connection.h>
+#include <engine/server/databases/connection_pool.h>
+#include <engine/shared/config.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+struct CPoolTestData : ISqlData
+{
+	CPoolTestData(std::shared_ptr<ISqlResult> pResult, std::function<bool(IDbConnection *)> Function) :
+		ISqlData(std::move(pResult)),
+		m_Function(std::move(Function))
+	{
+	}
+	std::function<bool(IDbConnection *)> m_Function;
+};
+
+static bool RunRead(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	return dynamic_cast<const CPoolTestData *>(pGameData)->m_Function(pSqlServer);
+}
+
+static bool RunWrite(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	if(w != Write::NORMAL)
+		return true;
+	return dynamic_cast<const CPoolTestData *>(pGameData)->m_Function(pSqlServer);
+}
+
+static bool WaitCompleted(const std::shared_ptr<ISqlResult> &pResult)
+{
+	for(int i = 0; i < 1000 && !pResult->m_Completed; i++)
+		std::this_thread::sleep_for(10ms);
+	return pResult->m_Completed;
+}
+
+static int64_t SumLatencyBuckets(const CDbConnectionPool::CLaneStats &Stats)
+{
+	int64_t Sum = 0;
+	for(int64_t Count : Stats.m_aLatencyBuckets)
+		Sum += Count;
+	return Sum;
+}
+
+struct ConnectionPool : public testing::Test
+{
+	CTestInfo m_Info;
+	char m_aFilename[64];
+
+	ConnectionPool()
+	{
+		// `:memory:` databases aren't shared between the connections of the workers
+		m_Info.Filename(m_aFilename, sizeof(m_aFilename), ".sqlite");
+		g_Config.m_SvSqlReadWorkers = 2;
+	}
+
+	~ConnectionPool()
+	{
+		char aBuf[IO_MAX_PATH_LENGTH];
+		for(const char *pSuffix : {"", "-wal", "-shm"})
+		{
+			str_format(aBuf, sizeof(aBuf), "%s%s", m_aFilename, pSuffix);
+			fs_remove(aBuf);
+		}
+	}
+
+	void Register(CDbConnectionPool &Pool)
+	{
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::READ, m_aFilename);
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, m_aFilename);
+	}
+};
+
+TEST_F(ConnectionPool, WritesInOrder)
+{
+	std::vector<int> vOrder;
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	{
+		CDbConnectionPool Pool;
+		Register(Pool);
+		for(int i = 0; i < 100; i++)
+		{
+			vpResults.push_back(std::make_shared<ISqlResult>());
+			Pool.ExecuteWrite(RunWrite, std::make_unique<CPoolTestData>(vpResults.back(), [&vOrder, i](IDbConnection *) {
+				vOrder.push_back(i);
+				return true;
+			}),
+				"order");
+		}
+		for(const auto &pResult : vpResults)
+		{
+			ASSERT_TRUE(WaitCompleted(pResult));
+			EXPECT_TRUE(pResult->m_Success);
+		}
+
+		CDbConnectionPool::CLaneStats Stats = Pool.Stats(CDbConnectionPool::LANE_WRITE);
+		EXPECT_EQ(Stats.m_NumQueued, 0);
+		EXPECT_GE(Stats.m_MaxQueued, 1);
+		EXPECT_EQ(Stats.m_NumDone, 100);
+		EXPECT_EQ(Stats.m_NumFailed, 0);
+		EXPECT_EQ(SumLatencyBuckets(Stats), 100);
+	}
+	ASSERT_EQ(vOrder.size(), 100u);
+	for(int i = 0; i < 100; i++)
+		EXPECT_EQ(vOrder[i], i);
+}
+
+TEST_F(ConnectionPool, ReadDuringWrite)
+{
+	std::atomic_bool Release = false;
+	CDbConnectionPool Pool;
+	Register(Pool);
+
+	auto pWriteResult = std::make_shared<ISqlResult>();
+	Pool.ExecuteWrite(RunWrite, std::make_unique<CPoolTestData>(pWriteResult, [&Release](IDbConnection *) {
+		for(int i = 0; i < 1000 && !Release; i++)
+			std::this_thread::sleep_for(10ms);
+		return true;
+	}),
+		"blocked write");
+
+	auto pReadResult = std::make_shared<ISqlResult>();
+	Pool.Execute(RunRead, std::make_unique<CPoolTestData>(pReadResult, [](IDbConnection *pSqlServer) {
+		char aError[256];
+		bool End;
+		return pSqlServer->PrepareStatement("SELECT COUNT(*) FROM record_race", aError, sizeof(aError)) &&
+		       pSqlServer->Step(&End, aError, sizeof(aError)) && !End;
+	}),
+		"read");
+
+	EXPECT_TRUE(WaitCompleted(pReadResult));
+	EXPECT_TRUE(pReadResult->m_Success);
+	EXPECT_FALSE(pWriteResult->m_Completed);
+	Release = true;
+	EXPECT_TRUE(WaitCompleted(pWriteResult));
+	EXPECT_TRUE(pWriteResult->m_Success);
+}
+
+TEST_F(ConnectionPool, ReadAfterWrites)
+{
+	std::atomic_bool Release = false;
+	std::atomic_bool Written = false;
+	CDbConnectionPool Pool;
+	Register(Pool);
+
+	auto pWriteResult = std::make_shared<ISqlResult>();
+	Pool.ExecuteWrite(RunWrite, std::make_unique<CPoolTestData>(pWriteResult, [&Release, &Written](IDbConnection *) {
+		for(int i = 0; i < 1000 && !Release; i++)
+			std::this_thread::sleep_for(10ms);
+		Written = true;
+		return true;
+	}),
+		"blocked write");
+
+	auto pReadResult = std::make_shared<ISqlResult>();
+	Pool.ExecuteAfterWrites(RunRead, std::make_unique<CPoolTestData>(pReadResult, [&Written](IDbConnection *) {
+		return Written.load();
+	}),
+		"read after write");
+
+	std::this_thread::sleep_for(100ms);
+	EXPECT_FALSE(pReadResult->m_Completed);
+	Release = true;
+	ASSERT_TRUE(WaitCompleted(pReadResult));
+	EXPECT_TRUE(pReadResult->m_Success);
+	EXPECT_TRUE(pWriteResult->m_Completed);
+
+	CDbConnectionPool::CLaneStats Stats = Pool.Stats(CDbConnectionPool::LANE_WRITE);
+	EXPECT_EQ(Stats.m_NumDone, 2);
+	EXPECT_EQ(Stats.m_NumFailed, 0);
+}
+
+TEST_F(ConnectionPool, ParallelReads)
+{
+	std::atomic_int NumStarted = 0;
+	CDbConnectionPool Pool;
+	Register(Pool);
+
+	std::shared_ptr<ISqlResult> apResults[2];
+	for(auto &pResult : apResults)
+	{
+		pResult = std::make_shared<ISqlResult>();
+		// only succeeds if the other read runs at the same time
+		Pool.Execute(RunRead, std::make_unique<CPoolTestData>(pResult, [&NumStarted](IDbConnection *) {
+			NumStarted++;
+			for(int i = 0; i < 1000 && NumStarted < 2; i++)
+				std::this_thread::sleep_for(10ms);
+			return NumStarted == 2;
+		}),
+			"parallel read");
+	}
+
+	for(const auto &pResult : apResults)
+	{
+		ASSERT_TRUE(WaitCompleted(pResult));
+		EXPECT_TRUE(pResult->m_Success);
+	}
+
+	CDbConnectionPool::CLaneStats Stats = Pool.Stats(CDbConnectionPool::LANE_READ);
+	EXPECT_EQ(Stats.m_NumQueued, 0);
+	EXPECT_EQ(Stats.m_MaxQueued, 2);
+	EXPECT_EQ(Stats.m_NumDone, 2);
+	EXPECT_EQ(SumLatencyBuckets(Stats), 2);
+}
+
+TEST_F(ConnectionPool, FailedReadStats)
+{
+	CDbConnectionPool Pool;
+	Register(Pool);
+
+	auto pResult = std::make_shared<ISqlResult>();
+	Pool.Execute(RunRead, std::make_unique<CPoolTestData>(pResult, [](IDbConnection *) { return false; }), "failing read");
+	ASSERT_TRUE(WaitCompleted(pResult));
+	EXPECT_FALSE(pResult->m_Success);
+
+	CDbConnectionPool::CLaneStats Stats = Pool.Stats(CDbConnectionPool::LANE_READ);
+	EXPECT_EQ(Stats.m_NumQueued, 0);
+	EXPECT_EQ(Stats.m_NumDone, 0);
+	EXPECT_EQ(Stats.m_NumFailed, 1);
+	EXPECT_EQ(SumLatencyBuckets(Stats), 1);
+}
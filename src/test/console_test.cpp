@@ -0,0 +1,223 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+static void CountCallback(IConsole::IResult *pResult, void *pUserData)
+{
+	(*static_cast<int *>(pUserData))++;
+}
+
+static void ChainCallback(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	(*static_cast<int *>(pUserData))++;
+	pfnCallback(pResult, pCallbackUserData);
+}
+
+TEST(Console, FindCaseInsensitive)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_CLIENT);
+	int Count = 0;
+	pConsole->Register("Test_Command", "", CFGFLAG_SERVER, CountCallback, &Count, "");
+
+	pConsole->ExecuteLine("test_command", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("TEST_COMMAND; Test_Command", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->ExecuteLine("test_command2", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Count, 3);
+
+	ASSERT_NE(pConsole->GetCommandInfo("tEST_cOMMAND", CFGFLAG_SERVER, false), nullptr);
+	EXPECT_STREQ(pConsole->GetCommandInfo("tEST_cOMMAND", CFGFLAG_SERVER, false)->Name(), "Test_Command");
+	EXPECT_EQ(pConsole->GetCommandInfo("test_command", CFGFLAG_CLIENT, false), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("test_command", CFGFLAG_SERVER, true), nullptr);
+}
+
+TEST(Console, SameNameDifferentFlags)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_CLIENT);
+	int ServerCount = 0;
+	int ClientCount = 0;
+	pConsole->Register("a", "", CFGFLAG_SERVER, CountCallback, &ServerCount, "server");
+	pConsole->Register("a", "", CFGFLAG_CLIENT, CountCallback, &ClientCount, "client");
+
+	EXPECT_STREQ(pConsole->GetCommandInfo("a", CFGFLAG_SERVER, false)->Help(), "server");
+	EXPECT_STREQ(pConsole->GetCommandInfo("a", CFGFLAG_CLIENT, false)->Help(), "client");
+	pConsole->ExecuteLineFlag("a", CFGFLAG_SERVER, IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(ServerCount, 1);
+	EXPECT_EQ(ClientCount, 0);
+
+	// registering again replaces the command with the same flags
+	pConsole->Register("a", "", CFGFLAG_CLIENT, CountCallback, &ServerCount, "client again");
+	EXPECT_STREQ(pConsole->GetCommandInfo("a", CFGFLAG_CLIENT, false)->Help(), "client again");
+	EXPECT_STREQ(pConsole->GetCommandInfo("a", CFGFLAG_SERVER, false)->Help(), "server");
+}
+
+TEST(Console, TempCommands)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	int Count = 0;
+	pConsole->Register("b", "", CFGFLAG_SERVER, CountCallback, &Count, "");
+	pConsole->RegisterTemp("b", "", CFGFLAG_SERVER, "temp");
+	pConsole->RegisterTemp("c", "", CFGFLAG_SERVER, "temp");
+	pConsole->RegisterTemp("d", "", CFGFLAG_SERVER, "temp");
+
+	ASSERT_NE(pConsole->GetCommandInfo("B", CFGFLAG_SERVER, true), nullptr);
+	ASSERT_NE(pConsole->GetCommandInfo("B", CFGFLAG_SERVER, false), nullptr);
+	EXPECT_STREQ(pConsole->GetCommandInfo("B", CFGFLAG_SERVER, true)->Help(), "temp");
+	EXPECT_STREQ(pConsole->GetCommandInfo("B", CFGFLAG_SERVER, false)->Help(), "");
+
+	pConsole->DeregisterTemp("c");
+	EXPECT_EQ(pConsole->GetCommandInfo("c", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(pConsole->GetCommandInfo("d", CFGFLAG_SERVER, true), nullptr);
+
+	// recycled temp commands are found by their new name only
+	pConsole->RegisterTemp("e", "", CFGFLAG_SERVER, "recycled");
+	EXPECT_EQ(pConsole->GetCommandInfo("c", CFGFLAG_SERVER, true), nullptr);
+	ASSERT_NE(pConsole->GetCommandInfo("e", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_STREQ(pConsole->GetCommandInfo("e", CFGFLAG_SERVER, true)->Help(), "recycled");
+
+	pConsole->DeregisterTempAll();
+	EXPECT_EQ(pConsole->GetCommandInfo("b", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("d", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("e", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(pConsole->GetCommandInfo("b", CFGFLAG_SERVER, false), nullptr);
+	pConsole->ExecuteLine("b", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Count, 1);
+}
+
+TEST(Console, Chain)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_CLIENT);
+	int Count = 0;
+	int ChainCount = 0;
+	pConsole->Register("chained", "", CFGFLAG_CLIENT, CountCallback, &Count, "");
+	pConsole->Chain("CHAINED", ChainCallback, &ChainCount);
+	pConsole->Chain("chained", ChainCallback, &ChainCount);
+	pConsole->ExecuteLine("Chained", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Count, 1);
+	EXPECT_EQ(ChainCount, 2);
+}
+
+TEST(Console, ManyCommands)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_CLIENT);
+	std::vector<std::string> vNames;
+	for(int i = 0; i < 2000; i++)
+	{
+		char aName[32];
+		str_format(aName, sizeof(aName), "cl_command_%d", (i * 7919) % 2000);
+		vNames.emplace_back(aName);
+	}
+	std::vector<int> vCounts(vNames.size(), 0);
+	for(size_t i = 0; i < vNames.size(); i++)
+		pConsole->Register(vNames[i].c_str(), "", CFGFLAG_CLIENT, CountCallback, &vCounts[i], "");
+
+	for(size_t i = 0; i < vNames.size(); i++)
+		pConsole->ExecuteLine(vNames[i].c_str(), IConsole::CLIENT_ID_UNSPECIFIED);
+	for(size_t i = 0; i < vNames.size(); i++)
+		EXPECT_EQ(vCounts[i], 1) << vNames[i];
+
+	// the list stays sorted
+	const char *pPrevious = "";
+	int Num = 0;
+	for(const IConsole::ICommandInfo *pInfo = pConsole->FirstCommandInfo(IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_CLIENT); pInfo; pInfo = pConsole->NextCommandInfo(pInfo, IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_CLIENT))
+	{
+		EXPECT_LE(str_comp(pPrevious, pInfo->Name()), 0);
+		pPrevious = pInfo->Name();
+		Num++;
+	}
+	EXPECT_GE(Num, (int)vNames.size());
+}
+
+struct SBatchChainData
+{
+	int *m_pVariable;
+	int m_Count = 0;
+	int m_OldValue = -1;
+};
+
+static void BatchChainCallback(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	SBatchChainData *pData = static_cast<SBatchChainData *>(pUserData);
+	pData->m_Count++;
+	pData->m_OldValue = *pData->m_pVariable;
+	pfnCallback(pResult, pCallbackUserData);
+}
+
+TEST(Console, Batch)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_CLIENT);
+	int Chained = 0;
+	int Plain = 0;
+	SIntConfigVariable ChainedVariable(pConsole.get(), "chained_var", SConfigVariable::VAR_INT, CFGFLAG_CLIENT, "", &Chained, 0, 0, 100);
+	SIntConfigVariable PlainVariable(pConsole.get(), "plain_var", SConfigVariable::VAR_INT, CFGFLAG_CLIENT, "", &Plain, 0, 0, 100);
+	ChainedVariable.Register();
+	PlainVariable.Register();
+	SBatchChainData Data;
+	Data.m_pVariable = &Chained;
+	pConsole->Chain("chained_var", BatchChainCallback, &Data);
+
+	pConsole->BeginBatch();
+	pConsole->ExecuteLine("chained_var 1; plain_var 1", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->BeginBatch();
+	pConsole->ExecuteLine("chained_var 2; plain_var 2", IConsole::CLIENT_ID_UNSPECIFIED);
+	pConsole->EndBatch();
+	// printing the value runs the chain
+	pConsole->ExecuteLine("chained_var", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Data.m_Count, 1);
+	EXPECT_EQ(Chained, 2);
+	EXPECT_EQ(Plain, 2);
+
+	pConsole->EndBatch();
+	EXPECT_EQ(Data.m_Count, 2);
+	EXPECT_EQ(Data.m_OldValue, 0);
+	EXPECT_EQ(Chained, 2);
+
+	pConsole->ExecuteLine("chained_var 3", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(Data.m_Count, 3);
+	EXPECT_EQ(Data.m_OldValue, 2);
+	EXPECT_EQ(Chained, 3);
+}
+
+TEST(Console, BatchResetToggle)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	pKernel->RegisterInterface(pStorage.get(), false);
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER).release();
+	pKernel->RegisterInterface(pConsole);
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+	pConsole->Init();
+	pConfigManager->Init();
+	pConsole->StoreCommands(false);
+
+	SBatchChainData Data;
+	Data.m_pVariable = &g_Config.m_SvVoteTime;
+	pConsole->Chain("sv_vote_time", BatchChainCallback, &Data);
+
+	pConsole->BeginBatch();
+	pConsole->ExecuteLine("sv_vote_time 5; reset sv_vote_time", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(g_Config.m_SvVoteTime, 25);
+	pConsole->ExecuteLine("sv_vote_time 10; toggle sv_vote_time 10 20", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(g_Config.m_SvVoteTime, 20);
+	EXPECT_EQ(Data.m_Count, 0);
+	pConsole->EndBatch();
+	EXPECT_EQ(Data.m_Count, 1);
+	EXPECT_EQ(Data.m_OldValue, 25);
+	EXPECT_EQ(g_Config.m_SvVoteTime, 20);
+
+	pConsole->ExecuteLine("reset sv_vote_time", IConsole::CLIENT_ID_UNSPECIFIED);
+	EXPECT_EQ(g_Config.m_SvVoteTime, 25);
+}
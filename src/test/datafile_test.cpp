@@ -1,13 +1,18 @@
 #include "test.h"
 
+#include <base/system.h>
+
+#include <engine/engine.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
 #include <game/mapitems_ex.h>
+#include <game/version.h>
 
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 TEST(Datafile, ExtendedType)
 {
@@ -112,3 +117,198 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, MappedData)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	CMapItemTest ItemTest;
+	ItemTest.m_Version = 1;
+	ItemTest.m_aFields[0] = 1234;
+	ItemTest.m_aFields[1] = 5678;
+	ItemTest.m_Field3 = 9876;
+	ItemTest.m_Field4 = 5432;
+
+	std::vector<std::vector<int>> vvData;
+	for(int i = 0; i < 16; i++)
+	{
+		std::vector<int> &vData = vvData.emplace_back((i + 1) * 1000);
+		for(size_t j = 0; j < vData.size(); j++)
+			vData[j] = (j % (i + 2)) * i;
+	}
+
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+
+		Writer.AddItem(MAPITEMTYPE_TEST, 0x8000, sizeof(ItemTest), &ItemTest);
+		for(const std::vector<int> &vData : vvData)
+			Writer.AddData(vData.size() * sizeof(int), vData.data());
+
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		CDataFileReader MappedReader;
+		ASSERT_TRUE(MappedReader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, true));
+
+		// hashes are calculated lazily
+		SHA256_DIGEST Sha256;
+		unsigned Crc;
+		ASSERT_TRUE(pStorage->CalculateHashes(Info.m_aFilename, IStorage::TYPE_ALL, &Sha256, &Crc));
+		EXPECT_EQ(Reader.Sha256(), Sha256);
+		EXPECT_EQ(Reader.Crc(), Crc);
+		EXPECT_EQ(MappedReader.Sha256(), Sha256);
+		EXPECT_EQ(MappedReader.Crc(), Crc);
+		EXPECT_EQ(MappedReader.MapSize(), Reader.MapSize());
+		ASSERT_EQ(MappedReader.NumData(), (int)vvData.size());
+
+		const CMapItemTest *pTest = (const CMapItemTest *)MappedReader.FindItem(MAPITEMTYPE_TEST, 0x8000);
+		ASSERT_NE(pTest, nullptr);
+		EXPECT_EQ(pTest->m_aFields[1], ItemTest.m_aFields[1]);
+		EXPECT_EQ(pTest->m_Field4, ItemTest.m_Field4);
+
+		// load all data but the first on the job pool, twice and with invalid indices
+		std::unique_ptr<IEngine> pEngine(CreateTestEngine(GAME_NAME));
+		std::vector<int> vIndices = {-1, 1000};
+		for(int i = 1; i < MappedReader.NumData(); i++)
+		{
+			vIndices.push_back(i);
+			vIndices.push_back(i);
+		}
+		MappedReader.LoadData(vIndices, pEngine.get());
+		for(int i = 0; i < MappedReader.NumData(); i++)
+		{
+			const int Size = vvData[i].size() * sizeof(int);
+			ASSERT_EQ(MappedReader.GetDataSize(i), Size);
+			ASSERT_EQ(Reader.GetDataSize(i), Size);
+			EXPECT_EQ(mem_comp(MappedReader.GetData(i), vvData[i].data(), Size), 0);
+			EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), Size), 0);
+		}
+
+		char *pReplaced = static_cast<char *>(malloc(4));
+		mem_copy(pReplaced, "abc", 4);
+		MappedReader.ReplaceData(0, pReplaced, 4);
+		EXPECT_STREQ(MappedReader.GetDataString(0), "abc");
+		MappedReader.UnloadData(1);
+		EXPECT_EQ(mem_comp(MappedReader.GetData(1), vvData[1].data(), vvData[1].size() * sizeof(int)), 0);
+
+		pEngine->ShutdownJobs();
+		MappedReader.Close();
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, TruncatedHashes)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		// more than is buffered when reading the header
+		std::vector<unsigned> vData(64 * 1024);
+		unsigned Seed = 1;
+		for(unsigned &Value : vData)
+			Value = Seed = Seed * 1103515245u + 12345u;
+		EXPECT_EQ(Writer.AddData(vData.size() * sizeof(unsigned), vData.data()), 0);
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+
+		// the file is truncated before the hashes are calculated
+		IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		EXPECT_FALSE(io_close(File));
+		EXPECT_FALSE(Reader.CalculateHashes());
+		EXPECT_FALSE(Reader.CalculateHashes());
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, ParallelCompression)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+	std::unique_ptr<IEngine> pEngine(CreateTestEngine(GAME_NAME));
+
+	CTestInfo Info;
+	char aEngineFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aEngineFilename, sizeof(aEngineFilename), "-engine.map");
+	char aFastFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aFastFilename, sizeof(aFastFilename), "-fast.map");
+
+	std::vector<std::vector<int>> vvData;
+	for(int i = 0; i < 32; i++)
+	{
+		std::vector<int> &vData = vvData.emplace_back((i % 5 + 1) * 5000);
+		for(size_t j = 0; j < vData.size(); j++)
+			vData[j] = (j * j) % (i + 7);
+	}
+
+	// on temporary threads, on the job pool of the engine and with fast compression
+	const char *apFilenames[] = {Info.m_aFilename, aEngineFilename, aFastFilename};
+	for(const char *pFilename : apFilenames)
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), pFilename));
+		for(size_t i = 0; i < vvData.size(); i++)
+			Writer.AddData(vvData[i].size() * sizeof(int), vvData[i].data(), i % 2 == 0 ? CDataFileWriter::COMPRESSION_DEFAULT : CDataFileWriter::COMPRESSION_BEST);
+		Writer.SetFastCompression(pFilename == aFastFilename);
+		Writer.Finish(pFilename == aEngineFilename ? pEngine.get() : nullptr);
+	}
+
+	// data is compressed independently, so the order of compression doesn't matter
+	void *pData;
+	unsigned Size;
+	ASSERT_TRUE(pStorage->ReadFile(Info.m_aFilename, IStorage::TYPE_ALL, &pData, &Size));
+	void *pEngineData;
+	unsigned EngineSize;
+	ASSERT_TRUE(pStorage->ReadFile(aEngineFilename, IStorage::TYPE_ALL, &pEngineData, &EngineSize));
+	ASSERT_EQ(Size, EngineSize);
+	EXPECT_EQ(mem_comp(pData, pEngineData, Size), 0);
+	free(pData);
+	free(pEngineData);
+
+	for(const char *pFilename : apFilenames)
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), pFilename, IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), (int)vvData.size());
+		for(int i = 0; i < Reader.NumData(); i++)
+		{
+			const int DataSize = vvData[i].size() * sizeof(int);
+			ASSERT_EQ(Reader.GetDataSize(i), DataSize);
+			EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), DataSize), 0);
+		}
+		Reader.Close();
+	}
+
+	pEngine->ShutdownJobs();
+	if(!HasFailure())
+	{
+		for(const char *pFilename : apFilenames)
+			pStorage->RemoveFile(pFilename, IStorage::TYPE_SAVE);
+	}
+}
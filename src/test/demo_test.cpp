@@ -0,0 +1,107 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+class CDemoTestListener : public CDemoPlayer::IListener
+{
+public:
+	int m_NumSnapshots = 0;
+	std::vector<int> m_vMessages;
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		m_NumSnapshots++;
+	}
+
+	void OnDemoPlayerMessage(void *pData, int Size) override
+	{
+		ASSERT_EQ(Size, (int)sizeof(int));
+		int Message;
+		mem_copy(&Message, pData, sizeof(Message));
+		m_vMessages.push_back(Message);
+	}
+};
+
+TEST(Demo, RecordAndPlay)
+{
+	CTestInfo Info;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	CNetBase::Init();
+
+	// several demos at once share the writer thread
+	const int NumDemos = 4;
+	CSnapshotDelta SnapshotDelta;
+	unsigned char aMapData[] = {1, 2, 3, 4};
+	CDemoRecorder aRecorders[NumDemos];
+	for(int Demo = 0; Demo < NumDemos; Demo++)
+	{
+		char aFilename[IO_MAX_PATH_LENGTH];
+		str_format(aFilename, sizeof(aFilename), "test%d.demo", Demo);
+		aRecorders[Demo] = CDemoRecorder(&SnapshotDelta);
+		ASSERT_EQ(aRecorders[Demo].Start(pStorage.get(), nullptr, aFilename, "0.6 626fce9a778df4d4", "test", SHA256_ZEROED, 0, "client", sizeof(aMapData), aMapData, nullptr, nullptr, nullptr), 0);
+		EXPECT_TRUE(aRecorders[Demo].IsRecording());
+	}
+
+	const int NumTicks = 20 * SERVER_TICK_SPEED;
+	std::unique_ptr<CSnapshotBuilder> pBuilder = std::make_unique<CSnapshotBuilder>();
+	std::vector<char> vSnapshot(CSnapshot::MAX_SIZE);
+	for(int Tick = 1; Tick <= NumTicks; Tick++)
+	{
+		for(int Demo = 0; Demo < NumDemos; Demo++)
+		{
+			pBuilder->Init();
+			for(int Id = 0; Id < 16; Id++)
+			{
+				int *pData = static_cast<int *>(pBuilder->NewItem(1, Id, 2 * sizeof(int)));
+				pData[0] = Id;
+				pData[1] = Tick / (Id + Demo + 1);
+			}
+			const int Size = pBuilder->Finish(vSnapshot.data());
+			aRecorders[Demo].RecordSnapshot(Tick, vSnapshot.data(), Size);
+			const int Message = Tick * NumDemos + Demo;
+			aRecorders[Demo].RecordMessage(&Message, sizeof(Message));
+		}
+	}
+	for(CDemoRecorder &Recorder : aRecorders)
+	{
+		EXPECT_EQ(Recorder.Length(), (NumTicks - 1) / SERVER_TICK_SPEED);
+		EXPECT_EQ(Recorder.Stop(IDemoRecorder::EStopMode::KEEP_FILE), 0);
+		EXPECT_FALSE(Recorder.IsRecording());
+	}
+
+	// all chunks are written and the header is complete after stopping
+	for(int Demo = 0; Demo < NumDemos; Demo++)
+	{
+		char aFilename[IO_MAX_PATH_LENGTH];
+		str_format(aFilename, sizeof(aFilename), "test%d.demo", Demo);
+		CDemoPlayer Player(&SnapshotDelta, false);
+		CDemoTestListener Listener;
+		Player.SetListener(&Listener);
+		ASSERT_EQ(Player.Load(pStorage.get(), nullptr, aFilename, IStorage::TYPE_SAVE), 0);
+		EXPECT_EQ(bytes_be_to_uint(Player.Info()->m_Header.m_aLength), (unsigned)aRecorders[Demo].Length());
+		EXPECT_EQ(Player.BaseInfo()->m_FirstTick, 1);
+		EXPECT_EQ(Player.BaseInfo()->m_LastTick, NumTicks);
+
+		Player.Play();
+		while(Player.IsPlaying() && !Player.BaseInfo()->m_Paused)
+			Player.Update(false);
+		EXPECT_STREQ(Player.ErrorMessage(), "");
+		Player.Stop();
+
+		EXPECT_EQ(Listener.m_NumSnapshots, NumTicks);
+		ASSERT_EQ((int)Listener.m_vMessages.size(), NumTicks);
+		for(int i = 0; i < NumTicks; i++)
+			EXPECT_EQ(Listener.m_vMessages[i], (i + 1) * NumDemos + Demo);
+	}
+}
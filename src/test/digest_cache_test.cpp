@@ -0,0 +1,140 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/shared/digest_cache.h>
+
+#include <gtest/gtest.h>
+
+static IO_FILE_INFO FileInfo(int64_t Size, int64_t Modified)
+{
+	IO_FILE_INFO Info;
+	Info.device = 0xfedcba9876543210;
+	Info.inode = 42;
+	Info.size = Size;
+	Info.modified = Modified;
+	return Info;
+}
+
+TEST(DigestCache, FindAdded)
+{
+	CTestInfo Info;
+	CDigestCache Cache;
+	Cache.Init(Info.m_aFilename);
+
+	SHA256_DIGEST Sha256 = sha256("abc", 3);
+	SHA256_DIGEST FoundSha256;
+	unsigned FoundCrc;
+	EXPECT_FALSE(Cache.Find("maps/a b.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+	EXPECT_TRUE(Cache.Add("maps/a b.map", FileInfo(3, 1000), Sha256, 0x12345678));
+
+	ASSERT_TRUE(Cache.Find("maps/a b.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+	EXPECT_EQ(FoundSha256, Sha256);
+	EXPECT_EQ(FoundCrc, 0x12345678u);
+
+	// any change of the file makes the entry invalid
+	EXPECT_FALSE(Cache.Find("maps/a b.map", FileInfo(4, 1000), &FoundSha256, &FoundCrc));
+	EXPECT_FALSE(Cache.Find("maps/a b.map", FileInfo(3, 1001), &FoundSha256, &FoundCrc));
+	EXPECT_FALSE(Cache.Find("maps/a.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
+
+TEST(DigestCache, Persistent)
+{
+	CTestInfo Info;
+	SHA256_DIGEST Sha256 = sha256("abc", 3);
+	SHA256_DIGEST OtherSha256 = sha256("xyz", 3);
+	{
+		CDigestCache Cache;
+		Cache.Init(Info.m_aFilename);
+		EXPECT_TRUE(Cache.Add("a.map", FileInfo(3, 1000), OtherSha256, 1));
+		EXPECT_TRUE(Cache.Add("a.map", FileInfo(3, 2000), Sha256, 2));
+		EXPECT_TRUE(Cache.Add("b.map", FileInfo(3, 1000), OtherSha256, 3));
+	}
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_APPEND);
+	ASSERT_TRUE(File);
+	const char *pInvalid = "invalid line\n";
+	io_write(File, pInvalid, str_length(pInvalid));
+	EXPECT_FALSE(io_close(File));
+
+	{
+		CDigestCache Cache;
+		Cache.Init(Info.m_aFilename);
+		SHA256_DIGEST FoundSha256;
+		unsigned FoundCrc;
+		EXPECT_FALSE(Cache.Find("a.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+		ASSERT_TRUE(Cache.Find("a.map", FileInfo(3, 2000), &FoundSha256, &FoundCrc));
+		EXPECT_EQ(FoundSha256, Sha256);
+		EXPECT_EQ(FoundCrc, 2u);
+		ASSERT_TRUE(Cache.Find("b.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+		EXPECT_EQ(FoundSha256, OtherSha256);
+		EXPECT_EQ(FoundCrc, 3u);
+
+		// the same file hashed differently means the cache can't be trusted for it
+		EXPECT_FALSE(Cache.Add("b.map", FileInfo(3, 1000), Sha256, 3));
+		ASSERT_TRUE(Cache.Find("b.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+		EXPECT_EQ(FoundSha256, Sha256);
+	}
+
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
+
+TEST(DigestCache, Rewrite)
+{
+	CTestInfo Info;
+	SHA256_DIGEST Sha256 = sha256("abc", 3);
+	{
+		CDigestCache Cache;
+		Cache.Init(Info.m_aFilename);
+		for(int i = 0; i < 200; i++)
+			EXPECT_TRUE(Cache.Add("a.map", FileInfo(3, i), Sha256, i));
+	}
+	{
+		// only the latest entry of a file is kept
+		CDigestCache Cache;
+		Cache.Init(Info.m_aFilename);
+		SHA256_DIGEST FoundSha256;
+		unsigned FoundCrc;
+		ASSERT_TRUE(Cache.Find("a.map", FileInfo(3, 199), &FoundSha256, &FoundCrc));
+		EXPECT_EQ(FoundCrc, 199u);
+	}
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	char aBuf[1024];
+	const unsigned Size = io_read(File, aBuf, sizeof(aBuf));
+	EXPECT_FALSE(io_close(File));
+	EXPECT_GT(Size, 0u);
+	EXPECT_LT(Size, 200u);
+
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
+
+TEST(DigestCache, OtherProcess)
+{
+	CTestInfo Info;
+	SHA256_DIGEST Sha256 = sha256("abc", 3);
+	SHA256_DIGEST FoundSha256;
+	unsigned FoundCrc;
+
+	// two processes that loaded the cache before the other one added an entry
+	CDigestCache Cache;
+	Cache.Init(Info.m_aFilename);
+	CDigestCache OtherCache;
+	OtherCache.Init(Info.m_aFilename);
+	EXPECT_FALSE(Cache.Find("a.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+	EXPECT_FALSE(OtherCache.Find("b.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+	EXPECT_TRUE(Cache.Add("a.map", FileInfo(3, 1000), Sha256, 1));
+	EXPECT_TRUE(OtherCache.Add("b.map", FileInfo(3, 1000), Sha256, 2));
+
+	CDigestCache LoadedCache;
+	LoadedCache.Init(Info.m_aFilename);
+	ASSERT_TRUE(LoadedCache.Find("a.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+	EXPECT_EQ(FoundCrc, 1u);
+	ASSERT_TRUE(LoadedCache.Find("b.map", FileInfo(3, 1000), &FoundSha256, &FoundCrc));
+	EXPECT_EQ(FoundCrc, 2u);
+
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
@@ -16,7 +16,9 @@
 
 #include <generated/protocol.h>
 
+#include <game/prng.h>
 #include <game/server/entities/character.h>
+#include <game/server/entities/projectile.h>
 #include <game/server/gamecontext.h>
 #include <game/server/gamecontroller.h>
 #include <game/server/gameworld.h>
@@ -75,7 +77,7 @@ public:
 		IConfigManager *pConfigManager = CreateConfigManager();
 		m_pKernel->RegisterInterface(pConfigManager);
 
-		IEngineMap *pEngineMap = CreateEngineMap();
+		IEngineMap *pEngineMap = CreateEngineMap(pEngine);
 		m_pKernel->RegisterInterface(pEngineMap);
 		m_pKernel->RegisterInterface(static_cast<IMap *>(pEngineMap), false);
 
@@ -310,3 +312,271 @@ TEST_F(CTestGameWorld, CharacterEmote)
 	pChr->Freeze(10);
 	ASSERT_EQ(pChr->DetermineEyeEmote(), EMOTE_ANGRY);
 }
+
+TEST_F(CTestGameWorld, GridQueriesMatchList)
+{
+	CGameWorld &World = GameServer()->m_World;
+	CPrng Prng;
+	uint64_t aSeed[2] = {3, 4};
+	Prng.Seed(aSeed);
+	auto RandomFloat = [&](float Min, float Max) {
+		return Min + (Max - Min) * (Prng.RandomBits() / (float)0xffffffffu);
+	};
+	// crowded spots, some of them outside of the map
+	auto RandomPos = [&]() {
+		const vec2 Center = vec2((int)(Prng.RandomBits() % 4) * 700.0f - 300.0f, (int)(Prng.RandomBits() % 3) * 500.0f - 200.0f);
+		return Center + vec2(RandomFloat(-400.0f, 400.0f), RandomFloat(-400.0f, 400.0f));
+	};
+
+	CNetObj_PlayerInput Input = {};
+	std::vector<CCharacter *> vpChrs;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CCharacter *pChr = new(i) CCharacter(&World, Input);
+		pChr->m_Pos = RandomPos();
+		World.InsertEntity(pChr);
+		vpChrs.push_back(pChr);
+	}
+
+	for(int Round = 0; Round < 20; Round++)
+	{
+		// moved outside of the world tick
+		for(CCharacter *pChr : vpChrs)
+			if(Prng.RandomBits() % 2)
+				pChr->m_Pos = RandomPos();
+		// some characters end up at the very same position
+		vpChrs[Round]->m_Pos = vpChrs[Round + 1]->m_Pos;
+
+		for(int Query = 0; Query < 200; Query++)
+		{
+			const vec2 Pos0 = RandomPos();
+			const vec2 Pos1 = Query % 2 ? RandomPos() : Pos0 + vec2(RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+			const float Radius = RandomFloat(0.0f, Query % 5 ? 150.0f : 1500.0f);
+			const CCharacter *pNotThis = vpChrs[Prng.RandomBits() % vpChrs.size()];
+
+			// reference results from walking the list
+			std::vector<CEntity *> vpExpected;
+			float ClosestRange = Radius * 2;
+			CEntity *pExpectedClosest = nullptr;
+			float ClosestLen = distance(Pos0, Pos1) * 100.0f;
+			CEntity *pExpectedIntersect = nullptr;
+			std::vector<CCharacter *> vpExpectedIntersected;
+			for(CEntity *pEnt = World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+			{
+				const float Len = distance(Pos0, pEnt->m_Pos);
+				if(Len < Radius + pEnt->GetProximityRadius())
+				{
+					vpExpected.push_back(pEnt);
+					if(pEnt != pNotThis && Len < ClosestRange)
+					{
+						ClosestRange = Len;
+						pExpectedClosest = pEnt;
+					}
+				}
+				vec2 IntersectPos;
+				if(pEnt != pNotThis && closest_point_on_line(Pos0, Pos1, pEnt->m_Pos, IntersectPos) && distance(pEnt->m_Pos, IntersectPos) < pEnt->GetProximityRadius() + Radius)
+				{
+					vpExpectedIntersected.push_back((CCharacter *)pEnt);
+					if(distance(Pos0, IntersectPos) < ClosestLen)
+					{
+						ClosestLen = distance(Pos0, IntersectPos);
+						pExpectedIntersect = pEnt;
+					}
+				}
+			}
+
+			CEntity *apEnts[MAX_CLIENTS];
+			const int Max = Query % 3 ? MAX_CLIENTS : 4;
+			const int Num = World.FindEntities(Pos0, Radius, apEnts, Max, CGameWorld::ENTTYPE_CHARACTER);
+			vpExpected.resize(minimum((int)vpExpected.size(), Max));
+			ASSERT_EQ(std::vector<CEntity *>(apEnts, apEnts + Num), vpExpected) << "Round=" << Round << " Query=" << Query;
+			EXPECT_EQ(World.ClosestCharacter(Pos0, Radius, pNotThis), pExpectedClosest);
+			vec2 NewPos;
+			EXPECT_EQ(World.IntersectCharacter(Pos0, Pos1, Radius, NewPos, pNotThis), pExpectedIntersect);
+			EXPECT_EQ(World.IntersectedCharacters(Pos0, Pos1, Radius, pNotThis), vpExpectedIntersected);
+		}
+	}
+}
+
+// only measures the time of a tick, run with --gtest_also_run_disabled_tests
+TEST_F(CTestGameWorld, DISABLED_TickBenchmark)
+{
+	const int NumCharacters = SERVER_MAX_CLIENTS;
+	const int NumProjectiles = 512;
+	const int NumTicks = 100;
+
+	CGameWorld &World = GameServer()->m_World;
+	const float Width = GameServer()->Collision()->GetWidth() * 32.0f;
+	const float Height = GameServer()->Collision()->GetHeight() * 32.0f;
+	CPrng Prng;
+	uint64_t aSeed[2] = {5, 6};
+	Prng.Seed(aSeed);
+	auto RandomPos = [&]() {
+		return vec2((Prng.RandomBits() % 1000) / 1000.0f * Width, (Prng.RandomBits() % 1000) / 1000.0f * Height);
+	};
+
+	for(int i = 0; i < NumCharacters; i++)
+	{
+		GameServer()->CreatePlayer(i, TEAM_GAME, false, -1);
+		ASSERT_NE(GameServer()->m_apPlayers[i]->ForceSpawn(RandomPos()), nullptr);
+	}
+
+	int64_t Duration = 0;
+	for(int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		// keep the number of projectiles up
+		int Num = 0;
+		for(CEntity *pEnt = World.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pEnt; pEnt = pEnt->TypeNext())
+			Num++;
+		for(; Num < NumProjectiles; Num++)
+		{
+			const vec2 Dir = direction((Prng.RandomBits() % 360) * pi / 180.0f);
+			const int Weapon = Num % 2 ? WEAPON_GUN : WEAPON_GRENADE;
+			new CProjectile(&World, Weapon, Num % NumCharacters, RandomPos(), Dir, 50, false, Weapon == WEAPON_GRENADE, -1, Dir);
+		}
+
+		const int64_t Start = time_get_nanoseconds().count();
+		World.Tick();
+		Duration += time_get_nanoseconds().count() - Start;
+	}
+	log_info("gameworld", "%d characters, %d projectiles: %.3f ms/tick", NumCharacters, NumProjectiles, Duration / 1e6 / NumTicks);
+}
+
+TEST_F(CTestGameWorld, ParallelSnapshots)
+{
+	const int NumClients = 16;
+	for(int i = 0; i < NumClients; i++)
+	{
+		GameServer()->CreatePlayer(i, TEAM_GAME, false, -1);
+		GameServer()->m_apPlayers[i]->ForceSpawn(vec2(100.0f + i * 40.0f, 100.0f));
+		m_pServer->m_aClients[i].m_State = CServer::CClient::STATE_INGAME;
+		m_pServer->m_aClients[i].m_SnapRate = CServer::CClient::SNAPRATE_FULL;
+		m_pServer->m_aClients[i].m_LastAckedSnapshot = -1;
+	}
+	m_pServer->Config()->m_SvHighBandwidth = 1;
+	// the first snapshot after spawning also has the spawn events
+	m_pServer->DoSnapshot();
+
+	// the same tick snapped on the main thread and by several workers
+	std::vector<std::vector<char>> avSnapshots[2];
+	const int aNumWorkers[2] = {1, 4};
+	for(int Run = 0; Run < 2; Run++)
+	{
+		m_pServer->Config()->m_SvSnapWorkers = aNumWorkers[Run];
+		for(int i = 0; i < NumClients; i++)
+			m_pServer->m_aClients[i].m_Snapshots.PurgeAll();
+		m_pServer->DoSnapshot();
+		for(int i = 0; i < NumClients; i++)
+		{
+			const CSnapshot *pSnapshot;
+			const int Size = m_pServer->m_aClients[i].m_Snapshots.Get(m_pServer->Tick(), nullptr, &pSnapshot, nullptr);
+			ASSERT_GT(Size, 0);
+			avSnapshots[Run].emplace_back((const char *)pSnapshot, (const char *)pSnapshot + Size);
+		}
+	}
+	EXPECT_EQ(avSnapshots[0], avSnapshots[1]);
+}
+
+TEST_F(CTestGameWorld, UnchangedSnapshots)
+{
+	const int NumClients = 4;
+	for(int i = 0; i < NumClients; i++)
+	{
+		GameServer()->CreatePlayer(i, TEAM_GAME, false, -1);
+		GameServer()->m_apPlayers[i]->ForceSpawn(vec2(100.0f + i * 40.0f, 100.0f));
+		m_pServer->m_aClients[i].m_State = CServer::CClient::STATE_INGAME;
+		m_pServer->m_aClients[i].m_SnapRate = CServer::CClient::SNAPRATE_FULL;
+		m_pServer->m_aClients[i].m_LastAckedSnapshot = -1;
+	}
+	m_pServer->Config()->m_SvHighBandwidth = 1;
+	// the first snapshot after spawning also has the spawn events
+	m_pServer->DoSnapshot();
+	for(int i = 0; i < NumClients; i++)
+		m_pServer->m_aClients[i].m_Snapshots.PurgeAll();
+	m_pServer->DoSnapshot();
+	EXPECT_EQ(m_pServer->m_NumSnapshotsUnchanged, 0);
+
+	// nothing happened since the acked snapshot
+	for(int i = 0; i < NumClients; i++)
+		m_pServer->m_aClients[i].m_LastAckedSnapshot = m_pServer->Tick();
+	const int64_t NumSent = m_pServer->m_NumSnapshotsSent;
+	m_pServer->DoSnapshot();
+	EXPECT_EQ(m_pServer->m_NumSnapshotsSent, NumSent + NumClients);
+	EXPECT_EQ(m_pServer->m_NumSnapshotsUnchanged, NumClients);
+
+	// a new projectile in view changes the snapshots again
+	new CProjectile(&GameServer()->m_World, WEAPON_GUN, 0, vec2(200.0f, 100.0f), vec2(1.0f, 0.0f), 50, false, false, -1, vec2(1.0f, 0.0f));
+	m_pServer->DoSnapshot();
+	EXPECT_EQ(m_pServer->m_NumSnapshotsUnchanged, NumClients);
+}
+
+TEST_F(CTestGameWorld, SnapCulling)
+{
+	const int NumClients = 16;
+	const int NumProjectiles = 512;
+
+	CGameWorld &World = GameServer()->m_World;
+	const float Width = GameServer()->Collision()->GetWidth() * 32.0f;
+	const float Height = GameServer()->Collision()->GetHeight() * 32.0f;
+	CPrng Prng;
+	uint64_t aSeed[2] = {7, 8};
+	Prng.Seed(aSeed);
+	auto RandomPos = [&]() {
+		return vec2((Prng.RandomBits() % 1000) / 1000.0f * Width, (Prng.RandomBits() % 1000) / 1000.0f * Height);
+	};
+
+	for(int i = 0; i < NumClients; i++)
+	{
+		GameServer()->CreatePlayer(i, TEAM_GAME, false, -1);
+		CPlayer *pPlayer = GameServer()->m_apPlayers[i];
+		ASSERT_NE(pPlayer->ForceSpawn(RandomPos()), nullptr);
+		pPlayer->m_ViewPos = pPlayer->GetCharacter()->m_Pos;
+		m_pServer->m_aClients[i].m_State = CServer::CClient::STATE_INGAME;
+		m_pServer->m_aClients[i].m_SnapRate = CServer::CClient::SNAPRATE_FULL;
+		m_pServer->m_aClients[i].m_LastAckedSnapshot = -1;
+	}
+	// views that aren't at the own character
+	GameServer()->m_apPlayers[0]->m_ShowAll = true;
+	GameServer()->m_apPlayers[1]->m_ViewPos = vec2(-5000.0f, -5000.0f);
+	GameServer()->m_apPlayers[2]->m_ViewPos = RandomPos();
+	GameServer()->m_apPlayers[2]->m_ShowDistance = vec2(3000.0f, 200.0f);
+
+	for(int i = 0; i < NumProjectiles; i++)
+	{
+		const vec2 Dir = direction((Prng.RandomBits() % 360) * pi / 180.0f);
+		const int Weapon = i % 2 ? WEAPON_GUN : WEAPON_GRENADE;
+		new CProjectile(&World, Weapon, i % NumClients, RandomPos(), Dir, 50, false, Weapon == WEAPON_GRENADE, -1, Dir);
+	}
+	m_pServer->Config()->m_SvHighBandwidth = 1;
+	m_pServer->DoSnapshot();
+
+	// the same tick snapped with and without culling
+	std::vector<std::vector<char>> avSnapshots[2];
+	CGameWorld::CSnapStats aStats[2];
+	for(int Culling = 0; Culling < 2; Culling++)
+	{
+		m_pServer->Config()->m_SvSnapCulling = Culling;
+		World.ResetSnapStats();
+		for(int i = 0; i < NumClients; i++)
+			m_pServer->m_aClients[i].m_Snapshots.PurgeAll();
+		m_pServer->DoSnapshot();
+		aStats[Culling] = World.SnapStats();
+		for(int i = 0; i < NumClients; i++)
+		{
+			const CSnapshot *pSnapshot;
+			const int Size = m_pServer->m_aClients[i].m_Snapshots.Get(m_pServer->Tick(), nullptr, &pSnapshot, nullptr);
+			ASSERT_GT(Size, 0);
+			avSnapshots[Culling].emplace_back((const char *)pSnapshot, (const char *)pSnapshot + Size);
+		}
+	}
+	EXPECT_EQ(avSnapshots[0], avSnapshots[1]);
+	EXPECT_EQ(aStats[0].m_NumEntities, aStats[1].m_NumEntities);
+	EXPECT_EQ(aStats[0].m_NumEmitted, aStats[1].m_NumEmitted);
+	// the test map is small, most of it is in view of every client
+	EXPECT_LT(aStats[1].m_NumVisited, aStats[0].m_NumVisited);
+	log_info("gameworld", "snap culling: %.1f entities, %.1f visited without and %.1f with culling, %.1f emitted",
+		aStats[1].m_NumEntities / (double)aStats[1].m_NumSnaps,
+		aStats[0].m_NumVisited / (double)aStats[0].m_NumSnaps,
+		aStats[1].m_NumVisited / (double)aStats[1].m_NumSnaps,
+		aStats[1].m_NumEmitted / (double)aStats[1].m_NumSnaps);
+}
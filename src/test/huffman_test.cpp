@@ -47,3 +47,55 @@ TEST(Huffman, CompressionCompatible)
 	EXPECT_EQ(match, 0) << "The compression is not compatible with older/other implementations anymore";
 	EXPECT_EQ(Size, 15);
 }
+
+TEST(Huffman, DecompressCompatible)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	const unsigned char aCompressed[] = {0x51, 0x58, 0x78, 0x76, 0x1B, 0xB7, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F, 0xc5, 0x0D};
+	unsigned char aExpected[64];
+	mem_zero(aExpected, sizeof(aExpected));
+	for(int i = 0; i < 8; i++)
+		aExpected[i] = i;
+
+	unsigned char aDecompressed[64];
+	ASSERT_EQ(Huffman.Decompress(aCompressed, sizeof(aCompressed), aDecompressed, sizeof(aDecompressed)), (int)sizeof(aExpected));
+	EXPECT_EQ(mem_comp(aDecompressed, aExpected, sizeof(aExpected)), 0);
+
+	// one byte too small
+	EXPECT_EQ(Huffman.Decompress(aCompressed, sizeof(aCompressed), aDecompressed, sizeof(aDecompressed) - 1), -1);
+}
+
+TEST(Huffman, RoundtripRandom)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	unsigned Seed = 1;
+	auto Rand = [&Seed]() {
+		Seed = Seed * 1103515245u + 12345u;
+		return Seed >> 8;
+	};
+
+	static unsigned char s_aInput[2048];
+	static unsigned char s_aCompressed[4096];
+	static unsigned char s_aDecompressed[2048];
+	for(int Round = 0; Round < 1000; Round++)
+	{
+		// from mostly zeros with short codes to random bytes with long ones
+		const int Size = Rand() % sizeof(s_aInput);
+		const unsigned RandomChance = 1 + Round % 10;
+		for(int i = 0; i < Size; i++)
+			s_aInput[i] = Rand() % RandomChance == 0 ? Rand() : 0;
+
+		const int CompressedSize = Huffman.Compress(s_aInput, Size, s_aCompressed, sizeof(s_aCompressed));
+		ASSERT_GT(CompressedSize, 0);
+		ASSERT_EQ(Huffman.Decompress(s_aCompressed, CompressedSize, s_aDecompressed, Size), Size);
+		ASSERT_EQ(mem_comp(s_aDecompressed, s_aInput, Size), 0);
+		if(Size > 0)
+		{
+			ASSERT_EQ(Huffman.Decompress(s_aCompressed, CompressedSize, s_aDecompressed, Size - 1), -1);
+		}
+	}
+}
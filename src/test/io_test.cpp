@@ -169,6 +169,38 @@ TEST(Io, WriteTruncatesFile)
 	EXPECT_FALSE(fs_remove(Info.m_aFilename));
 }
 
+TEST(Io, Map)
+{
+	CTestInfo Info;
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_write(File, "0123456789", 10), 10);
+	EXPECT_FALSE(io_close(File));
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_map(File, 0), nullptr);
+	char *pMapping = static_cast<char *>(io_map(File, 10));
+	EXPECT_FALSE(io_close(File));
+	ASSERT_NE(pMapping, nullptr);
+	EXPECT_TRUE(mem_comp(pMapping, "0123456789", 10) == 0);
+
+	// writes only change the mapping
+	pMapping[0] = 'A';
+	EXPECT_TRUE(mem_comp(pMapping, "A123456789", 10) == 0);
+	io_unmap(pMapping, 10);
+
+	char aBuf[16];
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_read(File, aBuf, sizeof(aBuf)), 10);
+	EXPECT_TRUE(mem_comp(aBuf, "0123456789", 10) == 0);
+	EXPECT_FALSE(io_close(File));
+
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
+
 TEST(Io, OpenFileShared)
 {
 	CTestInfo Info;
@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 
 #include <functional>
+#include <thread>
 
 static const int TEST_NUM_THREADS = 4;
 
@@ -45,6 +46,11 @@ public:
 	{
 		IJob::Abortable(Abortable);
 	}
+
+	void SetPriority(EJobPriority Priority)
+	{
+		IJob::SetPriority(Priority);
+	}
 };
 
 TEST_F(Jobs, Constructor)
@@ -164,3 +170,86 @@ TEST_F(Jobs, Many)
 	}
 	SetUp();
 }
+
+TEST(JobsPriority, HigherPriorityFirst)
+{
+	CJobPool Pool;
+	Pool.Init(1);
+
+	// block the only worker until all jobs are queued
+	SEMAPHORE sphore;
+	sphore_init(&sphore);
+	Pool.Add(std::make_shared<CJob>([&] { sphore_wait(&sphore); }));
+
+	std::vector<int> vOrder;
+	const IJob::EJobPriority aPriorities[] = {IJob::PRIORITY_LOW, IJob::PRIORITY_NORMAL, IJob::PRIORITY_HIGH, IJob::PRIORITY_LOW, IJob::PRIORITY_HIGH, IJob::PRIORITY_NORMAL};
+	std::vector<std::shared_ptr<CJob>> vpJobs;
+	for(int i = 0; i < (int)std::size(aPriorities); i++)
+	{
+		std::shared_ptr<CJob> pJob = std::make_shared<CJob>([&vOrder, i] { vOrder.push_back(i); });
+		pJob->SetPriority(aPriorities[i]);
+		EXPECT_EQ(pJob->Priority(), aPriorities[i]);
+		vpJobs.push_back(pJob);
+		Pool.Add(pJob);
+	}
+	sphore_signal(&sphore);
+	Pool.Shutdown();
+	sphore_destroy(&sphore);
+
+	// by priority, then in the order they were added
+	const std::vector<int> vExpected = {2, 4, 1, 5, 0, 3};
+	EXPECT_EQ(vOrder, vExpected);
+	for(const auto &pJob : vpJobs)
+	{
+		EXPECT_EQ(pJob->State(), IJob::STATE_DONE);
+	}
+}
+
+TEST_F(Jobs, Stress)
+{
+	// jobs that add more jobs from the workers, added from several threads
+	// at once with all priorities, so the workers have to steal from each other
+	static const int NUM_ADDING_THREADS = 4;
+	static const int NUM_ROOTS = 64;
+	static const int DEPTH = 6; // 2^DEPTH - 1 jobs per root
+
+	std::atomic<int> NumRun(0);
+	SEMAPHORE sphore;
+	sphore_init(&sphore);
+	const int NumTotal = NUM_ADDING_THREADS * NUM_ROOTS * ((1 << DEPTH) - 1);
+
+	std::function<std::shared_ptr<CJob>(int, int)> CreateJob = [&](int Depth, int Seed) {
+		std::shared_ptr<CJob> pJob = std::make_shared<CJob>([&, Depth, Seed] {
+			if(Depth > 1)
+			{
+				Add(CreateJob(Depth - 1, Seed * 3 + 1));
+				Add(CreateJob(Depth - 1, Seed * 3 + 2));
+			}
+			if(NumRun.fetch_add(1) + 1 == NumTotal)
+			{
+				sphore_signal(&sphore);
+			}
+		});
+		pJob->SetPriority((IJob::EJobPriority)(Seed % IJob::NUM_PRIORITIES));
+		return pJob;
+	};
+
+	std::vector<std::thread> vThreads;
+	for(int i = 0; i < NUM_ADDING_THREADS; i++)
+	{
+		vThreads.emplace_back([&, i] {
+			for(int j = 0; j < NUM_ROOTS; j++)
+			{
+				Add(CreateJob(DEPTH, i * NUM_ROOTS + j));
+			}
+		});
+	}
+	for(std::thread &Thread : vThreads)
+	{
+		Thread.join();
+	}
+
+	sphore_wait(&sphore);
+	sphore_destroy(&sphore);
+	EXPECT_EQ(NumRun.load(), NumTotal);
+}
@@ -1,8 +1,12 @@
 #include <base/system.h>
 
+#include <engine/shared/network.h>
+
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <iterator> // std::size
+#include <thread>
 
 using namespace std::chrono_literals;
 
@@ -52,3 +56,96 @@ TEST(Net, Ipv4AndIpv6Work)
 	net_udp_close(Socket1);
 	net_udp_close(Socket2);
 }
+
+TEST(Net, SendBatching)
+{
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand() % 64511 + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+
+	// same sized packets to the same address followed by a shorter one
+	// can be sent as a single segmented datagram
+	const int aSizes[] = {1000, 1000, 1000, 300, 1000, 7};
+	unsigned char aaData[std::size(aSizes)][1000];
+	net_udp_set_send_batching(Socket2, true);
+	for(int i = 0; i < (int)std::size(aSizes); i++)
+	{
+		mem_zero(aaData[i], sizeof(aaData[i]));
+		aaData[i][0] = i;
+		aaData[i][aSizes[i] - 1] = i;
+		EXPECT_EQ(net_udp_send(Socket2, &Target, aaData[i], aSizes[i]), aSizes[i]);
+	}
+	net_udp_flush(Socket2);
+
+	// all packets are received at once, the socket is only readable for the first one
+	EXPECT_EQ(net_socket_read_wait(Socket1, 10s), 1);
+	for(int i = 0; i < (int)std::size(aSizes); i++)
+	{
+		NETADDR Addr;
+		unsigned char *pData;
+		ASSERT_EQ(net_udp_recv(Socket1, &Addr, &pData), aSizes[i]);
+		EXPECT_EQ(mem_comp(pData, aaData[i], aSizes[i]), 0);
+	}
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
+
+TEST(Net, ClientRecvThread)
+{
+	NETADDR Bindaddr = {};
+	Bindaddr.type = NETTYPE_IPV4;
+	NETSOCKET Socket = net_udp_create(Bindaddr);
+	ASSERT_TRUE(Socket);
+
+	CNetClient Client;
+	do
+	{
+		Bindaddr.port = secure_rand() % 64511 + 1024;
+	} while(!Client.Open(Bindaddr, true));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+
+	const int64_t SendTime = time_get();
+	const char *apMessages[] = {"first", "second", "third"};
+	for(const char *pMessage : apMessages)
+	{
+		CNetBase::SendPacketConnless(Socket, &Target, pMessage, str_length(pMessage) + 1, false, nullptr);
+	}
+
+	// the packets are picked up by the receive thread in the background
+	const int64_t Timeout = time_get() + 10 * time_freq();
+	int Received = 0;
+	while(Received < (int)std::size(apMessages) && time_get() < Timeout)
+	{
+		CNetChunk Chunk;
+		SECURITY_TOKEN ResponseToken;
+		if(!Client.Recv(&Chunk, &ResponseToken, false))
+		{
+			std::this_thread::sleep_for(1ms);
+			continue;
+		}
+		EXPECT_EQ(Chunk.m_ClientId, -1);
+		EXPECT_STREQ((const char *)Chunk.m_pData, apMessages[Received]);
+		EXPECT_GE(Client.LastRecvTime(), SendTime);
+		EXPECT_LE(Client.LastRecvTime(), time_get());
+		Received++;
+	}
+	EXPECT_EQ(Received, (int)std::size(apMessages));
+
+	Client.Close();
+	net_udp_close(Socket);
+}
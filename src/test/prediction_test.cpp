@@ -0,0 +1,316 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/client/prediction/prediction_cache.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapbugs.h>
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+class CPredictionTest : public ::testing::Test
+{
+protected:
+	enum
+	{
+		LOCAL_ID = 0,
+		DUMMY_ID = 1,
+		NUM_CHARACTERS = 2,
+	};
+
+	struct CInputs
+	{
+		CNetObj_PlayerInput m_aInputs[NUM_CHARACTERS];
+	};
+
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IKernel> m_pKernel;
+	std::unique_ptr<IStorage> m_pStorage;
+	IEngineMap *m_pMap = nullptr;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CTuningParams m_aTuningList[TuneZone::NUM];
+	CMapBugs m_MapBugs;
+
+	// the world of the last snapshot, the parent of the predicted worlds
+	CGameWorld m_GameWorld;
+	std::vector<CInputs> m_vInputs;
+	CPrng m_Prng;
+
+	void SetUp() override
+	{
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		ASSERT_NE(m_pStorage, nullptr);
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+		m_pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(m_pMap);
+		ASSERT_TRUE(m_pMap->Load("maps/coverage.map"));
+		m_Layers.Init(m_pMap, true);
+		m_Collision.Init(&m_Layers);
+
+		InitWorld(&m_GameWorld);
+		m_GameWorld.m_GameTick = 0;
+		m_GameWorld.NetObjBegin(CTeamsCore(), LOCAL_ID);
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CNetObj_Character Char = {};
+			Char.m_X = 32 * 5 + i * 64;
+			Char.m_Y = 32 * 5;
+			Char.m_HookedPlayer = -1;
+			Char.m_Weapon = WEAPON_GUN;
+			m_GameWorld.NetCharAdd(i, &Char, nullptr, 0, i == LOCAL_ID);
+		}
+		m_GameWorld.NetObjEnd();
+		ASSERT_NE(m_GameWorld.GetCharacterById(LOCAL_ID), nullptr);
+		ASSERT_NE(m_GameWorld.GetCharacterById(DUMMY_ID), nullptr);
+
+		uint64_t aSeed[2] = {1, 2};
+		m_Prng.Seed(aSeed);
+		m_vInputs.resize(600);
+		for(auto &Inputs : m_vInputs)
+			for(auto &Input : Inputs.m_aInputs)
+				Input = RandomInput();
+	}
+
+	void TearDown() override
+	{
+		m_GameWorld.Clear();
+		m_Collision.Unload();
+		if(m_pMap)
+			m_pMap->Unload();
+	}
+
+	void InitWorld(CGameWorld *pWorld)
+	{
+		pWorld->Init(&m_Collision, m_aTuningList, &m_MapBugs);
+		pWorld->m_WorldConfig = {};
+		pWorld->m_WorldConfig.m_IsDDRace = true;
+		pWorld->m_WorldConfig.m_InfiniteAmmo = true;
+		pWorld->m_WorldConfig.m_PredictTiles = true;
+		pWorld->m_WorldConfig.m_PredictWeapons = true;
+		pWorld->m_WorldConfig.m_PredictDDRace = true;
+		pWorld->m_WorldConfig.m_UseTuneZones = true;
+	}
+
+	CNetObj_PlayerInput RandomInput()
+	{
+		CNetObj_PlayerInput Input = {};
+		Input.m_Direction = (int)(m_Prng.RandomBits() % 3) - 1;
+		Input.m_TargetX = (int)(m_Prng.RandomBits() % 200) - 100;
+		Input.m_TargetY = (int)(m_Prng.RandomBits() % 200) - 100;
+		Input.m_Jump = m_Prng.RandomBits() % 4 == 0;
+		Input.m_Hook = m_Prng.RandomBits() % 3 == 0;
+		Input.m_Fire = m_Prng.RandomBits() % 8 == 0 ? 1 : 0;
+		return Input;
+	}
+
+	void GetTickInput(int Tick, CPredictionCache::CTickInput *pInput)
+	{
+		pInput->m_pInput = &m_vInputs[Tick].m_aInputs[LOCAL_ID];
+		pInput->m_pDummyInput = &m_vInputs[Tick].m_aInputs[DUMMY_ID];
+	}
+
+	// one tick of the prediction loop in CGameClient::OnNewSnapshot/OnPredict
+	void PredictTick(CGameWorld *pWorld, int Tick)
+	{
+		CCharacter *apChars[NUM_CHARACTERS];
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+			apChars[i] = pWorld->GetCharacterById(i);
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+			if(apChars[i])
+				apChars[i]->OnDirectInput(&m_vInputs[Tick].m_aInputs[i]);
+		pWorld->m_GameTick = Tick;
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+			if(apChars[i])
+				apChars[i]->OnPredictedInput(&m_vInputs[Tick].m_aInputs[i]);
+		pWorld->Tick();
+	}
+};
+
+TEST_F(CPredictionTest, SameState)
+{
+	for(int Tick = 1; Tick <= 20; Tick++)
+		PredictTick(&m_GameWorld, Tick);
+
+	CGameWorld Copy;
+	Copy.CopyWorld(&m_GameWorld);
+	EXPECT_TRUE(Copy.SameState(&m_GameWorld));
+
+	CCharacterCore Core = Copy.GetCharacterById(DUMMY_ID)->GetCore();
+	Core.m_Vel.x += 1.0f;
+	Copy.GetCharacterById(DUMMY_ID)->SetCore(Core);
+	EXPECT_FALSE(Copy.SameState(&m_GameWorld));
+	Copy.CopyWorld(&m_GameWorld);
+	Copy.GetCharacterById(LOCAL_ID)->m_CanMoveInFreeze = !Copy.GetCharacterById(LOCAL_ID)->m_CanMoveInFreeze;
+	EXPECT_FALSE(Copy.SameState(&m_GameWorld));
+	Copy.CopyWorld(&m_GameWorld);
+	Core = Copy.GetCharacterById(LOCAL_ID)->GetCore();
+	Core.m_Input.m_Direction ^= 1;
+	Copy.GetCharacterById(LOCAL_ID)->SetCore(Core);
+	EXPECT_FALSE(Copy.SameState(&m_GameWorld));
+	Copy.CopyWorld(&m_GameWorld);
+	Copy.m_WorldConfig.m_PredictFreeze++;
+	EXPECT_FALSE(Copy.SameState(&m_GameWorld));
+	Copy.CopyWorld(&m_GameWorld);
+	Copy.m_GameTick++;
+	EXPECT_FALSE(Copy.SameState(&m_GameWorld));
+	Copy.CopyWorld(&m_GameWorld);
+	Copy.GetCharacterById(DUMMY_ID)->Destroy();
+	EXPECT_FALSE(Copy.SameState(&m_GameWorld));
+
+	// ticking both worlds the same way keeps them in the same state
+	Copy.CopyWorld(&m_GameWorld);
+	for(int Tick = 21; Tick <= 40; Tick++)
+	{
+		PredictTick(&Copy, Tick);
+		PredictTick(&m_GameWorld, Tick);
+	}
+	EXPECT_TRUE(Copy.SameState(&m_GameWorld));
+}
+
+TEST_F(CPredictionTest, CopyWorldDetached)
+{
+	CGameWorld Predicted;
+	Predicted.CopyWorld(&m_GameWorld);
+	for(int Tick = 1; Tick <= 10; Tick++)
+		PredictTick(&Predicted, Tick);
+
+	CGameWorld Detached;
+	Detached.CopyWorldDetached(&Predicted);
+	EXPECT_TRUE(Detached.SameState(&Predicted));
+	EXPECT_FALSE(Detached.m_IsValidCopy);
+	EXPECT_EQ(Predicted.m_pChild, nullptr);
+	for(int i = 0; i < NUM_CHARACTERS; i++)
+	{
+		const CCharacter *pChar = Detached.GetCharacterById(i);
+		ASSERT_NE(pChar, nullptr);
+		EXPECT_EQ(pChar->m_pParent, nullptr);
+		EXPECT_EQ(pChar->m_pChild, nullptr);
+		// the predicted world keeps its links to the snapshot
+		EXPECT_EQ(Predicted.GetCharacterById(i)->m_pParent, m_GameWorld.GetCharacterById(i));
+		EXPECT_EQ(Predicted.GetCharacterById(i)->m_pChild, nullptr);
+	}
+}
+
+TEST_F(CPredictionTest, ResumeWorld)
+{
+	CGameWorld Predicted;
+	Predicted.CopyWorld(&m_GameWorld);
+	for(int Tick = 1; Tick <= 10; Tick++)
+		PredictTick(&Predicted, Tick);
+	CGameWorld Cached;
+	Cached.CopyWorldDetached(&Predicted);
+
+	CGameWorld Resumed;
+	Resumed.ResumeWorld(&Cached, &m_GameWorld);
+	EXPECT_TRUE(Resumed.SameState(&Predicted));
+	EXPECT_TRUE(Resumed.m_IsValidCopy);
+	EXPECT_EQ(Resumed.m_pParent, &m_GameWorld);
+	EXPECT_EQ(m_GameWorld.m_pChild, &Resumed);
+	EXPECT_FALSE(Predicted.m_IsValidCopy);
+	for(int i = 0; i < NUM_CHARACTERS; i++)
+	{
+		CCharacter *pChar = Resumed.GetCharacterById(i);
+		ASSERT_NE(pChar, nullptr);
+		EXPECT_EQ(pChar->m_pParent, m_GameWorld.GetCharacterById(i));
+		EXPECT_EQ(m_GameWorld.GetCharacterById(i)->m_pChild, pChar);
+		EXPECT_EQ(Cached.GetCharacterById(i)->m_pParent, nullptr);
+	}
+}
+
+TEST_F(CPredictionTest, TickKey)
+{
+	CPredictionCache::CTickInput Input;
+	GetTickInput(5, &Input);
+	const uint64_t Key = CPredictionCache::TickKey(1, 5, Input);
+	EXPECT_EQ(CPredictionCache::TickKey(1, 5, Input), Key);
+	EXPECT_NE(CPredictionCache::TickKey(2, 5, Input), Key);
+	EXPECT_NE(CPredictionCache::TickKey(1, 6, Input), Key);
+
+	CPredictionCache::CTickInput Changed = Input;
+	Changed.m_CanMoveInFreeze = true;
+	EXPECT_NE(CPredictionCache::TickKey(1, 5, Changed), Key);
+
+	CNetObj_PlayerInput DummyInput = *Input.m_pDummyInput;
+	DummyInput.m_Jump ^= 1;
+	Changed = Input;
+	Changed.m_pDummyInput = &DummyInput;
+	EXPECT_NE(CPredictionCache::TickKey(1, 5, Changed), Key);
+	Changed.m_pDummyInput = nullptr;
+	EXPECT_NE(CPredictionCache::TickKey(1, 5, Changed), Key);
+
+	CNetMsg_Sv_PreInput PreInput = {};
+	PreInput.m_IntendedTick = 5;
+	Changed = Input;
+	Changed.m_apPreInputs[3] = &PreInput;
+	EXPECT_NE(CPredictionCache::TickKey(1, 5, Changed), Key);
+}
+
+TEST_F(CPredictionTest, IncrementalPrediction)
+{
+	std::unique_ptr<CPredictionCache> pCache = std::make_unique<CPredictionCache>();
+	CGameWorld Full;
+	CGameWorld Incremental;
+	int BaseSerial = 0;
+	int NumFullTicks = 0;
+	int NumIncrementalTicks = 0;
+	int NumResumed = 0;
+	for(int Frame = 0; Frame < 300; Frame++)
+	{
+		// a new snapshot every few frames
+		if(Frame % 3 == 0)
+		{
+			PredictTick(&m_GameWorld, m_GameWorld.GameTick() + 1);
+			BaseSerial++;
+		}
+		const int BaseTick = m_GameWorld.GameTick();
+		const int FinalTick = BaseTick + 10 + Frame % 3;
+		// inputs that are not confirmed yet may still change
+		if(Frame % 7 == 0)
+			m_vInputs[FinalTick - 1 - Frame % 5].m_aInputs[Frame % 2] = RandomInput();
+
+		Full.CopyWorld(&m_GameWorld);
+		for(int Tick = BaseTick + 1; Tick <= FinalTick; Tick++)
+		{
+			PredictTick(&Full, Tick);
+			NumFullTicks++;
+		}
+
+		Incremental.CopyWorld(&m_GameWorld);
+		const uint64_t BaseIdentity = CPredictionCache::CRing::ChainKey(CPredictionCache::CRing::EMPTY_KEY, BaseSerial);
+		const int FirstTick = pCache->Begin(&Incremental, &m_GameWorld, BaseIdentity, BaseTick + 1, FinalTick - 1, LOCAL_ID, DUMMY_ID, [&](int Tick, CPredictionCache::CTickInput *pInput) {
+			GetTickInput(Tick, pInput);
+		});
+		if(FirstTick > BaseTick + 1)
+		{
+			NumResumed++;
+			EXPECT_EQ(Incremental.m_pParent, &m_GameWorld);
+			EXPECT_EQ(Incremental.GetCharacterById(LOCAL_ID)->m_pParent, m_GameWorld.GetCharacterById(LOCAL_ID));
+		}
+		for(int Tick = FirstTick; Tick <= FinalTick; Tick++)
+		{
+			PredictTick(&Incremental, Tick);
+			NumIncrementalTicks++;
+			CPredictionCache::CTickInput TickInput;
+			GetTickInput(Tick, &TickInput);
+			pCache->Store(Tick, &Incremental, TickInput);
+		}
+
+		ASSERT_TRUE(Full.SameState(&Incremental)) << "Frame=" << Frame;
+	}
+	EXPECT_GT(NumResumed, 0);
+	EXPECT_LT(NumIncrementalTicks, NumFullTicks / 2);
+}
@@ -1,4 +1,6 @@
 #include <base/detect.h>
+#include <base/math.h>
+#include <base/system.h>
 
 #include <engine/server/databases/connection.h>
 #include <engine/server/databases/connection_pool.h>
@@ -10,6 +12,11 @@
 #include <gtest/gtest.h>
 #include <sqlite3.h>
 
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
 #if defined(CONF_TEST_MYSQL)
 int DummyMysqlInit = (MysqlInit(), 1);
 #endif
@@ -261,6 +268,185 @@ TEST_P(SingleScore, TimesDoesntExist)
 	ExpectLines(m_pPlayerResult, {"There are no times in the specified range"});
 }
 
+struct Leaderboard : public Score
+{
+	Leaderboard()
+	{
+		str_copy(m_PlayerRequest.m_aMap, "Kobra 3", sizeof(m_PlayerRequest.m_aMap));
+		str_copy(m_PlayerRequest.m_aRequestingPlayer, "brainless tee", sizeof(m_PlayerRequest.m_aRequestingPlayer));
+		str_copy(m_PlayerRequest.m_aServer, "GER", sizeof(m_PlayerRequest.m_aServer));
+		InsertFinish("nameless tee", 100.0f, "USA");
+		InsertFinish("brainless tee", 95.0f, "GER");
+		InsertFinish("brainless tee", 90.5f, "USA");
+		InsertFinish("tee", 100.0f, "GER2");
+		InsertFinish("Tee", 123.45f, "USA");
+		InsertFinish("faster tee", 12.34f, "GER");
+	}
+
+	void InsertFinish(const char *pName, float Time, const char *pServer)
+	{
+		str_copy(g_Config.m_SvSqlServerName, pServer, sizeof(g_Config.m_SvSqlServerName));
+		CSqlScoreData ScoreData(std::make_shared<CScorePlayerResult>());
+		str_copy(ScoreData.m_aMap, "Kobra 3", sizeof(ScoreData.m_aMap));
+		str_copy(ScoreData.m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320", sizeof(ScoreData.m_aGameUuid));
+		str_copy(ScoreData.m_aName, pName, sizeof(ScoreData.m_aName));
+		ScoreData.m_ClientId = 0;
+		ScoreData.m_Time = Time;
+		str_copy(ScoreData.m_aTimestamp, "2021-11-24 19:24:08", sizeof(ScoreData.m_aTimestamp));
+		for(float &TimeCp : ScoreData.m_aCurrentTimeCp)
+			TimeCp = 0;
+		ASSERT_TRUE(CScoreWorker::SaveScore(m_pConn, &ScoreData, Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	}
+
+	void LoadLeaderboard()
+	{
+		CSqlLeaderboardRequest Request(m_pLeaderboard);
+		str_copy(Request.m_aMap, "Kobra 3", sizeof(Request.m_aMap));
+		str_copy(Request.m_aServer, m_PlayerRequest.m_aServer, sizeof(Request.m_aServer));
+		ASSERT_TRUE(CScoreWorker::LoadLeaderboard(m_pConn, &Request, m_aError, sizeof(m_aError))) << m_aError;
+	}
+
+	void ExpectSameLines(
+		bool (*pSqlFunc)(IDbConnection *, const ISqlData *, char *pError, int ErrorSize),
+		void (*pLeaderboardFunc)(const CScoreLeaderboardResult *, const CSqlPlayerRequest *, CScorePlayerResult *))
+	{
+		m_pPlayerResult->SetVariant(CScorePlayerResult::DIRECT);
+		ASSERT_TRUE(pSqlFunc(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+		CScorePlayerResult Result;
+		pLeaderboardFunc(m_pLeaderboard.get(), &m_PlayerRequest, &Result);
+
+		EXPECT_EQ(Result.m_MessageKind, m_pPlayerResult->m_MessageKind);
+		for(int i = 0; i < CScorePlayerResult::MAX_MESSAGES; i++)
+		{
+			EXPECT_STREQ(Result.m_Data.m_aaMessages[i], m_pPlayerResult->m_Data.m_aaMessages[i]) << "name=" << m_PlayerRequest.m_aName << " offset=" << m_PlayerRequest.m_Offset;
+		}
+	}
+
+	std::shared_ptr<CScoreLeaderboardResult> m_pLeaderboard{std::make_shared<CScoreLeaderboardResult>()};
+};
+
+TEST_P(Leaderboard, Rank)
+{
+	LoadLeaderboard();
+	for(bool Regional : {false, true})
+	{
+		g_Config.m_SvRegionalRankings = Regional;
+		for(const char *pName : {"nameless tee", "brainless tee", "tee", "Tee", "faster tee", "foo"})
+		{
+			str_copy(m_PlayerRequest.m_aName, pName, sizeof(m_PlayerRequest.m_aName));
+			ExpectSameLines(CScoreWorker::ShowRank, CScoreWorker::ShowRank);
+		}
+	}
+
+	g_Config.m_SvRegionalRankings = true;
+	str_copy(m_PlayerRequest.m_aName, "brainless tee", sizeof(m_PlayerRequest.m_aName));
+	CScorePlayerResult Result;
+	CScoreWorker::ShowRank(m_pLeaderboard.get(), &m_PlayerRequest, &Result);
+	EXPECT_STREQ(Result.m_Data.m_aaMessages[0], "brainless tee - 01:30.50 - better than 75%");
+	EXPECT_STREQ(Result.m_Data.m_aaMessages[1], "Global rank 2 - GER rank 2");
+}
+
+TEST_P(Leaderboard, Top)
+{
+	LoadLeaderboard();
+	for(bool Regional : {false, true})
+	{
+		g_Config.m_SvRegionalRankings = Regional;
+		for(int Offset : {0, 1, 2, 4, 6})
+		{
+			m_PlayerRequest.m_Offset = Offset;
+			ExpectSameLines(CScoreWorker::ShowTop, CScoreWorker::ShowTop);
+		}
+	}
+
+	// the databases don't define the order of tied times when sorting descending
+	InsertFinish("tee", 99.0f, "GER2");
+	m_pLeaderboard->AddFinish("tee", 99.0f);
+	for(bool Regional : {false, true})
+	{
+		g_Config.m_SvRegionalRankings = Regional;
+		for(int Offset : {-1, -3})
+		{
+			m_PlayerRequest.m_Offset = Offset;
+			ExpectSameLines(CScoreWorker::ShowTop, CScoreWorker::ShowTop);
+		}
+	}
+}
+
+TEST_P(Leaderboard, AddFinish)
+{
+	LoadLeaderboard();
+	const struct
+	{
+		const char *m_pName;
+		float m_Time;
+	} aFinishes[] = {{"Tee", 95.123f}, {"new tee", 100.0f}, {"nameless tee", 101.0f}, {"faster tee", 1.005f}};
+	for(const auto &Finish : aFinishes)
+	{
+		InsertFinish(Finish.m_pName, Finish.m_Time, "GER");
+		m_pLeaderboard->AddFinish(Finish.m_pName, Finish.m_Time);
+	}
+
+	g_Config.m_SvRegionalRankings = true;
+	for(const char *pName : {"nameless tee", "Tee", "new tee", "faster tee"})
+	{
+		str_copy(m_PlayerRequest.m_aName, pName, sizeof(m_PlayerRequest.m_aName));
+		ExpectSameLines(CScoreWorker::ShowRank, CScoreWorker::ShowRank);
+	}
+	m_PlayerRequest.m_Offset = 1;
+	ExpectSameLines(CScoreWorker::ShowTop, CScoreWorker::ShowTop);
+}
+
+TEST(LeaderboardTree, ManyFinishes)
+{
+	// compares against sorting all best times after every finish
+	CLeaderboard Leaderboard;
+	std::map<std::string, float> BestTimes;
+	std::vector<CLeaderboard::CEntry> vLoad;
+	for(int i = 0; i < 200; i++)
+	{
+		char aName[16];
+		str_format(aName, sizeof(aName), "tee%d", i % 150);
+		const float Time = 10.0f + (i * 7919 % 97) / 4.0f;
+		vLoad.push_back({Time, aName});
+		auto [It, Inserted] = BestTimes.emplace(aName, Time);
+		if(!Inserted)
+			It->second = minimum(It->second, Time);
+	}
+	Leaderboard.Load(std::move(vLoad));
+
+	for(int i = 0; i < 500; i++)
+	{
+		char aName[16];
+		str_format(aName, sizeof(aName), "tee%d", i * 31 % 300);
+		const float Time = 5.0f + (i * 104729 % 89) / 4.0f;
+		Leaderboard.Add(aName, Time);
+		auto [It, Inserted] = BestTimes.emplace(aName, Time);
+		if(!Inserted)
+			It->second = minimum(It->second, Time);
+
+		std::vector<CLeaderboard::CEntry> vExpected;
+		for(const auto &[Name, BestTime] : BestTimes)
+			vExpected.push_back({BestTime, Name});
+		std::sort(vExpected.begin(), vExpected.end());
+		ASSERT_EQ(Leaderboard.Size(), (int)vExpected.size());
+		for(int Index = 0; Index < (int)vExpected.size(); Index += 17)
+		{
+			EXPECT_EQ(Leaderboard.Entry(Index).m_Name, vExpected[Index].m_Name);
+			EXPECT_EQ(Leaderboard.Entry(Index).m_Time, vExpected[Index].m_Time);
+			int Rank = Index;
+			while(Rank > 0 && vExpected[Rank - 1].m_Time == vExpected[Index].m_Time)
+				Rank--;
+			EXPECT_EQ(Leaderboard.EntryRank(Index), Rank + 1);
+			std::optional<CLeaderboard::CRank> PlayerRank = Leaderboard.Rank(vExpected[Index].m_Name.c_str());
+			ASSERT_TRUE(PlayerRank.has_value());
+			EXPECT_EQ(PlayerRank->m_Rank, Rank + 1);
+			EXPECT_EQ(PlayerRank->m_Time, vExpected[Index].m_Time);
+		}
+	}
+	EXPECT_FALSE(Leaderboard.Rank("nobody").has_value());
+}
+
 struct TeamScore : public Score
 {
 	void SetUp() override
@@ -658,6 +844,7 @@ auto g_TestValues{
 		})
 
 INSTANTIATE(SingleScore);
+INSTANTIATE(Leaderboard);
 INSTANTIATE(TeamScore);
 INSTANTIATE(MapInfo);
 INSTANTIATE(MapVote);
@@ -1,5 +1,7 @@
+#include <base/math.h>
 #include <base/system.h>
 
+#include <engine/shared/compression.h>
 #include <engine/shared/snapshot.h>
 
 #include <generated/protocol.h>
@@ -85,3 +87,166 @@ TEST(Snapshot, CrcOverflow)
 
 	ASSERT_EQ(pSnapshot->Crc(), 1);
 }
+
+TEST(Snapshot, StorageAddGetPurge)
+{
+	CSnapshotStorage Storage;
+	static char s_aData[CSnapshot::MAX_SIZE];
+	static char s_aAltData[CSnapshot::MAX_SIZE];
+
+	// sizes mix small snapshots with ones that don't fit into a block twice
+	auto SnapSize = [](int Tick) { return Tick % 7 == 0 ? (int)CSnapshot::MAX_SIZE : 64 + (Tick * 97) % 4000; };
+	auto AltSnapSize = [](int Tick) { return Tick % 3 == 0 ? 0 : (Tick % 11 == 0 ? (int)CSnapshot::MAX_SIZE : 32 + Tick % 500); };
+
+	for(int Tick = 1; Tick <= 500; Tick++)
+	{
+		mem_zero(s_aData, sizeof(s_aData));
+		mem_zero(s_aAltData, sizeof(s_aAltData));
+		s_aData[0] = s_aData[SnapSize(Tick) - 1] = Tick;
+		if(AltSnapSize(Tick))
+			s_aAltData[0] = s_aAltData[AltSnapSize(Tick) - 1] = -Tick;
+		Storage.Add(Tick, Tick * 1000, SnapSize(Tick), s_aData, AltSnapSize(Tick), s_aAltData);
+
+		// keep a window of snapshots like the client and the server do
+		if(Tick % 5 == 0)
+			Storage.PurgeUntil(Tick - 20);
+
+		for(int Check = maximum(1, Tick - 15); Check <= Tick; Check++)
+		{
+			int64_t Tagtime;
+			const CSnapshot *pSnap;
+			const CSnapshot *pAltSnap;
+			ASSERT_EQ(Storage.Get(Check, &Tagtime, &pSnap, &pAltSnap), SnapSize(Check));
+			EXPECT_EQ(Tagtime, Check * 1000);
+			EXPECT_EQ(((const char *)pSnap)[0], (char)Check);
+			EXPECT_EQ(((const char *)pSnap)[SnapSize(Check) - 1], (char)Check);
+			if(AltSnapSize(Check))
+			{
+				ASSERT_NE(pAltSnap, nullptr);
+				EXPECT_EQ(((const char *)pAltSnap)[0], (char)-Check);
+				EXPECT_EQ(((const char *)pAltSnap)[AltSnapSize(Check) - 1], (char)-Check);
+			}
+			else
+			{
+				EXPECT_EQ(pAltSnap, nullptr);
+			}
+		}
+	}
+
+	Storage.PurgeUntil(490);
+	EXPECT_EQ(Storage.Get(489, nullptr, nullptr, nullptr), -1);
+	EXPECT_EQ(Storage.m_pFirst->m_Tick, 490);
+	EXPECT_EQ(Storage.m_pLast->m_Tick, 500);
+
+	Storage.PurgeAll();
+	EXPECT_EQ(Storage.m_pFirst, nullptr);
+	EXPECT_EQ(Storage.Get(500, nullptr, nullptr, nullptr), -1);
+	Storage.Add(1, 0, 4, s_aData, 0, nullptr);
+	EXPECT_EQ(Storage.Get(1, nullptr, nullptr, nullptr), 4);
+}
+
+static int BuildRandomSnapshot(CSnapshot *pSnapshot, unsigned *pSeed, int NumItems)
+{
+	auto Rand = [pSeed]() {
+		*pSeed = *pSeed * 1103515245u + 12345u;
+		return *pSeed >> 8;
+	};
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	for(int i = 0; i < NumItems; i++)
+	{
+		// few distinct keys, so consecutive snapshots share most items
+		const int Size = 1 + i % 19;
+		int *pData = (int *)Builder.NewItem(1 + i % 7, i, Size * sizeof(int32_t));
+		if(!pData)
+			break;
+		for(int j = 0; j < Size; j++)
+			pData[j] = Rand() % 4 == 0 ? (int)(Rand() << (Rand() % 24)) - (int)Rand() : j;
+	}
+	return Builder.Finish(pSnapshot);
+}
+
+TEST(Snapshot, DiffItem)
+{
+	for(int Size = 0; Size < 20; Size++)
+	{
+		int aPast[20];
+		int aCurrent[20];
+		int aOut[20];
+		for(int i = 0; i < Size; i++)
+		{
+			aPast[i] = i * 12345;
+			aCurrent[i] = aPast[i];
+		}
+		EXPECT_EQ(CSnapshotDelta::DiffItem(aPast, aCurrent, aOut, Size), 0);
+		for(int i = 0; i < Size; i++)
+			EXPECT_EQ(aOut[i], 0);
+
+		for(int Changed = 0; Changed < Size; Changed++)
+		{
+			aCurrent[Changed] = aPast[Changed] - 1;
+			EXPECT_EQ(CSnapshotDelta::DiffItem(aPast, aCurrent, aOut, Size), -1);
+			EXPECT_EQ(aOut[Changed], -1);
+			aCurrent[Changed] = aPast[Changed];
+		}
+	}
+}
+
+TEST(Snapshot, DeltaRoundtrip)
+{
+	static char s_aFrom[CSnapshot::MAX_SIZE];
+	static char s_aTo[CSnapshot::MAX_SIZE];
+	static char s_aDelta[CSnapshot::MAX_SIZE * 2];
+	static char s_aUnpacked[CSnapshot::MAX_SIZE];
+	CSnapshot *pFrom = (CSnapshot *)s_aFrom;
+	CSnapshot *pTo = (CSnapshot *)s_aTo;
+	CSnapshot *pUnpacked = (CSnapshot *)s_aUnpacked;
+
+	CSnapshotDelta Delta;
+	unsigned Seed = 1;
+	BuildRandomSnapshot(pFrom, &Seed, 50);
+	for(int Round = 0; Round < 40; Round++)
+	{
+		const int ToSize = BuildRandomSnapshot(pTo, &Seed, 30 + (Round * 37) % 120);
+		const int DeltaSize = Delta.CreateDelta(pFrom, pTo, s_aDelta);
+		ASSERT_GT(DeltaSize, 0);
+		ASSERT_EQ(Delta.UnpackDelta(pFrom, pUnpacked, s_aDelta, DeltaSize, false), ToSize);
+		ASSERT_EQ(mem_comp(pUnpacked, pTo, ToSize), 0);
+		mem_copy(pFrom, pTo, ToSize);
+	}
+
+	// unchanged snapshots need no delta
+	EXPECT_EQ(Delta.CreateDelta(pFrom, pFrom, s_aDelta), 0);
+}
+
+TEST(Snapshot, DeltaDataRate)
+{
+	static char s_aTo[CSnapshot::MAX_SIZE];
+	static char s_aDelta[CSnapshot::MAX_SIZE];
+	static char s_aUnpacked[CSnapshot::MAX_SIZE];
+
+	const int aValues[] = {0, 1, -1, 63, 64, -64, -65, 8191, 8192, (1 << 20) - 1, 1 << 20, (1 << 27) - 1, 1 << 27, 2147483647, -2147483647 - 1};
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	int *pData = (int *)Builder.NewItem(100, 0, sizeof(aValues));
+	mem_copy(pData, aValues, sizeof(aValues));
+	const int ToSize = Builder.Finish(s_aTo);
+
+	// the delta against an empty item holds the values themselves
+	Builder.Init();
+	Builder.NewItem(100, 0, sizeof(aValues));
+	char aFrom[CSnapshot::MAX_SIZE];
+	Builder.Finish(aFrom);
+
+	CSnapshotDelta Delta;
+	const int DeltaSize = Delta.CreateDelta((CSnapshot *)aFrom, (CSnapshot *)s_aTo, s_aDelta);
+	ASSERT_EQ(Delta.UnpackDelta((CSnapshot *)aFrom, (CSnapshot *)s_aUnpacked, s_aDelta, DeltaSize, false), ToSize);
+
+	uint64_t Expected = 0;
+	for(int Value : aValues)
+	{
+		unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
+		Expected += Value == 0 ? 1 : (CVariableInt::Pack(aBuf, Value, sizeof(aBuf)) - aBuf) * 8;
+	}
+	EXPECT_EQ(Delta.GetDataRate(100), Expected);
+}
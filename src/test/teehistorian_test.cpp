@@ -1,14 +1,19 @@
+#include "test.h"
+
 #include <base/detect.h>
 
 #include <engine/external/json-parser/json.h>
 #include <engine/server.h>
 #include <engine/shared/config.h>
+#include <engine/shared/teehistorian_ex.h>
+#include <engine/shared/teehistorian_file.h>
 
 #include <game/gamecore.h>
 #include <game/server/teehistorian.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
 void RegisterGameUuids(CUuidManager *pManager);
@@ -23,6 +28,7 @@ protected:
 	CTeeHistorian::CGameInfo m_GameInfo;
 
 	std::vector<unsigned char> m_vBuffer;
+	CTeeHistorianWriter *m_pWriter = nullptr;
 
 	enum
 	{
@@ -95,6 +101,8 @@ protected:
 	{
 		TeeHistorian *pThis = (TeeHistorian *)pUser;
 		WriteBuffer(pThis->m_vBuffer, pData, DataSize);
+		if(pThis->m_pWriter)
+			pThis->m_pWriter->Write(pData, DataSize);
 	}
 
 	void Reset(const CTeeHistorian::CGameInfo *pGameInfo)
@@ -190,6 +198,8 @@ protected:
 			m_TH.EndInputs();
 			m_TH.EndTick();
 		}
+		if(m_pWriter)
+			m_pWriter->BeginTick(Tick);
 		m_TH.BeginTick(Tick);
 		m_TH.BeginPlayers();
 		m_State = STATE_PLAYERS;
@@ -906,3 +916,232 @@ TEST_F(TeeHistorian, PrevGameUuid)
 	EXPECT_STREQ(JsonPrevGameUuid, "fe19c218-f555-4002-a273-126c59ccc17a");
 	json_value_free(pJson);
 }
+
+TEST_F(TeeHistorian, Parse)
+{
+	CNetObj_PlayerInput Input = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+	const unsigned char aMessage[] = {0x01, 0x02, 0x03};
+
+	Tick(1);
+	Player(0, 10, 20);
+	Player(3, 30, 40);
+	Inputs();
+	m_TH.RecordPlayerJoin(5, CTeeHistorian::PROTOCOL_7);
+	m_TH.RecordPlayerInput(5, 1, &Input);
+	m_TH.RecordPlayerMessage(5, aMessage, sizeof(aMessage));
+	m_TH.RecordPlayerReady(5);
+	Tick(2);
+	Player(0, 15, 20);
+	Player(3, 30, 40);
+	Inputs();
+	Input.m_Direction = -1;
+	m_TH.RecordPlayerInput(5, 1, &Input);
+	Tick(3);
+	Tick(4);
+	DeadPlayer(0);
+	Player(3, 31, 40);
+	Inputs();
+	m_TH.RecordPlayerDrop(5, "too many pancakes");
+	Finish();
+
+	CTeeHistorianParser Parser;
+	ASSERT_TRUE(Parser.Init(m_vBuffer.data(), m_vBuffer.size()));
+	json_value *pJson = json_parse(Parser.Header(), -1);
+	ASSERT_TRUE(pJson);
+	EXPECT_STREQ((*pJson)["map_name"], "Kobra 3 Solo");
+	json_value_free(pJson);
+
+	std::vector<CTeeHistorianParser::CRecord> vRecords;
+	CTeeHistorianParser::CRecord Record;
+	while(Parser.Next(&Record))
+		vRecords.push_back(Record);
+	EXPECT_FALSE(Parser.Error());
+
+	const struct
+	{
+		CTeeHistorianParser::ERecordType m_Type;
+		int m_Tick;
+		int m_ClientId;
+	} aExpected[] = {
+		{CTeeHistorianParser::RECORD_TICK, 1, -1},
+		{CTeeHistorianParser::RECORD_PLAYER, 1, 0},
+		{CTeeHistorianParser::RECORD_PLAYER, 1, 3},
+		{CTeeHistorianParser::RECORD_EX, 1, -1},
+		{CTeeHistorianParser::RECORD_JOIN, 1, 5},
+		{CTeeHistorianParser::RECORD_INPUT, 1, 5},
+		{CTeeHistorianParser::RECORD_MESSAGE, 1, 5},
+		{CTeeHistorianParser::RECORD_EX, 1, -1},
+		{CTeeHistorianParser::RECORD_TICK, 2, -1},
+		{CTeeHistorianParser::RECORD_PLAYER, 2, 0},
+		{CTeeHistorianParser::RECORD_INPUT, 2, 5},
+		{CTeeHistorianParser::RECORD_TICK, 4, -1},
+		{CTeeHistorianParser::RECORD_PLAYER_OLD, 4, 0},
+		{CTeeHistorianParser::RECORD_PLAYER, 4, 3},
+		{CTeeHistorianParser::RECORD_DROP, 4, 5},
+		{CTeeHistorianParser::RECORD_FINISH, 4, -1},
+	};
+	ASSERT_EQ(vRecords.size(), std::size(aExpected));
+	for(size_t i = 0; i < vRecords.size(); i++)
+	{
+		EXPECT_EQ(vRecords[i].m_Type, aExpected[i].m_Type) << "record " << i;
+		EXPECT_EQ(vRecords[i].m_Tick, aExpected[i].m_Tick) << "record " << i;
+		EXPECT_EQ(vRecords[i].m_ClientId, aExpected[i].m_ClientId) << "record " << i;
+	}
+
+	// positions and inputs are absolute
+	EXPECT_EQ(vRecords[1].m_X, 10);
+	EXPECT_EQ(vRecords[1].m_Y, 20);
+	EXPECT_EQ(vRecords[9].m_X, 15);
+	EXPECT_EQ(vRecords[9].m_Y, 20);
+	EXPECT_EQ(vRecords[13].m_X, 31);
+	EXPECT_EQ(vRecords[13].m_Y, 40);
+	EXPECT_EQ(mem_comp(&vRecords[10].m_Input, &Input, sizeof(Input)), 0);
+	EXPECT_EQ(vRecords[5].m_Input.m_Direction, 1);
+
+	EXPECT_EQ(vRecords[3].m_ExType, (int)TEEHISTORIAN_JOINVER7);
+	EXPECT_EQ(vRecords[7].m_ExType, (int)TEEHISTORIAN_PLAYER_READY);
+	ASSERT_EQ(vRecords[6].m_DataSize, (int)sizeof(aMessage));
+	EXPECT_EQ(mem_comp(vRecords[6].m_pData, aMessage, sizeof(aMessage)), 0);
+	EXPECT_STREQ(vRecords[14].m_pString, "too many pancakes");
+}
+
+TEST_F(TeeHistorian, ParseTruncated)
+{
+	Tick(1);
+	Player(0, 10, 20);
+	Finish();
+
+	CTeeHistorianParser Parser;
+	EXPECT_FALSE(Parser.Init(m_vBuffer.data(), 20));
+
+	// a crashed server doesn't write the finish record
+	CTeeHistorianParser::CRecord Record;
+	ASSERT_TRUE(Parser.Init(m_vBuffer.data(), m_vBuffer.size() - 1));
+	ASSERT_TRUE(Parser.Next(&Record));
+	EXPECT_EQ(Record.m_Type, CTeeHistorianParser::RECORD_TICK);
+	ASSERT_TRUE(Parser.Next(&Record));
+	EXPECT_EQ(Record.m_Type, CTeeHistorianParser::RECORD_PLAYER);
+	EXPECT_FALSE(Parser.Next(&Record));
+	EXPECT_FALSE(Parser.Error());
+
+	// or it stops in the middle of a record
+	ASSERT_TRUE(Parser.Init(m_vBuffer.data(), m_vBuffer.size() - 2));
+	EXPECT_FALSE(Parser.Next(&Record));
+	EXPECT_TRUE(Parser.Error());
+}
+
+class TeeHistorianFile : public TeeHistorian
+{
+protected:
+	CTestInfo m_Info;
+
+	void WriteFile(bool Compressed, int NumTicks)
+	{
+		IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_WRITE);
+		ASSERT_TRUE(File);
+		CTeeHistorianWriter Writer;
+		Writer.Open(File, Compressed, 1024);
+		m_pWriter = &Writer;
+		Reset(&m_GameInfo);
+		for(int i = 1; i <= NumTicks; i++)
+		{
+			Tick(i);
+			for(int ClientId = 0; ClientId < 8; ClientId++)
+				Player(ClientId, i * ClientId, i % 37 * ClientId);
+		}
+		Finish();
+		m_pWriter = nullptr;
+		EXPECT_EQ(Writer.Close(), 0);
+	}
+
+	~TeeHistorianFile() override
+	{
+		fs_remove(m_Info.m_aFilename);
+	}
+};
+
+TEST_F(TeeHistorianFile, Uncompressed)
+{
+	WriteFile(false, 100);
+
+	CTeeHistorianReader Reader;
+	ASSERT_TRUE(Reader.Open(io_open(m_Info.m_aFilename, IOFLAG_READ)));
+	EXPECT_FALSE(Reader.IsCompressed());
+	EXPECT_EQ(Reader.Frames().size(), 1u);
+	EXPECT_EQ(Reader.FindFrame(50), 0);
+	std::vector<unsigned char> vData;
+	ASSERT_TRUE(Reader.ReadAll(vData));
+	EXPECT_EQ(vData, m_vBuffer);
+}
+
+TEST_F(TeeHistorianFile, Compressed)
+{
+	const int NumTicks = 2000;
+	WriteFile(true, NumTicks);
+
+	CTeeHistorianReader Reader;
+	ASSERT_TRUE(Reader.Open(io_open(m_Info.m_aFilename, IOFLAG_READ)));
+	EXPECT_TRUE(Reader.IsCompressed());
+	const std::vector<CTeeHistorianReader::CFrame> &vFrames = Reader.Frames();
+	ASSERT_GT(vFrames.size(), 10u);
+	EXPECT_EQ(vFrames[0].m_Tick, -1);
+	int64_t CompressedSize = 0;
+	for(size_t i = 1; i < vFrames.size(); i++)
+	{
+		EXPECT_LT(vFrames[i - 1].m_Tick, vFrames[i].m_Tick);
+		CompressedSize += vFrames[i].m_Size;
+	}
+	std::vector<unsigned char> vData;
+	ASSERT_TRUE(Reader.ReadAll(vData));
+	EXPECT_EQ(vData, m_vBuffer);
+	EXPECT_LT(CompressedSize, (int64_t)m_vBuffer.size());
+
+	// seeking to a tick only reads the frame that contains its start
+	for(int Tick : {1, 500, 1234, NumTicks})
+	{
+		const int Index = Reader.FindFrame(Tick);
+		const CTeeHistorianReader::CFrame &Frame = vFrames[Index];
+		EXPECT_LE(Frame.m_Tick, Tick);
+		if(Index + 1 < (int)vFrames.size())
+		{
+			EXPECT_GT(vFrames[Index + 1].m_Tick, Tick);
+		}
+		std::vector<unsigned char> vFrame;
+		ASSERT_TRUE(Reader.ReadFrame(Index, vFrame));
+		ASSERT_LE(Frame.m_DataOffset + Frame.m_DataSize, (int64_t)m_vBuffer.size());
+		EXPECT_TRUE(std::equal(vFrame.begin(), vFrame.end(), m_vBuffer.begin() + Frame.m_DataOffset));
+	}
+}
+
+TEST_F(TeeHistorianFile, CompressedWithoutIndex)
+{
+	WriteFile(true, 500);
+
+	// a crashed server doesn't write the index, and the last frame may be cut off
+	IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	std::vector<unsigned char> vFile(io_length(File));
+	ASSERT_EQ(io_read(File, vFile.data(), vFile.size()), vFile.size());
+	io_close(File);
+
+	CTeeHistorianReader Reader;
+	ASSERT_TRUE(Reader.Open(io_open(m_Info.m_aFilename, IOFLAG_READ)));
+	const std::vector<CTeeHistorianReader::CFrame> vFrames = Reader.Frames();
+	Reader.Close();
+	ASSERT_GT(vFrames.size(), 2u);
+	const CTeeHistorianReader::CFrame &Last = vFrames.back();
+
+	File = io_open(m_Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_write(File, vFile.data(), Last.m_Offset + 5);
+	io_close(File);
+
+	ASSERT_TRUE(Reader.Open(io_open(m_Info.m_aFilename, IOFLAG_READ)));
+	ASSERT_EQ(Reader.Frames().size(), vFrames.size() - 1);
+	for(size_t i = 0; i < Reader.Frames().size(); i++)
+		EXPECT_EQ(Reader.Frames()[i].m_Tick, vFrames[i].m_Tick);
+	std::vector<unsigned char> vData;
+	ASSERT_TRUE(Reader.ReadAll(vData));
+	ASSERT_EQ((int64_t)vData.size(), Last.m_DataOffset);
+	EXPECT_TRUE(std::equal(vData.begin(), vData.end(), m_vBuffer.begin()));
+}
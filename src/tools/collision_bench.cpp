@@ -0,0 +1,98 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/prng.h>
+
+#include <vector>
+
+static const char *TOOL_NAME = "collision_bench";
+
+static float RandomFloat(CPrng &Prng, float Min, float Max)
+{
+	return Min + (Max - Min) * (Prng.RandomBits() / (float)0xffffffffu);
+}
+
+static int BenchMoveBox(const CCollision &Collision, int Iterations)
+{
+	// same box size and elasticity as characters
+	const vec2 Size = vec2(28.0f, 28.0f);
+	const vec2 Elasticity = vec2(0.0f, 0.0f);
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {1, 2};
+	Prng.Seed(aSeed);
+	const float Width = Collision.GetWidth() * 32.0f;
+	const float Height = Collision.GetHeight() * 32.0f;
+	std::vector<vec2> vPos;
+	std::vector<vec2> vVel;
+	for(int i = 0; i < 4096; i++)
+	{
+		vPos.emplace_back(RandomFloat(Prng, 0.0f, Width), RandomFloat(Prng, 0.0f, Height));
+		vVel.emplace_back(RandomFloat(Prng, -30.0f, 30.0f), RandomFloat(Prng, -30.0f, 30.0f));
+	}
+
+	// keep the result alive so the calls can't be optimized away
+	float Checksum = 0.0f;
+	const int64_t Start = time_get_nanoseconds().count();
+	for(int i = 0; i < Iterations; i++)
+	{
+		vec2 Pos = vPos[i % vPos.size()];
+		vec2 Vel = vVel[i % vVel.size()];
+		bool Grounded = false;
+		Collision.MoveBox(&Pos, &Vel, Size, Elasticity, &Grounded);
+		Checksum += Pos.x + Pos.y + Vel.x + Vel.y + Grounded;
+	}
+	const int64_t Duration = time_get_nanoseconds().count() - Start;
+
+	log_info(TOOL_NAME, "MoveBox: %d calls in %.3f ms, %.1f ns/call (checksum %f)",
+		Iterations, Duration / 1e6, Duration / (double)Iterations, Checksum);
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	const CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc < 2 || argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s <map> [iterations]", TOOL_NAME);
+		return -1;
+	}
+	const char *pMapName = argv[1];
+	const int Iterations = argc == 3 ? str_toint(argv[2]) : 2000000;
+
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	std::unique_ptr<IStorage> pStorage = std::unique_ptr<IStorage>(CreateStorage(IStorage::EInitializationType::BASIC, argc, argv));
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating basic storage");
+		return -1;
+	}
+	pKernel->RegisterInterface(pStorage.get(), false);
+	IEngineMap *pMap = CreateEngineMap();
+	pKernel->RegisterInterface(pMap);
+
+	if(!pMap->Load(pMapName))
+	{
+		log_error(TOOL_NAME, "Failed to load map '%s'", pMapName);
+		return -1;
+	}
+
+	CLayers Layers;
+	Layers.Init(pMap, true);
+	CCollision Collision;
+	Collision.Init(&Layers);
+	log_info(TOOL_NAME, "Loaded map '%s' (%dx%d tiles)", pMapName, Collision.GetWidth(), Collision.GetHeight());
+
+	const int Result = BenchMoveBox(Collision, Iterations);
+	Collision.Unload();
+	pMap->Unload();
+	return Result;
+}
@@ -0,0 +1,115 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <memory>
+
+static const char *TOOL_NAME = "console_bench";
+static const char *GENERATED_FILENAME = "console_bench_settings.cfg";
+
+// writes a value for every config variable, like a settings file with all of them changed
+static bool GenerateSettings(IConsole *pConsole, const char *pFilename)
+{
+	IOHANDLE File = io_open(pFilename, IOFLAG_WRITE);
+	if(!File)
+	{
+		log_error(TOOL_NAME, "Failed to open '%s' for writing", pFilename);
+		return false;
+	}
+	int NumLines = 0;
+	for(const IConsole::ICommandInfo *pInfo = pConsole->FirstCommandInfo(IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_SAVE); pInfo; pInfo = pConsole->NextCommandInfo(pInfo, IConsole::CLIENT_ID_UNSPECIFIED, CFGFLAG_SAVE))
+	{
+		char aLine[256];
+		if(str_comp(pInfo->Params(), "?i") == 0)
+			str_format(aLine, sizeof(aLine), "%s 1", pInfo->Name());
+		else if(str_comp(pInfo->Params(), "?r") == 0)
+			str_format(aLine, sizeof(aLine), "%s \"%s value\"", pInfo->Name(), pInfo->Name());
+		else
+			continue;
+		io_write(File, aLine, str_length(aLine));
+		io_write_newline(File);
+		NumLines++;
+	}
+	io_close(File);
+	log_info(TOOL_NAME, "Generated '%s' with %d config variables", pFilename, NumLines);
+	return true;
+}
+
+int main(int argc, const char *argv[])
+{
+	// Create storage before setting logger to avoid log messages from storage creation
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating local storage");
+		return -1;
+	}
+
+	if(argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s [settings_file] [rounds]", TOOL_NAME);
+		return -1;
+	}
+	const int Rounds = argc == 3 ? str_toint(argv[2]) : 20;
+
+	// startup: registering all commands and config variables
+	const int64_t RegisterStart = time_get_nanoseconds().count();
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	pKernel->RegisterInterface(pStorage.get(), false);
+	IConsole *pConsole = CreateConsole(CFGFLAG_CLIENT).release();
+	pKernel->RegisterInterface(pConsole);
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConfigManager);
+	pConsole->Init();
+	pConfigManager->Init();
+	const int64_t RegisterDuration = time_get_nanoseconds().count() - RegisterStart;
+
+	const char *pFilename = argc >= 2 ? argv[1] : GENERATED_FILENAME;
+	if(argc < 2 && !GenerateSettings(pConsole, pFilename))
+		return -1;
+
+	// executing the settings file, like the client does on every start
+	const int64_t ExecuteStart = time_get_nanoseconds().count();
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		if(!pConsole->ExecuteFile(pFilename, IConsole::CLIENT_ID_UNSPECIFIED, true, IStorage::TYPE_ABSOLUTE))
+			return -1;
+	}
+	const int64_t ExecuteDuration = time_get_nanoseconds().count() - ExecuteStart;
+
+	// the same in a batch, like the client does when it starts
+	const int64_t BatchStart = time_get_nanoseconds().count();
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		pConsole->BeginBatch();
+		if(!pConsole->ExecuteFile(pFilename, IConsole::CLIENT_ID_UNSPECIFIED, true, IStorage::TYPE_ABSOLUTE))
+			return -1;
+		pConsole->EndBatch();
+	}
+	const int64_t BatchDuration = time_get_nanoseconds().count() - BatchStart;
+
+	// and single lines, like binds
+	const int64_t LineStart = time_get_nanoseconds().count();
+	const int NumLines = 100000;
+	for(int i = 0; i < NumLines; i++)
+		pConsole->ExecuteLine("cl_showhud 1", IConsole::CLIENT_ID_UNSPECIFIED);
+	const int64_t LineDuration = time_get_nanoseconds().count() - LineStart;
+
+	if(argc < 2)
+		fs_remove(pFilename);
+
+	log_info(TOOL_NAME, "Registering commands: %.3f ms", RegisterDuration / 1e6);
+	log_info(TOOL_NAME, "Executing '%s': %.3f ms per round", pFilename, ExecuteDuration / 1e6 / Rounds);
+	log_info(TOOL_NAME, "Executing '%s' in a batch: %.3f ms per round", pFilename, BatchDuration / 1e6 / Rounds);
+	log_info(TOOL_NAME, "Executing a single line: %.3f us", LineDuration / 1e3 / NumLines);
+	return 0;
+}
@@ -3,6 +3,7 @@
 #include <base/logger.h>
 #include <base/system.h>
 
+#include <cinttypes>
 #include <cstdlib>
 #include <iterator> // std::size
 #include <thread>
@@ -44,14 +45,20 @@ static int g_ConfigNumpingconfs = std::size(g_aConfigPings);
 static int g_ConfigInterval = 10; // seconds between different pingconfigs
 static int g_ConfigLog = 0;
 static int g_ConfigReorder = 0;
+static int g_ConfigBatch = 1; // send the packets of one loop iteration together
+static int g_ConfigStats = 1; // print send statistics every second
 
 static void Run(unsigned short Port, NETADDR Dest)
 {
 	NETADDR Src = {NETTYPE_IPV4, {0, 0, 0, 0}, Port};
 	NETSOCKET Socket = net_udp_create(Src);
+	net_udp_set_send_batching(Socket, g_ConfigBatch);
 
 	int Id = 0;
 	int Delaycounter = 0;
+	int64_t LastStatsTime = time_get();
+	NETSTATS LastStats;
+	net_stats(&LastStats);
 
 	while(true)
 	{
@@ -191,6 +198,20 @@ static void Run(unsigned short Port, NETADDR Dest)
 				free(p);
 			}
 		}
+		net_udp_flush(Socket);
+
+		if(g_ConfigStats && time_get() - LastStatsTime > time_freq())
+		{
+			NETSTATS Stats;
+			net_stats(&Stats);
+			const uint64_t Packets = Stats.sent_packets - LastStats.sent_packets;
+			const uint64_t Syscalls = Stats.sent_syscalls - LastStats.sent_syscalls;
+			const uint64_t QueueDelay = Stats.sent_queue_delay - LastStats.sent_queue_delay;
+			if(Packets)
+				dbg_msg("crapnet", "sent %" PRIu64 " packets with %" PRIu64 " syscalls, %.3f ms queue delay per packet", Packets, Syscalls, QueueDelay / 1e6 / Packets);
+			LastStats = Stats;
+			LastStatsTime = time_get();
+		}
 
 		std::this_thread::sleep_for(std::chrono::microseconds(1000));
 	}
@@ -0,0 +1,162 @@
+#include <base/logger.h>
+#include <base/system.h>
+#include <base/tl/threading.h>
+
+#include <engine/shared/jobs.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <functional>
+#include <memory>
+#include <vector>
+
+static const char *TOOL_NAME = "jobs_bench";
+
+class CBenchJob : public IJob
+{
+	std::function<void()> m_Function;
+
+	void Run() override
+	{
+		m_Function();
+	}
+
+public:
+	CBenchJob(std::function<void()> &&Function, EJobPriority Priority) :
+		m_Function(std::move(Function))
+	{
+		SetPriority(Priority);
+	}
+};
+
+// keeps a worker busy for about the given time
+static void Spin(int64_t Nanoseconds)
+{
+	const int64_t End = time_get_nanoseconds().count() + Nanoseconds;
+	while(time_get_nanoseconds().count() < End)
+	{
+	}
+}
+
+// many tiny jobs added from the main thread
+static void BenchThroughput(int NumThreads, int NumJobs)
+{
+	CJobPool Pool;
+	Pool.Init(NumThreads);
+	std::atomic<int> NumDone(0);
+	CSemaphore Done;
+
+	const int64_t Start = time_get_nanoseconds().count();
+	for(int i = 0; i < NumJobs; i++)
+	{
+		Pool.Add(std::make_shared<CBenchJob>([&] {
+			if(NumDone.fetch_add(1) + 1 == NumJobs)
+				Done.Signal();
+		},
+			IJob::PRIORITY_NORMAL));
+	}
+	Done.Wait();
+	const int64_t Duration = time_get_nanoseconds().count() - Start;
+	Pool.Shutdown();
+
+	log_info(TOOL_NAME, "Throughput, added from main thread: %d jobs in %.3f ms, %.2f M jobs/s", NumJobs, Duration / 1e6, NumJobs * 1e3 / Duration);
+}
+
+// jobs that add two more jobs each from the workers, which the other workers have to steal
+static void BenchSpawn(int NumThreads, int Depth)
+{
+	CJobPool Pool;
+	Pool.Init(NumThreads);
+	const int NumJobs = (1 << Depth) - 1;
+	std::atomic<int> NumDone(0);
+	CSemaphore Done;
+
+	std::function<std::shared_ptr<IJob>(int)> CreateJob = [&](int Level) -> std::shared_ptr<IJob> {
+		return std::make_shared<CBenchJob>([&, Level] {
+			if(Level > 1)
+			{
+				Pool.Add(CreateJob(Level - 1));
+				Pool.Add(CreateJob(Level - 1));
+			}
+			Spin(20000);
+			if(NumDone.fetch_add(1) + 1 == NumJobs)
+				Done.Signal();
+		},
+			IJob::PRIORITY_NORMAL);
+	};
+
+	const int64_t Start = time_get_nanoseconds().count();
+	Pool.Add(CreateJob(Depth));
+	Done.Wait();
+	const int64_t Duration = time_get_nanoseconds().count() - Start;
+	Pool.Shutdown();
+
+	// every job spins for 20 us, so this is how much of the workers' time was spent on jobs
+	log_info(TOOL_NAME, "Throughput, added from workers: %d jobs in %.3f ms, %.1f%% busy", NumJobs, Duration / 1e6, NumJobs * 20e3 * 100 / ((double)Duration * NumThreads));
+}
+
+// time from adding a job to it starting while the pool is busy with bulk jobs
+static void BenchLatency(int NumThreads, int NumBulkJobs, int NumProbes, IJob::EJobPriority Priority)
+{
+	CJobPool Pool;
+	Pool.Init(NumThreads);
+	std::atomic<int> NumBulkDone(0);
+	CSemaphore BulkDone;
+	for(int i = 0; i < NumBulkJobs; i++)
+	{
+		Pool.Add(std::make_shared<CBenchJob>([&] {
+			Spin(50000);
+			if(NumBulkDone.fetch_add(1) + 1 == NumBulkJobs)
+				BulkDone.Signal();
+		},
+			IJob::PRIORITY_LOW));
+	}
+
+	std::vector<int64_t> vLatencies;
+	for(int i = 0; i < NumProbes; i++)
+	{
+		CSemaphore Started;
+		int64_t StartTime = 0;
+		const int64_t AddTime = time_get_nanoseconds().count();
+		Pool.Add(std::make_shared<CBenchJob>([&] {
+			StartTime = time_get_nanoseconds().count();
+			Started.Signal();
+		},
+			Priority));
+		Started.Wait();
+		vLatencies.push_back(StartTime - AddTime);
+	}
+	BulkDone.Wait();
+	Pool.Shutdown();
+
+	std::sort(vLatencies.begin(), vLatencies.end());
+	const char *apPriorityNames[] = {"high", "normal", "low"};
+	log_info(TOOL_NAME, "Latency, %s priority behind %d low priority jobs: median %.3f ms, max %.3f ms", apPriorityNames[Priority], NumBulkJobs,
+		vLatencies[vLatencies.size() / 2] / 1e6, vLatencies.back() / 1e6);
+}
+
+int main(int argc, const char *argv[])
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(argc > 2)
+	{
+		log_error(TOOL_NAME, "Usage: %s [threads]", TOOL_NAME);
+		return -1;
+	}
+	const int NumThreads = argc == 2 ? str_toint(argv[1]) : 4;
+	if(NumThreads < 1)
+	{
+		log_error(TOOL_NAME, "Invalid number of threads");
+		return -1;
+	}
+
+	log_info(TOOL_NAME, "Using %d worker threads", NumThreads);
+	BenchThroughput(NumThreads, 200000);
+	BenchSpawn(NumThreads, 14);
+	BenchLatency(NumThreads, 200 * NumThreads, 20, IJob::PRIORITY_HIGH);
+	BenchLatency(NumThreads, 20 * NumThreads, 1, IJob::PRIORITY_LOW);
+	return 0;
+}
@@ -18,6 +18,11 @@ static int TestMap(const char *pMap, bool CalcHashes, IStorage *pStorage)
 		return -1;
 	}
 
+	if(!Reader.CalculateHashes())
+	{
+		log_error(TOOL_NAME, "Failed to read map '%s' completely", pMap);
+		return -1;
+	}
 	char aSha256Str[SHA256_MAXSTRSIZE];
 	sha256_str(Reader.Sha256(), aSha256Str, sizeof(aSha256Str));
 	log_info(TOOL_NAME, "File size: %d", Reader.MapSize());
@@ -0,0 +1,232 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/shared/compression.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/huffman.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <cinttypes>
+#include <memory>
+#include <vector>
+
+static const char *TOOL_NAME = "snapshot_delta_bench";
+
+class CSnapshotCollector : public CDemoPlayer::IListener
+{
+public:
+	std::vector<std::vector<char>> m_vSnapshots;
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		const char *pBytes = static_cast<const char *>(pData);
+		m_vSnapshots.emplace_back(pBytes, pBytes + Size);
+	}
+
+	void OnDemoPlayerMessage(void *pData, int Size) override {}
+};
+
+static bool CollectSnapshots(const char *pDemoFilePath, IStorage *pStorage, CSnapshotCollector *pCollector)
+{
+	std::unique_ptr<CSnapshotDelta> pDemoSnapshotDelta = std::make_unique<CSnapshotDelta>();
+	CDemoPlayer DemoPlayer(pDemoSnapshotDelta.get(), false);
+	if(DemoPlayer.Load(pStorage, nullptr, pDemoFilePath, IStorage::TYPE_ALL_OR_ABSOLUTE) == -1)
+	{
+		log_error(TOOL_NAME, "Demo file '%s' failed to load: %s", pDemoFilePath, DemoPlayer.ErrorMessage());
+		return false;
+	}
+
+	DemoPlayer.SetListener(pCollector);
+	const CDemoPlayer::CPlaybackInfo *pInfo = DemoPlayer.Info();
+	CNetBase::Init();
+	DemoPlayer.Play();
+	while(DemoPlayer.IsPlaying())
+	{
+		DemoPlayer.Update(false);
+		if(pInfo->m_Info.m_Paused)
+			break;
+	}
+	DemoPlayer.Stop();
+	return true;
+}
+
+// unpacked snapshots can have their items in a different order, and
+// a delta can't express an item key that's in a snapshot twice
+static bool ContainsItems(const CSnapshot *pA, const CSnapshot *pB)
+{
+	for(int i = 0; i < pA->NumItems(); i++)
+	{
+		const int Index = pB->GetItemIndex(pA->GetItem(i)->Key());
+		if(Index == -1)
+			return false;
+		if(pA->GetItemIndex(pA->GetItem(i)->Key()) != i)
+			continue;
+		if(pA->GetItemSize(i) != pB->GetItemSize(Index) ||
+			mem_comp(pA->GetItem(i)->Data(), pB->GetItem(Index)->Data(), pA->GetItemSize(i)) != 0)
+			return false;
+	}
+	return true;
+}
+
+static bool SameItems(const CSnapshot *pA, const CSnapshot *pB)
+{
+	return ContainsItems(pA, pB) && ContainsItems(pB, pA);
+}
+
+static int BenchDelta(const CSnapshotCollector &Collector, int Rounds)
+{
+	const std::vector<std::vector<char>> &vSnapshots = Collector.m_vSnapshots;
+	if(vSnapshots.size() < 2)
+	{
+		log_error(TOOL_NAME, "Demo contains less than two snapshots");
+		return -1;
+	}
+
+	std::unique_ptr<CSnapshotDelta> pDelta = std::make_unique<CSnapshotDelta>();
+	std::vector<std::vector<char>> vDeltas(vSnapshots.size());
+	std::vector<char> vUnpacked(CSnapshot::MAX_SIZE);
+	std::vector<char> vDeltaData(CSnapshot::MAX_SIZE * 2);
+
+	int64_t NumItems = 0;
+	for(size_t i = 1; i < vSnapshots.size(); i++)
+		NumItems += ((const CSnapshot *)vSnapshots[i].data())->NumItems();
+	NumItems *= Rounds;
+
+	// delta every snapshot against the previous one, like the server does for each client
+	const int64_t CreateStart = time_get_nanoseconds().count();
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		for(size_t i = 1; i < vSnapshots.size(); i++)
+		{
+			const int Size = pDelta->CreateDelta((const CSnapshot *)vSnapshots[i - 1].data(), (const CSnapshot *)vSnapshots[i].data(), vDeltaData.data());
+			if(Round == 0)
+				vDeltas[i].assign(vDeltaData.data(), vDeltaData.data() + Size);
+		}
+	}
+	const int64_t CreateDuration = time_get_nanoseconds().count() - CreateStart;
+
+	// and apply it again, like the client does
+	const int64_t UnpackStart = time_get_nanoseconds().count();
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		for(size_t i = 1; i < vSnapshots.size(); i++)
+		{
+			if(vDeltas[i].empty())
+				continue;
+			const int Size = pDelta->UnpackDelta((const CSnapshot *)vSnapshots[i - 1].data(), (CSnapshot *)vUnpacked.data(), vDeltas[i].data(), vDeltas[i].size(), false);
+			if(Round == 0 && (Size < 0 || !SameItems((const CSnapshot *)vUnpacked.data(), (const CSnapshot *)vSnapshots[i].data())))
+			{
+				log_error(TOOL_NAME, "Snapshot %d doesn't match after unpacking its delta", (int)i);
+				return -1;
+			}
+		}
+	}
+	const int64_t UnpackDuration = time_get_nanoseconds().count() - UnpackStart;
+
+	// deltas are sent and recorded as variable ints, use the ones against
+	// the empty snapshot that are sent on connect and recorded as keyframes
+	for(size_t i = 1; i < vSnapshots.size(); i++)
+	{
+		const int Size = pDelta->CreateDelta(CSnapshot::EmptySnapshot(), (const CSnapshot *)vSnapshots[i].data(), vDeltaData.data());
+		vDeltas[i].assign(vDeltaData.data(), vDeltaData.data() + Size);
+	}
+	int64_t NumInts = 0;
+	std::vector<std::vector<unsigned char>> vCompressed(vSnapshots.size());
+	std::vector<int> vDecompressed(CSnapshot::MAX_SIZE * 2 / sizeof(int));
+	const int64_t CompressStart = time_get_nanoseconds().count();
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		for(size_t i = 1; i < vSnapshots.size(); i++)
+		{
+			const long Size = CVariableInt::Compress(vDeltas[i].data(), vDeltas[i].size(), vDeltaData.data(), vDeltaData.size());
+			if(Round == 0)
+			{
+				vCompressed[i].assign(vDeltaData.data(), vDeltaData.data() + Size);
+				NumInts += vDeltas[i].size() / sizeof(int);
+			}
+		}
+	}
+	const int64_t CompressDuration = time_get_nanoseconds().count() - CompressStart;
+
+	const int64_t DecompressStart = time_get_nanoseconds().count();
+	for(int Round = 0; Round < Rounds; Round++)
+	{
+		for(size_t i = 1; i < vSnapshots.size(); i++)
+		{
+			const long Size = CVariableInt::Decompress(vCompressed[i].data(), vCompressed[i].size(), vDecompressed.data(), vDecompressed.size() * sizeof(int));
+			if(Round == 0 && (Size != (long)vDeltas[i].size() || mem_comp(vDecompressed.data(), vDeltas[i].data(), Size) != 0))
+			{
+				log_error(TOOL_NAME, "Delta %d doesn't match after decompressing it", (int)i);
+				return -1;
+			}
+		}
+	}
+	const int64_t DecompressDuration = time_get_nanoseconds().count() - DecompressStart;
+	NumInts *= Rounds;
+
+	// and finally huffman coded
+	static CHuffman s_Huffman;
+	s_Huffman.Init();
+	int64_t NumBytes = 0;
+	std::vector<std::vector<unsigned char>> vHuffman(vSnapshots.size());
+	for(size_t i = 1; i < vSnapshots.size(); i++)
+	{
+		const int Size = s_Huffman.Compress(vCompressed[i].data(), vCompressed[i].size(), vDeltaData.data(), vDeltaData.size());
+		vHuffman[i].assign(vDeltaData.data(), vDeltaData.data() + Size);
+		NumBytes += vCompressed[i].size();
+	}
+	NumBytes *= Rounds;
+
+	std::vector<std::vector<unsigned char>> vHuffmanDecompressed(vSnapshots.size(), std::vector<unsigned char>(CSnapshot::MAX_SIZE * 2));
+	std::vector<int> vHuffmanSizes(vSnapshots.size());
+	const int64_t HuffmanStart = time_get_nanoseconds().count();
+	for(int Round = 0; Round < Rounds; Round++)
+		for(size_t i = 1; i < vSnapshots.size(); i++)
+			vHuffmanSizes[i] = s_Huffman.Decompress(vHuffman[i].data(), vHuffman[i].size(), vHuffmanDecompressed[i].data(), vHuffmanDecompressed[i].size());
+	const int64_t HuffmanDuration = time_get_nanoseconds().count() - HuffmanStart;
+	for(size_t i = 1; i < vSnapshots.size(); i++)
+	{
+		if(vHuffmanSizes[i] != (int)vCompressed[i].size() || mem_comp(vHuffmanDecompressed[i].data(), vCompressed[i].data(), vHuffmanSizes[i]) != 0)
+		{
+			log_error(TOOL_NAME, "Delta %d doesn't match after huffman decompressing it", (int)i);
+			return -1;
+		}
+	}
+
+	log_info(TOOL_NAME, "%d snapshots, %" PRId64 " items in %d rounds", (int)vSnapshots.size(), NumItems, Rounds);
+	log_info(TOOL_NAME, "CreateDelta: %.3f ms, %.2f M items/s", CreateDuration / 1e6, NumItems * 1e3 / CreateDuration);
+	log_info(TOOL_NAME, "UnpackDelta: %.3f ms, %.2f M items/s", UnpackDuration / 1e6, NumItems * 1e3 / UnpackDuration);
+	log_info(TOOL_NAME, "CVariableInt::Compress: %.3f ms, %.2f M ints/s", CompressDuration / 1e6, NumInts * 1e3 / CompressDuration);
+	log_info(TOOL_NAME, "CVariableInt::Decompress: %.3f ms, %.2f M ints/s", DecompressDuration / 1e6, NumInts * 1e3 / DecompressDuration);
+	log_info(TOOL_NAME, "CHuffman::Decompress: %.3f ms, %.2f MB/s", HuffmanDuration / 1e6, NumBytes * 1e3 / HuffmanDuration);
+	return 0;
+}
+
+int main(int argc, const char *argv[])
+{
+	// Create storage before setting logger to avoid log messages from storage creation
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	if(!pStorage)
+	{
+		log_error(TOOL_NAME, "Error creating local storage");
+		return -1;
+	}
+
+	if(argc < 2 || argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s <demo_filename> [rounds]", TOOL_NAME);
+		return -1;
+	}
+	const int Rounds = argc == 3 ? str_toint(argv[2]) : 20;
+
+	CSnapshotCollector Collector;
+	if(!CollectSnapshots(argv[1], pStorage.get(), &Collector))
+		return -1;
+	return BenchDelta(Collector, Rounds);
+}
@@ -0,0 +1,536 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/engine.h>
+#include <engine/kernel.h>
+#include <engine/server/databases/connection_pool.h>
+#include <engine/server/server.h>
+#include <engine/shared/config.h>
+#include <engine/shared/json.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/teehistorian_ex.h>
+#include <engine/shared/teehistorian_file.h>
+#include <engine/storage.h>
+
+#include <game/server/entities/character.h>
+#include <game/server/gamecontext.h>
+#include <game/server/player.h>
+#include <game/server/teehistorian.h>
+#include <game/version.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static const char *TOOL_NAME = "teehistorian_replay";
+static const char *STORAGE_DIRECTORY = "teehistorian_replay";
+
+bool IsInterrupted()
+{
+	return false;
+}
+
+std::vector<std::string> FetchAndroidServerCommandQueue()
+{
+	return {};
+}
+
+enum
+{
+	PHASE_EVENTS,
+	PHASE_INPUT,
+	PHASE_TICK,
+	NUM_PHASES,
+};
+
+static const char *const PHASE_NAMES[NUM_PHASES] = {"events", "input", "tick"};
+
+static const char *JsonString(const json_value *pValue)
+{
+	return pValue->type == json_string ? json_string_get(pValue) : nullptr;
+}
+
+class CReplayServer : public CServer
+{
+public:
+	void AdvanceTick() { m_CurrentGameTick++; }
+};
+
+// runs the game server without network, driven by the records of a teehistorian file
+class CReplay
+{
+	std::unique_ptr<IKernel> m_pKernel;
+	std::unique_ptr<IStorage> m_pStorage;
+	CReplayServer *m_pServer = nullptr;
+	IConsole *m_pConsole = nullptr;
+	bool m_GameInitialized = false;
+
+	bool m_aHaveInput[MAX_CLIENTS] = {};
+	CNetObj_PlayerInput m_aInputs[MAX_CLIENTS];
+	bool m_aSixup[MAX_CLIENTS] = {};
+
+	// what the player records say about the end of the last tick
+	bool m_Check = false;
+	bool m_CheckPending = false;
+	bool m_aAlive[MAX_CLIENTS] = {};
+	int m_aX[MAX_CLIENTS] = {};
+	int m_aY[MAX_CLIENTS] = {};
+	int m_NumMismatches = 0;
+	int m_NumMismatchedTicks = 0;
+
+	int64_t m_EventTime = 0;
+	std::vector<int64_t> m_avPhaseTimes[NUM_PHASES];
+
+	CGameContext *GameServer() { return (CGameContext *)m_pServer->GameServer(); }
+
+	static bool CanUseCommand(int ClientId, const IConsole::ICommandInfo *pCommand, void *pUser)
+	{
+		// the recording only contains commands that were allowed
+		return true;
+	}
+
+	void ConnectClient(int ClientId)
+	{
+		CServer::CClient &Client = m_pServer->m_aClients[ClientId];
+		if(Client.m_State == CServer::CClient::STATE_EMPTY)
+			CServer::NewClientCallback(ClientId, m_pServer, m_aSixup[ClientId]);
+		if(Client.m_State < CServer::CClient::STATE_READY)
+		{
+			GameServer()->OnClientConnected(ClientId, nullptr);
+			Client.m_State = CServer::CClient::STATE_READY;
+		}
+	}
+
+	void DropClient(int ClientId, const char *pReason)
+	{
+		if(m_pServer->m_aClients[ClientId].m_State != CServer::CClient::STATE_EMPTY)
+			CServer::DelClientCallback(ClientId, pReason, m_pServer);
+		m_aHaveInput[ClientId] = false;
+		m_aSixup[ClientId] = false;
+	}
+
+	void RunTick()
+	{
+		const int64_t InputStart = time_get_nanoseconds().count();
+		for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
+		{
+			if(m_pServer->m_aClients[ClientId].m_State == CServer::CClient::STATE_INGAME)
+				GameServer()->OnClientPredictedEarlyInput(ClientId, m_aHaveInput[ClientId] ? &m_aInputs[ClientId] : nullptr);
+		}
+		m_pServer->AdvanceTick();
+		for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
+		{
+			if(m_pServer->m_aClients[ClientId].m_State == CServer::CClient::STATE_INGAME)
+				GameServer()->OnClientPredictedInput(ClientId, m_aHaveInput[ClientId] ? &m_aInputs[ClientId] : nullptr);
+			m_aHaveInput[ClientId] = false;
+		}
+		const int64_t TickStart = time_get_nanoseconds().count();
+		GameServer()->OnTick();
+		const int64_t TickEnd = time_get_nanoseconds().count();
+
+		m_avPhaseTimes[PHASE_EVENTS].push_back(m_EventTime);
+		m_avPhaseTimes[PHASE_INPUT].push_back(TickStart - InputStart);
+		m_avPhaseTimes[PHASE_TICK].push_back(TickEnd - TickStart);
+		m_EventTime = 0;
+		m_CheckPending = m_Check;
+	}
+
+	void CheckPlayers()
+	{
+		m_CheckPending = false;
+		bool Mismatch = false;
+		for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
+		{
+			CPlayer *pPlayer = GameServer()->m_apPlayers[ClientId];
+			CCharacter *pCharacter = pPlayer ? pPlayer->GetCharacter() : nullptr;
+			CNetObj_CharacterCore Core;
+			if(pCharacter)
+				pCharacter->GetCore().Write(&Core);
+			if(m_aAlive[ClientId] == (pCharacter != nullptr) && (!pCharacter || (Core.m_X == m_aX[ClientId] && Core.m_Y == m_aY[ClientId])))
+				continue;
+
+			Mismatch = true;
+			if(m_NumMismatches++ >= 10)
+				continue;
+			char aExpected[64];
+			char aGot[64];
+			if(m_aAlive[ClientId])
+				str_format(aExpected, sizeof(aExpected), "(%d, %d)", m_aX[ClientId], m_aY[ClientId]);
+			else
+				str_copy(aExpected, "no character");
+			if(pCharacter)
+				str_format(aGot, sizeof(aGot), "(%d, %d)", Core.m_X, Core.m_Y);
+			else
+				str_copy(aGot, "no character");
+			log_warn(TOOL_NAME, "tick %d: cid=%d expected %s, got %s", m_pServer->Tick(), ClientId, aExpected, aGot);
+		}
+		if(Mismatch)
+			m_NumMismatchedTicks++;
+	}
+
+	void ExecuteConsoleCommand(const CTeeHistorianParser::CRecord &Record)
+	{
+		char aLine[IConsole::CMDLINE_LENGTH];
+		str_copy(aLine, Record.m_pString);
+		for(const char *pArgument : Record.m_vpArguments)
+		{
+			str_append(aLine, " \"");
+			char *pDst = aLine + str_length(aLine);
+			str_escape(&pDst, pArgument, aLine + sizeof(aLine) - 2);
+			*pDst = '\0';
+			str_append(aLine, "\"");
+		}
+		m_pConsole->ExecuteLineFlag(aLine, Record.m_FlagMask, Record.m_ClientId, false);
+	}
+
+	void OnExtra(const CTeeHistorianParser::CRecord &Record)
+	{
+		CUnpacker Unpacker;
+		Unpacker.Reset(Record.m_pData, Record.m_DataSize);
+		const int ClientId = Unpacker.GetInt();
+		if(Unpacker.Error() || ClientId < 0 || ClientId >= MAX_CLIENTS)
+			return;
+
+		switch(Record.m_ExType)
+		{
+		case TEEHISTORIAN_JOINVER6:
+		case TEEHISTORIAN_JOINVER7:
+			m_aSixup[ClientId] = Record.m_ExType == TEEHISTORIAN_JOINVER7;
+			break;
+		case TEEHISTORIAN_PLAYER_READY:
+			ConnectClient(ClientId);
+			m_pServer->m_aClients[ClientId].m_State = CServer::CClient::STATE_INGAME;
+			GameServer()->OnClientEnter(ClientId);
+			break;
+		case TEEHISTORIAN_DDNETVER:
+		case TEEHISTORIAN_DDNETVER_OLD:
+		{
+			if(Record.m_ExType == TEEHISTORIAN_DDNETVER)
+				Unpacker.GetRaw(sizeof(CUuid));
+			const int DDNetVersion = Unpacker.GetInt();
+			if(Unpacker.Error())
+				break;
+			CServer::CClient &Client = m_pServer->m_aClients[ClientId];
+			Client.m_DDNetVersion = DDNetVersion;
+			Client.m_DDNetVersionSettled = true;
+			Client.m_GotDDNetVersionPacket = true;
+			break;
+		}
+		default:
+			// the other extra records are results of the game, not input to it
+			break;
+		}
+	}
+
+	void OnRecord(const CTeeHistorianParser::CRecord &Record)
+	{
+		if(m_CheckPending && Record.m_Type != CTeeHistorianParser::RECORD_PLAYER && Record.m_Type != CTeeHistorianParser::RECORD_PLAYER_OLD)
+			CheckPlayers();
+
+		switch(Record.m_Type)
+		{
+		case CTeeHistorianParser::RECORD_TICK:
+			while(m_pServer->Tick() < Record.m_Tick)
+				RunTick();
+			return;
+		case CTeeHistorianParser::RECORD_PLAYER:
+			m_aAlive[Record.m_ClientId] = true;
+			m_aX[Record.m_ClientId] = Record.m_X;
+			m_aY[Record.m_ClientId] = Record.m_Y;
+			return;
+		case CTeeHistorianParser::RECORD_PLAYER_OLD:
+			m_aAlive[Record.m_ClientId] = false;
+			return;
+		case CTeeHistorianParser::RECORD_FINISH:
+			return;
+		default:
+			break;
+		}
+
+		const int64_t Start = time_get_nanoseconds().count();
+		switch(Record.m_Type)
+		{
+		case CTeeHistorianParser::RECORD_INPUT:
+			m_aInputs[Record.m_ClientId] = Record.m_Input;
+			m_aHaveInput[Record.m_ClientId] = true;
+			if(m_pServer->m_aClients[Record.m_ClientId].m_State == CServer::CClient::STATE_INGAME)
+				GameServer()->OnClientDirectInput(Record.m_ClientId, &Record.m_Input);
+			break;
+		case CTeeHistorianParser::RECORD_MESSAGE:
+		{
+			ConnectClient(Record.m_ClientId);
+			CUnpacker Unpacker;
+			Unpacker.Reset(Record.m_pData, Record.m_DataSize);
+			const int Msg = Unpacker.GetInt();
+			if(!Unpacker.Error() && !(Msg & 1))
+				GameServer()->OnMessage(Msg >> 1, &Unpacker, Record.m_ClientId);
+			break;
+		}
+		case CTeeHistorianParser::RECORD_JOIN:
+			DropClient(Record.m_ClientId, "rejoin");
+			CServer::NewClientCallback(Record.m_ClientId, m_pServer, m_aSixup[Record.m_ClientId]);
+			break;
+		case CTeeHistorianParser::RECORD_DROP:
+			DropClient(Record.m_ClientId, Record.m_pString);
+			break;
+		case CTeeHistorianParser::RECORD_CONSOLE_COMMAND:
+			ExecuteConsoleCommand(Record);
+			break;
+		case CTeeHistorianParser::RECORD_EX:
+			OnExtra(Record);
+			break;
+		default:
+			break;
+		}
+		m_EventTime += time_get_nanoseconds().count() - Start;
+	}
+
+	void ApplyHeader(const json_value *pHeader)
+	{
+		const json_value *pConfig = json_object_get(pHeader, "config");
+		if(pConfig->type == json_object)
+		{
+			for(unsigned i = 0; i < pConfig->u.object.length; i++)
+			{
+				const char *pValue = JsonString(pConfig->u.object.values[i].value);
+				if(!pValue)
+					continue;
+				char aLine[IConsole::CMDLINE_LENGTH];
+				str_format(aLine, sizeof(aLine), "%s \"", pConfig->u.object.values[i].name);
+				char *pDst = aLine + str_length(aLine);
+				str_escape(&pDst, pValue, aLine + sizeof(aLine) - 2);
+				*pDst = '\0';
+				str_append(aLine, "\"");
+				m_pConsole->ExecuteLine(aLine, IConsole::CLIENT_ID_UNSPECIFIED);
+			}
+		}
+		// don't record the replay
+		g_Config.m_SvTeeHistorian = 0;
+	}
+
+	void ApplyTuning(const json_value *pHeader)
+	{
+		const json_value *pTuning = json_object_get(pHeader, "tuning");
+		if(pTuning->type != json_object)
+			return;
+		for(unsigned i = 0; i < pTuning->u.object.length; i++)
+		{
+			const char *pValue = JsonString(pTuning->u.object.values[i].value);
+			if(!pValue)
+				continue;
+			char aLine[256];
+			str_format(aLine, sizeof(aLine), "tune %s %.2f", pTuning->u.object.values[i].name, str_toint(pValue) / 100.0f);
+			m_pConsole->ExecuteLine(aLine, IConsole::CLIENT_ID_UNSPECIFIED);
+		}
+	}
+
+public:
+	~CReplay()
+	{
+		if(m_GameInitialized)
+		{
+			m_pServer->GameServer()->OnShutdown(nullptr);
+			m_pServer->m_pMap->Unload();
+			m_pServer->DbPool()->OnShutdown();
+		}
+	}
+
+	bool Init(const char *pArgv0, const json_value *pHeader, const char *pMapName)
+	{
+		m_pServer = new CReplayServer();
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_pKernel->RegisterInterface(m_pServer);
+
+		IEngine *pEngine = CreateTestEngine(GAME_NAME);
+		m_pKernel->RegisterInterface(pEngine);
+
+		// keep the databases and other files of the game apart from the ones of a real server
+		fs_makedir(STORAGE_DIRECTORY);
+		const char *apArgs[] = {pArgv0};
+		m_pStorage = CreateTempStorage(STORAGE_DIRECTORY, std::size(apArgs), apArgs);
+		if(!m_pStorage)
+		{
+			log_error(TOOL_NAME, "Error creating storage");
+			return false;
+		}
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+
+		m_pConsole = CreateConsole(CFGFLAG_SERVER | CFGFLAG_ECON).release();
+		m_pKernel->RegisterInterface(m_pConsole);
+
+		IConfigManager *pConfigManager = CreateConfigManager();
+		m_pKernel->RegisterInterface(pConfigManager);
+
+		IEngineMap *pEngineMap = CreateEngineMap(pEngine);
+		m_pKernel->RegisterInterface(pEngineMap);
+		m_pKernel->RegisterInterface(static_cast<IMap *>(pEngineMap), false);
+
+		IEngineAntibot *pEngineAntibot = CreateEngineAntibot();
+		m_pKernel->RegisterInterface(pEngineAntibot);
+		m_pKernel->RegisterInterface(static_cast<IAntibot *>(pEngineAntibot), false);
+
+		IGameServer *pGameServer = CreateGameServer();
+		m_pKernel->RegisterInterface(pGameServer);
+
+		pEngine->Init();
+		m_pConsole->Init();
+		pConfigManager->Init();
+		m_pServer->RegisterCommands();
+
+		ApplyHeader(pHeader);
+
+		if(!m_pServer->LoadMap(pMapName))
+		{
+			log_error(TOOL_NAME, "Failed to load map '%s'", pMapName);
+			return false;
+		}
+		char aSha256[SHA256_MAXSTRSIZE];
+		sha256_str(m_pServer->m_aCurrentMapSha256[CServer::MAP_TYPE_SIX], aSha256, sizeof(aSha256));
+		const char *pRecordedSha256 = JsonString(json_object_get(pHeader, "map_sha256"));
+		if(pRecordedSha256 && str_comp(aSha256, pRecordedSha256) != 0)
+			log_warn(TOOL_NAME, "Map '%s' differs from the recorded one, sha256 %s instead of %s", pMapName, aSha256, pRecordedSha256);
+
+		m_pServer->m_RunServer = CServer::RUNNING;
+		m_pServer->m_AuthManager.Init();
+		for(auto &Client : m_pServer->m_aClients)
+		{
+			Client.m_HasPersistentData = false;
+			Client.m_pPersistentData = malloc(pGameServer->PersistentClientDataSize());
+		}
+		m_pServer->m_pPersistentData = malloc(pGameServer->PersistentDataSize());
+		m_pServer->Antibot()->Init();
+		pGameServer->OnInit(nullptr);
+		m_GameInitialized = true;
+		ApplyTuning(pHeader);
+		m_pConsole->SetCanUseCommandCallback(CanUseCommand, nullptr);
+		return true;
+	}
+
+	bool Run(CTeeHistorianParser &Parser, bool Check)
+	{
+		m_Check = Check;
+		CTeeHistorianParser::CRecord Record;
+		const int64_t Start = time_get_nanoseconds().count();
+		while(Parser.Next(&Record))
+			OnRecord(Record);
+		if(m_CheckPending)
+			CheckPlayers();
+		const int64_t Duration = time_get_nanoseconds().count() - Start;
+
+		if(Parser.Error())
+			log_warn(TOOL_NAME, "The recording ends with an invalid record after tick %d", m_pServer->Tick());
+		Report(Duration);
+		return m_NumMismatches == 0;
+	}
+
+	void Report(int64_t Duration)
+	{
+		const size_t NumTicks = m_avPhaseTimes[PHASE_TICK].size();
+		if(NumTicks == 0)
+		{
+			log_info(TOOL_NAME, "No ticks replayed");
+			return;
+		}
+		std::vector<int64_t> vTotal(NumTicks, 0);
+		for(const auto &vTimes : m_avPhaseTimes)
+		{
+			for(size_t i = 0; i < NumTicks; i++)
+				vTotal[i] += vTimes[i];
+		}
+
+		const double GameSeconds = (double)NumTicks / SERVER_TICK_SPEED;
+		log_info(TOOL_NAME, "Replayed %d ticks (%.1f s of game time) in %.3f s, %.0f ticks/s, %.1fx real time",
+			(int)NumTicks, GameSeconds, Duration / 1e9, NumTicks * 1e9 / Duration, GameSeconds * 1e9 / Duration);
+
+		auto Percentile = [](const std::vector<int64_t> &vSorted, int Percent) {
+			return vSorted[(vSorted.size() - 1) * Percent / 100] / 1e3;
+		};
+		auto Summary = [&](const char *pName, std::vector<int64_t> vTimes, int64_t TotalTime) {
+			int64_t Sum = 0;
+			for(int64_t Time : vTimes)
+				Sum += Time;
+			std::sort(vTimes.begin(), vTimes.end());
+			log_info(TOOL_NAME, "%-6s mean %8.2f us  p50 %8.2f us  p90 %8.2f us  p99 %8.2f us  max %8.2f us  %5.1f%%",
+				pName, Sum / 1e3 / vTimes.size(), Percentile(vTimes, 50), Percentile(vTimes, 90), Percentile(vTimes, 99), vTimes.back() / 1e3,
+				TotalTime ? Sum * 100.0 / TotalTime : 100.0);
+		};
+		int64_t TotalTime = 0;
+		for(int64_t Time : vTotal)
+			TotalTime += Time;
+		Summary("total", vTotal, 0);
+		for(int Phase = 0; Phase < NUM_PHASES; Phase++)
+			Summary(PHASE_NAMES[Phase], m_avPhaseTimes[Phase], TotalTime);
+
+		if(m_Check)
+		{
+			if(m_NumMismatches == 0)
+				log_info(TOOL_NAME, "All character positions match the recording");
+			else
+				log_warn(TOOL_NAME, "%d character positions in %d ticks differ from the recording", m_NumMismatches, m_NumMismatchedTicks);
+		}
+	}
+};
+
+int main(int argc, const char *argv[])
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	const char *pArgv0 = argv[0];
+	bool Check = false;
+	if(argc >= 2 && str_comp(argv[1], "--check") == 0)
+	{
+		Check = true;
+		argc--;
+		argv++;
+	}
+	if(argc < 2 || argc > 3)
+	{
+		log_error(TOOL_NAME, "Usage: %s [--check] <teehistorian file> [map name]", TOOL_NAME);
+		return -1;
+	}
+
+	CTeeHistorianReader Reader;
+	IOHANDLE File = io_open(argv[1], IOFLAG_READ);
+	if(!File || !Reader.Open(File))
+	{
+		log_error(TOOL_NAME, "Failed to open '%s'", argv[1]);
+		return -1;
+	}
+	std::vector<unsigned char> vData;
+	if(!Reader.ReadAll(vData))
+	{
+		log_error(TOOL_NAME, "Failed to read '%s'", argv[1]);
+		return -1;
+	}
+	Reader.Close();
+
+	CTeeHistorianParser Parser;
+	if(!Parser.Init(vData.data(), vData.size()))
+	{
+		log_error(TOOL_NAME, "'%s' is not a teehistorian file", argv[1]);
+		return -1;
+	}
+	json_value *pHeader = json_parse(Parser.Header(), str_length(Parser.Header()));
+	if(!pHeader)
+	{
+		log_error(TOOL_NAME, "Failed to parse the header of '%s'", argv[1]);
+		return -1;
+	}
+	const char *pMapName = argc == 3 ? argv[2] : JsonString(json_object_get(pHeader, "map_name"));
+	if(!pMapName)
+	{
+		log_error(TOOL_NAME, "No map name in the header of '%s'", argv[1]);
+		json_value_free(pHeader);
+		return -1;
+	}
+
+	bool Success;
+	{
+		CReplay Replay;
+		Success = Replay.Init(pArgv0, pHeader, pMapName) && Replay.Run(Parser, Check);
+	}
+	json_value_free(pHeader);
+	return Success ? 0 : 1;
+}